@@ -0,0 +1,180 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <lib_bra_defs.h>
+#include <lib_bra_types.h>
+
+#include <encoders/bra_bwt.h>
+#include <encoders/bra_mtf.h>
+#include <encoders/bra_rle.h>
+#include <encoders/bra_zrle.h>
+#include <encoders/bra_huffman.h>
+#include <encoders/bra_cm.h>
+#include <encoders/bra_codec.h>
+
+#ifdef __cplusplus
+}
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/// \cond DO_NOT_DOCUMENT
+
+// Entropy coders of the BWT output, chunk by chunk as the archives encode them:
+// MTF+zero-run+multiple Huffman tables, the default levels, against context mixing, the maximum one.
+//
+// usage: bench_bra_encoders [file...]
+//        without files, a text of random words is encoded.
+
+using namespace std;
+
+using bench_clock = chrono::steady_clock;
+
+struct bench_coder_t
+{
+    const char*           name;
+    uint64_t              size = 0;
+    bench_clock::duration encode{0};
+    bench_clock::duration decode{0};
+};
+
+static vector<uint8_t> bench_input(const int argc, char* argv[])
+{
+    vector<uint8_t> data;
+    for (int i = 1; i < argc; ++i)
+    {
+        ifstream f(argv[i], ios::binary);
+        if (!f)
+        {
+            cerr << format("unable to read {}", argv[i]) << endl;
+            return {};
+        }
+
+        data.insert(data.end(), istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+    }
+
+    if (argc > 1)
+        return data;
+
+    const char* words[] = {"lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ", "adipiscing ", "elit, ", "sed ", "do ", "eiusmod ", "tempor ", "incididunt ", "ut ", "labore ", "et ", "dolore ", "magna ", "aliqua.\n"};
+    uint32_t    seed    = 12345;
+    while (data.size() < 4 * BRA_MAX_CHUNK_SIZE)
+    {
+        seed = seed * 1103515245U + 12345U;
+        for (const char* w = words[(seed >> 16) % size(words)]; *w != '\0'; ++w)
+            data.push_back(static_cast<uint8_t>(*w));
+    }
+
+    return data;
+}
+
+static double bench_mb_s(const uint64_t bytes, const bench_clock::duration d)
+{
+    const double s = chrono::duration<double>(d).count();
+    return s > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / s : 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+    const vector<uint8_t> data = bench_input(argc, argv);
+    if (data.empty())
+        return 1;
+
+    bra_codec_ctx_t codec;
+    bra_codec_ctx_init(&codec);
+    if (!bra_codec_ctx_reserve(&codec) || !bra_codec_ctx_reserve_cm(&codec))
+    {
+        cerr << "unable to allocate the codec buffers" << endl;
+        return 1;
+    }
+
+    bench_coder_t   huffman = {.name = "mtf+zrle+huffman"};
+    bench_coder_t   cm      = {.name = "context mixing"};
+    vector<uint8_t> bwt(BRA_MAX_CHUNK_SIZE);
+    vector<uint8_t> enc(BRA_CODEC_BUF_SIZE);
+    int             res = 0;
+    for (size_t pos = 0; pos < data.size() && res == 0; pos += BRA_MAX_CHUNK_SIZE)
+    {
+        const bra_bwt_index_t s = static_cast<bra_bwt_index_t>(min<size_t>(BRA_MAX_CHUNK_SIZE, data.size() - pos));
+        bra_bwt_index_t       primary_index;
+        memcpy(codec.buf, &data[pos], s);
+        if (!bra_bwt_encode2(codec.buf, s, &primary_index, codec.buf_trans, bwt.data()))
+        {
+            res = 2;
+            break;
+        }
+
+        // zero-run or RLE, as the chunks too big for the zero-run stage.
+        auto       t0    = bench_clock::now();
+        size_t     rle_s = 0;
+        bool       ok    = bra_mtf_encode2(bwt.data(), s, codec.buf);
+        const bool zrle  = ok && bra_zrle_encode2(codec.buf, s, codec.buf2, BRA_CODEC_BUF_SIZE, &rle_s);
+        ok               = ok && (zrle || bra_rle_encode2(codec.buf, s, codec.buf2, BRA_CODEC_BUF_SIZE, &rle_s));
+        bra_huffman_t meta;
+        ok = ok && bra_huffman_encode_multi(codec.buf2, static_cast<uint32_t>(rle_s), &meta, enc.data(), static_cast<uint32_t>(enc.size()));
+        auto t1 = bench_clock::now();
+
+        size_t dec_s = 0;
+        ok           = ok && bra_huffman_decode_multi(&meta, enc.data(), codec.buf2, BRA_CODEC_BUF_SIZE);
+        ok           = ok && (zrle ? bra_zrle_decode2(codec.buf2, rle_s, codec.buf, BRA_CODEC_BUF_SIZE, &dec_s) : bra_rle_decode2(codec.buf2, rle_s, codec.buf, BRA_CODEC_BUF_SIZE, &dec_s));
+        if (ok)
+            bra_mtf_decode2(codec.buf, s, codec.buf2);
+        auto t2 = bench_clock::now();
+        if (!ok || dec_s != s || memcmp(codec.buf2, bwt.data(), s) != 0)
+        {
+            res = 3;
+            break;
+        }
+
+        huffman.size   += meta.encoded_size;
+        huffman.encode += t1 - t0;
+        huffman.decode += t2 - t1;
+
+        size_t cm_s = 0;
+        t0          = bench_clock::now();
+        ok          = bra_cm_encode2(codec.cm, bwt.data(), s, enc.data(), enc.size(), &cm_s);
+        t1          = bench_clock::now();
+        ok          = ok && bra_cm_decode2(codec.cm, enc.data(), cm_s, codec.buf2, s);
+        t2          = bench_clock::now();
+        if (!ok || memcmp(codec.buf2, bwt.data(), s) != 0)
+        {
+            res = 4;
+            break;
+        }
+
+        cm.size   += cm_s;
+        cm.encode += t1 - t0;
+        cm.decode += t2 - t1;
+    }
+
+    bra_codec_ctx_free(&codec);
+    if (res != 0)
+    {
+        cerr << format("round-trip failed ({})", res) << endl;
+        return res;
+    }
+
+    cout << format("input: {} bytes, chunks of {} bytes", data.size(), BRA_MAX_CHUNK_SIZE) << endl;
+    for (const bench_coder_t* c : {&huffman, &cm})
+    {
+        cout << format("{:<18} {:>10} bytes {:6.2f}%  encode {:8.2f} MB/s  decode {:8.2f} MB/s",
+                       c->name,
+                       c->size,
+                       100.0 * static_cast<double>(c->size) / static_cast<double>(data.size()),
+                       bench_mb_s(data.size(), c->encode),
+                       bench_mb_s(data.size(), c->decode))
+             << endl;
+    }
+
+    return 0;
+}
+
+/// \endcond
@@ -1,10 +1,3 @@
-#if defined(linux) || defined(__BSD__)
-#define _GNU_SOURCE
-#define BRA_QSORT qsort_r
-#else
-#define BRA_QSORT qsort_s
-#endif
-
 #include <encoders/bra_bwt.h>
 #include <lib_bra_defs.h>
 
@@ -12,98 +5,331 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define BRA_BWT_SELECT_SORT_SIZE 7     //!< smaller groups are split with a selection sort.
+#define BRA_BWT_MED3_SIZE        7     //!< larger groups take the median of 3 as pivot.
+#define BRA_BWT_MED9_SIZE        40    //!< larger groups take the pseudo median of 9 as pivot.
+
 /**
- * @brief BWT transform helper.
+ * @brief BWT transform helper: the rotations sorted by their first @c h bytes, doubling @c h (Larsson-Sadakane).
+ *
+ * The sorted groups in @c index are marked by their negated length, the unsorted ones hold the rotations.
+ * The group of a rotation is the position of the last rotation of its group in @c index.
  */
 typedef struct bwt_suffix_ctx_t
 {
-    bra_bwt_index_t*      index;     //!< index
-    const uint8_t*        data;      //!< data
+    int32_t*              index;     //!< rotations by their first @c h bytes, or the negated length of the sorted groups.
+    int32_t*              group;     //!< group of each rotation, its position in the final sort once sorted.
+    bra_bwt_index_t       h;         //!< bytes of the rotations already sorted.
     const bra_bwt_index_t length;    //!< length
 
 } bwt_suffix_ctx_t;
 
 _Static_assert(BRA_MAX_CHUNK_SIZE <= 1 << (BRA_BWT_INDEX_BYTES * 8), "BRA_BWT_INDEX_BYTES insufficient to represent BRA_MAX_CHUNK_SIZE");
+_Static_assert(BRA_MAX_CHUNK_SIZE <= INT32_MAX / 2, "BRA_MAX_CHUNK_SIZE overflows the signed rotation indices");
 
 //////////////////////////////////////////////////////////////////////////////////////////
 
-#if defined(linux) || defined(__BSD__)
-static int bwt_suffix_context_compare(const void* a, const void* b, void* context)
-#else
-static int bwt_suffix_context_compare(void* context, const void* a, const void* b)
-#endif
+/**
+ * @brief The sort key of the rotation at @p p: the group of the rotation @c h bytes after it.
+ */
+static inline int32_t bwt_suffix_key(const bwt_suffix_ctx_t* ctx, const int32_t* p)
+{
+    const bra_bwt_index_t i = (bra_bwt_index_t) *p + ctx->h;
+    return ctx->group[i >= ctx->length ? i - ctx->length : i];
+}
+
+static inline void bwt_suffix_swap(int32_t* a, int32_t* b)
+{
+    const int32_t t = *a;
+    *a              = *b;
+    *b              = t;
+}
+
+static inline int32_t* bwt_suffix_med3(const bwt_suffix_ctx_t* ctx, int32_t* a, int32_t* b, int32_t* c)
+{
+    const int32_t ka = bwt_suffix_key(ctx, a);
+    const int32_t kb = bwt_suffix_key(ctx, b);
+    const int32_t kc = bwt_suffix_key(ctx, c);
+    if (ka < kb)
+        return kb < kc ? b : (ka < kc ? c : a);
+
+    return kb > kc ? b : (ka > kc ? c : a);
+}
+
+/**
+ * @brief Set the group of the rotations from @p pl to @p pm, the new group: marked sorted when a single one.
+ */
+static void bwt_suffix_update_group(bwt_suffix_ctx_t* ctx, int32_t* pl, int32_t* pm)
+{
+    const int32_t g = (int32_t) (pm - ctx->index);
+    ctx->group[*pl] = g;
+    if (pl == pm)
+    {
+        *pl = -1;
+        return;
+    }
+
+    do
+        ctx->group[*++pl] = g;
+    while (pl < pm);
+}
+
+/**
+ * @brief Split the @p n rotations at @p p in groups by their key, picking the smallest ones each time.
+ */
+static void bwt_suffix_select_sort_split(bwt_suffix_ctx_t* ctx, int32_t* p, const int32_t n)
+{
+    int32_t*       pa = p;
+    int32_t* const pn = p + n - 1;
+    while (pa < pn)
+    {
+        int32_t* pb = pa + 1;
+        int32_t  f  = bwt_suffix_key(ctx, pa);
+        for (int32_t* pi = pa + 1; pi <= pn; ++pi)
+        {
+            const int32_t v = bwt_suffix_key(ctx, pi);
+            if (v < f)
+            {
+                f = v;
+                bwt_suffix_swap(pi, pa);
+                pb = pa + 1;
+            }
+            else if (v == f)
+            {
+                bwt_suffix_swap(pi, pb);
+                ++pb;
+            }
+        }
+
+        bwt_suffix_update_group(ctx, pa, pb - 1);
+        pa = pb;
+    }
+
+    if (pa == pn)
+    {
+        ctx->group[*pa] = (int32_t) (pa - ctx->index);
+        *pa             = -1;
+    }
+}
+
+/**
+ * @brief Split the @p n rotations at @p p in groups by their key, with a ternary quick sort.
+ */
+static void bwt_suffix_sort_split(bwt_suffix_ctx_t* ctx, int32_t* p, const int32_t n)
+{
+    if (n < BRA_BWT_SELECT_SORT_SIZE)
+    {
+        bwt_suffix_select_sort_split(ctx, p, n);
+        return;
+    }
+
+    // pivot
+    int32_t* pm = p + (n >> 1);
+    if (n > BRA_BWT_MED3_SIZE)
+    {
+        int32_t* pl = p;
+        int32_t* pn = p + n - 1;
+        if (n > BRA_BWT_MED9_SIZE)
+        {
+            const int32_t s = n >> 3;
+            pl              = bwt_suffix_med3(ctx, pl, pl + s, pl + s + s);
+            pm              = bwt_suffix_med3(ctx, pm - s, pm, pm + s);
+            pn              = bwt_suffix_med3(ctx, pn - s - s, pn - s, pn);
+        }
+
+        pm = bwt_suffix_med3(ctx, pl, pm, pn);
+    }
+
+    const int32_t v = bwt_suffix_key(ctx, pm);
+
+    // split-end partition: the keys equal to the pivot at both ends.
+    int32_t* pa = p;
+    int32_t* pb = p;
+    int32_t* pc = p + n - 1;
+    int32_t* pd = p + n - 1;
+    for (;;)
+    {
+        int32_t f;
+        while (pb <= pc && (f = bwt_suffix_key(ctx, pb)) <= v)
+        {
+            if (f == v)
+                bwt_suffix_swap(pa++, pb);
+            ++pb;
+        }
+
+        while (pc >= pb && (f = bwt_suffix_key(ctx, pc)) >= v)
+        {
+            if (f == v)
+                bwt_suffix_swap(pc, pd--);
+            --pc;
+        }
+
+        if (pb > pc)
+            break;
+
+        bwt_suffix_swap(pb++, pc--);
+    }
+
+    // the keys equal to the pivot in the middle.
+    int32_t* const pn = p + n;
+    int32_t        s  = (int32_t) (pa - p);
+    int32_t        t  = (int32_t) (pb - pa);
+    for (int32_t *pl = p, *pr = pb - (s < t ? s : t); pr < pb; ++pl, ++pr)
+        bwt_suffix_swap(pl, pr);
+
+    s = (int32_t) (pd - pc);
+    t = (int32_t) (pn - pd - 1);
+    for (int32_t *pl = pb, *pr = pn - (s < t ? s : t); pr < pn; ++pl, ++pr)
+        bwt_suffix_swap(pl, pr);
+
+    s = (int32_t) (pb - pa);
+    t = (int32_t) (pd - pc);
+    if (s > 0)
+        bwt_suffix_sort_split(ctx, p, s);
+    bwt_suffix_update_group(ctx, p + s, p + n - t - 1);
+    if (t > 0)
+        bwt_suffix_sort_split(ctx, p + n - t, t);
+}
+
+/**
+ * @brief Sort the rotations by their first byte, a group for each byte value.
+ */
+static void bwt_suffix_bucket_sort(bwt_suffix_ctx_t* ctx, const uint8_t* buf)
 {
-    const bwt_suffix_ctx_t* ctx = (const bwt_suffix_ctx_t*) context;
+    const int32_t n = (int32_t) ctx->length;
 
-    const bra_bwt_index_t sa = *(const bra_bwt_index_t*) a;
-    const bra_bwt_index_t sb = *(const bra_bwt_index_t*) b;
+    bra_bwt_index_t count[BRA_ALPHABET_SIZE] = {0};
+    for (int32_t i = 0; i < n; ++i)
+        count[buf[i]]++;
 
-    for (bra_bwt_index_t i = 0; i < ctx->length; ++i)
+    // the group of a byte is its last position, the rotations are placed from there backwards.
+    bra_bwt_index_t last[BRA_ALPHABET_SIZE];
+    bra_bwt_index_t next[BRA_ALPHABET_SIZE];
+    bra_bwt_index_t sum = 0;
+    for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
     {
-        const uint8_t byte_a = ctx->data[(sa + i) % ctx->length];
-        const uint8_t byte_b = ctx->data[(sb + i) % ctx->length];
+        sum     += count[i];
+        last[i]  = sum - 1;
+        next[i]  = sum - 1;
+    }
 
-        if (byte_a < byte_b)
-            return -1;
-        if (byte_a > byte_b)
-            return 1;
+    for (int32_t i = n - 1; i >= 0; --i)
+    {
+        ctx->group[i]              = (int32_t) last[buf[i]];
+        ctx->index[next[buf[i]]--] = i;
     }
 
-    return 0;
+    // single rotation groups are already sorted.
+    for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
+    {
+        if (count[i] == 1)
+            ctx->index[last[i]] = -1;
+    }
+}
+
+/**
+ * @brief Sort the rotations doubling the bytes compared at each pass, until all of them are sorted.
+ *        The equal rotations, of periodic data, are left in their order after @c length bytes.
+ */
+static void bwt_suffix_sort(bwt_suffix_ctx_t* ctx)
+{
+    int32_t* const index = ctx->index;
+    const int32_t  n     = (int32_t) ctx->length;
+
+    for (ctx->h = 1; index[0] > -n && ctx->h < ctx->length; ctx->h *= 2)
+    {
+        int32_t* pi = index;
+        int32_t  sl = 0;    // negated length of the sorted groups before pi.
+        do
+        {
+            const int32_t s = *pi;
+            if (s < 0)
+            {
+                pi -= s;
+                sl += s;
+                continue;
+            }
+
+            if (sl != 0)
+            {
+                *(pi + sl) = sl;
+                sl         = 0;
+            }
+
+            int32_t* const pk = index + ctx->group[s] + 1;
+            bwt_suffix_sort_split(ctx, pi, (int32_t) (pk - pi));
+            pi = pk;
+        } while (pi < index + n);
+
+        if (sl != 0)
+            *(pi + sl) = sl;
+    }
+
+    // the equal rotations left take consecutive positions, then invert the groups.
+    for (int32_t i = 0; i < n;)
+    {
+        if (index[i] < 0)
+        {
+            i -= index[i];
+            continue;
+        }
+
+        const int32_t last = ctx->group[index[i]];
+        for (; i <= last; ++i)
+            ctx->group[index[i]] = i;
+    }
+
+    for (int32_t i = 0; i < n; ++i)
+        index[ctx->group[i]] = i;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 uint8_t* bra_bwt_encode(const uint8_t* buf, const bra_bwt_index_t buf_size, bra_bwt_index_t* primary_index)
 {
-    // Allocate output buffer
-    uint8_t* out_buf = (uint8_t*) malloc(buf_size);
-    if (out_buf == NULL)
+    // Allocate suffix array for all rotations
+    bra_bwt_index_t* index = malloc(BRA_BWT_ENCODE_WORK_SIZE(buf_size) * sizeof(bra_bwt_index_t));
+    if (index == NULL)
         return NULL;
 
-    if (!bra_bwt_encode2(buf, buf_size, primary_index, out_buf))
+    // Allocate output buffer
+    uint8_t* out_buf = (uint8_t*) malloc(buf_size);
+    if (out_buf != NULL && !bra_bwt_encode2(buf, buf_size, primary_index, index, out_buf))
     {
         free(out_buf);
-        return NULL;
+        out_buf = NULL;
     }
 
+    free(index);
     return out_buf;
 }
 
-bool bra_bwt_encode2(const uint8_t* buf, const bra_bwt_index_t buf_size, bra_bwt_index_t* primary_index, uint8_t* out_buf)
+bool bra_bwt_encode2(const uint8_t* buf, const bra_bwt_index_t buf_size, bra_bwt_index_t* primary_index, bra_bwt_index_t* index, uint8_t* out_buf)
 {
     assert(buf != NULL);
     assert(buf_size > 0);
     assert(primary_index != NULL);
+    assert(index != NULL);
     assert(out_buf != NULL);
 
-    // Allocate suffix array for all rotations
-    bwt_suffix_ctx_t suffix_ctx = {.index = NULL, .data = buf, .length = buf_size};
-    suffix_ctx.index            = malloc(buf_size * sizeof(bra_bwt_index_t));
-    if (!suffix_ctx.index)
-        return false;
-
-    // Initialize suffix array with all possible rotations
-    for (bra_bwt_index_t i = 0; i < buf_size; i++)
-        suffix_ctx.index[i] = i;
-
     // Sort all rotations lexicographically
-    BRA_QSORT(suffix_ctx.index, buf_size, sizeof(bra_bwt_index_t), bwt_suffix_context_compare, &suffix_ctx);
+    bwt_suffix_ctx_t suffix_ctx = {.index = (int32_t*) index, .group = (int32_t*) index + buf_size, .h = 0, .length = buf_size};
+    bwt_suffix_bucket_sort(&suffix_ctx, buf);
+    bwt_suffix_sort(&suffix_ctx);
 
     // Generate BWT by taking the last character of each sorted rotation
     *primary_index = 0;
     for (bra_bwt_index_t i = 0; i < buf_size; i++)
     {
         // Last character position in this rotation
-        bra_bwt_index_t last_pos = (suffix_ctx.index[i] + buf_size - 1) % buf_size;
+        bra_bwt_index_t last_pos = (index[i] + buf_size - 1) % buf_size;
         out_buf[i]               = buf[last_pos];
 
         // Track where the original string (rotation starting at 0) ended up
-        if (suffix_ctx.index[i] == 0)
+        if (index[i] == 0)
             *primary_index = i;
     }
 
-    free(suffix_ctx.index);
     return true;
 }
 
@@ -24,9 +24,7 @@
  * @note Caller is responsible for freeing the returned buffer.
  * @note Output size is always equal to input size.
  * @note Primary index is required for reversible decoding with @ref bra_bwt_decode().
- * @note Currently uses O(n² log n) comparison-based sorting.
- *
- * @todo Implement SA-IS algorithm to achieve O(n) time complexity.
+ * @note The rotations are sorted by prefix doubling (Larsson-Sadakane): O(n log n) time even on repetitive data.
  *
  * @warning Input buffer and primary_index must not be @c NULL.
  * @warning buf_size must be greater than 0.
@@ -56,11 +54,12 @@ uint8_t* bra_bwt_encode(const uint8_t* buf, const bra_bwt_index_t buf_size, bra_
  * @param buf Input data buffer to transform (must not be @c NULL)
  * @param buf_size Size of input data in bytes (must be > 0)
  * @param primary_index Pointer to store primary index for decoding (must not be @c NULL)
+ * @param index suffix index work buffer, at least #BRA_BWT_ENCODE_WORK_SIZE(@p buf_size) elements (must not be @c NULL)
  * @param out_buf Output buffer to store BWT-transformed data (must not be @c NULL)
  * @retval true  on success
  * @retval false on failure
  */
-bool bra_bwt_encode2(const uint8_t* buf, const bra_bwt_index_t buf_size, bra_bwt_index_t* primary_index, uint8_t* out_buf);
+bool bra_bwt_encode2(const uint8_t* buf, const bra_bwt_index_t buf_size, bra_bwt_index_t* primary_index, bra_bwt_index_t* index, uint8_t* out_buf);
 
 /**
  * @brief Decode BWT-transformed data back to original.
@@ -0,0 +1,299 @@
+#include <encoders/bra_cm.h>
+
+#include <lib_bra_defs.h>
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define BRA_CM_COUNTERS    6                        //!< predictions mixed for each bit.
+#define BRA_CM_INPUTS      (BRA_CM_COUNTERS + 1)    //!< the predictions and the bias of the mixer.
+#define BRA_CM_O2_BITS     12                       //!< order-2 contexts are hashed in 2^12 groups of 256 counters.
+#define BRA_CM_RUN_CLASSES 20                       //!< lengths of the run of the previous byte: 0 to 15, then 4 classes up to 128 and more.
+#define BRA_CM_APM_STEPS   33                       //!< interpolation steps of the final refinement of a prediction.
+#define BRA_CM_APM_RATE    7                        //!< adaptation rate of the refinement, as a shift.
+#define BRA_CM_MIXER_SHIFT 13                       //!< learning rate of the mixer, as a shift: the higher the slower.
+#define BRA_CM_FLUSH       4                        //!< bytes written at the end of the arithmetic coder.
+#define BRA_CM_TOP         0xFF000000U              //!< the top byte of the coder range, written out when settled.
+
+/**
+ * @brief Adaptation rates of the counters, as shifts: order-0 and order-1 have a fast and a slow one.
+ */
+static const int g_bra_cm_rates[BRA_CM_COUNTERS] = {1, 4, 3, 5, 4, 4};
+
+/**
+ * @brief Context mixing model: the counters of each context and the mixer weights.
+ *        The counters are 16 bits probabilities of a 1, by the bits already coded of the current byte.
+ */
+struct bra_cm_t
+{
+    uint16_t  o0[2][256];                                            //!< order-0 counters, fast and slow.
+    uint16_t  o1[2][256 * 256];                                      //!< order-1 counters by the previous byte, fast and slow.
+    uint16_t  o2[1U << (BRA_CM_O2_BITS + 8)];                        //!< order-2 counters by the hash of the 2 previous bytes.
+    uint16_t  run[BRA_CM_RUN_CLASSES * 256];                         //!< counters by the run length of the previous byte.
+    uint16_t  apm[2 * 256 * BRA_CM_APM_STEPS];                       //!< refined probabilities by a run of more than 2 and the bits of the current byte.
+    int32_t   w[4 * 256][BRA_CM_INPUTS];                             //!< mixer weights by a short run class and the bits of the current byte, 16 bits fixed point.
+    int16_t   stretch[4096];                                         //!< inverse of @ref _bra_cm_squash.
+    uint16_t* c[BRA_CM_COUNTERS];                                    //!< counters of the bit being coded.
+    int32_t   st[BRA_CM_INPUTS];                                     //!< their stretched predictions.
+    int32_t*  wc;                                                    //!< mixer weights of the bit being coded.
+    int32_t   pr_mix;                                                //!< the mixer prediction, 12 bits.
+    uint32_t  apm_idx;                                               //!< the refinement entry of the bit being coded.
+    uint32_t  c0;                                                    //!< bits of the current byte, after a leading 1.
+    uint32_t  c1;                                                    //!< previous byte.
+    uint32_t  c2;                                                    //!< byte before the previous one.
+    uint32_t  run_len;                                               //!< times the previous byte is repeated.
+};
+
+/**
+ * @brief Logistic function: the 12 bits probability of the stretched @p d, 8 bits of fraction.
+ */
+static int32_t _bra_cm_squash(int32_t d)
+{
+    static const int32_t t[33] = {1, 2, 3, 6, 10, 16, 27, 45, 73, 120, 194, 310, 488, 747, 1101, 1546, 2047, 2549, 2994, 3348, 3607, 3785, 3901, 3975, 4022, 4050, 4068, 4079, 4085, 4089, 4092, 4093, 4094};
+
+    if (d > 2047)
+        return 4095;
+    if (d < -2047)
+        return 0;
+
+    const int32_t w = d & 127;
+    d               = (d >> 7) + 16;
+    return (t[d] * (128 - w) + t[d + 1] * w + 64) >> 7;
+}
+
+static inline uint32_t _bra_cm_run_class(const uint32_t run_len)
+{
+    if (run_len < 16)
+        return run_len;
+
+    return 16 + (run_len >= 32) + (run_len >= 64) + (run_len >= 128);
+}
+
+static inline void _bra_cm_counter_update(uint16_t* c, const int y, const int rate)
+{
+    if (y)
+        *c += (uint16_t) ((UINT16_MAX - *c) >> rate);
+    else
+        *c -= (uint16_t) (*c >> rate);
+}
+
+static inline void _bra_cm_counters_reset(uint16_t* c, const size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        c[i] = 1U << 15;
+}
+
+static void _bra_cm_reset(bra_cm_t* cm)
+{
+    _bra_cm_counters_reset(&cm->o0[0][0], sizeof(cm->o0) / sizeof(uint16_t));
+    _bra_cm_counters_reset(&cm->o1[0][0], sizeof(cm->o1) / sizeof(uint16_t));
+    _bra_cm_counters_reset(cm->o2, sizeof(cm->o2) / sizeof(uint16_t));
+    _bra_cm_counters_reset(cm->run, sizeof(cm->run) / sizeof(uint16_t));
+
+    for (int i = 0; i < 2 * 256; ++i)
+    {
+        for (int j = 0; j < BRA_CM_APM_STEPS; ++j)
+            cm->apm[i * BRA_CM_APM_STEPS + j] = (uint16_t) (_bra_cm_squash((j - 16) * 128) * 16);
+    }
+
+    for (int i = 0; i < 4 * 256; ++i)
+    {
+        for (int j = 0; j < BRA_CM_COUNTERS; ++j)
+            cm->w[i][j] = (1 << 16) / BRA_CM_COUNTERS;
+        cm->w[i][BRA_CM_COUNTERS] = 0;
+    }
+
+    cm->c0      = 1;
+    cm->c1      = 0;
+    cm->c2      = 0;
+    cm->run_len = 0;
+}
+
+/**
+ * @brief Probability, 12 bits, that the next bit is 1.
+ */
+static inline int32_t _bra_cm_predict(bra_cm_t* cm)
+{
+    const uint32_t c0 = cm->c0;
+    const uint32_t rc = _bra_cm_run_class(cm->run_len);
+    const uint32_t h2 = (((cm->c2 << 8) | cm->c1) * 0x9E3779B1U) >> (32 - BRA_CM_O2_BITS);
+
+    cm->c[0] = &cm->o0[0][c0];
+    cm->c[1] = &cm->o0[1][c0];
+    cm->c[2] = &cm->o1[0][(cm->c1 << 8) | c0];
+    cm->c[3] = &cm->o1[1][(cm->c1 << 8) | c0];
+    cm->c[4] = &cm->o2[(h2 << 8) | c0];
+    cm->c[5] = &cm->run[(rc << 8) | c0];
+
+    cm->wc      = cm->w[((rc < 3 ? rc : 3) << 8) | c0];
+    int64_t dot = 0;
+    for (int i = 0; i < BRA_CM_COUNTERS; ++i)
+    {
+        cm->st[i]  = cm->stretch[*cm->c[i] >> 4];
+        dot       += (int64_t) cm->wc[i] * cm->st[i];
+    }
+
+    cm->st[BRA_CM_COUNTERS]  = 256;
+    dot                     += (int64_t) cm->wc[BRA_CM_COUNTERS] * 256;
+    cm->pr_mix               = _bra_cm_squash((int32_t) (dot >> 16));
+
+    // refine the prediction, interpolating between the 2 nearest steps.
+    const int32_t  s  = cm->stretch[cm->pr_mix] + 2048;
+    const int32_t  wt = s & 127;
+    const uint32_t i  = (((cm->run_len > 2 ? 256U : 0U) | c0) * BRA_CM_APM_STEPS) + (uint32_t) (s >> 7);
+    const int32_t  pa = (cm->apm[i] * (128 - wt) + cm->apm[i + 1] * wt) >> 11;
+    cm->apm_idx       = i + (uint32_t) (wt >> 6);
+
+    const int32_t p = (cm->pr_mix + pa) >> 1;
+    return p < 1 ? 1 : p > 4095 ? 4095 : p;
+}
+
+static inline void _bra_cm_update(bra_cm_t* cm, const int y)
+{
+    for (int i = 0; i < BRA_CM_COUNTERS; ++i)
+        _bra_cm_counter_update(cm->c[i], y, g_bra_cm_rates[i]);
+
+    const int32_t err = (y << 12) - cm->pr_mix;
+    for (int i = 0; i < BRA_CM_INPUTS; ++i)
+        cm->wc[i] += (cm->st[i] * err) >> BRA_CM_MIXER_SHIFT;
+
+    const int32_t g       = (y << 16) + (y << BRA_CM_APM_RATE) - y - y;
+    cm->apm[cm->apm_idx] += (g - cm->apm[cm->apm_idx]) >> BRA_CM_APM_RATE;
+
+    cm->c0 = (cm->c0 << 1) | (uint32_t) y;
+    if (cm->c0 >= 256)
+    {
+        const uint32_t c = cm->c0 & 0xFF;
+        cm->run_len      = c == cm->c1 ? cm->run_len + 1 : 0;
+        cm->c2           = cm->c1;
+        cm->c1           = c;
+        cm->c0           = 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bra_cm_t* bra_cm_create(void)
+{
+    bra_cm_t* cm = malloc(sizeof(bra_cm_t));
+    if (cm == NULL)
+        return NULL;
+
+    int32_t pi = 0;
+    for (int32_t x = -2047; x <= 2047; ++x)
+    {
+        const int32_t v = _bra_cm_squash(x);
+        for (int32_t i = pi; i <= v; ++i)
+            cm->stretch[i] = (int16_t) x;
+        pi = v + 1;
+    }
+    for (int32_t i = pi; i < 4096; ++i)
+        cm->stretch[i] = 2047;
+
+    return cm;
+}
+
+void bra_cm_destroy(bra_cm_t** cm)
+{
+    assert(cm != NULL);
+
+    free(*cm);
+    *cm = NULL;
+}
+
+bool bra_cm_encode2(bra_cm_t* cm, const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(cm != NULL);
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    _bra_cm_reset(cm);
+
+    uint32_t x1 = 0;
+    uint32_t x2 = 0xFFFFFFFFU;
+    size_t   n  = 0;
+    for (size_t i = 0; i < buf_size; ++i)
+    {
+        for (int b = 7; b >= 0; --b)
+        {
+            const int      y    = (buf[i] >> b) & 1;
+            const uint32_t xmid = x1 + ((x2 - x1) >> 12) * (uint32_t) _bra_cm_predict(cm);
+            if (y)
+                x2 = xmid;
+            else
+                x1 = xmid + 1;
+            _bra_cm_update(cm, y);
+
+            // write the settled top bytes
+            while (((x1 ^ x2) & BRA_CM_TOP) == 0)
+            {
+                if (n == out_buf_size)
+                    return false;
+
+                out_buf[n++]   = (uint8_t) (x2 >> 24);
+                x1           <<= 8;
+                x2             = (x2 << 8) | 0xFF;
+            }
+        }
+    }
+
+    if (n + BRA_CM_FLUSH > out_buf_size)
+        return false;
+
+    for (int i = 0; i < BRA_CM_FLUSH; ++i, x1 <<= 8)
+        out_buf[n++] = (uint8_t) (x1 >> 24);
+
+    *out_size = n;
+    return true;
+}
+
+bool bra_cm_decode2(bra_cm_t* cm, const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_size)
+{
+    assert(cm != NULL);
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+
+    if (buf_size < BRA_CM_FLUSH)
+        return false;
+
+    _bra_cm_reset(cm);
+
+    uint32_t x1 = 0;
+    uint32_t x2 = 0xFFFFFFFFU;
+    uint32_t x  = 0;
+    size_t   n  = 0;
+    for (; n < BRA_CM_FLUSH; ++n)
+        x = (x << 8) | buf[n];
+
+    for (size_t i = 0; i < out_size; ++i)
+    {
+        uint32_t c = 0;
+        for (int b = 0; b < 8; ++b)
+        {
+            const uint32_t xmid = x1 + ((x2 - x1) >> 12) * (uint32_t) _bra_cm_predict(cm);
+            const int      y    = x <= xmid;
+            if (y)
+                x2 = xmid;
+            else
+                x1 = xmid + 1;
+            _bra_cm_update(cm, y);
+            c = (c << 1) | (uint32_t) y;
+
+            while (((x1 ^ x2) & BRA_CM_TOP) == 0)
+            {
+                // the encoder wrote as many bytes as read here.
+                if (n == buf_size)
+                    return false;
+
+                x1 <<= 8;
+                x2   = (x2 << 8) | 0xFF;
+                x    = (x << 8) | buf[n++];
+            }
+        }
+
+        out_buf[i] = (uint8_t) c;
+    }
+
+    return n == buf_size;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <lib_bra_types.h>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Allocate a context mixing model, for @ref bra_cm_encode2 and @ref bra_cm_decode2.
+ *
+ * @return bra_cm_t* @c NULL on allocation failure, to be freed with @ref bra_cm_destroy.
+ */
+bra_cm_t* bra_cm_create(void);
+
+/**
+ * @brief Free the @p cm model and set it to @c NULL.
+ *
+ * @param cm
+ */
+void bra_cm_destroy(bra_cm_t** cm);
+
+/**
+ * @brief Encode @p buf with an adaptive binary arithmetic coder, the slowest and strongest entropy stage.
+ *
+ * Meant for the BWT output directly, without MTF: its bytes keep their identity as contexts.
+ * Each byte is coded bit by bit, most significant first. The probability of each bit is
+ * predicted by the bits already coded of the current byte in several contexts:
+ *  - order-0 and order-1, each with a fast and a slow adapting counter.
+ *  - order-2, hashed.
+ *  - the run length of the previous byte.
+ *
+ * A logistic mixer weights the predictions, then it is refined by the bits of the current byte.
+ * The model is reset at each call: the encoded chunks are independent.
+ *
+ * @param cm           work model, from @ref bra_cm_create.
+ * @param buf          the buffer to encode.
+ * @param buf_size     the buffer size in bytes.
+ * @param out_buf      the encoded data.
+ * @param out_buf_size capacity of @p out_buf in bytes.
+ * @param out_size     encoded size in bytes.
+ * @retval true  on success.
+ * @retval false if @p out_buf is too small.
+ */
+bool bra_cm_encode2(bra_cm_t* cm, const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
+
+/**
+ * @brief Decode @ref bra_cm_encode2 data in a caller provided buffer.
+ *
+ * @param cm       work model, from @ref bra_cm_create.
+ * @param buf      encoded data.
+ * @param buf_size encoded size in bytes.
+ * @param out_buf  decoded data.
+ * @param out_size the decoded size in bytes, known from the chunk header.
+ * @retval true  on success.
+ * @retval false on corrupted data: reading past the end of @p buf.
+ */
+bool bra_cm_decode2(bra_cm_t* cm, const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_size);
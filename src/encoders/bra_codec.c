@@ -0,0 +1,87 @@
+#include <encoders/bra_codec.h>
+#include <encoders/bra_cm.h>
+#include <lib_bra_defs.h>
+
+#include <log/bra_log.h>
+
+#include <assert.h>
+#include <stdlib.h>
+
+void bra_codec_ctx_init(bra_codec_ctx_t* codec)
+{
+    assert(codec != NULL);
+
+    codec->buf         = NULL;
+    codec->buf2        = NULL;
+    codec->buf_trans   = NULL;
+    codec->level       = BRA_COMP_LEVEL_DEFAULT;
+    codec->solid       = NULL;
+    codec->solid_size  = 0;
+    codec->solid_block = 0;
+    codec->cm          = NULL;
+}
+
+bool bra_codec_ctx_reserve(bra_codec_ctx_t* codec)
+{
+    assert(codec != NULL);
+
+    if (codec->buf == NULL)
+        codec->buf = malloc(sizeof(uint8_t) * BRA_CODEC_BUF_SIZE);
+    if (codec->buf2 == NULL)
+        codec->buf2 = malloc(sizeof(uint8_t) * BRA_CODEC_BUF_SIZE);
+    if (codec->buf_trans == NULL)
+        codec->buf_trans = malloc(sizeof(bra_bwt_index_t) * BRA_BWT_ENCODE_WORK_SIZE(BRA_MAX_CHUNK_SIZE));
+
+    if (codec->buf == NULL || codec->buf2 == NULL || codec->buf_trans == NULL)
+    {
+        bra_log_critical("unable to allocate codec buffers");
+        return false;
+    }
+
+    return true;
+}
+
+bool bra_codec_ctx_reserve_solid(bra_codec_ctx_t* codec)
+{
+    assert(codec != NULL);
+
+    if (codec->solid == NULL)
+        codec->solid = malloc(sizeof(uint8_t) * BRA_MAX_CHUNK_SIZE);
+
+    if (codec->solid == NULL)
+    {
+        bra_log_critical("unable to allocate solid block buffer");
+        return false;
+    }
+
+    return true;
+}
+
+bool bra_codec_ctx_reserve_cm(bra_codec_ctx_t* codec)
+{
+    assert(codec != NULL);
+
+    if (codec->cm == NULL)
+        codec->cm = bra_cm_create();
+
+    if (codec->cm == NULL)
+    {
+        bra_log_critical("unable to allocate context mixing model");
+        return false;
+    }
+
+    return true;
+}
+
+void bra_codec_ctx_free(bra_codec_ctx_t* codec)
+{
+    assert(codec != NULL);
+
+    free(codec->buf);
+    free(codec->buf2);
+    free(codec->buf_trans);
+    free(codec->solid);
+    if (codec->cm != NULL)
+        bra_cm_destroy(&codec->cm);
+    bra_codec_ctx_init(codec);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <lib_bra_types.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Initialize an empty codec context. No memory is allocated until @ref bra_codec_ctx_reserve.
+ *
+ * @param codec
+ */
+void bra_codec_ctx_init(bra_codec_ctx_t* codec);
+
+/**
+ * @brief Allocate the work buffers of @p codec if not already done.
+ *        Then the chunk codec runs without any other allocation.
+ *
+ * @param codec
+ * @retval true
+ * @retval false on allocation failure.
+ */
+bool bra_codec_ctx_reserve(bra_codec_ctx_t* codec);
+
+/**
+ * @brief Allocate the solid block buffer of @p codec if not already done.
+ *
+ * @param codec
+ * @retval true
+ * @retval false on allocation failure.
+ */
+bool bra_codec_ctx_reserve_solid(bra_codec_ctx_t* codec);
+
+/**
+ * @brief Allocate the context mixing model of @p codec if not already done.
+ *
+ * @param codec
+ * @retval true
+ * @retval false on allocation failure.
+ */
+bool bra_codec_ctx_reserve_cm(bra_codec_ctx_t* codec);
+
+/**
+ * @brief Release the work buffers of @p codec.
+ *
+ * @note Idempotent: the context is left empty and can be reused.
+ *
+ * @param codec
+ */
+void bra_codec_ctx_free(bra_codec_ctx_t* codec);
+
+/**
+ * @brief Create an empty pool of codec contexts.
+ *
+ * @return bra_codec_pool_t* @c NULL on allocation failure.
+ */
+bra_codec_pool_t* bra_codec_pool_create(void);
+
+/**
+ * @brief Destroy @p pool and all its contexts. The contexts must have been released.
+ *
+ * @param pool set to @c NULL.
+ */
+void bra_codec_pool_destroy(bra_codec_pool_t** pool);
+
+/**
+ * @brief Take an idle context from @p pool, or create a new one.
+ *        The buffers of a released context are kept for the next owner.
+ *
+ * @note Thread safe.
+ *
+ * @param pool
+ * @return bra_codec_ctx_t* @c NULL on allocation failure.
+ */
+bra_codec_ctx_t* bra_codec_pool_acquire(bra_codec_pool_t* pool);
+
+/**
+ * @brief Give back @p codec, obtained from @ref bra_codec_pool_acquire, to @p pool.
+ *
+ * @note Thread safe.
+ *
+ * @param pool
+ * @param codec
+ */
+void bra_codec_pool_release(bra_codec_pool_t* pool, bra_codec_ctx_t* codec);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,90 @@
+#include <encoders/bra_codec.h>
+
+#include <log/bra_log.h>
+
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace
+{
+
+struct codec_ctx_deleter
+{
+    void operator()(bra_codec_ctx_t* codec) const noexcept
+    {
+        bra_codec_ctx_free(codec);
+        delete codec;
+    }
+};
+
+}    // namespace
+
+/**
+ * @brief Pool of codec contexts: the owned contexts and the idle ones.
+ */
+struct bra_codec_pool_t
+{
+    std::mutex                                                       mutex;
+    std::vector<std::unique_ptr<bra_codec_ctx_t, codec_ctx_deleter>> contexts;    //!< all the contexts created.
+    std::vector<bra_codec_ctx_t*>                                    idle;        //!< contexts not acquired.
+};
+
+bra_codec_pool_t* bra_codec_pool_create(void)
+{
+    return new (std::nothrow) bra_codec_pool_t();
+}
+
+void bra_codec_pool_destroy(bra_codec_pool_t** pool)
+{
+    assert(pool != nullptr);
+
+    if (*pool == nullptr)
+        return;
+
+    assert((*pool)->idle.size() == (*pool)->contexts.size());
+    delete *pool;
+    *pool = nullptr;
+}
+
+bra_codec_ctx_t* bra_codec_pool_acquire(bra_codec_pool_t* pool)
+{
+    assert(pool != nullptr);
+
+    const std::lock_guard lock(pool->mutex);
+    if (!pool->idle.empty())
+    {
+        bra_codec_ctx_t* codec = pool->idle.back();
+        pool->idle.pop_back();
+        return codec;
+    }
+
+    try
+    {
+        std::unique_ptr<bra_codec_ctx_t, codec_ctx_deleter> codec(new bra_codec_ctx_t);
+        bra_codec_ctx_init(codec.get());
+
+        // reserve first: release can't fail.
+        pool->idle.reserve(pool->contexts.size() + 1);
+        pool->contexts.push_back(std::move(codec));
+        return pool->contexts.back().get();
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_critical("unable to create a codec context: %s", e.what());
+        return nullptr;
+    }
+}
+
+void bra_codec_pool_release(bra_codec_pool_t* pool, bra_codec_ctx_t* codec)
+{
+    assert(pool != nullptr);
+
+    if (codec == nullptr)
+        return;
+
+    const std::lock_guard lock(pool->mutex);
+    pool->idle.push_back(codec);
+}
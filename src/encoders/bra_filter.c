@@ -0,0 +1,361 @@
+#include <encoders/bra_filter.h>
+
+#include <lib_bra_defs.h>
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define BRA_FILTER_SAMPLE_SIZE (64 * 1024)    //!< bytes of a chunk measured to select its filter.
+#define BRA_FILTER_MIN_SIZE    (4 * 1024)     //!< smaller chunks are not filtered.
+#define BRA_FILTER_X86_OP_SIZE 5              //!< E8/E9 opcode and its 4 bytes displacement.
+#define BRA_FILTER_X86_MASK    0x1FFFFFFU     //!< the displacements converted are 25 bits signed: their upper byte is 0x00 or 0xFF.
+#define BRA_FILTER_LONG_RUN    64             //!< runs of equal bytes from this length make a filter output degenerate.
+
+static inline uint16_t _bra_filter_read16(const uint8_t* p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t _bra_filter_read32(const uint8_t* p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline unsigned _bra_filter_log2i(const uint32_t v)
+{
+    assert(v != 0);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanReverse(&i, v);
+    return (unsigned) i;
+#else
+    return 31U - (unsigned) __builtin_clz(v);
+#endif
+}
+
+/**
+ * @brief @p n * log2(@p n) in 16 bits fixed point, the fraction linearly interpolated.
+ */
+static inline uint64_t _bra_filter_nlog2(const uint32_t n)
+{
+    if (n <= 1)
+        return 0;
+
+    const unsigned k = _bra_filter_log2i(n);
+    return (uint64_t) n * (((uint64_t) k << 16) + ((((uint64_t) n << 16) >> k) - (1U << 16)));
+}
+
+/**
+ * @brief Order-1 entropy, in 16 bits fixed point, of the byte pairs in @p counts.
+ */
+static uint64_t _bra_filter_cost(const uint32_t* counts)
+{
+    uint64_t bits = 0;
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        const uint32_t* row = &counts[c << 8];
+        uint32_t        n   = 0;
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            if (row[i] == 0)
+                continue;
+
+            n    += row[i];
+            bits -= _bra_filter_nlog2(row[i]);
+        }
+
+        bits += _bra_filter_nlog2(n);
+    }
+
+    return bits;
+}
+
+/**
+ * @brief Order-0 entropy, in 16 bits fixed point, of the second bytes of the pairs in @p counts.
+ */
+static uint64_t _bra_filter_cost0(const uint32_t* counts)
+{
+    uint32_t totals[256] = {0};
+    for (unsigned c = 0; c < 256; ++c)
+    {
+        const uint32_t* row = &counts[c << 8];
+        for (unsigned i = 0; i < 256; ++i)
+            totals[i] += row[i];
+    }
+
+    uint64_t bits = 0;
+    uint32_t n    = 0;
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        n    += totals[i];
+        bits -= _bra_filter_nlog2(totals[i]);
+    }
+
+    return bits + _bra_filter_nlog2(n);
+}
+
+/**
+ * @brief Count the byte pairs of the filter output in @p counts, one byte at a time.
+ *
+ * @return size_t the output bytes in runs of at least #BRA_FILTER_LONG_RUN equal bytes so far.
+ */
+static inline size_t _bra_filter_count(uint32_t* counts, const uint8_t cur, uint8_t* prev, size_t* run, size_t runs)
+{
+    ++counts[(*prev << 8) | cur];
+    if (cur == *prev)
+        ++*run;
+    else
+    {
+        if (*run >= BRA_FILTER_LONG_RUN)
+            runs += *run;
+        *run = 1;
+    }
+
+    *prev = cur;
+    return runs;
+}
+
+/**
+ * @brief Count the byte pairs of the delta output in @p counts.
+ *
+ * @return size_t the output bytes in long runs.
+ */
+static size_t _bra_filter_count_delta(const uint8_t* buf, const size_t buf_size, const unsigned stride, uint32_t* counts)
+{
+    memset(counts, 0, BRA_FILTER_COUNTS_SIZE * sizeof(uint32_t));
+    uint8_t prev = 0;
+    size_t  run  = 0;
+    size_t  runs = 0;
+    for (size_t i = 0; i < buf_size; ++i)
+        runs = _bra_filter_count(counts, i < stride ? buf[i] : (uint8_t) (buf[i] - buf[i - stride]), &prev, &run, runs);
+
+    return run >= BRA_FILTER_LONG_RUN ? runs + run : runs;
+}
+
+/**
+ * @brief Count the byte pairs of the transposition output in @p counts, the bytes as they are with @p stride 1.
+ *
+ * @return size_t the output bytes in long runs.
+ */
+static size_t _bra_filter_count_transpose(const uint8_t* buf, const size_t buf_size, const unsigned stride, uint32_t* counts)
+{
+    memset(counts, 0, BRA_FILTER_COUNTS_SIZE * sizeof(uint32_t));
+    const size_t n    = buf_size / stride;
+    uint8_t      prev = 0;
+    size_t       run  = 0;
+    size_t       runs = 0;
+    for (unsigned j = 0; j < stride; ++j)
+    {
+        for (size_t r = 0; r < n; ++r)
+            runs = _bra_filter_count(counts, buf[r * stride + j], &prev, &run, runs);
+    }
+
+    return run >= BRA_FILTER_LONG_RUN ? runs + run : runs;
+}
+
+/**
+ * @brief Convert the E8/E9 displacements with the upper byte 0x00 or 0xFF, from relative to absolute when @p encode.
+ *        Each opcode skips its displacement, converted or not: no conversion changes the bytes examined
+ *        for an earlier one, so decoding finds the same opcodes and upper bytes.
+ */
+static void _bra_filter_x86(uint8_t* buf, const size_t buf_size, const bool encode)
+{
+    for (size_t i = 0; i + BRA_FILTER_X86_OP_SIZE <= buf_size;)
+    {
+        if ((buf[i] & 0xFE) != 0xE8)
+        {
+            ++i;
+            continue;
+        }
+
+        if (buf[i + 4] != 0x00 && buf[i + 4] != 0xFF)
+        {
+            i += BRA_FILTER_X86_OP_SIZE;
+            continue;
+        }
+
+        const uint32_t pos = (uint32_t) (i + BRA_FILTER_X86_OP_SIZE);
+        uint32_t       v   = _bra_filter_read32(&buf[i + 1]) & BRA_FILTER_X86_MASK;
+        v                  = (encode ? v + pos : v - pos) & BRA_FILTER_X86_MASK;
+        buf[i + 1]         = (uint8_t) v;
+        buf[i + 2]         = (uint8_t) (v >> 8);
+        buf[i + 3]         = (uint8_t) (v >> 16);
+        buf[i + 4]         = (v >> 24) != 0 ? 0xFF : 0x00;
+        i                 += BRA_FILTER_X86_OP_SIZE;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool bra_filter_is_x86(const uint8_t* buf, const size_t buf_size)
+{
+    assert(buf != NULL);
+
+    enum
+    {
+        ELF_MACHINE       = 18,        // e_machine
+        ELF_MACHINE_386   = 3,         // EM_386
+        ELF_MACHINE_X64   = 62,        // EM_X86_64
+        PE_OFFSET         = 0x3C,      // e_lfanew
+        PE_MACHINE_386    = 0x014C,    // IMAGE_FILE_MACHINE_I386
+        PE_MACHINE_X64    = 0x8664,    // IMAGE_FILE_MACHINE_AMD64
+        PE_SIGNATURE_SIZE = 4,         // "PE\0\0"
+    };
+
+    if (buf_size >= ELF_MACHINE + 2 && buf[0] == 0x7F && buf[1] == 'E' && buf[2] == 'L' && buf[3] == 'F')
+    {
+        const uint16_t m = _bra_filter_read16(&buf[ELF_MACHINE]);
+        return m == ELF_MACHINE_386 || m == ELF_MACHINE_X64;
+    }
+
+    if (buf_size >= PE_OFFSET + 4 && buf[0] == 'M' && buf[1] == 'Z')
+    {
+        const uint32_t pe = _bra_filter_read32(&buf[PE_OFFSET]);
+        if (pe > buf_size - PE_SIGNATURE_SIZE - 2 || memcmp(&buf[pe], "PE\0\0", PE_SIGNATURE_SIZE) != 0)
+            return false;
+
+        const uint16_t m = _bra_filter_read16(&buf[pe + PE_SIGNATURE_SIZE]);
+        return m == PE_MACHINE_386 || m == PE_MACHINE_X64;
+    }
+
+    return false;
+}
+
+uint8_t bra_filter_select(const uint8_t* buf, const size_t buf_size, uint32_t* counts)
+{
+    assert(buf != NULL);
+    assert(counts != NULL);
+
+    if (buf_size < BRA_FILTER_MIN_SIZE)
+        return BRA_FILTER_NONE;
+
+    // records of 1 byte: the bytes as they are.
+    const size_t   s     = buf_size < BRA_FILTER_SAMPLE_SIZE ? buf_size : BRA_FILTER_SAMPLE_SIZE;
+    const size_t   runs  = _bra_filter_count_transpose(buf, s, 1, counts);
+    uint64_t       best  = _bra_filter_cost(counts);
+    const uint64_t best0 = _bra_filter_cost0(counts);
+    uint8_t        res   = BRA_FILTER_NONE;
+
+    // worth only when clearly better: the BWT already exploits the longer contexts.
+    // Nor when the output degenerates in long runs, the slowest to sort for the BWT.
+    const uint64_t limit    = best - best / 8;
+    const size_t   max_runs = runs > s / 2 ? runs : s / 2;
+    for (unsigned stride = 1; stride <= BRA_FILTER_MAX_STRIDE; ++stride)
+    {
+        // the delta of text lowers only its order-1 entropy, with the runs of spaces: sampled data lowers also the order-0 one.
+        if (_bra_filter_count_delta(buf, s, stride, counts) <= max_runs)
+        {
+            const uint64_t d = _bra_filter_cost(counts);
+            if (d < best && d < limit && _bra_filter_cost0(counts) < best0)
+            {
+                best = d;
+                res  = BRA_FILTER_SET(BRA_FILTER_DELTA, stride);
+            }
+        }
+
+        if (stride == 1 || _bra_filter_count_transpose(buf, s, stride, counts) > max_runs)
+            continue;
+
+        const uint64_t t = _bra_filter_cost(counts);
+        if (t < best && t < limit)
+        {
+            best = t;
+            res  = BRA_FILTER_SET(BRA_FILTER_TRANSPOSE, stride);
+        }
+    }
+
+    return res;
+}
+
+void bra_filter_encode(const uint8_t filter, uint8_t* buf, const size_t buf_size, uint8_t* tmp)
+{
+    assert(buf != NULL);
+    assert(filter == BRA_FILTER_NONE || bra_filter_validate(filter));
+
+    const unsigned stride = BRA_FILTER_STRIDE(filter);
+    switch (BRA_FILTER_TYPE(filter))
+    {
+    case BRA_FILTER_DELTA:
+        for (size_t i = buf_size; i-- > stride;)
+            buf[i] = (uint8_t) (buf[i] - buf[i - stride]);
+        break;
+    case BRA_FILTER_X86:
+        _bra_filter_x86(buf, buf_size, true);
+        break;
+    case BRA_FILTER_TRANSPOSE:
+    {
+        assert(tmp != NULL);
+        const size_t n = buf_size / stride;
+        for (unsigned j = 0; j < stride; ++j)
+        {
+            for (size_t r = 0; r < n; ++r)
+                tmp[j * n + r] = buf[r * stride + j];
+        }
+
+        // the last partial record is left as it is.
+        memcpy(buf, tmp, n * stride);
+    }
+    break;
+    default:
+        break;
+    }
+}
+
+bool bra_filter_decode(const uint8_t filter, uint8_t* buf, const size_t buf_size, uint8_t* tmp)
+{
+    assert(buf != NULL);
+
+    if (filter == BRA_FILTER_NONE)
+        return true;
+    if (!bra_filter_validate(filter))
+        return false;
+
+    const unsigned stride = BRA_FILTER_STRIDE(filter);
+    switch (BRA_FILTER_TYPE(filter))
+    {
+    case BRA_FILTER_DELTA:
+        for (size_t i = stride; i < buf_size; ++i)
+            buf[i] = (uint8_t) (buf[i] + buf[i - stride]);
+        break;
+    case BRA_FILTER_X86:
+        _bra_filter_x86(buf, buf_size, false);
+        break;
+    case BRA_FILTER_TRANSPOSE:
+    {
+        assert(tmp != NULL);
+        const size_t n = buf_size / stride;
+        for (unsigned j = 0; j < stride; ++j)
+        {
+            for (size_t r = 0; r < n; ++r)
+                tmp[r * stride + j] = buf[j * n + r];
+        }
+
+        memcpy(buf, tmp, n * stride);
+    }
+    break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+bool bra_filter_validate(const uint8_t filter)
+{
+    switch (BRA_FILTER_TYPE(filter))
+    {
+    case BRA_FILTER_DELTA:
+        return true;
+    case BRA_FILTER_X86:
+        return BRA_FILTER_STRIDE(filter) == 1;
+    case BRA_FILTER_TRANSPOSE:
+        return BRA_FILTER_STRIDE(filter) > 1;
+    default:
+        return false;
+    }
+}
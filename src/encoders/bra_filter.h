@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BRA_FILTER_COUNTS_SIZE (256 * 256)    //!< elements of the @c counts work buffer of @ref bra_filter_select.
+
+/**
+ * @brief Check if @p buf is the start of an x86 or x86-64 executable: ELF or PE.
+ *        Its chunks are then encoded with #BRA_FILTER_X86.
+ *
+ * @param buf      first bytes of the file.
+ * @param buf_size Size of @p buf in bytes.
+ * @retval true    for an x86 executable.
+ * @retval false   otherwise.
+ */
+bool bra_filter_is_x86(const uint8_t* buf, const size_t buf_size);
+
+/**
+ * @brief Select the filter that makes @p buf most predictable, if any.
+ *
+ * Each candidate, the delta and the transposition filters with strides from 1 to #BRA_FILTER_MAX_STRIDE,
+ * is estimated by the order-1 entropy of its output, without writing it:
+ * the BWT compresses better the data with less surprising byte pairs.
+ * A filter is chosen only when it is clearly better than none.
+ *
+ * @param buf      chunk to be encoded.
+ * @param buf_size Size of @p buf in bytes.
+ * @param counts   work buffer of #BRA_FILTER_COUNTS_SIZE elements.
+ * @return uint8_t the filter byte, #BRA_FILTER_NONE when none helps.
+ */
+uint8_t bra_filter_select(const uint8_t* buf, const size_t buf_size, uint32_t* counts);
+
+/**
+ * @brief Apply @p filter to @p buf in place.
+ *
+ * @param filter   filter byte, see #BRA_FILTER_SET.
+ * @param buf      Buffer to filter.
+ * @param buf_size Size of @p buf in bytes.
+ * @param tmp      work buffer of @p buf_size bytes, for the transposition.
+ */
+void bra_filter_encode(const uint8_t filter, uint8_t* buf, const size_t buf_size, uint8_t* tmp);
+
+/**
+ * @brief Revert @ref bra_filter_encode on @p buf in place.
+ *
+ * @param filter   filter byte read from the chunk header.
+ * @param buf      Buffer to restore.
+ * @param buf_size Size of @p buf in bytes.
+ * @param tmp      work buffer of @p buf_size bytes, for the transposition.
+ * @retval true    on success.
+ * @retval false   if @p filter is not valid.
+ */
+bool bra_filter_decode(const uint8_t filter, uint8_t* buf, const size_t buf_size, uint8_t* tmp);
+
+/**
+ * @brief Check if @p filter is a valid filter byte, other than #BRA_FILTER_NONE.
+ *
+ * @param filter
+ * @retval true
+ * @retval false
+ */
+bool bra_filter_validate(const uint8_t filter);
@@ -6,228 +6,223 @@
 #include <string.h>
 #include <assert.h>
 
+#define BRA_HUFFMAN_MAX_NODES       (2 * BRA_ALPHABET_SIZE - 1)    //!< leaves and internal nodes of a full tree.
+#define BRA_HUFFMAN_MAX_CODE_LENGTH 32                             //!< longest code fitting in a uint32_t; a chunk can't reach it.
+
+#define BRA_HUFFMAN_MULTI_MAX_TABLES      6                                                                     //!< max number of tables of a multi-table stream.
+#define BRA_HUFFMAN_MULTI_GROUP_SIZE      50                                                                    //!< consecutive symbols coded with the same table.
+#define BRA_HUFFMAN_MULTI_ITERATIONS      4                                                                     //!< table optimisation passes.
+#define BRA_HUFFMAN_MULTI_MAX_CODE_LENGTH 17                                                                    //!< code length limit of the multi-table codes, it must fit the 5 bits start length.
+#define BRA_HUFFMAN_MULTI_MAX_SELECTORS   ((BRA_CODEC_BUF_SIZE + BRA_HUFFMAN_MULTI_GROUP_SIZE - 1) / BRA_HUFFMAN_MULTI_GROUP_SIZE)    //!< selectors of the longest stream.
+#define BRA_HUFFMAN_MULTI_LESSER_COST     0                                                                     //!< initial code length of the symbols assigned to a table.
+#define BRA_HUFFMAN_MULTI_GREATER_COST    15                                                                    //!< initial code length of the other symbols.
+#define BRA_HUFFMAN_MULTI_SHORT_SIZE      600                                                                   //!< streams shorter than this try a single table too.
+
 /**
- * @brief bra_huffman_node_t
+ * @brief Huffman tree built in a fixed pool: the children are always created before their parent.
  */
-typedef struct bra_huffman_node_t
+typedef struct bra_huffman_tree_t
 {
-    uint8_t                    symbol;    //!< symbol
-    uint32_t                   freq;      //!< max 4GB for 1 symbol
-    struct bra_huffman_node_t* left;      //!< left branch of the tree
-    struct bra_huffman_node_t* right;     //!< right branch of the tree
-} bra_huffman_node_t;
+    uint32_t freq[BRA_HUFFMAN_MAX_NODES];      //!< node frequency
+    uint16_t parent[BRA_HUFFMAN_MAX_NODES];    //!< parent node index
+    uint8_t  symbol[BRA_ALPHABET_SIZE];        //!< symbol of each leaf, the leaves are the first nodes.
+    uint16_t num_leaves;                       //!< number of leaves
+    uint16_t num_nodes;                        //!< number of nodes, the root is the last one.
+} bra_huffman_tree_t;
 
 /**
- * @brief minHeapNode_t
+ * @brief Canonical decoding table.
  */
-typedef struct minHeapNode_t
+typedef struct bra_huffman_decode_table_t
 {
-    bra_huffman_node_t*   node;    //!< node
-    struct minHeapNode_t* next;    //!< next
-} minHeapNode_t;
-
-///////////////////////////////////////////////////////////////////////////////
+    uint32_t count[BRA_HUFFMAN_MAX_CODE_LENGTH + 1];     //!< number of codes per length
+    uint32_t first[BRA_HUFFMAN_MAX_CODE_LENGTH + 1];     //!< first canonical code per length
+    uint32_t offset[BRA_HUFFMAN_MAX_CODE_LENGTH + 1];    //!< index in @p symbols of the first code per length
+    uint8_t  symbols[BRA_ALPHABET_SIZE];                 //!< symbols sorted by code length, then by value
+    uint8_t  max_length;                                 //!< longest code length
+} bra_huffman_decode_table_t;
 
-static bra_huffman_node_t* bra_huffman_create_node(const uint8_t symbol, const uint32_t freq)
+/**
+ * @brief MSB first bit writer with a bounded output.
+ */
+typedef struct bra_huffman_bit_writer_t
 {
-    bra_huffman_node_t* node = malloc(sizeof(bra_huffman_node_t));
-    if (node == NULL)
-    {
-        bra_log_error("unable to alloc huffman node");
-        return NULL;
-    }
+    uint8_t*       p;           //!< next output byte
+    const uint8_t* end;         //!< end of the output buffer
+    uint64_t       acc;         //!< pending bits, the lowest @p acc_bits ones.
+    int            acc_bits;    //!< number of pending bits
+    bool           overflow;    //!< the output buffer is too small
+} bra_huffman_bit_writer_t;
 
-    node->symbol = symbol;
-    node->freq   = freq;
-    node->left = node->right = NULL;
+/**
+ * @brief MSB first bit reader with a bounded input.
+ */
+typedef struct bra_huffman_bit_reader_t
+{
+    const uint8_t* data;          //!< input data
+    uint64_t       total_bits;    //!< input size in bits
+    uint64_t       pos;           //!< next bit to read
+} bra_huffman_bit_reader_t;
 
-    return node;
-}
+///////////////////////////////////////////////////////////////////////////////
 
-static void bra_huffman_tree_free(bra_huffman_node_t** node)
+static inline void bra_huffman_bits_put(bra_huffman_bit_writer_t* bw, const uint32_t value, const int n)
 {
-    assert(node != NULL);
+    assert(bw != NULL);
+    assert(n > 0 && n <= 32);
 
-    if (*node == NULL)
+    if (bw->overflow)
         return;
 
-    bra_huffman_tree_free(&(*node)->left);
-    bra_huffman_tree_free(&(*node)->right);
-    free(*node);
-    *node = NULL;
-}
-
-static minHeapNode_t* bra_minHeapNode_create(bra_huffman_node_t* node)
-{
-    assert(node != NULL);
-
-    minHeapNode_t* mhn = malloc(sizeof(minHeapNode_t));
-    if (mhn == NULL)
-        return NULL;
+    bw->acc       = (bw->acc << n) | value;
+    bw->acc_bits += n;
+    while (bw->acc_bits >= 8)
+    {
+        if (bw->p == bw->end)
+        {
+            bw->overflow = true;
+            return;
+        }
 
-    mhn->node = node;
-    mhn->next = NULL;
-    return mhn;
+        bw->acc_bits -= 8;
+        *bw->p++      = (uint8_t) (bw->acc >> bw->acc_bits);
+    }
 }
 
-static bra_huffman_node_t* bra_minHeap_extractMin(minHeapNode_t** head)
+static inline void bra_huffman_bits_flush(bra_huffman_bit_writer_t* bw)
 {
-    assert(head != NULL);
+    assert(bw != NULL);
 
-    if (*head == NULL)
-    {
-        bra_log_error("minHeap head is null");
-        return NULL;
-    }
-
-    minHeapNode_t* tmp       = *head;
-    *head                    = (*head)->next;
-    bra_huffman_node_t* node = tmp->node;
-    free(tmp);
-    return node;
+    if (!bw->overflow && bw->acc_bits > 0)
+        bra_huffman_bits_put(bw, 0, 8 - bw->acc_bits);
 }
 
-static bool bra_minHeap_insert(minHeapNode_t** head, bra_huffman_node_t* node)
+static inline bool bra_huffman_bits_get(bra_huffman_bit_reader_t* br, const int n, uint32_t* value)
 {
-    assert(head != NULL);
-    assert(node != NULL);
+    assert(br != NULL);
+    assert(value != NULL);
 
-    minHeapNode_t* new_node = bra_minHeapNode_create(node);
-    if (new_node == NULL)
-    {
-        bra_log_error("unable to create huffman new node");
+    if (br->total_bits - br->pos < (uint64_t) n)
         return false;
-    }
 
-    if (*head == NULL || (*head)->node->freq > node->freq)
-    {
-        new_node->next = *head;
-        *head          = new_node;
-        return true;
-    }
+    uint32_t v = 0;
+    for (int i = 0; i < n; ++i, ++br->pos)
+        v = (v << 1) | ((br->data[br->pos >> 3] >> (7 - (br->pos & 7))) & 1);
 
-    minHeapNode_t* cur = *head;
-    while (cur->next != NULL && cur->next->node->freq < node->freq)
-    {
-        cur = cur->next;
-    }
-
-    new_node->next = cur->next;
-    cur->next      = new_node;
+    *value = v;
     return true;
 }
 
-static void bra_minHeap_clear(minHeapNode_t** head)
+/**
+ * @brief Insert @p node in the list @p queue sorted by frequency.
+ *        Ties are placed as the previous linked list min-heap did, so the code lengths don't change.
+ */
+static void bra_huffman_queue_insert(const bra_huffman_tree_t* tree, uint16_t* queue, uint16_t* queue_size, const uint16_t node)
 {
-    if (head == NULL)
-        return;
+    const uint32_t f   = tree->freq[node];
+    uint16_t       pos = 0;
+    while (pos < *queue_size && tree->freq[queue[pos]] < f)
+        ++pos;
 
-    while (*head != NULL)
-    {
-        bra_huffman_node_t* n = bra_minHeap_extractMin(head);
-        bra_huffman_tree_free(&n);
-    }
+    if (pos == 0 && *queue_size > 0 && tree->freq[queue[0]] == f)
+        pos = 1;
+
+    memmove(&queue[pos + 1], &queue[pos], (*queue_size - pos) * sizeof(uint16_t));
+    queue[pos] = node;
+    ++*queue_size;
 }
 
-static bra_huffman_node_t* bra_huffman_tree_build(uint32_t freq[BRA_ALPHABET_SIZE])
+static bool bra_huffman_tree_build(bra_huffman_tree_t* tree, const uint32_t freq[BRA_ALPHABET_SIZE])
 {
+    assert(tree != NULL);
     assert(freq != NULL);
 
-    bra_huffman_node_t* n       = NULL;
-    bra_huffman_node_t* l       = NULL;
-    bra_huffman_node_t* r       = NULL;
-    minHeapNode_t*      minHeap = NULL;
+    uint16_t queue[BRA_ALPHABET_SIZE];
+    uint16_t queue_size = 0;
+
+    tree->num_leaves = 0;
     for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
     {
         if (freq[i] > 0)
         {
-            n = bra_huffman_create_node(i, freq[i]);
-            if (n == NULL)
-                goto BRA_HUFFMAN_TREE_BUILD_ERROR;
-
-            if (!bra_minHeap_insert(&minHeap, n))
-                goto BRA_HUFFMAN_TREE_BUILD_ERROR;
-
-            n = NULL;
+            const uint16_t n = tree->num_leaves++;
+            tree->symbol[n]  = (uint8_t) i;
+            tree->freq[n]    = freq[i];
+            bra_huffman_queue_insert(tree, queue, &queue_size, n);
         }
     }
 
-    if (minHeap == NULL)
-        goto BRA_HUFFMAN_TREE_BUILD_ERROR;
-
-    while (minHeap->next != NULL)
+    tree->num_nodes = tree->num_leaves;
+    if (queue_size == 0)
     {
-        n = NULL;
-        l = bra_minHeap_extractMin(&minHeap);
-        r = bra_minHeap_extractMin(&minHeap);
-        if (l == NULL || r == NULL)
-            goto BRA_HUFFMAN_TREE_BUILD_ERROR;
-
-        n = bra_huffman_create_node(0, l->freq + r->freq);
-        if (n == NULL)
-            goto BRA_HUFFMAN_TREE_BUILD_ERROR;
-
-        n->left  = l;
-        n->right = r;
-        l = r = NULL;
-        if (!bra_minHeap_insert(&minHeap, n))
-            goto BRA_HUFFMAN_TREE_BUILD_ERROR;
+        bra_log_error("unable to build huffman tree");
+        return false;
     }
 
-    return bra_minHeap_extractMin(&minHeap);
+    while (queue_size > 1)
+    {
+        const uint16_t l = queue[0];
+        const uint16_t r = queue[1];
+        queue_size      -= 2;
+        memmove(&queue[0], &queue[2], queue_size * sizeof(uint16_t));
+
+        const uint16_t n = tree->num_nodes++;
+        tree->freq[n]    = tree->freq[l] + tree->freq[r];
+        tree->parent[l]  = n;
+        tree->parent[r]  = n;
+        bra_huffman_queue_insert(tree, queue, &queue_size, n);
+    }
 
-BRA_HUFFMAN_TREE_BUILD_ERROR:
-    bra_log_error("unable to build huffman tree");
-    bra_huffman_tree_free(&n);
-    bra_huffman_tree_free(&l);
-    bra_huffman_tree_free(&r);
-    bra_minHeap_clear(&minHeap);
-    return NULL;
+    return true;
 }
 
-static void bra_huffman_generate_codes(bra_huffman_node_t* root, uint8_t codes[BRA_ALPHABET_SIZE][BRA_ALPHABET_SIZE], uint8_t lengths[BRA_ALPHABET_SIZE], uint8_t code[BRA_ALPHABET_SIZE], int len)
+/**
+ * @brief Code length of each symbol: the depth of its leaf.
+ */
+static bool bra_huffman_tree_lengths(const bra_huffman_tree_t* tree, uint8_t lengths[BRA_ALPHABET_SIZE])
 {
-    assert(codes != NULL);
+    assert(tree != NULL);
     assert(lengths != NULL);
-    assert(code != NULL);
 
-    if (root == NULL)
+    memset(lengths, 0, BRA_ALPHABET_SIZE * sizeof(uint8_t));
+
+    // if only 1 node
+    if (tree->num_leaves == 1)
     {
-        bra_log_warn("unable to generate huffman's codes: huffman tree is null");
-        return;
+        lengths[tree->symbol[0]] = 1;
+        return true;
     }
 
-    // if only 1 node
-    if (root->left == NULL && root->right == NULL)
+    // parents are created after their children: walk from the root down.
+    uint8_t depth[BRA_HUFFMAN_MAX_NODES];
+    depth[tree->num_nodes - 1] = 0;
+    for (int i = tree->num_nodes - 2; i >= 0; --i)
     {
-        if (len == 0)
-        {
-            lengths[root->symbol]  = 1;
-            codes[root->symbol][0] = 0;
-        }
-        else
+        const uint8_t d = depth[tree->parent[i]];
+        if (d >= BRA_HUFFMAN_MAX_CODE_LENGTH)
         {
-            lengths[root->symbol] = len;
-            memcpy(codes[root->symbol], code, len);
+            bra_log_error("huffman code too long");
+            return false;
         }
-        return;
+
+        depth[i] = d + 1;
     }
 
-    code[len] = 0;
-    bra_huffman_generate_codes(root->left, codes, lengths, code, len + 1);
-    code[len] = 1;
-    bra_huffman_generate_codes(root->right, codes, lengths, code, len + 1);
+    for (uint16_t i = 0; i < tree->num_leaves; ++i)
+        lengths[tree->symbol[i]] = depth[i];
+
+    return true;
 }
 
 /**
  * @brief Compute canonical Huffman codes from code lengths
  * @param lengths Input code lengths for each symbol
- * @param codes Output canonical codes (bit arrays)
+ * @param codes Output canonical codes, the lowest @c lengths[i] bits of @c codes[i].
  */
-static void bra_huffman_compute_canonical_codes(const uint8_t lengths[BRA_ALPHABET_SIZE], uint8_t codes[BRA_ALPHABET_SIZE][BRA_ALPHABET_SIZE])
+static void bra_huffman_compute_canonical_codes(const uint8_t lengths[BRA_ALPHABET_SIZE], uint32_t codes[BRA_ALPHABET_SIZE])
 {
     // Count symbols per length
-    uint32_t count[BRA_ALPHABET_SIZE + 1] = {0};
+    uint32_t count[BRA_HUFFMAN_MAX_CODE_LENGTH + 1] = {0};
     for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
     {
         if (lengths[i] > 0)
@@ -237,7 +232,7 @@ static void bra_huffman_compute_canonical_codes(const uint8_t lengths[BRA_ALPHAB
     // Compute starting code for each length
     uint32_t code = 0;
     count[0]      = 0;    // Length 0 not used
-    for (int len = 1; len <= BRA_ALPHABET_SIZE; ++len)
+    for (int len = 1; len <= BRA_HUFFMAN_MAX_CODE_LENGTH; ++len)
     {
         code          <<= 1;
         uint32_t temp   = count[len];
@@ -246,105 +241,290 @@ static void bra_huffman_compute_canonical_codes(const uint8_t lengths[BRA_ALPHAB
     }
 
     // Assign codes to symbols in order
+    for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
+        codes[i] = lengths[i] == 0 ? 0 : count[lengths[i]]++;
+}
+
+static bool bra_huffman_decode_table_build(bra_huffman_decode_table_t* table, const uint8_t lengths[BRA_ALPHABET_SIZE])
+{
+    assert(table != NULL);
+    assert(lengths != NULL);
+
+    memset(table, 0, sizeof(bra_huffman_decode_table_t));
     for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
     {
-        if (lengths[i] == 0)
-            continue;
+        if (lengths[i] > BRA_HUFFMAN_MAX_CODE_LENGTH)
+            return false;
 
-        uint32_t c = count[lengths[i]]++;
-        for (int j = lengths[i] - 1; j >= 0; --j)
+        if (lengths[i] > 0)
         {
-            codes[i][j]   = c & 1;
-            c           >>= 1;
+            ++table->count[lengths[i]];
+            if (lengths[i] > table->max_length)
+                table->max_length = lengths[i];
         }
     }
+
+    if (table->max_length == 0)
+        return false;
+
+    // canonical codes, as bra_huffman_compute_canonical_codes, rejecting an over-subscribed set.
+    uint64_t code  = 0;
+    uint32_t index = 0;
+    for (int len = 1; len <= table->max_length; ++len)
+    {
+        code               <<= 1;
+        table->first[len]    = (uint32_t) code;
+        table->offset[len]   = index;
+        code                += table->count[len];
+        index               += table->count[len];
+        if (code > (1ULL << len))
+            return false;
+    }
+
+    uint32_t next[BRA_HUFFMAN_MAX_CODE_LENGTH + 1];
+    memcpy(next, table->offset, sizeof(next));
+    for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
+    {
+        if (lengths[i] > 0)
+            table->symbols[next[lengths[i]]++] = (uint8_t) i;
+    }
+
+    return true;
 }
 
-static bra_huffman_node_t* bra_huffman_tree_build_from_lengths(const uint8_t lengths[BRA_ALPHABET_SIZE])
+/**
+ * @brief Code lengths of the first @p alpha_size symbols, all of them get a code, limited to @p max_length bits.
+ *        The frequencies are flattened until the longest code fits.
+ */
+static bool bra_huffman_limited_lengths(const uint32_t freq[BRA_ALPHABET_SIZE], const uint16_t alpha_size, const uint8_t max_length, uint8_t lengths[BRA_ALPHABET_SIZE])
 {
+    assert(freq != NULL);
     assert(lengths != NULL);
+    assert(alpha_size > 0 && alpha_size <= BRA_ALPHABET_SIZE);
 
-    // Compute canonical codes
-    uint8_t codes[BRA_ALPHABET_SIZE][BRA_ALPHABET_SIZE];
-    bra_huffman_compute_canonical_codes(lengths, codes);
+    uint32_t f[BRA_ALPHABET_SIZE] = {0};
+    for (uint16_t i = 0; i < alpha_size; ++i)
+        f[i] = freq[i] == 0 ? 1 : freq[i];
 
-    bra_huffman_node_t* n    = NULL;
-    bra_huffman_node_t* root = bra_huffman_create_node(0, 0);
-    if (root == NULL)
-        goto BRA_HUFFMAN_DECODE_ERROR;
+    bra_huffman_tree_t tree;
+    for (;;)
+    {
+        if (!bra_huffman_tree_build(&tree, f) || !bra_huffman_tree_lengths(&tree, lengths))
+            return false;
 
+        uint8_t longest = 0;
+        for (uint16_t i = 0; i < alpha_size; ++i)
+        {
+            if (lengths[i] > longest)
+                longest = lengths[i];
+        }
+
+        if (longest <= max_length)
+            return true;
+
+        for (uint16_t i = 0; i < alpha_size; ++i)
+            f[i] = 1 + f[i] / 2;
+    }
+}
+
+/**
+ * @brief Number of tables of a multi-table stream of @p size symbols, as bzip2.
+ */
+static inline int bra_huffman_multi_num_tables(const uint32_t size)
+{
+    if (size < 200)
+        return 2;
+    if (size < 600)
+        return 3;
+    if (size < 1200)
+        return 4;
+    if (size < 2400)
+        return 5;
+
+    return BRA_HUFFMAN_MULTI_MAX_TABLES;
+}
+
+/**
+ * @brief Multi-table encoding of @p buf with @p num_tables tables.
+ *
+ * @see bra_huffman_encode_multi
+ */
+static bool bra_huffman_multi_encode_tables(const uint8_t* buf, const uint32_t buf_size, const int num_tables, uint8_t* out_buf, const uint32_t out_buf_size, uint32_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+    assert(buf_size > 0 && buf_size <= BRA_CODEC_BUF_SIZE);
+    assert(num_tables > 0 && num_tables <= BRA_HUFFMAN_MULTI_MAX_TABLES);
+
+    // 1. symbols in use, the tables cover only them: dense index and frequency.
+    bool in_use[BRA_ALPHABET_SIZE] = {false};
+    for (uint32_t i = 0; i < buf_size; ++i)
+        in_use[buf[i]] = true;
+
+    uint8_t  seq[BRA_ALPHABET_SIZE];
+    uint16_t alpha_size = 0;
     for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
     {
-        if (lengths[i] == 0)
-            continue;
+        if (in_use[i])
+            seq[i] = (uint8_t) alpha_size++;
+    }
 
-        bra_huffman_node_t* cur = root;
-        for (int j = 0; j < lengths[i]; ++j)
+    uint32_t freq[BRA_ALPHABET_SIZE] = {0};
+    for (uint32_t i = 0; i < buf_size; ++i)
+        ++freq[seq[buf[i]]];
+
+    // 2. initial tables: each one cheap on a range of symbols with an even share of the frequencies.
+    const uint32_t num_selectors = (buf_size + BRA_HUFFMAN_MULTI_GROUP_SIZE - 1) / BRA_HUFFMAN_MULTI_GROUP_SIZE;
+    uint8_t        lengths[BRA_HUFFMAN_MULTI_MAX_TABLES][BRA_ALPHABET_SIZE];
+    uint8_t        selectors[BRA_HUFFMAN_MULTI_MAX_SELECTORS];
+
+    memset(lengths, 0, sizeof(lengths));
+    uint32_t rem_freq = buf_size;
+    int      gs       = 0;
+    for (int n = num_tables; n > 0; --n)
+    {
+        const uint32_t t_freq = rem_freq / n;
+        uint32_t       a_freq = 0;
+        int            ge     = gs - 1;
+        while (a_freq < t_freq && ge < alpha_size - 1)
+            a_freq += freq[++ge];
+
+        if (ge > gs && n != num_tables && n != 1 && (num_tables - n) % 2 == 1)
+            a_freq -= freq[ge--];
+
+        for (int v = 0; v < alpha_size; ++v)
+            lengths[n - 1][v] = (v >= gs && v <= ge) ? BRA_HUFFMAN_MULTI_LESSER_COST : BRA_HUFFMAN_MULTI_GREATER_COST;
+
+        gs        = ge + 1;
+        rem_freq -= a_freq;
+    }
+
+    // 3. refine: each group picks its cheapest table, the tables are rebuilt on the groups they got.
+    for (int iter = 0; iter < BRA_HUFFMAN_MULTI_ITERATIONS; ++iter)
+    {
+        uint32_t t_freq[BRA_HUFFMAN_MULTI_MAX_TABLES][BRA_ALPHABET_SIZE];
+        memset(t_freq, 0, sizeof(t_freq));
+        for (uint32_t g = 0; g < num_selectors; ++g)
         {
-            const uint8_t bit = codes[i][j];
-            if (j == lengths[i] - 1)
+            const uint32_t start = g * BRA_HUFFMAN_MULTI_GROUP_SIZE;
+            const uint32_t end   = buf_size - start < BRA_HUFFMAN_MULTI_GROUP_SIZE ? buf_size : start + BRA_HUFFMAN_MULTI_GROUP_SIZE;
+
+            uint32_t cost[BRA_HUFFMAN_MULTI_MAX_TABLES] = {0};
+            for (uint32_t i = start; i < end; ++i)
             {
-                // Last bit, assign symbol
-                n = bra_huffman_create_node(i, 0);
-                if (n == NULL)
-                    goto BRA_HUFFMAN_DECODE_ERROR;
-
-                if (bit == 0)
-                {
-                    if (cur->left != NULL)
-                        goto BRA_HUFFMAN_DECODE_ERROR;
-
-                    cur->left = n;
-                }
-                else
-                {
-                    if (cur->right != NULL)
-                        goto BRA_HUFFMAN_DECODE_ERROR;
-
-                    cur->right = n;
-                }
-
-                n = NULL;
+                const uint8_t v = seq[buf[i]];
+                for (int t = 0; t < num_tables; ++t)
+                    cost[t] += lengths[t][v];
             }
-            else
+
+            int best = 0;
+            for (int t = 1; t < num_tables; ++t)
             {
-                if (bit == 0)
-                {
-                    if (cur->left == NULL)
-                    {
-                        n = bra_huffman_create_node(0, 0);
-                        if (n == NULL)
-                            goto BRA_HUFFMAN_DECODE_ERROR;
-
-                        cur->left = n;
-                        n         = NULL;
-                    }
-                    cur = cur->left;
-                }
-                else    // bit == 1
-                {
-                    if (cur->right == NULL)
-                    {
-                        n = bra_huffman_create_node(0, 0);
-                        if (n == NULL)
-                            goto BRA_HUFFMAN_DECODE_ERROR;
-
-                        cur->right = n;
-                        n          = NULL;
-                    }
-                    cur = cur->right;
-                }
+                if (cost[t] < cost[best])
+                    best = t;
             }
+
+            selectors[g] = (uint8_t) best;
+            for (uint32_t i = start; i < end; ++i)
+                ++t_freq[best][seq[buf[i]]];
+        }
+
+        for (int t = 0; t < num_tables; ++t)
+        {
+            if (!bra_huffman_limited_lengths(t_freq[t], alpha_size, BRA_HUFFMAN_MULTI_MAX_CODE_LENGTH, lengths[t]))
+                return false;
+        }
+    }
+
+    // 4. write the header: symbols in use, tables and selectors.
+    bra_huffman_bit_writer_t bw = {.p = out_buf, .end = out_buf + out_buf_size, .acc = 0, .acc_bits = 0, .overflow = false};
+
+    // symbols in use: 16 bits map of the used blocks of 16 symbols, then 16 bits per used block.
+    uint32_t blocks = 0;
+    for (int b = 0; b < 16; ++b)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            if (in_use[b * 16 + i])
+                blocks |= 1U << (15 - b);
+        }
+    }
+
+    bra_huffman_bits_put(&bw, blocks, 16);
+    for (int b = 0; b < 16; ++b)
+    {
+        if ((blocks & (1U << (15 - b))) == 0)
+            continue;
+
+        uint32_t mask = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (in_use[b * 16 + i])
+                mask |= 1U << (15 - i);
         }
+
+        bra_huffman_bits_put(&bw, mask, 16);
     }
 
-    return root;
+    bra_huffman_bits_put(&bw, (uint32_t) num_tables, 3);
+
+    // selectors: move-to-front ranks in unary.
+    uint8_t mtf[BRA_HUFFMAN_MULTI_MAX_TABLES];
+    for (int t = 0; t < BRA_HUFFMAN_MULTI_MAX_TABLES; ++t)
+        mtf[t] = (uint8_t) t;
+
+    for (uint32_t g = 0; g < num_selectors; ++g)
+    {
+        int pos = 0;
+        while (mtf[pos] != selectors[g])
+            ++pos;
 
-BRA_HUFFMAN_DECODE_ERROR:
-    bra_log_error("unable to rebuild huffman tree");
-    bra_huffman_tree_free(&n);
-    bra_huffman_tree_free(&root);
-    return NULL;
+        for (int j = pos; j > 0; --j)
+            mtf[j] = mtf[j - 1];
+        mtf[0] = selectors[g];
+
+        bra_huffman_bits_put(&bw, ((1U << pos) - 1) << 1, pos + 1);
+    }
+
+    // tables: 5 bits start length, then the deltas to each symbol length: 10 increment, 11 decrement, 0 next symbol.
+    uint32_t codes[BRA_HUFFMAN_MULTI_MAX_TABLES][BRA_ALPHABET_SIZE];
+    for (int t = 0; t < num_tables; ++t)
+    {
+        int cur = lengths[t][0];
+        bra_huffman_bits_put(&bw, (uint32_t) cur, 5);
+        for (int v = 0; v < alpha_size; ++v)
+        {
+            for (; cur < lengths[t][v]; ++cur)
+                bra_huffman_bits_put(&bw, 2, 2);
+            for (; cur > lengths[t][v]; --cur)
+                bra_huffman_bits_put(&bw, 3, 2);
+
+            bra_huffman_bits_put(&bw, 0, 1);
+        }
+
+        bra_huffman_compute_canonical_codes(lengths[t], codes[t]);
+    }
+
+    // 5. encode data, each group with its table.
+    for (uint32_t g = 0; g < num_selectors; ++g)
+    {
+        const uint32_t start = g * BRA_HUFFMAN_MULTI_GROUP_SIZE;
+        const uint32_t end   = buf_size - start < BRA_HUFFMAN_MULTI_GROUP_SIZE ? buf_size : start + BRA_HUFFMAN_MULTI_GROUP_SIZE;
+        const int      t     = selectors[g];
+        for (uint32_t i = start; i < end; ++i)
+        {
+            const uint8_t v = seq[buf[i]];
+            bra_huffman_bits_put(&bw, codes[t][v], lengths[t][v]);
+        }
+    }
+
+    bra_huffman_bits_flush(&bw);
+    if (bw.overflow)
+        return false;
+
+    *out_size = (uint32_t) (bw.p - out_buf);
+    return true;
 }
 
 //////////////////////////////////////////////////////////////////////////////////
@@ -353,8 +533,6 @@ bra_huffman_chunk_t* bra_huffman_encode(const uint8_t* buf, const uint32_t buf_s
 {
     assert(buf != NULL);
 
-    uint32_t freq[BRA_ALPHABET_SIZE] = {0};
-
     bra_huffman_chunk_t* output = malloc(sizeof(bra_huffman_chunk_t));
     if (output == NULL)
     {
@@ -362,73 +540,76 @@ bra_huffman_chunk_t* bra_huffman_encode(const uint8_t* buf, const uint32_t buf_s
         return NULL;
     }
 
+    // the encoded data is never bigger than the source one.
     output->meta.encoded_size = 0;
-    output->data              = NULL;
+    output->data              = malloc(buf_size > 0 ? buf_size : 1);
+    if (output->data == NULL || !bra_huffman_encode2(buf, buf_size, &output->meta, output->data, buf_size))
+    {
+        bra_log_error("unable to huffman encode");
+        bra_huffman_chunk_free(output);
+        return NULL;
+    }
+
+    return output;
+}
+
+bool bra_huffman_encode2(const uint8_t* buf, const uint32_t buf_size, bra_huffman_t* meta, uint8_t* out_buf, const uint32_t out_buf_size)
+{
+    assert(buf != NULL);
+    assert(meta != NULL);
+    assert(out_buf != NULL);
 
     // 1. count frequencies
+    uint32_t freq[BRA_ALPHABET_SIZE] = {0};
     for (uint32_t i = 0; i < buf_size; ++i)
         ++freq[buf[i]];
 
     // 2. build Huffman Tree
-    bra_huffman_node_t* root = bra_huffman_tree_build(freq);
-    if (root == NULL)
-    {
-        bra_log_error("unable to huffman encode");
-        free(output);
-        return NULL;
-    }
+    bra_huffman_tree_t tree;
+    if (!bra_huffman_tree_build(&tree, freq))
+        return false;
 
     // 3. Generate codes
-    uint8_t codes[BRA_ALPHABET_SIZE][BRA_ALPHABET_SIZE];
-    // uint8_t lengths[BRA_ALPHABET_SIZE] = {0};
-    memset(output->meta.lengths, 0, BRA_ALPHABET_SIZE * sizeof(uint8_t));
-    uint8_t code[BRA_ALPHABET_SIZE];
-    bra_huffman_generate_codes(root, codes, output->meta.lengths, code, 0);
-    bra_huffman_compute_canonical_codes(output->meta.lengths, codes);
+    uint32_t codes[BRA_ALPHABET_SIZE];
+    if (!bra_huffman_tree_lengths(&tree, meta->lengths))
+        return false;
+    bra_huffman_compute_canonical_codes(meta->lengths, codes);
 
     // 4. calculate output size
-    uint32_t bit_count = 0;
-    for (uint32_t i = 0; i < buf_size; ++i)
-        bit_count += output->meta.lengths[buf[i]];
+    uint64_t bit_count = 0;
+    for (int i = 0; i < BRA_ALPHABET_SIZE; ++i)
+        bit_count += (uint64_t) freq[i] * meta->lengths[i];
 
-    output->meta.orig_size    = buf_size;
-    output->meta.encoded_size = (bit_count + 7) / 8;    // Code lengths + packed data
-    output->data              = malloc(output->meta.encoded_size);
-    if (output->data == NULL)
+    const uint64_t encoded_size = (bit_count + 7) / 8;
+    if (encoded_size > out_buf_size)
     {
-        bra_log_error("unable to encode huffman");
-        bra_huffman_tree_free(&root);
-        free(output);
-        return NULL;
+        bra_log_error("huffman encoded data too big: %llu/%u", (unsigned long long) encoded_size, out_buf_size);
+        return false;
     }
 
-    // 5. encode data
-    uint8_t* data_ptr = output->data;
-    uint8_t  cur_byte = 0;
-    int      bit_pos  = 0;
+    meta->orig_size    = buf_size;
+    meta->encoded_size = (uint32_t) encoded_size;
+
+    // 5. encode data, MSB first
+    uint8_t* data_ptr = out_buf;
+    uint64_t acc      = 0;
+    int      acc_bits = 0;
     for (uint32_t i = 0; i < buf_size; ++i)
     {
-        const uint8_t symbol = buf[i];
-        for (int j = 0; j < output->meta.lengths[symbol]; ++j)
+        const uint8_t symbol  = buf[i];
+        acc                   = (acc << meta->lengths[symbol]) | codes[symbol];
+        acc_bits             += meta->lengths[symbol];
+        while (acc_bits >= 8)
         {
-            if (codes[symbol][j] > 0)
-                cur_byte |= (1 << (7 - bit_pos));
-
-            ++bit_pos;
-            if (bit_pos == 8)
-            {
-                *data_ptr++ = cur_byte;
-                cur_byte    = 0;
-                bit_pos     = 0;
-            }
+            acc_bits    -= 8;
+            *data_ptr++  = (uint8_t) (acc >> acc_bits);
         }
     }
 
-    if (bit_pos > 0)
-        *data_ptr = cur_byte;
+    if (acc_bits > 0)
+        *data_ptr = (uint8_t) (acc << (8 - acc_bits));
 
-    bra_huffman_tree_free(&root);
-    return output;
+    return true;
 }
 
 uint8_t* bra_huffman_decode(const bra_huffman_t* meta, const uint8_t* data, uint32_t* out_size)
@@ -437,64 +618,262 @@ uint8_t* bra_huffman_decode(const bra_huffman_t* meta, const uint8_t* data, uint
     assert(data != NULL);
     assert(out_size != NULL);
 
-    *out_size                = 0;
-    bra_huffman_node_t* root = bra_huffman_tree_build_from_lengths(meta->lengths);
-    if (root == NULL)
-        return NULL;
-
-    // Decode data
-    const uint32_t data_size = meta->encoded_size;
-    uint8_t*       decoded   = (uint8_t*) malloc(meta->orig_size);
+    *out_size        = 0;
+    uint8_t* decoded = (uint8_t*) malloc(meta->orig_size > 0 ? meta->orig_size : 1);
     if (decoded == NULL)
     {
         bra_log_error("unable to decode huffman");
-        bra_huffman_tree_free(&root);
         return NULL;
     }
 
-    uint32_t            decoded_idx = 0;
-    bra_huffman_node_t* cur         = root;
-    for (uint32_t i = 0; i < data_size; ++i)
+    if (!bra_huffman_decode2(meta, data, decoded, meta->orig_size))
     {
-        const uint8_t byte = data[i];
-        for (int bit = 7; bit >= 0; bit--)
-        {
-            const uint8_t bit_val = (byte >> bit) & 1;
-            cur                   = bit_val == 0 ? cur->left : cur->right;
+        free(decoded);
+        return NULL;
+    }
+
+    *out_size = meta->orig_size;
+    return decoded;
+}
 
+bool bra_huffman_decode2(const bra_huffman_t* meta, const uint8_t* data, uint8_t* out_buf, const uint32_t out_buf_size)
+{
+    assert(meta != NULL);
+    assert(data != NULL);
+    assert(out_buf != NULL);
+
+    if (meta->orig_size > out_buf_size)
+    {
+        bra_log_error("huffman decode error: original data:%u - buffer size:%u", meta->orig_size, out_buf_size);
+        return false;
+    }
+
+    bra_huffman_decode_table_t table;
+    if (!bra_huffman_decode_table_build(&table, meta->lengths))
+    {
+        bra_log_error("unable to rebuild huffman tree");
+        return false;
+    }
+
+    // Decode data
+    const uint64_t total_bits  = (uint64_t) meta->encoded_size * 8;
+    uint64_t       bit_pos     = 0;
+    uint32_t       decoded_idx = 0;
+    while (decoded_idx < meta->orig_size)
+    {
+        uint32_t code = 0;
+        int      len  = 0;
+        for (;;)
+        {
             // sanity check
-            if (cur == NULL)
+            if (bit_pos >= total_bits || len == table.max_length)
             {
                 bra_log_error("huffman decode error: invalid code sequence");
-                goto BRA_HUFFMAN_DECODE_ERROR;
+                return false;
             }
 
-            if (cur->left == NULL && cur->right == NULL)
+            code = (code << 1) | ((data[bit_pos >> 3] >> (7 - (bit_pos & 7))) & 1);
+            ++bit_pos;
+            ++len;
+            if (code - table.first[len] < table.count[len])
+                break;
+        }
+
+        out_buf[decoded_idx++] = table.symbols[table.offset[len] + code - table.first[len]];
+    }
+
+    return true;
+}
+
+bool bra_huffman_encode_multi(const uint8_t* buf, const uint32_t buf_size, bra_huffman_t* meta, uint8_t* out_buf, const uint32_t out_buf_size)
+{
+    assert(buf != NULL);
+    assert(meta != NULL);
+    assert(out_buf != NULL);
+
+    if (buf_size == 0 || buf_size > BRA_CODEC_BUF_SIZE)
+        return false;
+
+    uint32_t size = 0;
+    if (buf_size >= BRA_HUFFMAN_MULTI_SHORT_SIZE)
+    {
+        if (!bra_huffman_multi_encode_tables(buf, buf_size, bra_huffman_multi_num_tables(buf_size), out_buf, out_buf_size, &size))
+            return false;
+    }
+    else
+    {
+        // short streams: the extra tables might cost more than they save, keep the smaller coding.
+        if (!bra_huffman_multi_encode_tables(buf, buf_size, 1, out_buf, out_buf_size, &size))
+            return false;
+
+        uint32_t size2 = 0;
+        if (bra_huffman_multi_encode_tables(buf, buf_size, bra_huffman_multi_num_tables(buf_size), out_buf + size, out_buf_size - size, &size2) && size2 < size)
+        {
+            memmove(out_buf, out_buf + size, size2);
+            size = size2;
+        }
+    }
+
+    memset(meta->lengths, 0, sizeof(meta->lengths));
+    meta->orig_size    = buf_size;
+    meta->encoded_size = size;
+    return true;
+}
+
+bool bra_huffman_encode_compact(const uint8_t* buf, const uint32_t buf_size, bra_huffman_t* meta, uint8_t* out_buf, const uint32_t out_buf_size)
+{
+    assert(buf != NULL);
+    assert(meta != NULL);
+    assert(out_buf != NULL);
+
+    uint32_t size = 0;
+    if (buf_size == 0 || buf_size > BRA_CODEC_BUF_SIZE || !bra_huffman_multi_encode_tables(buf, buf_size, 1, out_buf, out_buf_size, &size))
+        return false;
+
+    memset(meta->lengths, 0, sizeof(meta->lengths));
+    meta->orig_size    = buf_size;
+    meta->encoded_size = size;
+    return true;
+}
+
+bool bra_huffman_decode_multi(const bra_huffman_t* meta, const uint8_t* data, uint8_t* out_buf, const uint32_t out_buf_size)
+{
+    assert(meta != NULL);
+    assert(data != NULL);
+    assert(out_buf != NULL);
+
+    if (meta->orig_size > out_buf_size || meta->orig_size > BRA_CODEC_BUF_SIZE)
+    {
+        bra_log_error("huffman decode error: original data:%u - buffer size:%u", meta->orig_size, out_buf_size);
+        return false;
+    }
+
+    bra_huffman_bit_reader_t br = {.data = data, .total_bits = (uint64_t) meta->encoded_size * 8, .pos = 0};
+    uint32_t                 v;
+
+    // symbols in use
+    uint8_t  unseq[BRA_ALPHABET_SIZE];
+    uint16_t alpha_size = 0;
+    uint32_t blocks;
+    if (!bra_huffman_bits_get(&br, 16, &blocks))
+        goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+    for (int b = 0; b < 16; ++b)
+    {
+        if ((blocks & (1U << (15 - b))) == 0)
+            continue;
+
+        uint32_t mask;
+        if (!bra_huffman_bits_get(&br, 16, &mask))
+            goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            if (mask & (1U << (15 - i)))
+                unseq[alpha_size++] = (uint8_t) (b * 16 + i);
+        }
+    }
+
+    uint32_t num_tables;
+    if (alpha_size == 0 || !bra_huffman_bits_get(&br, 3, &num_tables) || num_tables == 0 || num_tables > BRA_HUFFMAN_MULTI_MAX_TABLES)
+        goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+    // selectors
+    const uint32_t num_selectors = (meta->orig_size + BRA_HUFFMAN_MULTI_GROUP_SIZE - 1) / BRA_HUFFMAN_MULTI_GROUP_SIZE;
+    uint8_t        selectors[BRA_HUFFMAN_MULTI_MAX_SELECTORS];
+    uint8_t        mtf[BRA_HUFFMAN_MULTI_MAX_TABLES];
+    for (int t = 0; t < BRA_HUFFMAN_MULTI_MAX_TABLES; ++t)
+        mtf[t] = (uint8_t) t;
+
+    for (uint32_t g = 0; g < num_selectors; ++g)
+    {
+        uint32_t pos = 0;
+        for (;;)
+        {
+            if (!bra_huffman_bits_get(&br, 1, &v))
+                goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+            if (v == 0)
+                break;
+            if (++pos >= num_tables)
+                goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+        }
+
+        const uint8_t t = mtf[pos];
+        for (uint32_t j = pos; j > 0; --j)
+            mtf[j] = mtf[j - 1];
+        mtf[0]       = t;
+        selectors[g] = t;
+    }
+
+    // tables
+    bra_huffman_decode_table_t tables[BRA_HUFFMAN_MULTI_MAX_TABLES];
+    for (uint32_t t = 0; t < num_tables; ++t)
+    {
+        uint8_t  lengths[BRA_ALPHABET_SIZE] = {0};
+        uint32_t cur;
+        if (!bra_huffman_bits_get(&br, 5, &cur))
+            goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+        for (uint16_t s = 0; s < alpha_size; ++s)
+        {
+            for (;;)
             {
-                // Leaf node
-                decoded[decoded_idx++] = cur->symbol;
-                cur                    = root;
-                // NOTE: this is required to skip the eventual padding bits
-                if (decoded_idx >= meta->orig_size)
+                if (cur < 1 || cur > BRA_HUFFMAN_MULTI_MAX_CODE_LENGTH)
+                    goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+                if (!bra_huffman_bits_get(&br, 1, &v))
+                    goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+                if (v == 0)
                     break;
+                if (!bra_huffman_bits_get(&br, 1, &v))
+                    goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+                cur = v == 0 ? cur + 1 : cur - 1;
             }
+
+            lengths[s] = (uint8_t) cur;
         }
+
+        if (!bra_huffman_decode_table_build(&tables[t], lengths))
+            goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
     }
 
-    bra_huffman_tree_free(&root);
-    if (decoded_idx != meta->orig_size)
+    // decode data
+    const uint8_t* p = data;
+    for (uint32_t g = 0; g < num_selectors; ++g)
     {
-        bra_log_error("huffman decode error: decoded data:%u - original_data:%u", decoded_idx, meta->orig_size);
-        goto BRA_HUFFMAN_DECODE_ERROR;
+        if (selectors[g] >= num_tables)
+            goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+        const uint32_t                    start = g * BRA_HUFFMAN_MULTI_GROUP_SIZE;
+        const uint32_t                    end   = meta->orig_size - start < BRA_HUFFMAN_MULTI_GROUP_SIZE ? meta->orig_size : start + BRA_HUFFMAN_MULTI_GROUP_SIZE;
+        const bra_huffman_decode_table_t* table = &tables[selectors[g]];
+
+        for (uint32_t i = start; i < end; ++i)
+        {
+            uint32_t code = 0;
+            int      len  = 0;
+            for (;;)
+            {
+                // sanity check
+                if (br.pos >= br.total_bits || len == table->max_length)
+                    goto BRA_HUFFMAN_DECODE_MULTI_ERROR;
+
+                code = (code << 1) | ((p[br.pos >> 3] >> (7 - (br.pos & 7))) & 1);
+                ++br.pos;
+                ++len;
+                if (code - table->first[len] < table->count[len])
+                    break;
+            }
+
+            out_buf[i] = unseq[table->symbols[table->offset[len] + code - table->first[len]]];
+        }
     }
 
-    *out_size = decoded_idx;
-    return decoded;
+    return true;
 
-BRA_HUFFMAN_DECODE_ERROR:
-    bra_huffman_tree_free(&root);
-    free(decoded);
-    return NULL;
+BRA_HUFFMAN_DECODE_MULTI_ERROR:
+    bra_log_error("huffman decode error: invalid multi-table stream");
+    return false;
 }
 
 void bra_huffman_chunk_free(bra_huffman_chunk_t* chunk)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <lib_bra_defs.h>
 #include <lib_bra_types.h>
 
@@ -24,6 +25,19 @@ typedef struct bra_huffman_chunk_t
  */
 bra_huffman_chunk_t* bra_huffman_encode(const uint8_t* buf, const uint32_t buf_size);
 
+/**
+ * @brief Encode @p buf into Huffman canonical codes in a caller provided buffer.
+ *
+ * @param buf          the buffer to encode
+ * @param buf_size     the buffer size in bytes.
+ * @param meta         Huffman metadata of the encoded data.
+ * @param out_buf      the encoded data, @p buf_size bytes are always enough.
+ * @param out_buf_size capacity of @p out_buf in bytes.
+ * @retval true  on success
+ * @retval false on empty @p buf or if @p out_buf is too small.
+ */
+bool bra_huffman_encode2(const uint8_t* buf, const uint32_t buf_size, bra_huffman_t* meta, uint8_t* out_buf, const uint32_t out_buf_size);
+
 /**
  * @brief Decode Huffman canonical codes.
  *
@@ -34,6 +48,66 @@ bra_huffman_chunk_t* bra_huffman_encode(const uint8_t* buf, const uint32_t buf_s
  */
 uint8_t* bra_huffman_decode(const bra_huffman_t* meta, const uint8_t* data, uint32_t* out_size);
 
+/**
+ * @brief Decode Huffman canonical codes in a caller provided buffer.
+ *
+ * @param meta         Huffman metadata
+ * @param data         Huffman encoded data, @c meta->encoded_size bytes.
+ * @param out_buf      Decoded data, @c meta->orig_size bytes.
+ * @param out_buf_size capacity of @p out_buf in bytes.
+ * @retval true  on success
+ * @retval false on corrupted data or if @p out_buf is too small.
+ */
+bool bra_huffman_decode2(const bra_huffman_t* meta, const uint8_t* data, uint8_t* out_buf, const uint32_t out_buf_size);
+
+/**
+ * @brief Encode @p buf with multiple Huffman tables, as bzip2.
+ *
+ * Up to 6 tables are optimised iteratively, a selector picks one of them every 50 symbols.
+ * Short streams use a single table when it is smaller.
+ * The output starts with the coding description instead of @c meta->lengths, that is left empty:
+ *  - the symbols in use: a bitmap of the 16 blocks of 16 symbols, then the bitmap of each used block.
+ *  - the number of tables and the move-to-front coded selectors.
+ *  - the delta coded code lengths of each table.
+ *
+ * @param buf          the buffer to encode
+ * @param buf_size     the buffer size in bytes, up to #BRA_CODEC_BUF_SIZE.
+ * @param meta         Huffman metadata of the encoded data, only the sizes are set.
+ * @param out_buf      the encoded data.
+ * @param out_buf_size capacity of @p out_buf in bytes.
+ * @retval true  on success
+ * @retval false on empty or too big @p buf, or if @p out_buf is too small.
+ */
+bool bra_huffman_encode_multi(const uint8_t* buf, const uint32_t buf_size, bra_huffman_t* meta, uint8_t* out_buf, const uint32_t out_buf_size);
+
+/**
+ * @brief Encode @p buf with a single Huffman table in the @ref bra_huffman_encode_multi format:
+ *        its code lengths are delta coded in the output instead of the 256 bytes of @c meta->lengths.
+ *
+ * @param buf          the buffer to encode
+ * @param buf_size     the buffer size in bytes, up to #BRA_CODEC_BUF_SIZE.
+ * @param meta         Huffman metadata of the encoded data, only the sizes are set.
+ * @param out_buf      the encoded data.
+ * @param out_buf_size capacity of @p out_buf in bytes.
+ * @retval true  on success
+ * @retval false on empty or too big @p buf, or if @p out_buf is too small.
+ */
+bool bra_huffman_encode_compact(const uint8_t* buf, const uint32_t buf_size, bra_huffman_t* meta, uint8_t* out_buf, const uint32_t out_buf_size);
+
+/**
+ * @brief Decode multiple Huffman tables encoded data in a caller provided buffer.
+ *
+ * @see bra_huffman_encode_multi
+ *
+ * @param meta         Huffman metadata, only the sizes are used.
+ * @param data         Huffman encoded data, @c meta->encoded_size bytes.
+ * @param out_buf      Decoded data, @c meta->orig_size bytes.
+ * @param out_buf_size capacity of @p out_buf in bytes.
+ * @retval true  on success
+ * @retval false on corrupted data or if @p out_buf is too small.
+ */
+bool bra_huffman_decode_multi(const bra_huffman_t* meta, const uint8_t* data, uint8_t* out_buf, const uint32_t out_buf_size);
+
 /**
  * @brief Free the Huffman encoded data struct. It is safe to pass @p chunk as @c NULL.
  *
@@ -0,0 +1,267 @@
+#include <encoders/bra_lz.h>
+
+#include <lib_bra_defs.h>
+
+#include <assert.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define BRA_LZ_HASH_BITS    14                            //!< hash table entries of the match finder: 2^14.
+#define BRA_LZ_MAX_OFFSET   UINT16_MAX                    //!< farthest match.
+#define BRA_LZ_MF_LIMIT     12                            //!< no match starts in the last bytes.
+#define BRA_LZ_SKIP_TRIGGER 6                             //!< after 2^6 misses the search step grows by 1.
+#define BRA_LZ_RUN_MASK     15                            //!< nibble value followed by extra length bytes.
+
+static inline uint32_t _bra_lz_read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _bra_lz_read64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t _bra_lz_hash(const uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - BRA_LZ_HASH_BITS);
+}
+
+static inline unsigned _bra_lz_ctz64(const uint64_t v)
+{
+    assert(v != 0);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, v);
+    return (unsigned) i;
+#else
+    return (unsigned) __builtin_ctzll(v);
+#endif
+}
+
+/**
+ * @brief Length of the common prefix of @p a and @p b, @p b preceding @p a, not going past @p end.
+ */
+static inline size_t _bra_lz_match_length(const uint8_t* a, const uint8_t* b, const uint8_t* end)
+{
+    const uint8_t* const start = a;
+    while (end - a >= 8)
+    {
+        const uint64_t diff = _bra_lz_read64(a) ^ _bra_lz_read64(b);
+        if (diff != 0)
+            return (size_t) (a - start) + _bra_lz_ctz64(diff) / 8;    // little endian
+
+        a += 8;
+        b += 8;
+    }
+
+    while (a < end && *a == *b)
+    {
+        ++a;
+        ++b;
+    }
+
+    return (size_t) (a - start);
+}
+
+static inline bool _bra_lz_write_length(uint8_t** p, const uint8_t* end, size_t len)
+{
+    for (; len >= UINT8_MAX; len -= UINT8_MAX)
+    {
+        if (*p == end)
+            return false;
+
+        *(*p)++ = UINT8_MAX;
+    }
+
+    if (*p == end)
+        return false;
+
+    *(*p)++ = (uint8_t) len;
+    return true;
+}
+
+static inline bool _bra_lz_read_length(const uint8_t** p, const uint8_t* end, size_t* len)
+{
+    uint8_t b;
+    do
+    {
+        if (*p == end)
+            return false;
+
+        b     = *(*p)++;
+        *len += b;
+    } while (b == UINT8_MAX);
+
+    return true;
+}
+
+/**
+ * @brief Write a sequence: @p lit_len literals from @p lit, then the match, if @p match_len is not 0.
+ */
+static bool _bra_lz_write_sequence(uint8_t** p, const uint8_t* end, const uint8_t* lit, const size_t lit_len, const size_t offset, const size_t match_len)
+{
+    if (*p == end)
+        return false;
+
+    const size_t ml    = match_len == 0 ? 0 : match_len - BRA_LZ_MIN_MATCH;
+    uint8_t*     token = (*p)++;
+    *token             = (uint8_t) (((lit_len < BRA_LZ_RUN_MASK ? lit_len : BRA_LZ_RUN_MASK) << 4) | (ml < BRA_LZ_RUN_MASK ? ml : BRA_LZ_RUN_MASK));
+    if (lit_len >= BRA_LZ_RUN_MASK && !_bra_lz_write_length(p, end, lit_len - BRA_LZ_RUN_MASK))
+        return false;
+
+    if ((size_t) (end - *p) < lit_len)
+        return false;
+
+    memcpy(*p, lit, lit_len);
+    *p += lit_len;
+    if (match_len == 0)
+        return true;
+
+    if (end - *p < 2)
+        return false;
+
+    *(*p)++ = (uint8_t) offset;
+    *(*p)++ = (uint8_t) (offset >> 8);
+    if (ml >= BRA_LZ_RUN_MASK && !_bra_lz_write_length(p, end, ml - BRA_LZ_RUN_MASK))
+        return false;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool bra_lz_encode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    *out_size = 0;
+
+    uint8_t*             p      = out_buf;
+    const uint8_t* const end    = out_buf + out_buf_size;
+    size_t               anchor = 0;
+
+    if (buf_size > BRA_LZ_MF_LIMIT)
+    {
+        // positions of the last 4 bytes sequences seen, 0 is a valid (checked) candidate.
+        uint32_t table[1U << BRA_LZ_HASH_BITS];
+        memset(table, 0, sizeof(table));
+
+        const size_t         limit       = buf_size - BRA_LZ_MF_LIMIT;
+        const uint8_t* const match_limit = buf + buf_size - BRA_LZ_LAST_LITERALS;
+        size_t               ip          = 1;
+        size_t               misses      = 0;
+
+        table[_bra_lz_hash(_bra_lz_read32(buf))] = 0;
+        while (ip < limit)
+        {
+            const uint32_t h   = _bra_lz_hash(_bra_lz_read32(&buf[ip]));
+            size_t         ref = table[h];
+            table[h]           = (uint32_t) ip;
+            if (ip - ref > BRA_LZ_MAX_OFFSET || _bra_lz_read32(&buf[ref]) != _bra_lz_read32(&buf[ip]))
+            {
+                // incompressible data is skipped faster and faster
+                ip += 1 + (misses++ >> BRA_LZ_SKIP_TRIGGER);
+                continue;
+            }
+
+            // extend backward, then forward
+            while (ip > anchor && ref > 0 && buf[ip - 1] == buf[ref - 1])
+            {
+                --ip;
+                --ref;
+            }
+
+            const size_t len = BRA_LZ_MIN_MATCH + _bra_lz_match_length(&buf[ip + BRA_LZ_MIN_MATCH], &buf[ref + BRA_LZ_MIN_MATCH], match_limit);
+            if (!_bra_lz_write_sequence(&p, end, &buf[anchor], ip - anchor, ip - ref, len))
+                return false;
+
+            ip     += len;
+            anchor  = ip;
+            misses  = 0;
+
+            // the position before the next search is a likely match start
+            if (ip < limit)
+                table[_bra_lz_hash(_bra_lz_read32(&buf[ip - 2]))] = (uint32_t) (ip - 2);
+        }
+    }
+
+    // last literals
+    if (!_bra_lz_write_sequence(&p, end, &buf[anchor], buf_size - anchor, 0, 0))
+        return false;
+
+    *out_size = (size_t) (p - out_buf);
+    return true;
+}
+
+bool bra_lz_decode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    *out_size = 0;
+
+    const uint8_t*       ip     = buf;
+    const uint8_t* const in_end = buf + buf_size;
+    uint8_t*             op     = out_buf;
+    const uint8_t* const end    = out_buf + out_buf_size;
+    while (ip < in_end)
+    {
+        const uint8_t token = *ip++;
+
+        // literals
+        size_t lit_len = token >> 4;
+        if (lit_len == BRA_LZ_RUN_MASK && !_bra_lz_read_length(&ip, in_end, &lit_len))
+            return false;
+        if (lit_len > (size_t) (in_end - ip) || lit_len > (size_t) (end - op))
+            return false;
+
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+        if (ip == in_end)
+            break;    // last sequence
+
+        // match
+        if (in_end - ip < 2)
+            return false;
+
+        const size_t offset  = ip[0] | ((size_t) ip[1] << 8);
+        ip                  += 2;
+        if (offset == 0 || offset > (size_t) (op - out_buf))
+            return false;
+
+        size_t len = token & BRA_LZ_RUN_MASK;
+        if (len == BRA_LZ_RUN_MASK && !_bra_lz_read_length(&ip, in_end, &len))
+            return false;
+
+        len += BRA_LZ_MIN_MATCH;
+        if (len > (size_t) (end - op))
+            return false;
+
+        const uint8_t* match = op - offset;
+        if (offset >= 8)
+        {
+            // 8 bytes apart at least: each 8 bytes copy doesn't overlap.
+            for (; len >= 8; len -= 8, op += 8, match += 8)
+                memcpy(op, match, 8);
+        }
+
+        for (; len > 0; --len)
+            *op++ = *match++;
+    }
+
+    *out_size = (size_t) (op - out_buf);
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Encode a buffer with LZ77 in the LZ4 block format, using a single probe hash match finder.
+ *
+ * The data is a list of sequences, each of them is:
+ *  - a token: literals length in the upper 4 bits, match length - #BRA_LZ_MIN_MATCH in the lower 4 bits.
+ *    A nibble of 15 is followed by extra bytes added to it, until one is lower than 255.
+ *  - the literals.
+ *  - the match offset, 2 bytes little endian, and the extra match length bytes.
+ *
+ * The last sequence has only literals, the last #BRA_LZ_LAST_LITERALS bytes are always literals.
+ *
+ * @param buf           Input buffer to encode.
+ * @param buf_size      Size of the input buffer in bytes.
+ * @param out_buf       Output buffer, #BRA_LZ_ENCODE_BOUND(@p buf_size) bytes are always enough.
+ * @param out_buf_size  Capacity of @p out_buf in bytes.
+ * @param out_size      Encoded size in bytes.
+ * @retval true         on successful encoding.
+ * @retval false        if @p out_buf is too small.
+ */
+bool bra_lz_encode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
+
+/**
+ * @brief Decode LZ77 data encoded by @ref bra_lz_encode2 into a caller provided buffer.
+ *
+ * @param buf           Input buffer to decode.
+ * @param buf_size      Size of the input buffer in bytes.
+ * @param out_buf       Output buffer decoded.
+ * @param out_buf_size  Capacity of @p out_buf in bytes.
+ * @param out_size      Decoded size in bytes.
+ * @retval true         on successful decoding.
+ * @retval false        on corrupted data or if @p out_buf is too small.
+ */
+bool bra_lz_decode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
@@ -1,58 +1,101 @@
 #include <encoders/bra_rle.h>
 
+#include <lib_bra_defs.h>
 #include <log/bra_log.h>
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
-static inline size_t _bra_rle_encoding_compute_size_detect_run(const uint8_t* buf, const size_t buf_size, const size_t i)
+// SSE2 is always available on x86-64: no runtime dispatch needed.
+#if defined(__SSE2__) || defined(_M_X64)
+#define BRA_RLE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+_Static_assert(BRA_RLE_MIN_RUNS == 3, "run start detection compares 3 consecutive bytes");
+
+#ifdef BRA_RLE_SSE2
+static inline unsigned _bra_rle_ctz(const unsigned mask)
+{
+    assert(mask != 0);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return (unsigned) i;
+#else
+    return (unsigned) __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/**
+ * @brief Length of the run of bytes equal to @c buf[i], up to #BRA_RLE_MAX_RUNS.
+ */
+static inline size_t _bra_rle_detect_run(const uint8_t* buf, const size_t buf_size, const size_t i)
 {
     assert(buf != NULL);
+    assert(i < buf_size);
+
+    const size_t  max = buf_size - i < BRA_RLE_MAX_RUNS ? buf_size - i : BRA_RLE_MAX_RUNS;
+    const uint8_t v   = buf[i];
+    size_t        run = 1;
+
+#ifdef BRA_RLE_SSE2
+    const __m128i vv = _mm_set1_epi8((char) v);
+    while (run + 16 <= max)
+    {
+        const __m128i  b    = _mm_loadu_si128((const __m128i*) &buf[i + run]);
+        const unsigned diff = ~(unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(b, vv)) & 0xFFFFU;
+        if (diff != 0)
+            return run + _bra_rle_ctz(diff);
 
-    size_t run = 1;
-    while (i + run < buf_size && buf[i + run] == buf[i] && run < BRA_RLE_MAX_RUNS)
+        run += 16;
+    }
+#endif
+
+    while (run < max && buf[i + run] == v)
         ++run;
 
     return run;
 }
 
-static inline size_t _bra_rle_encode_compute_size(const uint8_t* buf, const size_t buf_size)
+/**
+ * @brief First position in [@p from, @p limit) where a run of #BRA_RLE_MIN_RUNS bytes starts; @p limit if none.
+ */
+static inline size_t _bra_rle_find_run(const uint8_t* buf, const size_t buf_size, const size_t from, const size_t limit)
 {
     assert(buf != NULL);
+    assert(limit <= buf_size);
 
-    size_t size = 0;
-    for (size_t i = 0; i < buf_size;)
+    size_t j = from;
+
+#ifdef BRA_RLE_SSE2
+    // 16 candidates at once: buf[j] == buf[j + 1] == buf[j + 2]
+    while (j + 16 <= limit && j + 18 <= buf_size)
     {
-        // counting repeated bytes
-        const size_t run = _bra_rle_encoding_compute_size_detect_run(buf, buf_size, i);
-        if (run >= BRA_RLE_MIN_RUNS)
-        {
-            // run block
-            size += 2;
-            i    += run;
-        }
-        else
-        {
-            // literal block
-            // 1st time already checked that is a literal run
-            size_t lit_size  = run;
-            i               += run;
-            while (i < buf_size)
-            {
-                if (_bra_rle_encoding_compute_size_detect_run(buf, buf_size, i) >= BRA_RLE_MIN_RUNS)
-                    break;
-
-                ++i;
-                if (++lit_size == BRA_RLE_MAX_RUNS)
-                    break;
-            }
-
-            size += 1 + lit_size;
-        }
+        const __m128i  b0   = _mm_loadu_si128((const __m128i*) &buf[j]);
+        const __m128i  b1   = _mm_loadu_si128((const __m128i*) &buf[j + 1]);
+        const __m128i  b2   = _mm_loadu_si128((const __m128i*) &buf[j + 2]);
+        const unsigned mask = (unsigned) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b0, b1), _mm_cmpeq_epi8(b0, b2)));
+        if (mask != 0)
+            return j + _bra_rle_ctz(mask);
+
+        j += 16;
     }
+#endif
 
-    return size;
+    for (; j < limit; ++j)
+    {
+        if (j + 2 < buf_size && buf[j] == buf[j + 1] && buf[j] == buf[j + 2])
+            return j;
+    }
+
+    return limit;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -64,29 +107,45 @@ bool bra_rle_encode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf
     assert(out_buf != NULL);
     assert(out_buf_size != NULL);
 
-    // estimate the out_buf_size doing a pre-scan of the data
     *out_buf_size = 0;
     *out_buf      = NULL;
 
-    size_t s = _bra_rle_encode_compute_size(buf, buf_size);
-    if (s == 0)
+    // sized to the worst case: a single encoding pass.
+    const size_t s = BRA_RLE_ENCODE_BOUND(buf_size);
+    uint8_t*     b = malloc(sizeof(uint8_t) * s);
+    if (b == NULL)
         return false;
 
-    // if (s > buf_size)
-    //     return false;
-
-    uint8_t* b = malloc(sizeof(uint8_t) * s);
-    if (b == NULL)
+    if (!bra_rle_encode2(buf, buf_size, b, s, out_buf_size))
+    {
+        free(b);
         return false;
+    }
+
+    *out_buf = b;
+    return true;
+}
+
+bool bra_rle_encode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    *out_size = 0;
 
     // encode the data
-    uint8_t* p = b;
+    uint8_t*             p   = out_buf;
+    const uint8_t* const end = out_buf + out_buf_size;
     for (size_t i = 0; i < buf_size;)
     {
-        const size_t run = _bra_rle_encoding_compute_size_detect_run(buf, buf_size, i);
+        const size_t run = _bra_rle_detect_run(buf, buf_size, i);
         if (run >= BRA_RLE_MIN_RUNS)
         {
             // run block
+            if (end - p < 2)
+                return false;
+
             const int8_t control  = -(run - 1);
             *p++                  = control;
             *p++                  = buf[i];
@@ -94,28 +153,22 @@ bool bra_rle_encode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf
         }
         else
         {
-            // literal block
-            size_t  lit_start   = i;
-            uint8_t lit_length  = run;
-            i                  += run;
-            while (i < buf_size)
-            {
-                if (_bra_rle_encoding_compute_size_detect_run(buf, buf_size, i) >= BRA_RLE_MIN_RUNS)
-                    break;
-
-                ++i;
-                if (++lit_length == BRA_RLE_MAX_RUNS)
-                    break;
-            }
-
-            *p++ = (lit_length - 1);
-            memcpy(p, &buf[lit_start], lit_length);
+            // literal block: up to the next run or #BRA_RLE_MAX_RUNS bytes.
+            // the first 1 or 2 bytes are already known not to start a run.
+            const size_t limit      = buf_size - i < BRA_RLE_MAX_RUNS ? buf_size : i + BRA_RLE_MAX_RUNS;
+            const size_t lit_end    = _bra_rle_find_run(buf, buf_size, i + run, limit);
+            const size_t lit_length = lit_end - i;
+            if ((size_t) (end - p) < 1U + lit_length)
+                return false;
+
+            *p++ = (uint8_t) (lit_length - 1);
+            memcpy(p, &buf[i], lit_length);
             p += lit_length;
+            i  = lit_end;
         }
     }
 
-    *out_buf_size = s;
-    *out_buf      = b;
+    *out_size = (size_t) (p - out_buf);
     return true;
 }
 
@@ -177,8 +230,26 @@ bool bra_rle_decode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf
     if (b == NULL)
         return false;
 
-    uint8_t* p = b;
+    if (!bra_rle_decode2(buf, buf_size, b, s, out_buf_size))
+    {
+        free(b);
+        return false;
+    }
+
+    *out_buf = b;
+    return true;
+}
+
+bool bra_rle_decode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    *out_size = 0;
 
+    uint8_t*             p   = out_buf;
+    const uint8_t* const end = out_buf + out_buf_size;
 
     // decode the data
     for (size_t i = 0; i < buf_size;)
@@ -188,11 +259,8 @@ bool bra_rle_decode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf
         {
             // literal block
             const int count = control + 1;
-
-            // safety check can be skipped
-            // as it has been performed already when determine the out_buf_size
-            if (i + count > buf_size)
-                goto BRA_RLE_DECODE_ERROR;
+            if (i + count > buf_size || end - p < count)
+                return false;
 
             memcpy(p, &buf[i], count);
             i += count;
@@ -202,8 +270,8 @@ bool bra_rle_decode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf
         {
             // run block
             const int count = 1 - control;
-            if (i >= buf_size)
-                goto BRA_RLE_DECODE_ERROR;
+            if (i >= buf_size || end - p < count)
+                return false;
 
             const uint8_t v = buf[i++];
             memset(p, v, count);
@@ -214,11 +282,6 @@ bool bra_rle_decode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf
         }
     }
 
-    *out_buf_size = s;
-    *out_buf      = b;
-    return true;
-
-BRA_RLE_DECODE_ERROR:
-    free(b);
-    return false;
+    *out_size = (size_t) (p - out_buf);
+    return *out_size > 0;
 }
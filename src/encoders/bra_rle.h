@@ -13,6 +13,7 @@
  *  - -128       : not used
  *
  * @note Caller must free @p *out_buf on success
+ * @note @p *out_buf is allocated with the worst case size #BRA_RLE_ENCODE_BOUND(@p buf_size).
  *
  * @param buf           Input buffer to encode.
  * @param buf_size      Size of the input buffer in bytes.
@@ -23,6 +24,21 @@
  */
 bool bra_rle_encode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf, size_t* out_buf_size);
 
+/**
+ * @brief Encode a buffer using Run-Length Encoding as PackBits into a caller provided buffer.
+ *
+ * @see bra_rle_encode
+ *
+ * @param buf           Input buffer to encode.
+ * @param buf_size      Size of the input buffer in bytes.
+ * @param out_buf       Output buffer, #BRA_RLE_ENCODE_BOUND(@p buf_size) bytes are always enough.
+ * @param out_buf_size  Capacity of @p out_buf in bytes.
+ * @param out_size      Encoded size in bytes.
+ * @retval true         on successful encoding.
+ * @retval false        if @p out_buf is too small.
+ */
+bool bra_rle_encode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
+
 /**
  * @brief Compute the decode RLE buffer size.
  *
@@ -45,3 +61,16 @@ size_t bra_rle_decode_compute_size(const uint8_t* buf, const size_t buf_size);
  * @retval false        on error.
  */
 bool bra_rle_decode(const uint8_t* buf, const size_t buf_size, uint8_t** out_buf, size_t* out_buf_size);
+
+/**
+ * @brief Decode Run-Length Encoded data into a caller provided buffer.
+ *
+ * @param buf           Input buffer to decode.
+ * @param buf_size      Size of the input buffer in bytes.
+ * @param out_buf       Output buffer decoded.
+ * @param out_buf_size  Capacity of @p out_buf in bytes.
+ * @param out_size      Decoded size in bytes.
+ * @retval true         on successful decoding.
+ * @retval false        on corrupted data or if @p out_buf is too small.
+ */
+bool bra_rle_decode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
@@ -0,0 +1,168 @@
+#include <encoders/bra_zrle.h>
+
+#include <lib_bra_defs.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Write the run of @p run zeros as RUNA/RUNB digits.
+ */
+static inline bool _bra_zrle_encode_run(size_t run, uint8_t** p, const uint8_t* const end)
+{
+    assert(run > 0);
+
+    while (run > 0)
+    {
+        if (*p == end)
+            return false;
+
+        --run;
+        *(*p)++   = (run & 1) ? BRA_ZRLE_RUNB : BRA_ZRLE_RUNA;
+        run     >>= 1;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decode the zero-run encoded data, writing only when @p out_buf is not @c NULL.
+ *
+ * @return size_t the decoded size, 0 on error.
+ */
+static size_t _bra_zrle_decode(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size)
+{
+    assert(buf != NULL);
+
+    size_t size   = 0;
+    size_t run    = 0;
+    size_t weight = 1;
+    for (size_t i = 0; i < buf_size; ++i)
+    {
+        const uint8_t sym = buf[i];
+        if (sym <= BRA_ZRLE_RUNB)
+        {
+            // sym + 1 is the digit, the run can't be longer than the output.
+            if (weight > out_buf_size / 2)
+                return 0;
+
+            const size_t d = (sym + 1U) * weight;
+            if (d > out_buf_size - size - run)
+                return 0;
+
+            run    += d;
+            weight <<= 1;
+
+            continue;
+        }
+
+        // end of a zero run
+        if (run > 0)
+        {
+            if (out_buf != NULL)
+                memset(&out_buf[size], 0, run);
+
+            size   += run;
+            run     = 0;
+            weight  = 1;
+        }
+
+        if (size == out_buf_size)
+            return 0;
+
+        uint8_t rank = sym - 1;
+        if (sym == BRA_ZRLE_ESC)
+        {
+            if (++i == buf_size || buf[i] > 1)
+                return 0;
+
+            rank = BRA_ZRLE_ESC - 1 + buf[i];
+        }
+
+        if (out_buf != NULL)
+            out_buf[size] = rank;
+        ++size;
+    }
+
+    if (run > 0)
+    {
+        if (out_buf != NULL)
+            memset(&out_buf[size], 0, run);
+
+        size += run;
+    }
+
+    return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool bra_zrle_encode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    *out_size = 0;
+
+    uint8_t*             p   = out_buf;
+    const uint8_t* const end = out_buf + out_buf_size;
+    size_t               run = 0;
+    for (size_t i = 0; i < buf_size; ++i)
+    {
+        const uint8_t rank = buf[i];
+        if (rank == 0)
+        {
+            ++run;
+            continue;
+        }
+
+        if (run > 0)
+        {
+            if (!_bra_zrle_encode_run(run, &p, end))
+                return false;
+
+            run = 0;
+        }
+
+        if (rank < BRA_ZRLE_ESC - 1)
+        {
+            if (p == end)
+                return false;
+
+            *p++ = rank + 1;
+        }
+        else
+        {
+            if (end - p < 2)
+                return false;
+
+            *p++ = BRA_ZRLE_ESC;
+            *p++ = rank - (BRA_ZRLE_ESC - 1);
+        }
+    }
+
+    if (run > 0 && !_bra_zrle_encode_run(run, &p, end))
+        return false;
+
+    *out_size = (size_t) (p - out_buf);
+    return true;
+}
+
+size_t bra_zrle_decode_compute_size(const uint8_t* buf, const size_t buf_size)
+{
+    assert(buf != NULL);
+
+    return _bra_zrle_decode(buf, buf_size, NULL, SIZE_MAX / 2);
+}
+
+bool bra_zrle_decode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size)
+{
+    assert(buf != NULL);
+    assert(out_buf != NULL);
+    assert(out_size != NULL);
+
+    *out_size = _bra_zrle_decode(buf, buf_size, out_buf, out_buf_size);
+    return *out_size > 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief Encode MTF ranks with the zero-run coding of bzip2.
+ *
+ * After BWT+MTF the data is dominated by runs of rank 0, they are written as the
+ * bijective base-2 digits of their length, least significant first, with 2 symbols:
+ *  - #BRA_ZRLE_RUNA : digit 1
+ *  - #BRA_ZRLE_RUNB : digit 2
+ *
+ * The other ranks are shifted by one to leave room for them:
+ *  - rank 1 to 253   : symbol rank + 1
+ *  - rank 254 or 255 : #BRA_ZRLE_ESC followed by the symbol rank - 254.
+ *
+ * The output is meant to feed the Huffman stage directly.
+ *
+ * @param buf           MTF ranks to encode.
+ * @param buf_size      Size of @p buf in bytes.
+ * @param out_buf       Output buffer, 2 * @p buf_size bytes are always enough.
+ * @param out_buf_size  Capacity of @p out_buf in bytes.
+ * @param out_size      Encoded size in bytes.
+ * @retval true         on successful encoding.
+ * @retval false        if @p out_buf is too small.
+ */
+bool bra_zrle_encode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
+
+/**
+ * @brief Compute the decoded size of zero-run encoded data.
+ *
+ * @param buf      zero-run encoded buffer.
+ * @param buf_size zero-run encoded buffer size in bytes.
+ * @return size_t decoded size. 0 on error or when @p buf_size is 0.
+ */
+size_t bra_zrle_decode_compute_size(const uint8_t* buf, const size_t buf_size);
+
+/**
+ * @brief Decode zero-run encoded data back to MTF ranks into a caller provided buffer.
+ *
+ * @see bra_zrle_encode2
+ *
+ * @param buf           Input buffer to decode.
+ * @param buf_size      Size of the input buffer in bytes.
+ * @param out_buf       Output buffer decoded.
+ * @param out_buf_size  Capacity of @p out_buf in bytes.
+ * @param out_size      Decoded size in bytes.
+ * @retval true         on successful decoding.
+ * @retval false        on corrupted data or if @p out_buf is too small.
+ */
+bool bra_zrle_decode2(const uint8_t* buf, const size_t buf_size, uint8_t* out_buf, const size_t out_buf_size, size_t* out_size);
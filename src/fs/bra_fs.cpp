@@ -6,9 +6,7 @@
 #include <iostream>
 #include <string>
 #include <cctype>
-#include <regex>
 #include <algorithm>
-#include <limits>
 
 namespace bra::fs
 {
@@ -20,7 +18,19 @@ using namespace std;
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-bool try_sanitize(std::filesystem::path& path) noexcept
+path_sanitizer::path_sanitizer() noexcept
+{
+    error_code ec;
+
+    m_cwd = fs::current_path(ec);
+    if (ec)
+    {
+        bra_log_error("unable to get current directory: %s", ec.message().c_str());
+        m_cwd.clear();
+    }
+}
+
+bool path_sanitizer::sanitize_fs(std::filesystem::path& path) const noexcept
 {
     error_code ec;
     auto       err = [&path, &ec]() {
@@ -28,17 +38,14 @@ bool try_sanitize(std::filesystem::path& path) noexcept
         return false;
     };
 
-    auto abs = fs::absolute(path, ec);
-    if (ec)
-        return err();
+    const fs::path abs = path.is_absolute() ? path : m_cwd / path;
 
-    fs::path p = abs.lexically_relative(fs::current_path(ec));
-    if (ec)
-        return err();
+    fs::path p = abs.lexically_relative(m_cwd);
     if (p.empty())
         return false;
 
-    p = fs::relative(p, fs::current_path(), ec);
+    // resolve the symlinks
+    p = fs::relative(m_cwd / p, m_cwd, ec);
     if (ec)
         return err();
 
@@ -50,14 +57,81 @@ bool try_sanitize(std::filesystem::path& path) noexcept
     else
         path = p;
 
-    path = path.lexically_normal().generic_string();
+    return true;
+}
+
+bool path_sanitizer::has_symlink(const std::filesystem::path& path) const
+{
+    // the components not existing can't be symlinks, neither the ones below them.
+    fs::path p = m_cwd;
     for (const auto& p_ : path)
     {
-        if (p_ == "..")
+        error_code ec;
+        p               /= p_;
+        const auto st    = fs::symlink_status(p, ec);
+        if (ec || !fs::exists(st))
             return false;
+        if (fs::is_symlink(st))
+            return true;
     }
 
-    return !path.empty();
+    return false;
+}
+
+bool path_sanitizer::sanitize(std::filesystem::path& path) const noexcept
+{
+    if (m_cwd.empty())
+        return false;
+
+    try
+    {
+        // a ".." after a symlink doesn't go back to the lexical parent.
+        const bool has_dot_dot = std::any_of(path.begin(), path.end(), [](const fs::path& p_) { return p_ == ".."; });
+
+        bool lexical = !has_dot_dot;
+        if (lexical && path.is_absolute())
+        {
+            // it might still be under the current directory through a symlink
+            fs::path p = path.lexically_relative(m_cwd);
+            lexical    = !p.empty() && *p.begin() != "..";
+            if (lexical)
+                path = std::move(p);
+        }
+        else if (path.has_root_name() || path.has_root_directory())
+            lexical = false;
+
+        // a symlink could lead out of the current directory.
+        if (lexical && has_symlink(path))
+            lexical = false;
+
+        if (!lexical && !sanitize_fs(path))
+            return false;
+
+        string s = path.lexically_normal().generic_string();
+        if (s.size() > 1 && s.back() == '/')
+            s.pop_back();
+
+        path = std::move(s);
+        for (const auto& p_ : path)
+        {
+            if (p_ == "..")
+                return false;
+        }
+
+        return !path.empty();
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_error("unable to sanitize path '%s': %s", path.string().c_str(), e.what());
+        return false;
+    }
+}
+
+bool try_sanitize(std::filesystem::path& path) noexcept
+{
+    const path_sanitizer sanitizer;
+
+    return sanitizer.sanitize(path);
 }
 
 bool dir_exists(const std::filesystem::path& path) noexcept
@@ -106,10 +180,11 @@ bool dir_isSubDir(const std::filesystem::path& base, const std::filesystem::path
 {
     error_code ec;
 
-    fs::path b = base;
-    fs::path p = path;
+    const path_sanitizer sanitizer;
+    fs::path             b = base;
+    fs::path             p = path;
 
-    if (!try_sanitize(b) || !try_sanitize(p))
+    if (!sanitizer.sanitize(b) || !sanitizer.sanitize(p))
         return false;
 
     if (b.empty() || p.empty() || b == p)
@@ -125,7 +200,7 @@ bool dir_isSubDir(const std::filesystem::path& base, const std::filesystem::path
     }
 
     // Ensure p is a non-empty relative subpath of base (dot‑prefixed names allowed); sanitized above.
-    if (!try_sanitize(p))
+    if (!sanitizer.sanitize(p))
         return false;
 
     if (isRoot && p.parent_path().empty())
@@ -291,6 +366,29 @@ std::optional<bra_attr_t> file_attributes(const std::filesystem::path& base, con
     return nullopt;
 }
 
+std::optional<file_info> file_stat(const std::filesystem::path& path) noexcept
+{
+    std::error_code ec;
+    auto            err = [&path, &ec]() {
+        bra_log_error("unable to read file status of %s: %s", path.string().c_str(), ec.message().c_str());
+        return nullopt;
+    };
+
+    file_info info;
+    info.type = fs::status(path, ec).type();
+    if (ec && info.type != fs::file_type::not_found)
+        return err();
+
+    if (info.type == fs::file_type::regular)
+    {
+        info.size = fs::file_size(path, ec);
+        if (ec)
+            return err();
+    }
+
+    return info;
+}
+
 std::optional<uint64_t> file_size(const std::filesystem::path& path) noexcept
 {
     std::error_code ec;
@@ -384,110 +482,56 @@ bool file_permissions(const std::filesystem::path& path, const std::filesystem::
     return true;
 }
 
-bool file_set_add_dirs(std::set<std::filesystem::path>& files) noexcept
+bool search(const std::filesystem::path& dir, const std::string& pattern, file_list& out_files, const bool recursive, const walk_options& options) noexcept
 {
-    std::list<fs::path> listFiles(files.begin(), files.end());
-    files.clear();
-    while (!listFiles.empty())
-    {
-        // NOTE: as it is a set i can just insert multiple time the directory
-        //       and when iterate later it, resolve it on it.
-        //       need to keep track of the last directory entry to remove from the file.
-
-        const auto f = listFiles.front();
-        listFiles.pop_front();
-
-        // skip current dir "." as no valuable information.
-        // it is by default starting from there.
-        if (f == ".")
-            continue;
-
-        if (!dir_exists(f) && !file_exists(f))
-        {
-            bra_log_error("%s is neither a regular file nor a directory", f.string().c_str());
-
-            return false;
-        }
-
-        fs::path f_ = f;
-        if (!bra::fs::try_sanitize(f_))
-        {
-            bra_log_error("path not valid: %s - (%s)", f.string().c_str(), f_.string().c_str());
-
-            return false;
-        }
-
-        fs::path p_;
-        p_.clear();
-        for (const auto& p : f_)
-        {
-            p_ /= p;
-            files.insert(p_);
-        }
-        if (p_ != f_)
-        {
-            bra_log_error("expected %s == %s", p_.string().c_str(), f_.string().c_str());
-            return false;
-        }
-    }
+    if (recursive)
+        return walk(dir, pattern, out_files, options);
 
-    if (files.size() > numeric_limits<uint32_t>::max())
-    {
-        bra_log_error("Too many files, not supported yet: %zu/%u", files.size(), numeric_limits<uint32_t>::max());
-        return false;
-    }
-
-    return true;
-}
-
-bool search(const std::filesystem::path& dir, const std::string& pattern, std::list<std::filesystem::path>& out_files, const bool recursive) noexcept
-{
     try
     {
-        const std::regex r(pattern);
+        const bra::wildcards::glob_matcher glob(pattern);
+        const path_sanitizer               sanitizer;
 
-        // TODO: add a cli flag for fs::directory_options::skip_permission_denied
-        // TODO: add a cli flag for fs::directory_options::follow_directory_symlink (to replace symlink with the real file)
         for (const auto& entry : fs::directory_iterator(dir))
         {
-            fs::path   ep     = entry.path();
-            const bool is_dir = dir_exists(ep);
-            if (!(file_exists(ep) || is_dir))
-                continue;
+            fs::path ep = entry.path();
 
-            const std::string filename = ep.filename().string();
+            // the type is cached from the directory scan, only symlinks need to be resolved with a stat.
+            error_code ec;
+            file_info  info;
+            if (entry.is_regular_file(ec))
+            {
+                info.type = fs::file_type::regular;
+                info.size = entry.file_size(ec);
+            }
+            else if (!ec && entry.is_directory(ec))
+                info.type = fs::file_type::directory;
 
-            if (is_dir)
+            if (ec)
             {
-                // TODO: it might be better to use recursive_directory_iterator instead
-                //       of bra::fs::search being recursive itself.
-                if (!recursive)
-                {
-                    bra_log_info("Skip directory: %s", filename.c_str());
-                    continue;
-                }
-
-#ifndef NDEBUG
-                bra_log_verbose("Matched dir: %s", ep.string().c_str());
-#endif
-
-                // out_files.push_back(ep);    // but if it is not a wildcard match it shouldn't be added.
-                if (!search(ep, pattern, out_files, recursive))
-                    return false;
+                bra_log_error("can't check %s: %s", ep.string().c_str(), ec.message().c_str());
+                continue;
             }
 
-            // here is either a file or a dir
-            if (!std::regex_match(filename, r))
+            if (info.type == fs::file_type::directory)
+            {
+                bra_log_info("Skip directory: %s", ep.filename().string().c_str());
+                continue;
+            }
+            else if (info.type != fs::file_type::regular)
+                continue;
+
+            if (!glob.match(ep.filename().string()))
                 continue;
 
             // ep is a file
-            if (!try_sanitize(ep))
+            if (!sanitizer.sanitize(ep))
             {
                 bra_log_error("not a valid file: %s", ep.string().c_str());
                 return false;
             }
 
-            out_files.push_back(ep);
+            out_files.emplace_back(std::move(ep), info);
         }
 
         return true;
@@ -497,14 +541,14 @@ bool search(const std::filesystem::path& dir, const std::string& pattern, std::l
         bra_log_error("Filesystem: %s", e.what());
         return false;
     }
-    catch (const std::regex_error& e)
+    catch (const std::exception& e)
     {
-        bra_log_error("Regex: %s", e.what());
+        bra_log_error("search: %s", e.what());
         return false;
     }
 }
 
-bool search_wildcard(const std::filesystem::path& wildcard_path, std::set<std::filesystem::path>& out_files, const bool recursive) noexcept
+bool search_wildcard(const std::filesystem::path& wildcard_path, file_table& out_files, const bool recursive, const walk_options& options) noexcept
 {
     fs::path p = wildcard_path.generic_string();
 
@@ -515,42 +559,18 @@ bool search_wildcard(const std::filesystem::path& wildcard_path, std::set<std::f
         return false;
 
     const fs::path dir     = bra::wildcards::wildcard_extract_dir(p);
-    const string   pattern = bra::wildcards::wildcard_to_regexp(p.string());
+    const string   pattern = p.generic_string();
 
-    std::list<fs::path> files;
-    if (!bra::fs::search(dir, pattern, files, recursive))
+    file_list files;
+    if (!bra::fs::search(dir, pattern, files, recursive, options))
     {
         bra_log_error("search failed in %s for wildcard %s", dir.string().c_str(), p.string().c_str());
         return false;
     }
 
-    while (!files.empty())
+    for (const auto& [f, info] : files)
     {
-        const auto& f = files.front();
-        if (!out_files.insert(f).second)
-            bra_log_warn("duplicate file given in input: %s", f.string().c_str());
-        files.pop_front();
-    }
-    return true;
-}
-
-bool make_tree(const std::set<std::filesystem::path>& set_files, std::map<std::filesystem::path, std::set<std::filesystem::path>>& tree, size_t& out_tree_size) noexcept
-{
-    out_tree_size = 0;
-    for (const auto& f : set_files)
-    {
-        if (dir_exists(f))
-        {
-            tree.insert({f, std::set<fs::path>()});
-            ++out_tree_size;
-        }
-        else if (file_exists(f))
-        {
-            auto d = f.parent_path();
-            tree[d].insert(f.filename());
-            ++out_tree_size;
-        }
-        else
+        if (!out_files.add(f, info))
             return false;
     }
 
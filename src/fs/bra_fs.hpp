@@ -10,23 +10,212 @@
 
 
 #include <lib_bra_types.h>
+#include <utils/bra_arena.h>
 
 #include <filesystem>
+#include <functional>
 #include <optional>
 #include <string>
 #include <list>
-#include <set>
-#include <map>
+#include <vector>
+#include <string_view>
+#include <utility>
+#include <cstdint>
 
 namespace bra::fs
 {
 
+/**
+ * @brief Status of a path cached when it is scanned, so the same path doesn't need to be stat'ed again later on.
+ */
+struct file_info
+{
+    std::filesystem::file_type type = std::filesystem::file_type::none;    //!< type with symlinks resolved; @c none when unknown yet.
+    uint64_t                   size = 0;                                    //!< size in bytes of a regular file; @c 0 otherwise.
+
+    bool operator==(const file_info&) const = default;
+};
+
+/**
+ * @brief Entry of a @ref file_table. The path is NUL-terminated and lives in the table arena.
+ */
+struct file_entry
+{
+    static constexpr uint32_t no_ref = UINT32_MAX;    //!< @p ref of an entry not duplicated.
+
+    std::string_view path;                 //!< relative path in generic format.
+    uint32_t         dir_len    = 0;       //!< length of the parent directory in @p path; @c 0 at top level.
+    file_info        info;
+    uint32_t         ref        = no_ref;  //!< index in the table of the first entry with the same contents, see @ref file_table::dedup.
+    uint32_t         crc32      = 0;       //!< CRC32C of the contents of a duplicate file.
+    bool             referenced = false;   //!< a later entry is a duplicate of this one.
+
+    [[nodiscard]] std::string_view dir() const noexcept { return path.substr(0, dir_len); }
+
+    [[nodiscard]] std::string_view name() const noexcept { return path.substr(dir_len == 0 ? 0 : dir_len + 1); }
+
+    [[nodiscard]] bool is_dir() const noexcept { return info.type == std::filesystem::file_type::directory; }
+};
+
+/**
+ * @brief Flat table of the entries to archive, with the paths stored in an arena.
+ *
+ * @details Entries are appended unsorted while scanning; @ref finalize sorts them once
+ *          in archive order: each directory followed by its files, parent directories first.
+ */
+class file_table
+{
+private:
+    file_table(const file_table&)            = delete;
+    file_table& operator=(const file_table&) = delete;
+    file_table(file_table&&)                 = delete;
+    file_table& operator=(file_table&&)      = delete;
+
+    bra_arena_t             m_arena;
+    std::vector<file_entry> m_entries;
+
+    void sort_unique(const bool warn_duplicates) noexcept;
+
+public:
+    using const_iterator = std::vector<file_entry>::const_iterator;
+
+    file_table();
+    ~file_table();
+
+    /**
+     * @brief Append @p path with its cached status. @c "." and empty paths are ignored.
+     *
+     * @param path relative path, already sanitized (see @ref try_sanitize).
+     * @param info
+     * @retval true on success.
+     * @retval false on allocation failure.
+     */
+    [[nodiscard]] bool add(std::string_view path, const file_info& info) noexcept;
+    [[nodiscard]] bool add(const std::filesystem::path& path, const file_info& info) noexcept;
+
+    /**
+     * @brief Stat the entries without a cached status, add the missing parent directories,
+     *        then sort in archive order and remove the duplicates in place.
+     *
+     * @retval true on success.
+     * @retval false if an entry is neither a regular file nor a directory, or there are too many entries.
+     */
+    [[nodiscard]] bool finalize() noexcept;
+
+    /**
+     * @brief Sort the files of each directory by extension, then by name, keeping the archive order.
+     *        Similar files next to each other compress better together in a solid block.
+     *
+     * @note To be called after @ref finalize.
+     */
+    void sort_by_extension() noexcept;
+
+    /**
+     * @brief Find the files with the same contents, hashing them with @p num_threads threads.
+     *        Each duplicate gets the index of its first copy in archive order.
+     *
+     * @details Only the files sharing their size are read: their CRC32C first,
+     *          then the SHA-256 of the ones sharing also the CRC32C.
+     *
+     * @note To be called when the table is in its final order, the indexes are not updated.
+     *
+     * @param num_threads worker threads; @c 0 selects the hardware concurrency.
+     * @retval true on success.
+     * @retval false if a file can't be read.
+     */
+    [[nodiscard]] bool dedup(const unsigned num_threads) noexcept;
+
+    [[nodiscard]] const file_entry& operator[](const size_t i) const noexcept { return m_entries[i]; }
+
+    /**
+     * @brief Remove @p path from the table.
+     *
+     * @param path
+     * @return size_t number of removed entries.
+     */
+    size_t erase(const std::filesystem::path& path) noexcept;
+
+    /**
+     * @brief Remove the entries matching @p pred from the table, keeping the order of the others.
+     *
+     * @param pred
+     * @return size_t number of removed entries.
+     */
+    size_t erase_if(const std::function<bool(const file_entry&)>& pred) noexcept;
+
+    /**
+     * @brief Count the entries with the given @p path.
+     *
+     * @param path
+     * @return size_t
+     */
+    [[nodiscard]] size_t count(const std::filesystem::path& path) const noexcept;
+
+    void clear() noexcept;
+
+    [[nodiscard]] size_t size() const noexcept { return m_entries.size(); }
+
+    [[nodiscard]] bool empty() const noexcept { return m_entries.empty(); }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return m_entries.begin(); }
+
+    [[nodiscard]] const_iterator end() const noexcept { return m_entries.end(); }
+};
+
+/**
+ * @brief Paths with their cached status in scan order.
+ */
+using file_list = std::list<std::pair<std::filesystem::path, file_info>>;
+
+/**
+ * @brief Options of the recursive directory walk.
+ */
+struct walk_options
+{
+    bool     follow_symlinks        = true;     //!< archive the targets of symlinks and descend into symlinked directories; skip them otherwise.
+    bool     skip_permission_denied = false;    //!< skip the directories that can't be read with a warning instead of failing.
+    unsigned num_threads            = 0;        //!< worker threads; @c 0 selects them from the hardware concurrency.
+};
+
+/**
+ * @brief Path sanitizer bound to the current directory captured once at construction.
+ *
+ * @details Paths are normalized lexically against the captured directory, once none of their existing
+ *          components is a symlink. The symlinks are resolved otherwise, as when the path has a @c ".."
+ *          component, or it is absolute but not lexically below the captured directory.
+ */
+class path_sanitizer
+{
+private:
+    std::filesystem::path m_cwd;
+
+    [[nodiscard]] bool sanitize_fs(std::filesystem::path& path) const noexcept;
+    [[nodiscard]] bool has_symlink(const std::filesystem::path& path) const;
+
+public:
+    path_sanitizer() noexcept;
+    ~path_sanitizer() = default;
+
+    /**
+     * @brief Same as @ref try_sanitize, relative to the captured directory.
+     *
+     * @param path
+     * @retval true if it is successful
+     * @retval false otherwise
+     */
+    [[nodiscard]] bool sanitize(std::filesystem::path& path) const noexcept;
+
+    [[nodiscard]] const std::filesystem::path& cwd() const noexcept { return m_cwd; }
+};
+
 /**
  * @brief Try to sanitize the @p path.
  *        It must be relative to the current directory.
  *        It can't escape the current directory.
  *        Existence is not checked; it only rewrites to a safe, relative path.
  *
+ * @note To sanitize many paths, use a single @ref path_sanitizer instead.
+ *
  * @param path
  * @retval true if it is successful
  * @retval false otherwise
@@ -132,6 +321,14 @@ namespace bra::fs
  */
 [[nodiscard]] std::optional<bra_attr_t> file_attributes(const std::filesystem::path& base, const std::filesystem::path& path) noexcept;
 
+/**
+ * @brief Read type and size of @p path in one go.
+ *
+ * @param path
+ * @return std::optional<file_info> the status, with type @c not_found if @p path doesn't exist; @c nullopt on error.
+ */
+[[nodiscard]] std::optional<file_info> file_stat(const std::filesystem::path& path) noexcept;
+
 /**
  * @brief Get the size of a file or directory.
  *
@@ -177,52 +374,50 @@ namespace bra::fs
 
 
 /**
- * @brief Extend the @p files set with their directories.
+ * @brief Recursively walk @p dir in parallel, collecting the files and directories whose filename matches the wildcard @p pattern.
+ *        Sub-directories are scanned by a pool of work-stealing threads.
  *
- * @details the parent directories from the files present in @p files are added into @p files.
+ * @note  The existing contents of @p out_files are preserved; the results are appended sorted by path.
  *
- * @param files
- * @retval true on success.
- * @retval false on error. The @p files set may be left in an invalid state.
+ * @param dir
+ * @param pattern Wildcard pattern matched against the filenames, see bra::wildcards::glob_matcher
+ * @param out_files List to append matching file paths and their status to
+ * @param options
+ * @retval true if successful
+ * @retval false otherwise
  */
-[[nodiscard]] bool file_set_add_dirs(std::set<std::filesystem::path>& files) noexcept;
+[[nodiscard]] bool walk(const std::filesystem::path& dir, const std::string& pattern, file_list& out_files, const walk_options& options) noexcept;
 
 /**
- * @brief Search for files in the given @p dir matching the regular expression @p pattern.
+ * @brief Search for files in the given @p dir matching the wildcard @p pattern.
  *        It stores the results in @p out_files.
  *
  * @note  The existing contents of @p out_files are preserved (results are appended).
+ *        The type of each entry comes from the directory scan; only regular files are stat'ed for their size.
+ *
+ * @see walk
  *
  * @param dir
- * @param pattern Regular expression pattern (not a wildcard pattern)
- * @param out_files List to append matching file paths to
- * @param recursive If false performs a non-recursive search in the immediate directory only; recursive otherwise.
+ * @param pattern Wildcard pattern matched against the filenames, see bra::wildcards::glob_matcher
+ * @param out_files List to append matching file paths and their status to
+ * @param recursive If false performs a non-recursive search in the immediate directory only; recursive otherwise using @ref walk.
+ * @param options used when @p recursive.
  * @retval true if successful
  * @retval false otherwise
  */
-[[nodiscard]] bool search(const std::filesystem::path& dir, const std::string& pattern, std::list<std::filesystem::path>& out_files, const bool recursive) noexcept;
+[[nodiscard]] bool search(const std::filesystem::path& dir, const std::string& pattern, file_list& out_files, const bool recursive, const walk_options& options = {}) noexcept;
 
 /**
  * @brief Expand the given @p wildcard_path and store the resulting paths into @p out_files.
- *        It doesn't clear @p out_files, but it adds on it.
+ *        It doesn't clear @p out_files, but it adds on it. Duplicates are resolved by @ref file_table::finalize.
  *
  * @param wildcard_path
  * @param out_files
  * @param recursive
+ * @param options used when @p recursive.
  * @retval true on success and add the results to @p out_files
  * @retval false on error (unsupported wildcard, sanitization failure, or search failure).
  */
-[[nodiscard]] bool search_wildcard(const std::filesystem::path& wildcard_path, std::set<std::filesystem::path>& out_files, const bool recursive) noexcept;
-
-/**
- * @brief Make a tree from @p set_files into @p tree. Counting also all the elements into @p out_tree.
- *
- * @param set_files
- * @param tree
- * @param out_tree_size
- * @retval true
- * @retval false
- */
-[[nodiscard]] bool make_tree(const std::set<std::filesystem::path>& set_files, std::map<std::filesystem::path, std::set<std::filesystem::path>>& tree, size_t& out_tree_size) noexcept;
+[[nodiscard]] bool search_wildcard(const std::filesystem::path& wildcard_path, file_table& out_files, const bool recursive, const walk_options& options = {}) noexcept;
 
 }    // namespace bra::fs
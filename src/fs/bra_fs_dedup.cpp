@@ -0,0 +1,203 @@
+#include <fs/bra_fs.hpp>
+
+#include <log/bra_log.h>
+#include <utils/bra_sha256.h>
+
+extern "C" {
+#include <utils/lib_bra_crc32c.h>
+}
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace bra::fs
+{
+
+namespace fs = std::filesystem;
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+constexpr size_t DEDUP_BUF_SIZE = BRA_CHUNK_SIZE;    //!< bytes read at once while hashing.
+
+using sha256_digest = std::array<uint8_t, BRA_SHA256_DIGEST_SIZE>;
+
+/**
+ * @brief Read the whole file @p path, calling @p update on each piece.
+ */
+bool read_file(const std::string_view path, const uint64_t size, std::vector<char>& buf, const std::function<void(const char*, size_t)>& update)
+{
+    std::ifstream f(fs::path(path), std::ios::binary);
+    if (!f)
+    {
+        bra_log_error("unable to open %s", path.data());
+        return false;
+    }
+
+    for (uint64_t i = 0; i < size;)
+    {
+        const size_t s = static_cast<size_t>(std::min<uint64_t>(buf.size(), size - i));
+        if (!f.read(buf.data(), static_cast<std::streamsize>(s)))
+        {
+            bra_log_error("unable to read %s", path.data());
+            return false;
+        }
+
+        update(buf.data(), s);
+        i += s;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Run @p fn on the indexes 0 to @p n - 1 with @p num_threads threads, @c 0 for the hardware concurrency.
+ */
+bool parallel_for(const size_t n, const unsigned num_threads, const std::function<bool(size_t, std::vector<char>&)>& fn)
+{
+    std::atomic<size_t> next{0};
+    std::atomic<bool>   failed{false};
+
+    const auto worker = [&]() noexcept {
+        try
+        {
+            std::vector<char> buf(DEDUP_BUF_SIZE);
+            for (size_t i = next++; i < n && !failed; i = next++)
+            {
+                if (!fn(i, buf))
+                    failed = true;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            bra_log_error("dedup: %s", e.what());
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const unsigned           nt = num_threads != 0 ? num_threads : std::max(std::thread::hardware_concurrency(), 1U);
+    const unsigned           t  = static_cast<unsigned>(std::clamp<size_t>(n, 1, nt));
+    threads.reserve(t - 1);
+    for (unsigned i = 1; i < t; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+    for (auto& th : threads)
+        th.join();
+
+    return !failed;
+}
+
+/**
+ * @brief Keep in @p idx only the runs of at least 2 consecutive entries with the same @p key.
+ */
+template<typename K>
+void keep_shared(std::vector<uint32_t>& idx, const K& key)
+{
+    std::vector<uint32_t> out;
+    for (size_t i = 0; i < idx.size();)
+    {
+        size_t j = i + 1;
+        while (j < idx.size() && key(idx[j]) == key(idx[i]))
+            ++j;
+
+        if (j - i > 1)
+            out.insert(out.end(), idx.begin() + static_cast<ptrdiff_t>(i), idx.begin() + static_cast<ptrdiff_t>(j));
+        i = j;
+    }
+
+    idx.swap(out);
+}
+
+}    // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool file_table::dedup(const unsigned num_threads) noexcept
+{
+    try
+    {
+        // 1. the files sharing their size, in archive order within the same size.
+        std::vector<uint32_t> idx;
+        for (uint32_t i = 0; i < m_entries.size(); ++i)
+        {
+            if (!m_entries[i].is_dir() && m_entries[i].info.size > 0)
+                idx.push_back(i);
+        }
+
+        std::stable_sort(idx.begin(), idx.end(), [this](const uint32_t a, const uint32_t b) { return m_entries[a].info.size < m_entries[b].info.size; });
+        keep_shared(idx, [this](const uint32_t i) { return m_entries[i].info.size; });
+        if (idx.empty())
+            return true;
+
+        // 2. prefilter: the ones sharing also the CRC32C.
+        std::vector<uint32_t> crc(m_entries.size());
+        const bool            res = parallel_for(idx.size(), num_threads, [this, &idx, &crc](const size_t i, std::vector<char>& buf) {
+            const file_entry& e = m_entries[idx[i]];
+            uint32_t          c = BRA_CRC32C_INIT;
+            if (!read_file(e.path, e.info.size, buf, [&c](const char* p, const size_t s) { c = bra_crc32c(p, s, c); }))
+                return false;
+
+            crc[idx[i]] = c;
+            return true;
+        });
+        if (!res)
+            return false;
+
+        const auto size_crc = [this, &crc](const uint32_t i) { return std::make_pair(m_entries[i].info.size, crc[i]); };
+        std::stable_sort(idx.begin(), idx.end(), [&size_crc](const uint32_t a, const uint32_t b) { return size_crc(a) < size_crc(b); });
+        keep_shared(idx, size_crc);
+        if (idx.empty())
+            return true;
+
+        // 3. the same contents: the same SHA-256 too.
+        std::vector<sha256_digest> digests(idx.size());
+        if (!parallel_for(idx.size(), num_threads, [this, &idx, &digests](const size_t i, std::vector<char>& buf) {
+                const file_entry& e = m_entries[idx[i]];
+                bra_sha256_t      ctx;
+                bra_sha256_init(&ctx);
+                if (!read_file(e.path, e.info.size, buf, [&ctx](const char* p, const size_t s) { bra_sha256_update(&ctx, p, s); }))
+                    return false;
+
+                bra_sha256_final(&ctx, digests[i].data());
+                return true;
+            }))
+            return false;
+
+        // the first one in archive order is the copy archived.
+        std::map<std::tuple<uint64_t, uint32_t, sha256_digest>, uint32_t> first;
+        for (size_t i = 0; i < idx.size(); ++i)
+        {
+            file_entry& e             = m_entries[idx[i]];
+            const auto [it, inserted] = first.emplace(std::make_tuple(e.info.size, crc[idx[i]], digests[i]), idx[i]);
+            e.crc32                   = crc[idx[i]];
+            if (inserted)
+                continue;
+
+            e.ref                            = it->second;
+            m_entries[it->second].referenced = true;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_critical("dedup: %s", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+}    // namespace bra::fs
@@ -0,0 +1,285 @@
+#include <fs/bra_fs.hpp>
+
+#include <log/bra_log.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace bra::fs
+{
+
+namespace fs = std::filesystem;
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/**
+ * @brief Compare 2 generic paths with '/' as the lowest character,
+ *        so a directory sorts right before all its descendants.
+ */
+int path_compare(const std::string_view a, const std::string_view b) noexcept
+{
+    const size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i)
+    {
+        const unsigned ca = a[i] == '/' ? 0U : static_cast<unsigned char>(a[i]);
+        const unsigned cb = b[i] == '/' ? 0U : static_cast<unsigned char>(b[i]);
+        if (ca != cb)
+            return ca < cb ? -1 : 1;
+    }
+
+    if (a.size() == b.size())
+        return 0;
+
+    return a.size() < b.size() ? -1 : 1;
+}
+
+/**
+ * @brief Archive order: a directory (its own group) followed by its files (the parent group), then the sub-directories.
+ */
+bool entry_less(const file_entry& a, const file_entry& b) noexcept
+{
+    const int c = path_compare(a.is_dir() ? a.path : a.dir(), b.is_dir() ? b.path : b.dir());
+    if (c != 0)
+        return c < 0;
+
+    if (a.is_dir() != b.is_dir())
+        return a.is_dir();
+
+    return a.name() < b.name();
+}
+
+/**
+ * @brief @p prefix is @p path or one of its parent directories.
+ */
+bool is_dir_prefix(const std::string_view prefix, const std::string_view path) noexcept
+{
+    return path.substr(0, prefix.size()) == prefix && (path.size() == prefix.size() || path[prefix.size()] == '/');
+}
+
+/**
+ * @brief Extension of the file name @p name without the dot, empty if none.
+ */
+std::string_view extension(const std::string_view name) noexcept
+{
+    const size_t dot = name.rfind('.');
+    return dot == std::string_view::npos || dot == 0 ? std::string_view() : name.substr(dot + 1);
+}
+
+}    // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+file_table::file_table()
+{
+    bra_arena_init(&m_arena, 0);
+}
+
+file_table::~file_table()
+{
+    bra_arena_destroy(&m_arena);
+}
+
+void file_table::sort_unique(const bool warn_duplicates) noexcept
+{
+    std::sort(m_entries.begin(), m_entries.end(), entry_less);
+
+    // same path => same group, kind and name: duplicates are adjacent.
+    const auto last = std::unique(m_entries.begin(), m_entries.end(), [warn_duplicates](const file_entry& a, const file_entry& b) {
+        if (a.path != b.path)
+            return false;
+
+        if (warn_duplicates)
+            bra_log_warn("duplicate file given in input: %s", b.path.data());
+        return true;
+    });
+    m_entries.erase(last, m_entries.end());
+}
+
+bool file_table::add(const std::string_view path, const file_info& info) noexcept
+{
+    // skip current dir "." as no valuable information.
+    // it is by default starting from there.
+    if (path.empty() || path == ".")
+        return true;
+
+    const char* s = bra_arena_strndup(&m_arena, path.data(), path.size());
+    if (s == nullptr)
+    {
+        bra_log_critical("unable to allocate memory for %s", std::string(path).c_str());
+        return false;
+    }
+
+    const size_t sep = path.rfind('/');
+    try
+    {
+        m_entries.push_back(file_entry{std::string_view(s, path.size()), sep == std::string_view::npos ? 0U : static_cast<uint32_t>(sep), info});
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_critical("unable to add %s: %s", s, e.what());
+        return false;
+    }
+
+    return true;
+}
+
+bool file_table::add(const std::filesystem::path& path, const file_info& info) noexcept
+{
+    try
+    {
+        return add(std::string_view(path.generic_string()), info);
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_critical("unable to add %s: %s", path.string().c_str(), e.what());
+        return false;
+    }
+}
+
+bool file_table::finalize() noexcept
+{
+    // status not cached by the scan
+    for (auto& e : m_entries)
+    {
+        if (e.info.type == fs::file_type::none)
+        {
+            const auto s = file_stat(fs::path(e.path));
+            if (!s)
+                return false;
+
+            e.info = *s;
+        }
+
+        if (e.info.type != fs::file_type::directory && e.info.type != fs::file_type::regular)
+        {
+            bra_log_error("%s is neither a regular file nor a directory", e.path.data());
+            return false;
+        }
+    }
+
+    sort_unique(true);
+
+    // add the missing parent directories.
+    // the entries are sorted parents first: the ancestors of the previous group are already there.
+    try
+    {
+        const size_t     n = m_entries.size();
+        std::string_view last_group;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const std::string_view dir = m_entries[i].dir();
+            if (!dir.empty() && !is_dir_prefix(dir, last_group))
+            {
+                for (size_t pos = dir.find('/'); ; pos = dir.find('/', pos + 1))
+                {
+                    const std::string_view p = dir.substr(0, pos);
+                    if (!is_dir_prefix(p, last_group) && !add(p, file_info{fs::file_type::directory, 0}))
+                        return false;
+
+                    if (pos == std::string_view::npos)
+                        break;
+                }
+            }
+
+            // NOTE: m_entries might be reallocated by add(), but the views point to the arena.
+            last_group = m_entries[i].is_dir() ? m_entries[i].path : m_entries[i].dir();
+        }
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_critical("finalize: %s", e.what());
+        return false;
+    }
+
+    sort_unique(false);
+
+    if (m_entries.size() > numeric_limits<uint32_t>::max())
+    {
+        bra_log_error("Too many files, not supported yet: %zu/%u", m_entries.size(), numeric_limits<uint32_t>::max());
+        return false;
+    }
+
+    return true;
+}
+
+void file_table::sort_by_extension() noexcept
+{
+    // the files of a directory are consecutive, right after it.
+    for (auto first = m_entries.begin(); first != m_entries.end();)
+    {
+        if (first->is_dir())
+        {
+            ++first;
+            continue;
+        }
+
+        const auto last = std::find_if(first, m_entries.end(), [first](const file_entry& e) { return e.is_dir() || e.dir() != first->dir(); });
+        std::stable_sort(first, last, [](const file_entry& a, const file_entry& b) {
+            const int c = extension(a.name()).compare(extension(b.name()));
+            return c != 0 ? c < 0 : a.name() < b.name();
+        });
+        first = last;
+    }
+}
+
+size_t file_table::erase(const std::filesystem::path& path) noexcept
+{
+    try
+    {
+        const string p    = path.generic_string();
+        const auto   last = std::remove_if(m_entries.begin(), m_entries.end(), [&p](const file_entry& e) { return e.path == p; });
+        const size_t n    = static_cast<size_t>(std::distance(last, m_entries.end()));
+
+        m_entries.erase(last, m_entries.end());
+        return n;
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_error("erase: %s", e.what());
+        return 0;
+    }
+}
+
+size_t file_table::erase_if(const std::function<bool(const file_entry&)>& pred) noexcept
+{
+    try
+    {
+        const auto   last = std::remove_if(m_entries.begin(), m_entries.end(), pred);
+        const size_t n    = static_cast<size_t>(std::distance(last, m_entries.end()));
+
+        m_entries.erase(last, m_entries.end());
+        return n;
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_error("erase: %s", e.what());
+        return 0;
+    }
+}
+
+size_t file_table::count(const std::filesystem::path& path) const noexcept
+{
+    try
+    {
+        const string p = path.generic_string();
+        return static_cast<size_t>(std::count_if(m_entries.begin(), m_entries.end(), [&p](const file_entry& e) { return e.path == p; }));
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_error("count: %s", e.what());
+        return 0;
+    }
+}
+
+void file_table::clear() noexcept
+{
+    m_entries.clear();
+    bra_arena_destroy(&m_arena);
+}
+
+}    // namespace bra::fs
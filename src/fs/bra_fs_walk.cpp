@@ -0,0 +1,347 @@
+#include <fs/bra_fs.hpp>
+
+#include <fs/bra_wildcards.hpp>
+#include <log/bra_log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace bra::fs
+{
+
+namespace fs = std::filesystem;
+
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+constexpr unsigned WALK_MAX_DEFAULT_THREADS = 16;    //!< upper bound of the worker threads when not given.
+
+/**
+ * @brief Per worker queue of the directories still to be scanned.
+ *        The owner pushes and pops at the back (depth-first), thieves steal from the front.
+ */
+struct WalkQueue
+{
+    std::mutex           mutex;
+    std::deque<fs::path> dirs;
+};
+
+/**
+ * @brief Work-stealing recursive directory walker.
+ *
+ * @details Every worker scans one directory at a time, the sub-directories found are queued
+ *          in its own queue, idle workers steal them from the others.
+ *          Workers without anything to steal sleep until a directory is queued or the walk is over.
+ *          Matching entries are collected per worker and merged, sorted, at the end.
+ */
+class DirWalker
+{
+private:
+    DirWalker(const DirWalker&)            = delete;
+    DirWalker& operator=(const DirWalker&) = delete;
+    DirWalker(DirWalker&&)                 = delete;
+    DirWalker& operator=(DirWalker&&)      = delete;
+
+    const bra::wildcards::glob_matcher&       m_glob;
+    const walk_options&                       m_options;
+    std::vector<std::unique_ptr<WalkQueue>>   m_queues;
+    std::vector<file_list>                    m_results;
+    std::atomic<size_t>                       m_pending{0};    //!< directories queued or being scanned.
+    std::atomic<size_t>                       m_queued{0};     //!< directories queued only.
+    std::atomic<bool>                         m_failed{false};
+    std::mutex                                m_idle_mutex;
+    std::condition_variable                   m_idle_cv;    //!< wakes the idle workers up.
+    std::mutex                                m_visited_mutex;
+    std::set<fs::path>                        m_visited;    //!< canonical targets of the followed directory symlinks.
+
+    /**
+     * @brief Wake the idle workers up after a change of the state they wait on.
+     *
+     * @param all @c true when the walk is over, @c false when only a directory has been queued.
+     */
+    void notify_idle(const bool all)
+    {
+        // the waiters check the state holding the lock: taking it here can't miss one about to sleep.
+        {
+            const std::lock_guard lock(m_idle_mutex);
+        }
+
+        if (all)
+            m_idle_cv.notify_all();
+        else
+            m_idle_cv.notify_one();
+    }
+
+    void push(const unsigned id, fs::path dir)
+    {
+        ++m_pending;
+        {
+            const std::lock_guard lock(m_queues[id]->mutex);
+            m_queues[id]->dirs.push_back(std::move(dir));
+            ++m_queued;
+        }
+
+        notify_idle(false);
+    }
+
+    void fail()
+    {
+        m_failed = true;
+        notify_idle(true);
+    }
+
+    bool pop(const unsigned id, fs::path& dir)
+    {
+        {
+            const std::lock_guard lock(m_queues[id]->mutex);
+            if (!m_queues[id]->dirs.empty())
+            {
+                dir = std::move(m_queues[id]->dirs.back());
+                m_queues[id]->dirs.pop_back();
+                --m_queued;
+                return true;
+            }
+        }
+
+        // steal the oldest (shallowest) directory from the others
+        const unsigned n = static_cast<unsigned>(m_queues.size());
+        for (unsigned i = 1; i < n; ++i)
+        {
+            WalkQueue&            q = *m_queues[(id + i) % n];
+            const std::lock_guard lock(q.mutex);
+            if (!q.dirs.empty())
+            {
+                dir = std::move(q.dirs.front());
+                q.dirs.pop_front();
+                --m_queued;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Check the directory symlink @p link can be walked: no loop and not already walked through another link.
+     */
+    bool follow_dir_symlink(const fs::path& link)
+    {
+        error_code     ec;
+        const fs::path target = fs::canonical(link, ec);
+        if (ec)
+        {
+            bra_log_warn("unable to resolve symlink %s: %s", link.string().c_str(), ec.message().c_str());
+            return false;
+        }
+
+        const fs::path parent = fs::canonical(link.has_parent_path() ? link.parent_path() : fs::path("."), ec);
+        if (ec)
+        {
+            bra_log_warn("unable to resolve %s: %s", link.string().c_str(), ec.message().c_str());
+            return false;
+        }
+
+        // pointing to itself or to one of its parents
+        if (std::mismatch(target.begin(), target.end(), parent.begin(), parent.end()).first == target.end())
+        {
+            bra_log_warn("Skip symlink loop: %s -> %s", link.string().c_str(), target.string().c_str());
+            return false;
+        }
+
+        const std::lock_guard lock(m_visited_mutex);
+        if (!m_visited.insert(target).second)
+        {
+            bra_log_info("Skip symlink already walked: %s -> %s", link.string().c_str(), target.string().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool scan(const unsigned id, const fs::path& dir)
+    {
+        error_code ec;
+
+        fs::directory_iterator it(dir.empty() ? fs::path(".") : dir, ec);
+        if (ec)
+        {
+            if (m_options.skip_permission_denied && ec == std::errc::permission_denied)
+            {
+                bra_log_warn("Skip directory (permission denied): %s", dir.string().c_str());
+                return true;
+            }
+
+            bra_log_error("can't read dir %s: %s", dir.string().c_str(), ec.message().c_str());
+            return false;
+        }
+
+#ifndef NDEBUG
+        bra_log_verbose("Matched dir: %s", dir.string().c_str());
+#endif
+
+        for (const fs::directory_iterator end; it != end; it.increment(ec))
+        {
+            if (ec)
+                break;
+
+            const fs::directory_entry& entry    = *it;
+            const fs::path             filename = entry.path().filename();
+            fs::path                   ep       = dir.empty() ? filename : dir / filename;
+
+            const bool is_symlink = entry.is_symlink(ec);
+            if (!ec && is_symlink && !m_options.follow_symlinks)
+            {
+                bra_log_info("Skip symlink: %s", ep.string().c_str());
+                continue;
+            }
+
+            // the type is cached from the directory scan, only symlinks need to be resolved with a stat.
+            file_info info;
+            if (!ec && entry.is_regular_file(ec))
+            {
+                info.type = fs::file_type::regular;
+                info.size = entry.file_size(ec);
+            }
+            else if (!ec && entry.is_directory(ec))
+                info.type = fs::file_type::directory;
+
+            if (ec)
+            {
+                bra_log_error("can't check %s: %s", ep.string().c_str(), ec.message().c_str());
+                ec.clear();
+                continue;
+            }
+
+            if (info.type == fs::file_type::directory)
+            {
+                if (is_symlink && !follow_dir_symlink(ep))
+                    continue;
+
+                push(id, ep);
+            }
+            else if (info.type != fs::file_type::regular)
+                continue;
+
+            if (m_glob.match(filename.string()))
+                m_results[id].emplace_back(std::move(ep), info);
+        }
+
+        if (ec)
+        {
+            bra_log_error("can't read dir %s: %s", dir.string().c_str(), ec.message().c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void worker(const unsigned id) noexcept
+    {
+        try
+        {
+            fs::path dir;
+            while (!m_failed)
+            {
+                if (pop(id, dir))
+                {
+                    // sub-dirs are pushed (pending) before this one is done
+                    if (!scan(id, dir))
+                        fail();
+                    if (--m_pending == 0)
+                        notify_idle(true);
+                }
+                else
+                {
+                    std::unique_lock lock(m_idle_mutex);
+                    m_idle_cv.wait(lock, [this] { return m_queued != 0 || m_pending == 0 || m_failed; });
+                    if (m_pending == 0)
+                        break;
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            bra_log_error("walk: %s", e.what());
+            fail();
+        }
+    }
+
+public:
+    DirWalker(const bra::wildcards::glob_matcher& glob, const walk_options& options, const unsigned num_threads) :
+        m_glob(glob), m_options(options), m_results(num_threads)
+    {
+        m_queues.reserve(num_threads);
+        for (unsigned i = 0; i < num_threads; ++i)
+            m_queues.emplace_back(std::make_unique<WalkQueue>());
+    }
+
+    ~DirWalker() = default;
+
+    bool run(const fs::path& root, file_list& out_files)
+    {
+        push(0, root);
+
+        std::vector<std::thread> threads;
+        threads.reserve(m_queues.size() - 1);
+        for (unsigned i = 1; i < m_queues.size(); ++i)
+            threads.emplace_back(&DirWalker::worker, this, i);
+
+        worker(0);
+        for (auto& t : threads)
+            t.join();
+
+        if (m_failed)
+            return false;
+
+        std::vector<std::pair<fs::path, file_info>> entries;
+        for (auto& r : m_results)
+            entries.insert(entries.end(), std::make_move_iterator(r.begin()), std::make_move_iterator(r.end()));
+
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        out_files.insert(out_files.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+        return true;
+    }
+};
+
+}    // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool walk(const std::filesystem::path& dir, const std::string& pattern, file_list& out_files, const walk_options& options) noexcept
+{
+    try
+    {
+        const bra::wildcards::glob_matcher glob(pattern);
+
+        unsigned num_threads = options.num_threads;
+        if (num_threads == 0)
+            num_threads = std::clamp(std::thread::hardware_concurrency(), 1U, WALK_MAX_DEFAULT_THREADS);
+
+        // relative to the current dir, without a leading "./"
+        fs::path root = dir.lexically_normal();
+        if (root == ".")
+            root.clear();
+
+        DirWalker walker(glob, options, num_threads);
+        return walker.run(root, out_files);
+    }
+    catch (const std::exception& e)
+    {
+        bra_log_error("walk: %s", e.what());
+        return false;
+    }
+}
+
+}    // namespace bra::fs
@@ -17,6 +17,118 @@ using namespace std;
 namespace bra::wildcards
 {
 
+glob_matcher::glob_matcher(std::string_view wildcard)
+{
+    m_leading_star  = !wildcard.empty() && wildcard.front() == '*';
+    m_trailing_star = !wildcard.empty() && wildcard.back() == '*';
+
+    size_t start = 0;
+    while (start <= wildcard.size())
+    {
+        size_t end = wildcard.find('*', start);
+        if (end == string_view::npos)
+            end = wildcard.size();
+        else
+            m_has_star = true;
+
+        // consecutive '*' are collapsed
+        if (end > start)
+        {
+            segment seg;
+            seg.text    = wildcard.substr(start, end - start);
+            seg.has_any = seg.text.find('?') != string::npos;
+            m_min_length += seg.text.size();
+            m_segments.push_back(std::move(seg));
+        }
+
+        start = end + 1;
+    }
+}
+
+bool glob_matcher::segment_match_at(const segment& seg, std::string_view str, const size_t pos) noexcept
+{
+    const size_t n = seg.text.size();
+    if (!seg.has_any)
+        return str.compare(pos, n, seg.text) == 0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (seg.text[i] != '?' && seg.text[i] != str[pos + i])
+            return false;
+    }
+
+    return true;
+}
+
+size_t glob_matcher::segment_find(const segment& seg, std::string_view str, const size_t pos, const size_t end) noexcept
+{
+    const size_t n = seg.text.size();
+    if (end - pos < n)
+        return string_view::npos;
+
+    if (!seg.has_any)
+        return str.substr(0, end).find(seg.text, pos);
+
+    for (size_t i = pos; i + n <= end; ++i)
+    {
+        if (segment_match_at(seg, str, i))
+            return i;
+    }
+
+    return string_view::npos;
+}
+
+bool glob_matcher::match(std::string_view str) const noexcept
+{
+    if (str.size() < m_min_length)
+        return false;
+
+    // no '*': fixed length
+    if (!m_has_star)
+        return m_segments.empty() ? str.empty() : (str.size() == m_min_length && segment_match_at(m_segments.front(), str, 0));
+
+    // only '*'
+    if (m_segments.empty())
+        return true;
+
+    size_t first = 0;
+    size_t last  = m_segments.size();
+    size_t pos   = 0;
+    size_t end   = str.size();
+
+    // anchored prefix
+    if (!m_leading_star)
+    {
+        const segment& prefix = m_segments[first++];
+        if (!segment_match_at(prefix, str, 0))
+            return false;
+        pos = prefix.text.size();
+    }
+
+    // anchored suffix
+    if (!m_trailing_star && first < last)
+    {
+        const segment& suffix = m_segments[--last];
+        end -= suffix.text.size();
+        if (end < pos || !segment_match_at(suffix, str, end))
+            return false;
+    }
+
+    // the middle segments, left-most first is always the best choice between '*'
+    for (size_t i = first; i < last; ++i)
+    {
+        const size_t found = segment_find(m_segments[i], str, pos, end);
+        if (found == string_view::npos)
+            return false;
+        pos = found + m_segments[i].text.size();
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+
 bool is_wildcard(const std::filesystem::path& path) noexcept
 {
     if (path.empty())
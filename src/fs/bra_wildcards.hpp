@@ -12,9 +12,51 @@
 #include <filesystem>
 #include <string_view>
 #include <string>
+#include <vector>
 
 namespace bra::wildcards
 {
+
+/**
+ * @brief Wildcard pattern compiled once for matching many filenames.
+ *        @c '*' matches any sequence of characters, @c '?' any single character, anything else is literal.
+ *
+ * @details The pattern is split on @c '*' into literal segments: the first one is an anchored prefix,
+ *          the last one an anchored suffix, the others are searched left-most in between.
+ *          Matching is linear, without backtracking nor allocations;
+ *          patterns like @c "*", @c "abc*", @c "*.txt" or without @c '*' take a direct fast path.
+ */
+class glob_matcher
+{
+private:
+    struct segment
+    {
+        std::string text;               //!< literal text, @c '?' included.
+        bool        has_any = false;    //!< text contains @c '?'.
+    };
+
+    std::vector<segment> m_segments;                 //!< literal segments between the @c '*'.
+    size_t               m_min_length    = 0;        //!< sum of the segment lengths.
+    bool                 m_has_star      = false;    //!< pattern contains at least a @c '*'.
+    bool                 m_leading_star  = false;    //!< pattern starts with @c '*'; no anchored prefix.
+    bool                 m_trailing_star = false;    //!< pattern ends with @c '*'; no anchored suffix.
+
+    [[nodiscard]] static bool   segment_match_at(const segment& seg, std::string_view str, const size_t pos) noexcept;
+    [[nodiscard]] static size_t segment_find(const segment& seg, std::string_view str, const size_t pos, const size_t end) noexcept;
+
+public:
+    explicit glob_matcher(std::string_view wildcard);
+
+    /**
+     * @brief Check if the whole @p str matches the pattern.
+     *
+     * @param str
+     * @retval true if it matches.
+     * @retval false otherwise.
+     */
+    [[nodiscard]] bool match(std::string_view str) const noexcept;
+};
+
 /**
  * @brief Check if the given @p path contains a supported wildcard pattern.
  *
@@ -45,6 +87,8 @@ namespace bra::wildcards
 /**
  * @brief Convert the wildcard to a regular expression for internal use.
  *
+ * @see glob_matcher for matching filenames, this is kept for regex based consumers.
+ *
  * @todo this should most likely be private. Paired with @ref wildcard_extract_dir
  *
  * @param wildcard
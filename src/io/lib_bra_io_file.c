@@ -13,6 +13,16 @@
 #include <stdint.h>    // UINT8_MAX, uint{8,32,64}_t
 #include <stdio.h>     // FILE, fopen/fread/fwrite
 
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>       // _setmode
+#include <fcntl.h>    // _O_BINARY
+#endif
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <linux/fs.h>    // FICLONE
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 _Static_assert(BRA_MAX_PATH_LENGTH > UINT8_MAX, "BRA_MAX_PATH_LENGTH must be greater than bra_meta_entry_t.name_size max value");
@@ -178,8 +188,10 @@ bool bra_io_file_open(bra_io_file_t* f, const char* fn, const char* mode)
     if (fn == NULL || f == NULL || mode == NULL)
         return false;
 
-    f->f  = fopen(fn, mode);    // open file
-    f->fn = _bra_strdup(fn);    // copy filename
+    f->f          = fopen(fn, mode);    // open file
+    f->fn         = _bra_strdup(fn);    // copy filename
+    f->stream     = false;
+    f->stream_pos = 0;
     if (f->f == NULL || f->fn == NULL)
     {
         bra_io_file_open_error(f);
@@ -189,10 +201,35 @@ bool bra_io_file_open(bra_io_file_t* f, const char* fn, const char* mode)
     return true;
 }
 
+bool bra_io_file_stdio_open(bra_io_file_t* f, const bool write)
+{
+    assert(f != NULL);
+
+    f->f          = write ? stdout : stdin;
+    f->fn         = _bra_strdup(BRA_STDIO_FILENAME);
+    f->stream     = true;
+    f->stream_pos = 0;
+    if (f->fn == NULL)
+    {
+        f->f = NULL;
+        bra_io_file_open_error(f);
+        return false;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    // no newline translations in the archive.
+    _setmode(_fileno(f->f), _O_BINARY);
+#endif
+
+    return true;
+}
+
 bool bra_io_file_tmp_open(bra_io_file_t* f)
 {
-    f->f  = tmpfile();
-    f->fn = _bra_strdup("");
+    f->f          = tmpfile();
+    f->fn         = _bra_strdup("");
+    f->stream     = false;
+    f->stream_pos = 0;
     if (f->f == NULL || f->fn == NULL)
     {
         bra_io_file_close(f);
@@ -203,6 +240,21 @@ bool bra_io_file_tmp_open(bra_io_file_t* f)
     return true;
 }
 
+bool bra_io_file_clone(bra_io_file_t* dst, bra_io_file_t* src)
+{
+    assert_bra_io_file_t(dst);
+    assert_bra_io_file_t(src);
+
+#if defined(__linux__) && defined(FICLONE)
+    if (fflush(dst->f) != 0)
+        return false;
+
+    return ioctl(fileno(dst->f), FICLONE, fileno(src->f)) == 0;
+#else
+    return false;
+#endif
+}
+
 void bra_io_file_close(bra_io_file_t* f)
 {
     assert(f != NULL);
@@ -215,15 +267,60 @@ void bra_io_file_close(bra_io_file_t* f)
 
     if (f->f != NULL)
     {
-        fclose(f->f);
+        // the standard streams stay open, only what is buffered is written.
+        if (f->stream)
+            fflush(f->f);
+        else
+            fclose(f->f);
         f->f = NULL;
     }
+
+    f->stream = false;
+}
+
+/**
+ * @brief Go forward in a stream by @p offs bytes, reading and discarding them.
+ */
+static bool _bra_io_file_stream_skip(bra_io_file_t* f, const int64_t offs)
+{
+    if (offs < 0)
+    {
+        bra_log_error("can't seek backward in a stream: %s (the archive must be a file)", f->fn);
+        return false;
+    }
+
+    uint8_t buf[BUFSIZ];
+    for (int64_t i = 0; i < offs;)
+    {
+        const size_t s = (size_t) _bra_min(sizeof(buf), (uint64_t) (offs - i));
+        if (fread(buf, sizeof(char), s, f->f) != s)
+            return false;
+
+        f->stream_pos += s;
+        i             += (int64_t) s;
+    }
+
+    return true;
 }
 
 bool bra_io_file_seek(bra_io_file_t* f, const int64_t offs, const int origin)
 {
     assert_bra_io_file_t(f);
 
+    if (f->stream)
+    {
+        switch (origin)
+        {
+        case SEEK_CUR:
+            return _bra_io_file_stream_skip(f, offs);
+        case SEEK_SET:
+            return _bra_io_file_stream_skip(f, offs - (int64_t) f->stream_pos);
+        default:
+            bra_log_error("can't seek from the end of a stream: %s", f->fn);
+            return false;
+        }
+    }
+
     // return fseek(f->f, offs, origin) == 0;
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -239,6 +336,9 @@ int64_t bra_io_file_tell(bra_io_file_t* f)
 {
     assert_bra_io_file_t(f);
 
+    if (f->stream)
+        return (int64_t) f->stream_pos;
+
     // return ftell(f->f);
 
 #if defined(_WIN32) || defined(_WIN64)
@@ -262,6 +362,8 @@ bool bra_io_file_read(bra_io_file_t* src, void* buf, const size_t buf_size)
         return false;
     }
 
+    src->stream_pos += buf_size;
+
     return true;
 }
 
@@ -277,6 +379,8 @@ bool bra_io_file_write(bra_io_file_t* dst, const void* buf, const size_t buf_siz
         return false;
     }
 
+    dst->stream_pos += buf_size;
+
     return true;
 }
 
@@ -141,6 +141,19 @@ bool bra_io_file_can_be_sfx(const char* fn);
  */
 bool bra_io_file_open(bra_io_file_t* f, const char* fn, const char* mode);
 
+/**
+ * @brief Open the standard output, when @p write, or the standard input as a stream, in binary mode.
+ *        A stream only goes forward: seeking ahead reads and discards, seeking back is an error.
+ *
+ * @param f     File wrapper to initialize (must not be NULL), named #BRA_STDIO_FILENAME.
+ * @param write
+ * @retval true On success
+ * @retval false On error - wrapper is in safe state, no cleanup needed
+ *
+ * @note @ref bra_io_file_close flushes it, without closing it.
+ */
+bool bra_io_file_stdio_open(bra_io_file_t* f, const bool write);
+
 /**
  * @brief Open a temporary file. It will be autodeleted when @ref bra_io_file_close.
  *
@@ -150,6 +163,18 @@ bool bra_io_file_open(bra_io_file_t* f, const char* fn, const char* mode);
  */
 bool bra_io_file_tmp_open(bra_io_file_t* f);
 
+/**
+ * @brief Make @p dst share the data blocks of the whole @p src (reflink), without copying them.
+ *
+ * @note Only on file systems supporting it (e.g. Btrfs, XFS on Linux), otherwise the contents must be copied.
+ *
+ * @param dst File wrapper opened for writing, empty (must not be NULL)
+ * @param src File wrapper opened for reading (must not be NULL)
+ * @retval true On success - @p dst has the same contents of @p src
+ * @retval false Not supported - both files are left untouched
+ */
+bool bra_io_file_clone(bra_io_file_t* dst, bra_io_file_t* src);
+
 /**
  * @brief Close the file and reset the wrapper.
  *
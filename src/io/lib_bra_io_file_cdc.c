@@ -0,0 +1,759 @@
+#include "lib_bra_io_file_cdc.h"
+
+#include <lib_bra.h>
+#include <lib_bra_private.h>
+#include <lib_bra_defs.h>
+
+#include <io/lib_bra_io_file.h>
+#include <io/lib_bra_io_file_chunks.h>
+#include <io/lib_bra_io_file_meta_entries.h>
+#include <log/bra_log.h>
+#include <utils/bra_cdc.h>
+#include <utils/bra_sha256.h>
+#include <utils/lib_bra_crc32c.h>
+#include <encoders/bra_codec.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define BRA_CDC_TABLE_INIT_CAPACITY 1024              //!< initial slots of the block table, a power of 2.
+#define BRA_CDC_BUF_SIZE            BRA_CHUNK_SIZE    //!< bytes of the file read at once while splitting it, at least 2 blocks.
+
+/**
+ * @brief A content-defined block already archived.
+ */
+typedef struct bra_cdc_block_t
+{
+    uint8_t  digest[BRA_SHA256_DIGEST_SIZE];    //!< SHA-256 of the block.
+    uint32_t size;                              //!< bytes of the block.
+    int64_t  entry;                             //!< archive offset of the entry with the block in its data; @c 0 for an empty slot.
+    uint64_t pos;                               //!< offset of the block in the decoded data of @p entry.
+    uint8_t  ref;                               //!< #BRA_CDC_RUN_REF: @p entry is in the archive; #BRA_CDC_RUN_BASE: in the base archive.
+} bra_cdc_block_t;
+
+/**
+ * @brief Open addressing hash table of the blocks, by digest.
+ */
+struct bra_cdc_table_t
+{
+    bra_cdc_block_t* blocks;      //!< @p capacity slots.
+    size_t           capacity;    //!< a power of 2.
+    size_t           count;       //!< used slots, up to 3/4 of @p capacity.
+    char*            base_name;   //!< base archive of the #BRA_CDC_RUN_BASE blocks, relative to the directory of the archive; @c NULL for none.
+};
+
+/**
+ * @brief A file being split in content-defined blocks.
+ */
+typedef struct bra_io_file_cdc_reader_t
+{
+    bra_io_file_t* f;        //!< the file, positioned after the bytes read.
+    uint64_t       size;     //!< bytes of @p f to split.
+    uint64_t       read;     //!< bytes of @p f read.
+    uint8_t*       buf;      //!< #BRA_CDC_BUF_SIZE bytes.
+    size_t         start;    //!< start of the next block in @p buf.
+    size_t         end;      //!< end of the bytes read in @p buf.
+} bra_io_file_cdc_reader_t;
+
+/**
+ * @brief The entry data being read for the blocks referred by a #BRA_ATTR_CDC file.
+ *        Its last decoded chunk is kept: the next blocks usually follow.
+ */
+typedef struct bra_io_file_cdc_fetch_t
+{
+    int64_t        entry;         //!< archive offset of the entry; @c 0 for none.
+    bra_attr_t     comp;          //!< compression of its data.
+    int64_t        data;          //!< archive offset of its data.
+    int64_t        data_end;      //!< archive offset of the end of its data.
+    int64_t        next;          //!< archive offset of the chunk after @p chunk.
+    uint64_t       chunk_pos;     //!< offset of @p chunk in the decoded data.
+    uint32_t       chunk_size;    //!< bytes of @p chunk.
+    const uint8_t* chunk;         //!< last decoded chunk, in the codec buffers.
+} bra_io_file_cdc_fetch_t;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t _bra_io_file_cdc_table_slot(const bra_cdc_table_t* table, const uint8_t digest[BRA_SHA256_DIGEST_SIZE])
+{
+    uint64_t h;
+    memcpy(&h, digest, sizeof(uint64_t));
+    return (size_t) h & (table->capacity - 1);
+}
+
+/**
+ * @brief Slot of the block @p digest of @p size bytes: the block itself or the empty slot where to add it.
+ */
+static bra_cdc_block_t* _bra_io_file_cdc_table_find(bra_cdc_table_t* table, const uint8_t digest[BRA_SHA256_DIGEST_SIZE], const uint32_t size)
+{
+    for (size_t i = _bra_io_file_cdc_table_slot(table, digest);; i = (i + 1) & (table->capacity - 1))
+    {
+        bra_cdc_block_t* b = &table->blocks[i];
+        if (b->entry == 0 || (b->size == size && memcmp(b->digest, digest, BRA_SHA256_DIGEST_SIZE) == 0))
+            return b;
+    }
+}
+
+static bool _bra_io_file_cdc_table_grow(bra_cdc_table_t* table)
+{
+    bra_cdc_block_t* blocks   = table->blocks;
+    const size_t     capacity = table->capacity;
+
+    table->blocks = calloc(capacity * 2, sizeof(bra_cdc_block_t));
+    if (table->blocks == NULL)
+    {
+        bra_log_critical("unable to allocate memory for the block table");
+        table->blocks = blocks;
+        return false;
+    }
+
+    table->capacity = capacity * 2;
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        if (blocks[i].entry != 0)
+            *_bra_io_file_cdc_table_find(table, blocks[i].digest, blocks[i].size) = blocks[i];
+    }
+
+    free(blocks);
+    return true;
+}
+
+/**
+ * @brief Next content-defined block of @p r: @p n is @c 0 at the end of the file.
+ *        The window of the buffer holds at least a whole block, but at the end of the file.
+ */
+static bool _bra_io_file_cdc_reader_next(bra_io_file_cdc_reader_t* r, const uint8_t** block, uint32_t* n)
+{
+    if (r->end - r->start < BRA_CDC_MAX_SIZE && r->read < r->size)
+    {
+        memmove(r->buf, &r->buf[r->start], r->end - r->start);
+        r->end   -= r->start;
+        r->start  = 0;
+
+        const uint32_t s = _bra_min(BRA_CDC_BUF_SIZE - r->end, r->size - r->read);
+        if (!bra_io_file_read(r->f, &r->buf[r->end], s))
+            return false;
+
+        r->end  += s;
+        r->read += s;
+    }
+
+    *block    = &r->buf[r->start];
+    *n        = (uint32_t) bra_cdc_cut(*block, r->end - r->start);
+    r->start += *n;
+    return true;
+}
+
+/**
+ * @brief Add the block in @p slot, an empty slot found for it.
+ */
+static bool _bra_io_file_cdc_table_add(bra_cdc_table_t* table, bra_cdc_block_t* slot, const uint8_t digest[BRA_SHA256_DIGEST_SIZE], const uint32_t size, const uint8_t ref, const int64_t entry, const uint64_t pos)
+{
+    memcpy(slot->digest, digest, BRA_SHA256_DIGEST_SIZE);
+    slot->size  = size;
+    slot->entry = entry;
+    slot->pos   = pos;
+    slot->ref   = ref;
+    return ++table->count <= table->capacity / 4 * 3 || _bra_io_file_cdc_table_grow(table);
+}
+
+/**
+ * @brief Append a run of @p size bytes to @p runs, merged with the last one when they are contiguous.
+ */
+static bool _bra_io_file_cdc_runs_add(bra_cdc_run_t** runs, uint32_t* num_runs, uint32_t* capacity, const uint8_t ref, const uint64_t size, const uint64_t offset, const uint64_t pos)
+{
+    if (*num_runs > 0)
+    {
+        bra_cdc_run_t* last = &(*runs)[*num_runs - 1];
+        if (last->ref == ref && (ref == BRA_CDC_RUN_NEW || (last->offset == offset && last->pos + last->size == pos)))
+        {
+            last->size += size;
+            return true;
+        }
+    }
+
+    if (*num_runs == *capacity)
+    {
+        if (*capacity == UINT32_MAX)
+        {
+            bra_log_error("too many block runs");
+            return false;
+        }
+
+        const uint32_t c = *capacity == 0 ? 16 : (*capacity > UINT32_MAX / 2 ? UINT32_MAX : *capacity * 2);
+        bra_cdc_run_t* r = realloc(*runs, sizeof(bra_cdc_run_t) * c);
+        if (r == NULL)
+        {
+            bra_log_critical("unable to allocate memory for the block runs");
+            return false;
+        }
+
+        *runs     = r;
+        *capacity = c;
+    }
+
+    (*runs)[(*num_runs)++] = (bra_cdc_run_t) {.ref = ref, .size = size, .offset = offset, .pos = pos};
+    return true;
+}
+
+/**
+ * @brief Read the file entry at @p entry and start reading its data.
+ */
+static bool _bra_io_file_cdc_fetch_entry(bra_io_file_t* src, bra_io_file_cdc_fetch_t* fetch, const int64_t entry)
+{
+    bra_meta_entry_t e = {0};
+    if (!bra_io_file_seek(src, entry, SEEK_SET))
+    {
+        bra_io_file_seek_error(src);
+        return false;
+    }
+
+    if (!bra_io_file_meta_entry_read_common_header(src, &e))
+        return false;
+
+    if (BRA_ATTR_TYPE(e.attributes) != BRA_ATTR_TYPE_FILE || BRA_ATTR_IS_REF(e.attributes) || BRA_ATTR_COMP(e.attributes) == BRA_ATTR_COMP_SOLID)
+    {
+        bra_log_error("entry with the blocks not valid: %s", e.name);
+        bra_meta_entry_free(&e);
+        bra_io_file_close(src);
+        return false;
+    }
+
+    if (!bra_io_file_meta_entry_read_file_entry(src, &e))
+    {
+        bra_meta_entry_free(&e);
+        return false;
+    }
+
+    fetch->entry      = entry;
+    fetch->comp       = BRA_ATTR_COMP(e.attributes);
+    fetch->data       = bra_io_file_tell(src);
+    fetch->data_end   = fetch->data + (int64_t) ((const bra_meta_entry_file_t*) e.entry_data)->data_size;
+    fetch->next       = fetch->data;
+    fetch->chunk_pos  = 0;
+    fetch->chunk_size = 0;
+    fetch->chunk      = NULL;
+    bra_meta_entry_free(&e);
+    return fetch->data > 0;
+}
+
+/**
+ * @brief Write to @p dst the @p size bytes at @p pos of the decoded data of @p entry, updating @p crc32.
+ */
+static bool _bra_io_file_cdc_fetch(bra_codec_ctx_t* codec, bra_io_file_t* src, bra_io_file_cdc_fetch_t* fetch, const int64_t entry, uint64_t pos, uint64_t size, uint8_t* buf, bra_io_file_t* dst, uint32_t* crc32)
+{
+    if ((fetch->entry != entry || pos < fetch->chunk_pos) && !_bra_io_file_cdc_fetch_entry(src, fetch, entry))
+        return false;
+
+    if (fetch->comp == BRA_ATTR_COMP_STORED)
+    {
+        if (pos > (uint64_t) (fetch->data_end - fetch->data) || size > (uint64_t) (fetch->data_end - fetch->data) - pos)
+            goto BRA_IO_FILE_CDC_FETCH_ERR;
+
+        if (!bra_io_file_seek(src, fetch->data + (int64_t) pos, SEEK_SET))
+        {
+            bra_io_file_seek_error(src);
+            return false;
+        }
+
+        while (size > 0)
+        {
+            const uint32_t s = _bra_min(BRA_CDC_BUF_SIZE, size);
+            if (!bra_io_file_read(src, buf, s))
+                return false;
+
+            *crc32 = bra_crc32c(buf, s, *crc32);
+            if (dst != NULL && !bra_io_file_write(dst, buf, s))
+                return false;
+
+            size -= s;
+        }
+
+        return true;
+    }
+
+    while (size > 0)
+    {
+        if (pos >= fetch->chunk_pos + fetch->chunk_size)
+        {
+            if (fetch->next >= fetch->data_end)
+                goto BRA_IO_FILE_CDC_FETCH_ERR;
+
+            if (bra_io_file_tell(src) != fetch->next && !bra_io_file_seek(src, fetch->next, SEEK_SET))
+            {
+                bra_io_file_seek_error(src);
+                return false;
+            }
+
+            fetch->chunk_pos += fetch->chunk_size;
+            if (!bra_io_file_chunks_decode_chunk(codec, src, fetch->comp == BRA_ATTR_COMP_FAST, &fetch->chunk, &fetch->chunk_size))
+                return false;
+
+            fetch->next = bra_io_file_tell(src);
+            continue;
+        }
+
+        const uint32_t s = (uint32_t) _bra_min(size, fetch->chunk_pos + fetch->chunk_size - pos);
+        const uint8_t* p = &fetch->chunk[pos - fetch->chunk_pos];
+        *crc32           = bra_crc32c(p, s, *crc32);
+        if (dst != NULL && !bra_io_file_write(dst, p, s))
+            return false;
+
+        pos  += s;
+        size -= s;
+    }
+
+    return true;
+
+BRA_IO_FILE_CDC_FETCH_ERR:
+    bra_log_error("blocks out of the entry data in %s", src->fn);
+    bra_io_file_close(src);
+    return false;
+}
+
+/**
+ * @brief Open the base archive @p base_name, relative to the directory of the archive @p fn.
+ */
+static bool _bra_io_file_cdc_base_open(bra_io_file_t* base, const char* fn, const char* base_name)
+{
+    if (base_name == NULL)
+    {
+        bra_log_error("base archive missing in %s", fn);
+        return false;
+    }
+
+    const char*  sep     = strrchr(fn, BRA_DIR_DELIM[0]);
+    const size_t dir_len = sep == NULL ? 0 : (size_t) (sep - fn) + 1;
+    const size_t len     = strlen(base_name);
+    char*        path    = malloc(dir_len + len + 1);
+    if (path == NULL)
+    {
+        bra_log_critical("unable to allocate memory for the base archive path");
+        return false;
+    }
+
+    memcpy(path, fn, dir_len);
+    memcpy(&path[dir_len], base_name, len + 1);
+
+    bra_io_header_t header;
+    const bool      res = bra_io_file_open(base, path, "rb") && bra_io_file_read(base, &header, sizeof(bra_io_header_t));
+    free(path);
+    if (!res)
+        return false;
+
+    if (header.magic != BRA_MAGIC)
+    {
+        bra_log_error("Not valid %s file: %s", BRA_NAME, base->fn);
+        bra_io_file_close(base);
+        return false;
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bra_cdc_table_t* bra_io_file_cdc_table_create(void)
+{
+    bra_cdc_table_t* table = malloc(sizeof(bra_cdc_table_t));
+    if (table == NULL)
+        goto BRA_IO_FILE_CDC_TABLE_CREATE_ERR;
+
+    table->capacity  = BRA_CDC_TABLE_INIT_CAPACITY;
+    table->count     = 0;
+    table->base_name = NULL;
+    table->blocks    = calloc(table->capacity, sizeof(bra_cdc_block_t));
+    if (table->blocks == NULL)
+    {
+        free(table);
+        goto BRA_IO_FILE_CDC_TABLE_CREATE_ERR;
+    }
+
+    return table;
+
+BRA_IO_FILE_CDC_TABLE_CREATE_ERR:
+    bra_log_critical("unable to allocate memory for the block table");
+    return NULL;
+}
+
+void bra_io_file_cdc_table_destroy(bra_cdc_table_t** table)
+{
+    assert(table != NULL);
+
+    if (*table == NULL)
+        return;
+
+    free((*table)->blocks);
+    free((*table)->base_name);
+    free(*table);
+    *table = NULL;
+}
+
+bool bra_io_file_cdc_table_set_base(bra_cdc_table_t* table, const char* base_name)
+{
+    assert(table != NULL);
+    assert(base_name != NULL);
+
+    const size_t len = strlen(base_name);
+    if (len == 0 || len > UINT8_MAX)
+    {
+        bra_log_error("base archive name not valid: %s", base_name);
+        return false;
+    }
+
+    free(table->base_name);
+    table->base_name = _bra_strdup(base_name);
+    return table->base_name != NULL;
+}
+
+bool bra_io_file_cdc_table_add_base_entry(bra_cdc_table_t* table, bra_codec_ctx_t* codec, bra_io_file_t* src, bra_meta_entry_t* me, const int64_t me_pos)
+{
+    assert(table != NULL);
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
+    assert(me_pos > 0);
+    assert(BRA_ATTR_TYPE(me->attributes) == BRA_ATTR_TYPE_FILE);
+
+    const bra_meta_entry_file_t* mef  = (const bra_meta_entry_file_t*) me->entry_data;
+    const bra_attr_t             comp = BRA_ATTR_COMP(me->attributes);
+    bra_io_file_t                data = {.f = NULL, .fn = NULL};
+    bra_io_file_cdc_reader_t     r    = {.f = &data, .size = mef->data_size, .read = 0, .buf = NULL, .start = 0, .end = 0};
+
+    assert(mef != NULL);
+
+    // the blocks can be read only from the data of the entries, as the new blocks are.
+    if (BRA_ATTR_IS_REF(me->attributes) || comp == BRA_ATTR_COMP_SOLID || mef->data_size == 0)
+        return bra_io_file_chunks_read_file(codec, src, mef->data_size, me, false);
+
+    if (!bra_io_file_tmp_open(&data))
+        goto BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR;
+
+    if (comp == BRA_ATTR_COMP_STORED ? !bra_io_file_chunks_copy_file(&data, src, mef->data_size, me, false) : !bra_io_file_chunks_decompress_file(codec, &data, src, mef->data_size, me, true))
+        goto BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR;
+
+    r.size = (uint64_t) bra_io_file_tell(&data);
+    r.buf  = malloc(BRA_CDC_BUF_SIZE);
+    if (r.buf == NULL)
+    {
+        bra_log_critical("unable to allocate the block buffer");
+        goto BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR;
+    }
+
+    if (!bra_io_file_seek(&data, 0, SEEK_SET))
+    {
+        bra_io_file_seek_error(&data);
+        goto BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR;
+    }
+
+    for (uint64_t pos = 0;;)
+    {
+        const uint8_t* block;
+        uint32_t       n;
+        if (!_bra_io_file_cdc_reader_next(&r, &block, &n))
+            goto BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR;
+
+        if (n == 0)
+            break;
+
+        uint8_t digest[BRA_SHA256_DIGEST_SIZE];
+        bra_sha256(block, n, digest);
+
+        bra_cdc_block_t* b = _bra_io_file_cdc_table_find(table, digest, n);
+        if (b->entry == 0 && !_bra_io_file_cdc_table_add(table, b, digest, n, BRA_CDC_RUN_BASE, me_pos, pos))
+            goto BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR;
+
+        pos += n;
+    }
+
+    bra_io_file_close(&data);
+    free(r.buf);
+    return true;
+
+BRA_IO_FILE_CDC_TABLE_ADD_BASE_ENTRY_ERR:
+    bra_io_file_close(&data);
+    bra_io_file_close(src);
+    free(r.buf);
+    return false;
+}
+
+bool bra_io_file_cdc_plan(bra_cdc_table_t* table, const char* fn, const int64_t me_pos, bra_meta_entry_t* me, uint32_t* crc32)
+{
+    assert(table != NULL);
+    assert(fn != NULL);
+    assert(me_pos > 0);
+    assert(me != NULL);
+    assert(crc32 != NULL);
+    assert(BRA_ATTR_TYPE(me->attributes) == BRA_ATTR_TYPE_FILE);
+
+    bra_meta_entry_file_t*   mef      = (bra_meta_entry_file_t*) me->entry_data;
+    const uint64_t           size     = mef->data_size;
+    bra_cdc_run_t*           runs     = NULL;
+    uint32_t                 num_runs = 0;
+    uint32_t                 capacity = 0;
+    uint64_t                 data_pos = 0;
+    bool                     base     = false;
+    bra_io_file_t            f        = {.f = NULL, .fn = NULL};
+    bra_io_file_cdc_reader_t r        = {.f = &f, .size = size, .read = 0, .buf = malloc(BRA_CDC_BUF_SIZE), .start = 0, .end = 0};
+
+    *crc32 = BRA_CRC32C_INIT;
+    if (r.buf == NULL)
+    {
+        bra_log_critical("unable to allocate the block buffer");
+        return false;
+    }
+
+    if (!bra_io_file_open(&f, fn, "rb"))
+        goto BRA_IO_FILE_CDC_PLAN_ERR;
+
+    for (;;)
+    {
+        const uint8_t* block;
+        uint32_t       n;
+        if (!_bra_io_file_cdc_reader_next(&r, &block, &n))
+            goto BRA_IO_FILE_CDC_PLAN_ERR;
+
+        if (n == 0)
+            break;
+
+        uint8_t digest[BRA_SHA256_DIGEST_SIZE];
+        bra_sha256(block, n, digest);
+        *crc32 = bra_crc32c(block, n, *crc32);
+
+        bra_cdc_block_t* b = _bra_io_file_cdc_table_find(table, digest, n);
+        if (b->entry != 0)
+        {
+            // the base archive blocks are referred by their absolute entry offset.
+            const uint64_t offset = b->ref == BRA_CDC_RUN_BASE ? (uint64_t) b->entry : (uint64_t) (me_pos - b->entry);
+            if (!_bra_io_file_cdc_runs_add(&runs, &num_runs, &capacity, b->ref, n, offset, b->pos))
+                goto BRA_IO_FILE_CDC_PLAN_ERR;
+
+            base |= b->ref == BRA_CDC_RUN_BASE;
+        }
+        else
+        {
+            if (!_bra_io_file_cdc_table_add(table, b, digest, n, BRA_CDC_RUN_REF, me_pos, data_pos))
+                goto BRA_IO_FILE_CDC_PLAN_ERR;
+
+            if (!_bra_io_file_cdc_runs_add(&runs, &num_runs, &capacity, BRA_CDC_RUN_NEW, n, 0, 0))
+                goto BRA_IO_FILE_CDC_PLAN_ERR;
+
+            data_pos += n;
+        }
+    }
+
+    bra_io_file_close(&f);
+    free(r.buf);
+    r.buf = NULL;
+
+    // all new blocks: the data is the whole file, as usual.
+    if (num_runs == 0 || (num_runs == 1 && runs[0].ref == BRA_CDC_RUN_NEW))
+    {
+        free(runs);
+        return true;
+    }
+
+    if (base)
+    {
+        assert(table->base_name != NULL);
+
+        free(mef->cdc_base_name);
+        mef->cdc_base_name = _bra_strdup(table->base_name);
+        if (mef->cdc_base_name == NULL)
+            goto BRA_IO_FILE_CDC_PLAN_ERR;
+
+        mef->cdc_base_name_size = (uint8_t) strlen(mef->cdc_base_name);
+    }
+
+    free(mef->cdc_runs);
+    me->attributes    |= BRA_ATTR_CDC;
+    mef->cdc_runs      = runs;
+    mef->cdc_num_runs  = num_runs;
+    mef->cdc_size      = size;
+    mef->data_size     = data_pos;
+    return true;
+
+BRA_IO_FILE_CDC_PLAN_ERR:
+    bra_io_file_close(&f);
+    free(r.buf);
+    free(runs);
+    return false;
+}
+
+bool bra_io_file_cdc_open_data(bra_io_file_t* f, const char* fn, const bra_meta_entry_t* me)
+{
+    assert(f != NULL);
+    assert(fn != NULL);
+    assert(me != NULL);
+    assert(BRA_ATTR_IS_CDC(me->attributes));
+
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    bra_io_file_t                f2  = {.f = NULL, .fn = NULL};
+    uint8_t*                     buf = malloc(BRA_CDC_BUF_SIZE);
+
+    if (buf == NULL)
+    {
+        bra_log_critical("unable to allocate the block buffer");
+        return false;
+    }
+
+    if (!bra_io_file_tmp_open(f) || !bra_io_file_open(&f2, fn, "rb"))
+        goto BRA_IO_FILE_CDC_OPEN_DATA_ERR;
+
+    // the new blocks only, the others are skipped.
+    for (uint32_t i = 0; i < mef->cdc_num_runs; ++i)
+    {
+        const bra_cdc_run_t* run = &mef->cdc_runs[i];
+        if (run->ref)
+        {
+            if (!bra_io_file_seek(&f2, (int64_t) run->size, SEEK_CUR))
+            {
+                bra_io_file_seek_error(&f2);
+                goto BRA_IO_FILE_CDC_OPEN_DATA_ERR;
+            }
+
+            continue;
+        }
+
+        for (uint64_t j = 0; j < run->size;)
+        {
+            const uint32_t s = _bra_min(BRA_CDC_BUF_SIZE, run->size - j);
+            if (!bra_io_file_read(&f2, buf, s) || !bra_io_file_write(f, buf, s))
+                goto BRA_IO_FILE_CDC_OPEN_DATA_ERR;
+
+            j += s;
+        }
+    }
+
+    if (!bra_io_file_seek(f, 0, SEEK_SET))
+    {
+        bra_io_file_seek_error(f);
+        goto BRA_IO_FILE_CDC_OPEN_DATA_ERR;
+    }
+
+    bra_io_file_close(&f2);
+    free(buf);
+    return true;
+
+BRA_IO_FILE_CDC_OPEN_DATA_ERR:
+    bra_io_file_close(&f2);
+    bra_io_file_close(f);
+    free(buf);
+    return false;
+}
+
+bool bra_io_file_cdc_read_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
+    assert(BRA_ATTR_IS_CDC(me->attributes));
+
+    const bra_meta_entry_file_t* mef        = (const bra_meta_entry_file_t*) me->entry_data;
+    const bool                   stored     = BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_STORED;
+    bra_io_file_t                data       = {.f = NULL, .fn = NULL};
+    bra_io_file_t                base       = {.f = NULL, .fn = NULL};
+    bra_codec_ctx_t              base_codec = {.buf = NULL};
+    uint8_t*                     buf        = NULL;
+    bra_io_file_cdc_fetch_t      fetch      = {.entry = 0};
+    bra_io_file_cdc_fetch_t      base_fetch = {.entry = 0};
+    uint32_t                     crc32      = BRA_CRC32C_INIT;
+
+    assert(mef != NULL);
+    if (!decode)
+    {
+        if (stored ? !bra_io_file_chunks_copy_file(NULL, src, mef->data_size, me, false) : !bra_io_file_chunks_decompress_file(codec, NULL, src, mef->data_size, me, false))
+            return false;
+
+        me->_compression_ratio = mef->cdc_size == 0 ? 0.0f : (float) ((double) mef->data_size / (double) mef->cdc_size);
+        return true;
+    }
+
+    // 1. the new blocks, decoded in a temporary file: the CRC32 of the entry is on its data as usual.
+    if (!bra_io_file_tmp_open(&data))
+        goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+    if (stored ? !bra_io_file_chunks_copy_file(&data, src, mef->data_size, me, true) : !bra_io_file_chunks_decompress_file(codec, &data, src, mef->data_size, me, true))
+        goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+    const int64_t data_end = bra_io_file_tell(src);
+    if (data_end < 0 || !bra_io_file_seek(&data, 0, SEEK_SET))
+        goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+    buf = malloc(BRA_CDC_BUF_SIZE);
+    if (buf == NULL)
+    {
+        bra_log_critical("unable to allocate the block buffer");
+        goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+    }
+
+    // 2. the contents, run by run, then the CRC32 is on them too.
+    for (uint32_t i = 0; i < mef->cdc_num_runs; ++i)
+    {
+        const bra_cdc_run_t* run = &mef->cdc_runs[i];
+        if (run->ref == BRA_CDC_RUN_BASE)
+        {
+            // the base archive has its own codec buffers: the last chunks decoded from both are kept.
+            if (base.f == NULL && !_bra_io_file_cdc_base_open(&base, src->fn, mef->cdc_base_name))
+                goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+            if (run->offset == 0 || run->offset > INT64_MAX || !_bra_io_file_cdc_fetch(&base_codec, &base, &base_fetch, (int64_t) run->offset, run->pos, run->size, buf, dst, &crc32))
+                goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+            continue;
+        }
+
+        if (run->ref == BRA_CDC_RUN_REF)
+        {
+            if (mef->_cdc_entry <= 0 || run->offset >= (uint64_t) mef->_cdc_entry)
+            {
+                bra_log_error("block run %" PRIu32 " not valid: %s", i, me->name);
+                goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+            }
+
+            if (!_bra_io_file_cdc_fetch(codec, src, &fetch, mef->_cdc_entry - (int64_t) run->offset, run->pos, run->size, buf, dst, &crc32))
+                goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+            continue;
+        }
+
+        for (uint64_t j = 0; j < run->size;)
+        {
+            const uint32_t s = _bra_min(BRA_CDC_BUF_SIZE, run->size - j);
+            if (!bra_io_file_read(&data, buf, s))
+                goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+            crc32 = bra_crc32c(buf, s, crc32);
+            if (dst != NULL && !bra_io_file_write(dst, buf, s))
+                goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+
+            j += s;
+        }
+    }
+
+    if (bra_io_file_tell(src) != data_end && !bra_io_file_seek(src, data_end, SEEK_SET))
+    {
+        bra_io_file_seek_error(src);
+        goto BRA_IO_FILE_CDC_READ_FILE_ERR;
+    }
+
+    me->crc32              = bra_crc32c_combine(me->crc32, crc32, mef->cdc_size);
+    me->_compression_ratio = mef->cdc_size == 0 ? 0.0f : (float) ((double) mef->data_size / (double) mef->cdc_size);
+    codec->data_crc32      = crc32;
+    bra_io_file_close(&data);
+    bra_io_file_close(&base);
+    bra_codec_ctx_free(&base_codec);
+    free(buf);
+    return true;
+
+BRA_IO_FILE_CDC_READ_FILE_ERR:
+    bra_io_file_close(&data);
+    bra_io_file_close(&base);
+    bra_codec_ctx_free(&base_codec);
+    if (dst != NULL)
+        bra_io_file_close(dst);
+    bra_io_file_close(src);
+    free(buf);
+    return false;
+}
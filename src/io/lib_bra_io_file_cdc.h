@@ -0,0 +1,93 @@
+#pragma once
+
+#include <lib_bra_types.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Create an empty table of content-defined blocks.
+ *
+ * @return bra_cdc_table_t* @c NULL on allocation failure, to be freed with @ref bra_io_file_cdc_table_destroy.
+ */
+bra_cdc_table_t* bra_io_file_cdc_table_create(void);
+
+/**
+ * @brief Free the @p table and set it to @c NULL.
+ *
+ * @param table
+ */
+void bra_io_file_cdc_table_destroy(bra_cdc_table_t** table);
+
+/**
+ * @brief Set the base archive of @p table, before adding its entries with @ref bra_io_file_cdc_table_add_base_entry.
+ *
+ * @param table
+ * @param base_name path of the base archive relative to the directory of the archive being written, up to 255 characters.
+ * @retval true on success.
+ * @retval false on error.
+ */
+bool bra_io_file_cdc_table_set_base(bra_cdc_table_t* table, const char* base_name);
+
+/**
+ * @brief Read the data of the file entry @p me of the base archive @p src and add its blocks to @p table.
+ *        The next files planned refer to them with #BRA_CDC_RUN_BASE runs.
+ *
+ * @details The duplicates and the solid files are skipped: their blocks can't be referred to.
+ *
+ * @param table
+ * @param codec  codec work buffers (must not be @c NULL)
+ * @param src    the base archive, positioned at the entry data.
+ * @param me
+ * @param me_pos absolute offset of the entry @p me in @p src.
+ * @retval true On success, @p src is positioned after the entry data.
+ * @retval false On error, @p src is closed.
+ */
+bool bra_io_file_cdc_table_add_base_entry(bra_cdc_table_t* table, bra_codec_ctx_t* codec, bra_io_file_t* src, bra_meta_entry_t* me, const int64_t me_pos);
+
+/**
+ * @brief Split the file @p fn in content-defined blocks and look them up in @p table.
+ *        The new blocks are added to it at their offset in the data of this entry.
+ *
+ * @details When some blocks are already in @p table, @p me becomes a #BRA_ATTR_CDC file:
+ *          its runs of blocks are set and its @c data_size is the size of the new blocks only,
+ *          to be read with @ref bra_io_file_cdc_open_data.
+ *          Otherwise @p me is left as it is: its data is the whole file.
+ *
+ * @param table
+ * @param fn     the file to be encoded.
+ * @param me_pos archive offset where the entry @p me is going to be written.
+ * @param me     a file entry, its @c data_size is the size of @p fn.
+ * @param crc32  the CRC32C of the contents of @p fn.
+ * @retval true on success.
+ * @retval false on error.
+ */
+bool bra_io_file_cdc_plan(bra_cdc_table_t* table, const char* fn, const int64_t me_pos, bra_meta_entry_t* me, uint32_t* crc32);
+
+/**
+ * @brief Open the data of the #BRA_ATTR_CDC file @p fn: its new blocks in a temporary file, positioned at its start.
+ *
+ * @param f  the temporary file, to be closed with @ref bra_io_file_close.
+ * @param fn
+ * @param me planned with @ref bra_io_file_cdc_plan.
+ * @retval true on success.
+ * @retval false on error, @p f is closed.
+ */
+bool bra_io_file_cdc_open_data(bra_io_file_t* f, const char* fn, const bra_meta_entry_t* me);
+
+/**
+ * @brief Read the data of the #BRA_ATTR_CDC file entry @p me and, when @p decode, rebuild its contents:
+ *        the new blocks from its data, the others decoded from the data of the entries with them,
+ *        opening the base archive for the #BRA_CDC_RUN_BASE runs.
+ *
+ * @param codec  codec work buffers (must not be @c NULL)
+ * @param dst    where to write the contents, @c NULL to only compute the CRC32.
+ * @param src    the archive, positioned at the entry data.
+ * @param me     its CRC32 is updated with the data and, when @p decode, the contents: their own CRC32 is left in @c codec->data_crc32.
+ * @param decode @c false to skip the data, computing only the compression ratio.
+ * @retval true On success, @p src is positioned after the entry data.
+ * @retval false On error, @p src and @p dst are closed.
+ *
+ * @note Reentrant: concurrent calls must use different @p codec contexts and @p src handles.
+ */
+bool bra_io_file_cdc_read_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode);
@@ -1,9 +1,11 @@
 #include "lib_bra_io_file_chunks.h"
 
+#include <lib_bra.h>
 #include <lib_bra_private.h>
 #include <lib_bra_defs.h>
 
 #include <io/lib_bra_io_file.h>
+#include <io/lib_bra_io_file_cdc.h>
 #include <io/lib_bra_io_file_meta_entries.h>
 #include <log/bra_log.h>
 #include <utils/lib_bra_crc32c.h>
@@ -11,10 +13,16 @@
 #include <encoders/bra_bwt.h>
 #include <encoders/bra_mtf.h>
 #include <encoders/bra_rle.h>
+#include <encoders/bra_zrle.h>
 #include <encoders/bra_huffman.h>
+#include <encoders/bra_cm.h>
+#include <encoders/bra_lz.h>
+#include <encoders/bra_filter.h>
+#include <encoders/bra_codec.h>
 
 #include <inttypes.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 /**
@@ -26,6 +34,41 @@ typedef union bra_bwt_index_u
     uint32_t u32;                    //!< uint32_t representation
 } bra_bwt_index_u;
 
+_Static_assert(BRA_MAX_CHUNK_SIZE <= BRA_IO_CHUNK_FILTERED, "primary index overlaps the filter and pipeline bits");
+_Static_assert(BRA_FILTER_COUNTS_SIZE <= BRA_MAX_CHUNK_SIZE, "filter counts don't fit in the BWT index buffer");
+_Static_assert(BRA_IO_CHUNK_PIPELINE_SHIFT + 3 <= BRA_BWT_INDEX_BYTES * 8, "pipeline bits not stored on disk");
+_Static_assert(BRA_LZ_ENCODE_BOUND(BRA_MAX_CHUNK_SIZE) <= BRA_CODEC_BUF_SIZE, "LZ77 chunk doesn't fit in the codec buffer");
+_Static_assert(3 * BRA_CODEC_BUF_SIZE <= sizeof(bra_bwt_index_t) * BRA_BWT_ENCODE_WORK_SIZE(BRA_MAX_CHUNK_SIZE), "chunk encodings don't fit in the BWT index buffer");
+
+/**
+ * @brief Engine choices of a compression level.
+ *        The chunks record the stages used, decoding doesn't need the level.
+ */
+typedef struct bra_io_comp_level_t
+{
+    uint32_t chunk_size;    //!< bytes compressed at once: larger chunks give the BWT more context, but it is slower.
+    bool     zrle;          //!< zero-run stage too, kept when smaller than RLE.
+    bool     multi;         //!< multiple Huffman tables too, kept when smaller than one.
+    bool     filters;       //!< a filter before the BWT, for executables and tables.
+    bool     cm;            //!< context mixing coder on the BWT output too, kept when smaller than Huffman: the slowest.
+} bra_io_comp_level_t;
+
+/**
+ * @brief Compression levels, #BRA_COMP_LEVEL_STORED doesn't use chunks and #BRA_COMP_LEVEL_FAST only uses the chunk size.
+ */
+static const bra_io_comp_level_t g_bra_io_comp_levels[BRA_COMP_LEVEL_MAX + 1] = {
+    {BRA_CHUNK_SIZE, false, false, false, false},
+    {BRA_CHUNK_SIZE, false, false, false, false},
+    {64 * 1024, false, false, false, false},
+    {128 * 1024, true, false, false, false},
+    {128 * 1024, true, true, false, false},
+    {192 * 1024, true, true, true, false},
+    {BRA_CHUNK_SIZE, true, true, true, false},
+    {512 * 1024, true, true, true, false},
+    {768 * 1024, true, true, true, false},
+    {BRA_MAX_CHUNK_SIZE, true, true, true, true},
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 static bool bra_io_file_chunks_header_validate(const bra_io_chunk_header_t* chunk_header)
@@ -33,11 +76,19 @@ static bool bra_io_file_chunks_header_validate(const bra_io_chunk_header_t* chun
     if (chunk_header == NULL)
         return false;
 
-    if (chunk_header->primary_index >= BRA_MAX_CHUNK_SIZE)
+    if (BRA_IO_CHUNK_PRIMARY_INDEX(chunk_header->primary_index) >= BRA_MAX_CHUNK_SIZE)
         return false;
-    if (chunk_header->huffman.encoded_size > BRA_MAX_CHUNK_SIZE)
+    if (BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index) > (BRA_IO_CHUNK_PIPELINE_COMPACT | BRA_IO_CHUNK_PIPELINE_ZRLE | BRA_IO_CHUNK_PIPELINE_MULTI))
         return false;
-    if (chunk_header->huffman.orig_size > BRA_MAX_CHUNK_SIZE)
+    // the context mixing coder replaces all the stages after the BWT.
+    if (BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index) == (BRA_IO_CHUNK_PIPELINE_CM | BRA_IO_CHUNK_PIPELINE_ZRLE))
+        return false;
+    if ((chunk_header->primary_index & BRA_IO_CHUNK_FILTERED) != 0 && !bra_filter_validate(BRA_IO_CHUNK_FILTER(chunk_header->primary_index)))
+        return false;
+    // the RLE stage might expand a chunk up to its worst case.
+    if (chunk_header->huffman.encoded_size > BRA_CODEC_BUF_SIZE)
+        return false;
+    if (chunk_header->huffman.orig_size > BRA_CODEC_BUF_SIZE)
         return false;
     if (chunk_header->huffman.encoded_size == 0)
         return false;
@@ -47,6 +98,414 @@ static bool bra_io_file_chunks_header_validate(const bra_io_chunk_header_t* chun
     return true;
 }
 
+static inline bool bra_io_file_chunks_header_is_multi(const bra_io_chunk_header_t* chunk_header)
+{
+    return (BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index) & BRA_IO_CHUNK_PIPELINE_MULTI) != 0;
+}
+
+static inline bool bra_io_file_chunks_header_is_compact(const bra_io_chunk_header_t* chunk_header)
+{
+    return (BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index) & BRA_IO_CHUNK_PIPELINE_COMPACT) != 0;
+}
+
+static inline bool bra_io_file_chunks_header_is_cm(const bra_io_chunk_header_t* chunk_header)
+{
+    return (BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index) & (BRA_IO_CHUNK_PIPELINE_CM | BRA_IO_CHUNK_PIPELINE_MULTI)) == BRA_IO_CHUNK_PIPELINE_CM;
+}
+
+/**
+ * @brief The single Huffman table chunks have the code lengths in their header, the others only the sizes.
+ */
+static inline bool bra_io_file_chunks_header_has_lengths(const bra_io_chunk_header_t* chunk_header)
+{
+    return !bra_io_file_chunks_header_is_multi(chunk_header) && !bra_io_file_chunks_header_is_compact(chunk_header);
+}
+
+/**
+ * @brief Encode @p value as LEB128: 7 bits per byte, the high bit set when more bytes follow.
+ *
+ * @return uint32_t the number of bytes written in @p buf
+ */
+static uint32_t bra_io_file_chunks_varint_encode(uint32_t value, uint8_t buf[BRA_IO_VARINT_MAX_BYTES])
+{
+    uint32_t n = 0;
+    while (value >= 0x80)
+    {
+        buf[n++]   = (uint8_t) (value | 0x80);
+        value    >>= 7;
+    }
+
+    buf[n++] = (uint8_t) value;
+    return n;
+}
+
+static bool bra_io_file_chunks_read_varint(bra_io_file_t* src, uint32_t* value)
+{
+    *value = 0;
+    for (int i = 0; i < BRA_IO_VARINT_MAX_BYTES; ++i)
+    {
+        uint8_t b;
+        if (!bra_io_file_read(src, &b, sizeof(uint8_t)))
+            return false;
+
+        *value |= (uint32_t) (b & 0x7F) << (7 * i);
+        if ((b & 0x80) == 0)
+            return true;
+    }
+
+    bra_log_error("invalid varint in %s", src->fn);
+    return false;
+}
+
+/**
+ * @brief Size on disk of @p chunk_header.
+ */
+static uint32_t bra_io_file_chunks_header_size(const bra_io_chunk_header_t* chunk_header)
+{
+    const uint32_t filter = (chunk_header->primary_index & BRA_IO_CHUNK_FILTERED) != 0 ? 1 : 0;
+    if (bra_io_file_chunks_header_has_lengths(chunk_header))
+        return BRA_IO_CHUNK_HEADER_SIZE + filter;
+    if (!bra_io_file_chunks_header_is_compact(chunk_header))
+        return BRA_IO_CHUNK_HEADER_MULTI_SIZE + filter;
+
+    uint8_t b[BRA_IO_VARINT_MAX_BYTES];
+    return BRA_BWT_INDEX_BYTES + filter + bra_io_file_chunks_varint_encode(chunk_header->huffman.orig_size, b) + bra_io_file_chunks_varint_encode(chunk_header->huffman.encoded_size, b);
+}
+
+/**
+ * @brief Size on disk of a #BRA_ATTR_COMP_FAST @p chunk_header: only the 2 sizes as varints.
+ */
+static uint32_t bra_io_file_chunks_fast_header_size(const bra_io_chunk_header_t* chunk_header)
+{
+    uint8_t b[BRA_IO_VARINT_MAX_BYTES];
+    return bra_io_file_chunks_varint_encode(chunk_header->huffman.orig_size, b) + bra_io_file_chunks_varint_encode(chunk_header->huffman.encoded_size, b);
+}
+
+static bool bra_io_file_chunks_read_fast_header(bra_io_file_t* src, bra_io_chunk_header_t* chunk_header)
+{
+    memset(chunk_header, 0, sizeof(bra_io_chunk_header_t));
+    if (!bra_io_file_chunks_read_varint(src, &chunk_header->huffman.orig_size) || !bra_io_file_chunks_read_varint(src, &chunk_header->huffman.encoded_size))
+    {
+        bra_log_error("unable to read fast chunk header from %s", src->fn);
+        return false;
+    }
+
+    // the LZ77 data has no expansion stage before it.
+    if (chunk_header->huffman.orig_size == 0 || chunk_header->huffman.orig_size > BRA_MAX_CHUNK_SIZE)
+        return false;
+    if (chunk_header->huffman.encoded_size == 0 || chunk_header->huffman.encoded_size > BRA_CODEC_BUF_SIZE)
+        return false;
+
+    return true;
+}
+
+static bool bra_io_file_chunks_write_fast_header(bra_io_file_t* dst, const bra_io_chunk_header_t* chunk_header)
+{
+    uint8_t  b[2 * BRA_IO_VARINT_MAX_BYTES];
+    uint32_t n  = bra_io_file_chunks_varint_encode(chunk_header->huffman.orig_size, b);
+    n          += bra_io_file_chunks_varint_encode(chunk_header->huffman.encoded_size, &b[n]);
+    if (!bra_io_file_write(dst, b, n))
+    {
+        bra_log_error("unable to write fast chunk header to %s", dst->fn);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Compress the chunk of @p s bytes in @c codec->buf with BWT+MTF+zero-run (or RLE)+huffman, or BWT+context mixing:
+ *        the smallest of the encodings enabled by @p level.
+ *
+ * @param codec
+ * @param s
+ * @param level        the optional stages to run.
+ * @param x86          the chunk is part of an x86 executable.
+ * @param chunk_header the header of the chunk to fill.
+ * @param out          set to the codec buffer holding the compressed chunk.
+ * @retval true
+ * @retval false
+ */
+static bool bra_io_file_chunks_encode_chunk(bra_codec_ctx_t* codec, const uint32_t s, const bra_io_comp_level_t* level, const bool x86, bra_io_chunk_header_t* chunk_header, const uint8_t** out)
+{
+    uint8_t*        buf           = codec->buf;
+    uint8_t*        buf2          = codec->buf2;
+    bra_bwt_index_t primary_index = 0;
+
+    // reversible filter, its counts in the BWT index buffer not used yet.
+    uint8_t filter = BRA_FILTER_NONE;
+    if (level->filters)
+    {
+        filter = x86 ? BRA_FILTER_X86 : bra_filter_select(buf, s, codec->buf_trans);
+        bra_filter_encode(filter, buf, s, buf2);
+    }
+
+    if (!bra_bwt_encode2(buf, s, &primary_index, codec->buf_trans, buf2))
+    {
+        bra_log_error("bra_bwt_encode() failed");
+        return false;
+    }
+
+    // the BWT index buffer is free now: the candidate encodings go there, the smallest with its header is kept.
+    uint8_t* const work      = (uint8_t*) codec->buf_trans;
+    uint8_t*       best      = NULL;
+    uint32_t       best_size = UINT32_MAX;
+
+    // context mixing coder on the BWT output.
+    size_t cm_s = 0;
+    if (level->cm && bra_codec_ctx_reserve_cm(codec) && bra_cm_encode2(codec->cm, buf2, s, &work[2 * BRA_CODEC_BUF_SIZE], BRA_CODEC_BUF_SIZE, &cm_s))
+    {
+        memset(chunk_header, 0, sizeof(bra_io_chunk_header_t));
+        chunk_header->primary_index        = BRA_IO_CHUNK_SET_PIPELINE(0, BRA_IO_CHUNK_PIPELINE_CM);
+        chunk_header->huffman.orig_size    = s;
+        chunk_header->huffman.encoded_size = (uint32_t) cm_s;
+        best                               = &work[2 * BRA_CODEC_BUF_SIZE];
+        best_size                          = bra_io_file_chunks_header_size(chunk_header) + (uint32_t) cm_s;
+    }
+
+    if (!bra_mtf_encode2(buf2, s, buf))
+    {
+        bra_log_error("bra_mtf_encode() failed");
+        return false;
+    }
+
+    // zero-run (or RLE), then multiple Huffman tables (or a single one):
+    // zero-run and the multiple tables don't always win, neither fits in the codec buffer in the worst case.
+    const unsigned stages[] = {BRA_IO_CHUNK_PIPELINE_ZRLE, BRA_IO_CHUNK_PIPELINE_RLE};
+    for (size_t i = level->zrle ? 0 : 1; i < sizeof(stages) / sizeof(stages[0]); ++i)
+    {
+        const bool zrle      = stages[i] == BRA_IO_CHUNK_PIPELINE_ZRLE;
+        size_t     buf_rle_s = 0;
+        if (zrle ? !bra_zrle_encode2(buf, s, buf2, BRA_CODEC_BUF_SIZE, &buf_rle_s) : !bra_rle_encode2(buf, s, buf2, BRA_CODEC_BUF_SIZE, &buf_rle_s))
+            continue;
+
+        for (int multi = level->multi ? 1 : 0; multi >= 0; --multi)
+        {
+            uint8_t*              huf_buf = best == work ? &work[BRA_CODEC_BUF_SIZE] : work;
+            bra_io_chunk_header_t h       = {.primary_index = BRA_IO_CHUNK_SET_PIPELINE(0, stages[i] | BRA_IO_CHUNK_PIPELINE_MULTI | BRA_IO_CHUNK_PIPELINE_COMPACT)};
+            if (multi ? !bra_huffman_encode_multi(buf2, (uint32_t) buf_rle_s, &h.huffman, huf_buf, BRA_CODEC_BUF_SIZE) : !bra_huffman_encode_compact(buf2, (uint32_t) buf_rle_s, &h.huffman, huf_buf, BRA_CODEC_BUF_SIZE))
+            {
+                // a single table with its code lengths in the header when the compact coding doesn't fit.
+                h.primary_index = BRA_IO_CHUNK_SET_PIPELINE(0, stages[i]);
+                if (multi || !bra_huffman_encode2(buf2, (uint32_t) buf_rle_s, &h.huffman, huf_buf, BRA_CODEC_BUF_SIZE))
+                    continue;
+            }
+
+            const uint32_t h_size = bra_io_file_chunks_header_size(&h) + h.huffman.encoded_size;
+            if (h_size >= best_size)
+                continue;
+
+            *chunk_header = h;
+            best          = huf_buf;
+            best_size     = h_size;
+        }
+    }
+
+    if (best == NULL)
+    {
+        bra_log_error("bra_huffman_encode() failed");
+        return false;
+    }
+
+    const unsigned pipeline     = BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index);
+    chunk_header->primary_index = BRA_IO_CHUNK_SET_FILTER(BRA_IO_CHUNK_SET_PIPELINE(primary_index, pipeline), filter);
+    *out                        = best;
+    return true;
+}
+
+/**
+ * @brief Compress the chunk of @p s bytes in @c codec->buf with LZ77 only.
+ *        The header has no primary index and no code lengths, only the sizes.
+ *
+ * @param codec
+ * @param s
+ * @param chunk_header the header of the chunk to fill.
+ * @param out          set to the codec buffer holding the compressed chunk.
+ * @retval true
+ * @retval false
+ */
+static bool bra_io_file_chunks_encode_chunk_fast(bra_codec_ctx_t* codec, const uint32_t s, bra_io_chunk_header_t* chunk_header, const uint8_t** out)
+{
+    size_t lz_s = 0;
+    if (!bra_lz_encode2(codec->buf, s, codec->buf2, BRA_CODEC_BUF_SIZE, &lz_s))
+    {
+        bra_log_error("bra_lz_encode() failed");
+        return false;
+    }
+
+    chunk_header->huffman.orig_size    = s;
+    chunk_header->huffman.encoded_size = (uint32_t) lz_s;
+    *out                               = codec->buf2;
+    return true;
+}
+
+/**
+ * @brief Decode the #BRA_IO_CHUNK_PIPELINE_CM chunk read in @c codec->buf, when @p decode, in @c codec->buf too.
+ *
+ * @param codec
+ * @param src
+ * @param decode       @c false to compute only the original size, that is in the header.
+ * @param chunk_header the header read.
+ * @param out_size     the original size of the chunk.
+ * @retval true
+ * @retval false
+ */
+static bool bra_io_file_chunks_read_chunk_cm(bra_codec_ctx_t* codec, bra_io_file_t* src, const bool decode, const bra_io_chunk_header_t* chunk_header, size_t* out_size)
+{
+    const uint32_t        s             = chunk_header->huffman.orig_size;
+    const bra_bwt_index_t primary_index = BRA_IO_CHUNK_PRIMARY_INDEX(chunk_header->primary_index);
+    if (s > BRA_MAX_CHUNK_SIZE || primary_index >= s)
+    {
+        bra_log_error("invalid primary index (%u) for chunk size %u in %s", primary_index, s, src->fn);
+        return false;
+    }
+
+    *out_size = s;
+    if (!decode)
+        return true;
+
+    if (!bra_codec_ctx_reserve_cm(codec))
+        return false;
+
+    if (!bra_cm_decode2(codec->cm, codec->buf, chunk_header->huffman.encoded_size, codec->buf2, s))
+    {
+        bra_log_error("unable to decode context mixing in %s", src->fn);
+        return false;
+    }
+
+    bra_bwt_decode2(codec->buf2, s, primary_index, codec->buf_trans, codec->buf);
+    if (!bra_filter_decode(BRA_IO_CHUNK_FILTER(chunk_header->primary_index), codec->buf, s, codec->buf2))
+    {
+        bra_log_error("invalid chunk filter in %s", src->fn);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Read a BWT pipeline chunk and, when @p decode, decompress it in @c codec->buf.
+ *
+ * @param codec
+ * @param src
+ * @param decode       @c false to compute only the original size, decoding just the Huffman stage.
+ * @param chunk_header the header read.
+ * @param out_size     the original size of the chunk.
+ * @retval true
+ * @retval false
+ */
+static bool bra_io_file_chunks_read_chunk(bra_codec_ctx_t* codec, bra_io_file_t* src, const bool decode, bra_io_chunk_header_t* chunk_header, size_t* out_size)
+{
+    uint8_t* buf  = codec->buf;
+    uint8_t* buf2 = codec->buf2;
+
+    // read chunk header
+    if (!bra_io_file_chunks_read_header(src, chunk_header))
+        return false;
+
+    if (!bra_io_file_chunks_header_validate(chunk_header))
+    {
+        bra_log_error("chunk header not valid in %s", src->fn);
+        return false;
+    }
+
+    // read source chunk
+    if (!bra_io_file_read(src, buf, chunk_header->huffman.encoded_size))
+        return false;
+
+    // decode huffman (required for computing file size)
+    const uint32_t        huf_s         = chunk_header->huffman.orig_size;
+    const bool            zrle          = (BRA_IO_CHUNK_PIPELINE(chunk_header->primary_index) & BRA_IO_CHUNK_PIPELINE_ZRLE) != 0;
+    const bra_bwt_index_t primary_index = BRA_IO_CHUNK_PRIMARY_INDEX(chunk_header->primary_index);
+    if (bra_io_file_chunks_header_is_cm(chunk_header))
+        return bra_io_file_chunks_read_chunk_cm(codec, src, decode, chunk_header, out_size);
+
+    if (bra_io_file_chunks_header_is_multi(chunk_header) ? !bra_huffman_decode_multi(&chunk_header->huffman, buf, buf2, BRA_CODEC_BUF_SIZE) : !bra_huffman_decode2(&chunk_header->huffman, buf, buf2, BRA_CODEC_BUF_SIZE))
+    {
+        bra_log_error("unable to decode huffman file: %s ", src->fn);
+        return false;
+    }
+
+    if (!decode)
+    {
+        // compute only the original file size:
+        *out_size = zrle ? bra_zrle_decode_compute_size(buf2, huf_s) : bra_rle_decode_compute_size(buf2, huf_s);
+        return true;
+    }
+
+    // decode zero-run or RLE
+    size_t s = 0;
+    if (zrle ? !bra_zrle_decode2(buf2, huf_s, buf, BRA_MAX_CHUNK_SIZE, &s) : !bra_rle_decode2(buf2, huf_s, buf, BRA_MAX_CHUNK_SIZE, &s))
+    {
+        bra_log_error("unable to decode %s in %s", zrle ? "zero-run" : "RLE", src->fn);
+        return false;
+    }
+
+    if (primary_index >= s)
+    {
+        bra_log_error("invalid primary index (%u) for chunk size %zu in %s", primary_index, s, src->fn);
+        return false;
+    }
+
+    // decompress MTF+BWT, then the filter
+    bra_mtf_decode2(buf, s, buf2);
+    bra_bwt_decode2(buf2, s, primary_index, codec->buf_trans, buf);
+    if (!bra_filter_decode(BRA_IO_CHUNK_FILTER(chunk_header->primary_index), buf, s, buf2))
+    {
+        bra_log_error("invalid chunk filter in %s", src->fn);
+        return false;
+    }
+
+    *out_size = s;
+    return true;
+}
+
+/**
+ * @brief Read and, when @p decode, decompress a #BRA_ATTR_COMP_FAST chunk.
+ *
+ * @param codec
+ * @param dst          where to write the decoded chunk, can be @c NULL.
+ * @param src
+ * @param me           its CRC32 is updated when @p decode.
+ * @param decode       @c false to only skip the chunk data.
+ * @param chunk_header the header read.
+ * @retval true
+ * @retval false
+ */
+static bool bra_io_file_chunks_decompress_chunk_fast(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode, bra_io_chunk_header_t* chunk_header)
+{
+    if (!bra_io_file_chunks_read_fast_header(src, chunk_header))
+    {
+        bra_log_error("chunk header not valid in %s", src->fn);
+        return false;
+    }
+
+    if (!bra_io_file_read(src, codec->buf, chunk_header->huffman.encoded_size))
+        return false;
+
+    // the original size is in the header, nothing to decode for it.
+    if (!decode)
+        return true;
+
+    size_t s = 0;
+    if (!bra_lz_decode2(codec->buf, chunk_header->huffman.encoded_size, codec->buf2, BRA_MAX_CHUNK_SIZE, &s) || s != chunk_header->huffman.orig_size)
+    {
+        bra_log_error("unable to decode LZ77 in %s", src->fn);
+        return false;
+    }
+
+    // update CRC32
+    me->crc32         = bra_crc32c(chunk_header, sizeof(bra_io_chunk_header_t), me->crc32);
+    me->crc32         = bra_crc32c(codec->buf2, s, me->crc32);
+    codec->data_crc32 = bra_crc32c(codec->buf2, s, codec->data_crc32);
+
+    // write source chunk
+    if (dst != NULL)
+        return bra_io_file_write(dst, codec->buf2, s);
+
+    return true;
+}
+
 /////////////////////////////////////////////////////////////////////////
 
 bool bra_io_file_chunks_read_header(bra_io_file_t* src, bra_io_chunk_header_t* chunk_header)
@@ -63,8 +522,37 @@ bool bra_io_file_chunks_read_header(bra_io_file_t* src, bra_io_chunk_header_t* c
     }
 
     chunk_header->primary_index = pi_union.u32;
-    // read huffman
-    if (!bra_io_file_read(src, &chunk_header->huffman, sizeof(bra_huffman_t)))
+    if ((chunk_header->primary_index & BRA_IO_CHUNK_FILTERED) != 0)
+    {
+        uint8_t filter = BRA_FILTER_NONE;
+        if (!bra_io_file_read(src, &filter, sizeof(filter)))
+        {
+            bra_log_error("unable to read chunk filter from %s", src->fn);
+            return false;
+        }
+
+        chunk_header->primary_index |= (bra_bwt_index_t) filter << 24;
+    }
+
+    // read huffman, the multi-table code lengths are in the data.
+    if (!bra_io_file_chunks_header_has_lengths(chunk_header))
+    {
+        memset(chunk_header->huffman.lengths, 0, sizeof(chunk_header->huffman.lengths));
+        if (bra_io_file_chunks_header_is_compact(chunk_header))
+        {
+            if (!bra_io_file_chunks_read_varint(src, &chunk_header->huffman.orig_size) || !bra_io_file_chunks_read_varint(src, &chunk_header->huffman.encoded_size))
+            {
+                bra_log_error("unable to read chunk huffman header from %s", src->fn);
+                return false;
+            }
+        }
+        else if (!bra_io_file_read(src, &chunk_header->huffman.orig_size, BRA_IO_CHUNK_HEADER_MULTI_SIZE - BRA_BWT_INDEX_BYTES))
+        {
+            bra_log_error("unable to read chunk huffman header from %s", src->fn);
+            return false;
+        }
+    }
+    else if (!bra_io_file_read(src, &chunk_header->huffman, sizeof(bra_huffman_t)))
     {
         bra_log_error("unable to read chunk huffman header from %s", src->fn);
         return false;
@@ -85,7 +573,33 @@ bool bra_io_file_chunks_write_header(bra_io_file_t* dst, const bra_io_chunk_head
         return false;
     }
 
-    if (!bra_io_file_write(dst, &chunk_header->huffman, sizeof(bra_huffman_t)))
+    if ((chunk_header->primary_index & BRA_IO_CHUNK_FILTERED) != 0)
+    {
+        const uint8_t filter = BRA_IO_CHUNK_FILTER(chunk_header->primary_index);
+        if (!bra_io_file_write(dst, &filter, sizeof(filter)))
+        {
+            bra_log_error("unable to write chunk filter to %s", dst->fn);
+            return false;
+        }
+    }
+
+    if (!bra_io_file_chunks_header_has_lengths(chunk_header))
+    {
+        uint8_t  b[2 * BRA_IO_VARINT_MAX_BYTES];
+        uint32_t n = 0;
+        if (bra_io_file_chunks_header_is_compact(chunk_header))
+        {
+            n  = bra_io_file_chunks_varint_encode(chunk_header->huffman.orig_size, b);
+            n += bra_io_file_chunks_varint_encode(chunk_header->huffman.encoded_size, &b[n]);
+        }
+
+        if (n > 0 ? !bra_io_file_write(dst, b, n) : !bra_io_file_write(dst, &chunk_header->huffman.orig_size, BRA_IO_CHUNK_HEADER_MULTI_SIZE - BRA_BWT_INDEX_BYTES))
+        {
+            bra_log_error("unable to write chunk huffman header to %s", dst->fn);
+            return false;
+        }
+    }
+    else if (!bra_io_file_write(dst, &chunk_header->huffman, sizeof(bra_huffman_t)))
     {
         bra_log_error("unable to write chunk huffman header to %s", dst->fn);
         return false;
@@ -94,17 +608,27 @@ bool bra_io_file_chunks_write_header(bra_io_file_t* dst, const bra_io_chunk_head
     return true;
 }
 
-bool bra_io_file_chunks_read_file(bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode)
+bool bra_io_file_chunks_read_file(bra_codec_ctx_t* codec, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode)
 {
+    assert(codec != NULL);
     assert_bra_io_file_t(src);
     assert(me != NULL);
 
+    if (BRA_ATTR_IS_REF(me->attributes))
+        return bra_io_file_chunks_read_ref_file(codec, NULL, src, me, decode);
+
+    if (BRA_ATTR_IS_CDC(me->attributes))
+        return bra_io_file_cdc_read_file(codec, NULL, src, me, decode);
+
     switch (BRA_ATTR_COMP(me->attributes))
     {
     case BRA_ATTR_COMP_STORED:
         return bra_io_file_chunks_copy_file(NULL, src, data_size, me, decode);
     case BRA_ATTR_COMP_COMPRESSED:
-        return bra_io_file_chunks_decompress_file(NULL, src, data_size, me, decode);
+    case BRA_ATTR_COMP_FAST:
+        return bra_io_file_chunks_decompress_file(codec, NULL, src, data_size, me, decode);
+    case BRA_ATTR_COMP_SOLID:
+        return bra_io_file_chunks_read_solid_file(codec, NULL, src, me, decode);
     default:
         bra_log_critical("invalid compression type for file: %u", BRA_ATTR_COMP(me->attributes));
         return false;
@@ -115,13 +639,9 @@ bool bra_io_file_chunks_copy_file(bra_io_file_t* dst, bra_io_file_t* src, const
 {
     assert_bra_io_file_t(src);
 
-    extern uint8_t* g_buf;
-
-    if (g_buf == NULL)
-    {
-        bra_log_critical("bra not initialized");
-        return false;
-    }
+    // NOTE: own buffer, sized on the data, instead of the global one:
+    //       stored entries can be copied concurrently from different threads.
+    uint8_t* buf = NULL;
 
     if (dst != NULL)
     {
@@ -135,143 +655,152 @@ bool bra_io_file_chunks_copy_file(bra_io_file_t* dst, bra_io_file_t* src, const
         goto BRA_IO_FILE_CHUNKS_COPY_FILE_ERROR;
     }
 
+    if (data_size > 0)
+    {
+        buf = malloc(sizeof(uint8_t) * _bra_min(BRA_CHUNK_SIZE, data_size));
+        if (buf == NULL)
+        {
+            bra_log_critical("unable to allocate copy buffer");
+            goto BRA_IO_FILE_CHUNKS_COPY_FILE_ERROR;
+        }
+    }
+
     for (uint64_t i = 0; i < data_size;)
     {
-        const uint32_t s = _bra_min(BRA_MAX_CHUNK_SIZE, data_size - i);
+        const uint32_t s = _bra_min(BRA_CHUNK_SIZE, data_size - i);
 
         // read source chunk
-        if (!bra_io_file_read(src, g_buf, s))
+        if (!bra_io_file_read(src, buf, s))
             goto BRA_IO_FILE_CHUNKS_COPY_FILE_ERROR;
 
         // update CRC32
         if (compute_crc32)
-            me->crc32 = bra_crc32c(g_buf, s, me->crc32);
+            me->crc32 = bra_crc32c(buf, s, me->crc32);
 
         // write source chunk
         if (dst != NULL)
         {
-            if (!bra_io_file_write(dst, g_buf, s))
+            if (!bra_io_file_write(dst, buf, s))
                 goto BRA_IO_FILE_CHUNKS_COPY_FILE_ERROR;
         }
 
         i += s;
     }
 
+    free(buf);
     return true;
 
 BRA_IO_FILE_CHUNKS_COPY_FILE_ERROR:
+    free(buf);
     if (dst != NULL)
         bra_io_file_close(dst);
     bra_io_file_close(src);
     return false;
 }
 
-bool bra_io_file_chunks_compress_file(bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me)
+/**
+ * @brief Compress @p data_size bytes of @p src chunk by chunk, writing them to @p dst.
+ *
+ * @param codec
+ * @param dst            where to write the chunks, @c NULL to only measure them.
+ * @param src
+ * @param data_size
+ * @param me             its compression type selects the engine.
+ * @param out_size       bytes of the chunks, headers included.
+ * @param out_crc32      CRC32C of the chunk headers and of the original data.
+ * @param out_num_chunks
+ * @retval true
+ * @retval false on error, the files are left to the caller.
+ */
+static bool bra_io_file_chunks_compress_chunks(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, const bra_meta_entry_t* me, uint64_t* out_size, uint32_t* out_crc32, uint64_t* out_num_chunks)
 {
-    assert_bra_io_file_t(dst);
-    assert_bra_io_file_t(src);
-    assert(me != NULL);
-
-    extern uint8_t* g_buf;
-    extern uint8_t* g_buf2;
-
-    if (g_buf == NULL || g_buf2 == NULL)
-    {
-        bra_log_critical("bra not initialized");
-        return false;
-    }
-
-    uint8_t*             buf_rle     = NULL;
-    bra_huffman_chunk_t* buf_huffman = NULL;
-    uint32_t             crc32       = BRA_CRC32C_INIT;
-
-    // NOTE: compress a file is done in a temporary file:
-    //      if it is smaller than the original file append it to the archive.
-    //      otherwise change the attribute to store and redo the whole file
-    //      processing including metadata due to CRC32
-    bra_io_file_t tmpfile;
-    if (!bra_io_file_tmp_open(&tmpfile))
-    {
-        bra_log_error("unable to compress file: %s", src->fn);
-        return false;
-    }
-
+    // every stage works in the codec buffers, no allocations per chunk.
+    uint8_t*                   buf   = codec->buf;
+    const bool                 fast  = BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_FAST;
+    const bra_io_comp_level_t* level = &g_bra_io_comp_levels[_bra_min(codec->level, BRA_COMP_LEVEL_MAX)];
+
+    bool x86        = false;
+    *out_size       = 0;
+    *out_crc32      = BRA_CRC32C_INIT;
+    *out_num_chunks = 0;
     for (uint64_t i = 0; i < data_size;)
     {
-        const uint32_t s = _bra_min(BRA_MAX_CHUNK_SIZE, data_size - i);
+        const uint32_t s = _bra_min(level->chunk_size, data_size - i);
 
         bra_log_printf("%3u%%", (unsigned int) (i * 100 / data_size));
         bra_log_printf("\b\b\b\b");
 
         // read source chunk
-        if (!bra_io_file_read(src, g_buf, s))
-        {
-            bra_io_file_close(&tmpfile);
-            bra_io_file_close(dst);
+        if (!bra_io_file_read(src, buf, s))
             return false;
-        }
 
-        const uint32_t crc_source_chunk = bra_crc32c(g_buf, s, BRA_CRC32C_INIT);
-        // compress BWT+MTF+RLE+huffman
+        // the executables are recognized by their first bytes.
+        if (i == 0 && !fast)
+            x86 = bra_filter_is_x86(buf, s);
+
+        const uint32_t crc_source_chunk = bra_crc32c(buf, s, BRA_CRC32C_INIT);
+        // compress LZ77 or BWT+MTF+zero-run (or RLE)+huffman
         bra_io_chunk_header_t chunk_header = {.primary_index = 0};
-        if (!bra_bwt_encode2(g_buf, s, &chunk_header.primary_index, g_buf2))
+        const uint8_t*        out          = NULL;
+        if (fast ? !bra_io_file_chunks_encode_chunk_fast(codec, s, &chunk_header, &out) : !bra_io_file_chunks_encode_chunk(codec, s, level, x86, &chunk_header, &out))
         {
-            bra_log_error("bra_bwt_encode() failed: %s (chunk: %" PRIu64 ")", src->fn, i);
-            goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
+            bra_log_error("unable to compress file: %s (chunk: %" PRIu64 ")", src->fn, i);
+            return false;
         }
 
-        if (!bra_mtf_encode2(g_buf2, s, g_buf))
-        {
-            bra_log_error("bra_mtf_encode() failed: %s (chunk: %" PRIu64 ")", src->fn, i);
-            goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
-        }
+        // CRC32
+        *out_crc32 = bra_crc32c(&chunk_header, sizeof(chunk_header), *out_crc32);
+        *out_crc32 = bra_crc32c_combine(*out_crc32, crc_source_chunk, s);
 
-        // RLE encoding
-        size_t buf_rle_s = 0;
-        if (!bra_rle_encode(g_buf, s, &buf_rle, &buf_rle_s))
+        *out_size += (fast ? bra_io_file_chunks_fast_header_size(&chunk_header) : bra_io_file_chunks_header_size(&chunk_header)) + chunk_header.huffman.encoded_size;
+        if (dst != NULL)
         {
-            bra_log_error("bra_rle_encode() failed: %s (chunk: %" PRIu64 ")", src->fn, i);
-            goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
-        }
+            // write chunk header
+            if (fast ? !bra_io_file_chunks_write_fast_header(dst, &chunk_header) : !bra_io_file_chunks_write_header(dst, &chunk_header))
+                return false;
 
-        // huffman encoding
-        buf_huffman = bra_huffman_encode(buf_rle, buf_rle_s);
-        if (buf_huffman == NULL)
-        {
-            bra_log_error("bra_huffman_encode() failed: %s (chunk: %" PRIu64 ")", src->fn, i);
-            goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
+            // write source chunk
+            if (!bra_io_file_write(dst, out, chunk_header.huffman.encoded_size))
+                return false;
         }
 
-        chunk_header.huffman = buf_huffman->meta;
-
-        // CRC32
-        crc32 = bra_crc32c(&chunk_header, sizeof(chunk_header), crc32);
-        crc32 = bra_crc32c_combine(crc32, crc_source_chunk, s);
-
-        // write chunk header
-        if (!bra_io_file_chunks_write_header(&tmpfile, &chunk_header))
-            goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
+        i += s;
+        ++*out_num_chunks;
+    }
 
-        // write source chunk
-        if (!bra_io_file_write(&tmpfile, buf_huffman->data, buf_huffman->meta.encoded_size))
-            goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
+    return true;
+}
 
-        free(buf_rle);
-        buf_rle = NULL;
+bool bra_io_file_chunks_compress_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(dst);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
 
-        bra_huffman_chunk_free(buf_huffman);
-        buf_huffman = NULL;
+    if (!bra_codec_ctx_reserve(codec))
+        return false;
 
-        i += s;
+    // NOTE: compress a file is done in a temporary file:
+    //      if it is smaller than the original file append it to the archive.
+    //      otherwise change the attribute to store and redo the whole file
+    //      processing including metadata due to CRC32
+    bra_io_file_t tmpfile;
+    if (!bra_io_file_tmp_open(&tmpfile))
+    {
+        bra_log_error("unable to compress file: %s", src->fn);
+        return false;
     }
 
-    // Check if the tmpfile is smaller than original file:
-    const int64_t tmpfile_size = bra_io_file_tell(&tmpfile);
-    if (tmpfile_size < 0)
+    uint64_t tmpfile_size = 0;
+    uint32_t crc32        = 0;
+    uint64_t num_chunks   = 0;
+    if (!bra_io_file_chunks_compress_chunks(codec, &tmpfile, src, data_size, me, &tmpfile_size, &crc32, &num_chunks))
         goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
 
+    // Check if the tmpfile is smaller than original file:
     bool res = true;
-    if ((uint64_t) tmpfile_size >= data_size)
+    if (tmpfile_size >= data_size)
     {
         res            = false;
         me->attributes = BRA_ATTR_SET_COMP(me->attributes, BRA_ATTR_COMP_STORED);
@@ -281,15 +810,11 @@ bool bra_io_file_chunks_compress_file(bra_io_file_t* dst, bra_io_file_t* src, co
         if (!bra_io_file_seek(&tmpfile, 0, SEEK_SET))
             goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
 
-        uint64_t num_chunks = (data_size / BRA_MAX_CHUNK_SIZE);
-        if (data_size % BRA_MAX_CHUNK_SIZE > 0)
-            ++num_chunks;
-
         // update file size
         bra_meta_entry_file_t* mef = (bra_meta_entry_file_t*) me->entry_data;
         mef->data_size             = tmpfile_size;
-        me->crc32                  = bra_crc32c(&tmpfile_size, sizeof(tmpfile_size), me->crc32);
-        me->crc32                  = bra_crc32c_combine(me->crc32, crc32, data_size + (num_chunks * sizeof(bra_io_chunk_header_t)));
+        _bra_compute_file_entry_crc32(me);
+        me->crc32 = bra_crc32c_combine(me->crc32, crc32, data_size + (num_chunks * sizeof(bra_io_chunk_header_t)));
         if (!bra_io_file_meta_entry_write_file_entry(dst, me))
             goto BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR;
 
@@ -301,35 +826,84 @@ bool bra_io_file_chunks_compress_file(bra_io_file_t* dst, bra_io_file_t* src, co
 
 BRA_IO_FILE_COMPRESS_FILE_CHUNKS_ERR:
     bra_io_file_close(&tmpfile);
-    if (buf_rle != NULL)
-        free(buf_rle);
-
-    bra_huffman_chunk_free(buf_huffman);
-
     bra_io_file_close(dst);
     bra_io_file_close(src);
     return false;
 }
 
-bool bra_io_file_chunks_decompress_file(bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode)
+bool bra_io_file_chunks_compress_size(bra_codec_ctx_t* codec, bra_io_file_t* src, const uint64_t data_size, const bra_meta_entry_t* me, uint64_t* out_size)
 {
+    assert(codec != NULL);
     assert_bra_io_file_t(src);
     assert(me != NULL);
+    assert(out_size != NULL);
 
-    extern uint8_t*         g_buf;
-    extern uint8_t*         g_buf2;
-    extern bra_bwt_index_t* g_buf_trans;
+    if (!bra_codec_ctx_reserve(codec))
+        return false;
 
-    if (g_buf == NULL || g_buf2 == NULL || g_buf_trans == NULL)
+    uint32_t crc32      = 0;
+    uint64_t num_chunks = 0;
+    if (!bra_io_file_chunks_compress_chunks(codec, NULL, src, data_size, me, out_size, &crc32, &num_chunks) || !bra_io_file_seek(src, 0, SEEK_SET))
     {
-        bra_log_critical("bra not initialized");
+        bra_io_file_close(src);
         return false;
     }
 
-    bool     res            = true;
-    uint8_t* buf_rle        = NULL;
-    uint8_t* buf_huffman    = NULL;
-    uint64_t file_orig_size = 0;
+    return true;
+}
+
+bool bra_io_file_chunks_compress_stream(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, const uint64_t comp_size, bra_meta_entry_t* me)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(dst);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
+    assert(comp_size < data_size);
+
+    if (!bra_codec_ctx_reserve(codec))
+        return false;
+
+    // the CRC32 of the chunks is known only once written: it is at the end of the entry.
+    bra_meta_entry_file_t* mef = (bra_meta_entry_file_t*) me->entry_data;
+    mef->data_size             = comp_size;
+    _bra_compute_file_entry_crc32(me);
+    if (!bra_io_file_meta_entry_write_file_entry(dst, me))
+        goto BRA_IO_FILE_COMPRESS_STREAM_ERR;
+
+    uint64_t size       = 0;
+    uint32_t crc32      = 0;
+    uint64_t num_chunks = 0;
+    if (!bra_io_file_chunks_compress_chunks(codec, dst, src, data_size, me, &size, &crc32, &num_chunks))
+        goto BRA_IO_FILE_COMPRESS_STREAM_ERR;
+
+    if (size != comp_size)
+    {
+        bra_log_critical("compressed size of %s changed: %" PRIu64 " != %" PRIu64, src->fn, size, comp_size);
+        goto BRA_IO_FILE_COMPRESS_STREAM_ERR;
+    }
+
+    me->crc32 = bra_crc32c_combine(me->crc32, crc32, data_size + (num_chunks * sizeof(bra_io_chunk_header_t)));
+    return true;
+
+BRA_IO_FILE_COMPRESS_STREAM_ERR:
+    bra_io_file_close(dst);
+    bra_io_file_close(src);
+    return false;
+}
+
+bool bra_io_file_chunks_decompress_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
+
+    if (!bra_codec_ctx_reserve(codec))
+        return false;
+
+    // every stage works in the codec buffers, no allocations per chunk.
+    uint8_t*   buf            = codec->buf;
+    uint64_t   file_orig_size = 0;
+    const bool fast           = BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_FAST;
 
     if (dst != NULL)
     {
@@ -339,78 +913,38 @@ bool bra_io_file_chunks_decompress_file(bra_io_file_t* dst, bra_io_file_t* src,
 
     for (uint64_t i = 0; i < data_size;)
     {
-        // read chunk header
         bra_io_chunk_header_t chunk_header = {.primary_index = 0};
-        if (!bra_io_file_chunks_read_header(src, &chunk_header))
-            goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
-
-        if (!bra_io_file_chunks_header_validate(&chunk_header))
+        if (fast)
         {
-            bra_log_error("chunk header not valid in %s", src->fn);
-            goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
-        }
-
-        // in this way if not RLE encoded otherwise it must also decode huffman to detect RLE size
-        // file_orig_size += chunk_header.huffman.orig_size;
+            if (!bra_io_file_chunks_decompress_chunk_fast(codec, dst, src, me, decode, &chunk_header))
+                goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
 
-        // read source chunk
-        if (!bra_io_file_read(src, g_buf, chunk_header.huffman.encoded_size))
-            goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
+            file_orig_size += chunk_header.huffman.orig_size;
+            i              += chunk_header.huffman.encoded_size + bra_io_file_chunks_fast_header_size(&chunk_header);
+            continue;
+        }
 
-        // decode huffman (required for computing file size)
-        uint32_t huf_s = 0;
-        buf_huffman    = bra_huffman_decode(&chunk_header.huffman, g_buf, &huf_s);
-        if (buf_huffman == NULL)
-        {
-            bra_log_error("unable to decode huffman file: %s ", src->fn);
+        size_t s = 0;
+        if (!bra_io_file_chunks_read_chunk(codec, src, decode, &chunk_header, &s))
             goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
-        }
 
-        if (!decode)
-        {
-            // compute only the original file size:
-            file_orig_size += bra_rle_decode_compute_size(buf_huffman, huf_s);
-        }
-        else
+        file_orig_size += s;
+        if (decode)
         {
-            // decode RLE
-            size_t s = 0;
-            if (!bra_rle_decode(buf_huffman, huf_s, &buf_rle, &s))
-            {
-                bra_log_error("unable to decode RLE in %s", src->fn);
-                goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
-            }
-
-            file_orig_size += s;
-            if (chunk_header.primary_index >= s)
-            {
-                bra_log_error("invalid primary index (%u) for chunk size %zu in %s", chunk_header.primary_index, s, src->fn);
-                goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
-            }
-
-            // decompress MTF+BWT
-            bra_mtf_decode2(buf_rle, s, g_buf2);
-            bra_bwt_decode2(g_buf2, s, chunk_header.primary_index, g_buf_trans, g_buf);
-
             // update CRC32
-            me->crc32 = bra_crc32c(&chunk_header, sizeof(bra_io_chunk_header_t), me->crc32);
-            me->crc32 = bra_crc32c(g_buf, s, me->crc32);
-
-            free(buf_rle);
-            buf_rle = NULL;
+            me->crc32         = bra_crc32c(&chunk_header, sizeof(bra_io_chunk_header_t), me->crc32);
+            me->crc32         = bra_crc32c(buf, s, me->crc32);
+            codec->data_crc32 = bra_crc32c(buf, s, codec->data_crc32);
 
             // write source chunk
             if (dst != NULL)
             {
-                if (!bra_io_file_write(dst, g_buf, s))
+                if (!bra_io_file_write(dst, buf, s))
                     goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
             }
         }
 
-        free(buf_huffman);
-        buf_huffman = NULL;
-
-        i += chunk_header.huffman.encoded_size + BRA_IO_CHUNK_HEADER_SIZE;
+        i += chunk_header.huffman.encoded_size + bra_io_file_chunks_header_size(&chunk_header);
     }
 
     // safety check
@@ -420,22 +954,252 @@ bool bra_io_file_chunks_decompress_file(bra_io_file_t* dst, bra_io_file_t* src,
         goto BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR;
     }
     me->_compression_ratio = (float) ((double) data_size / (double) file_orig_size);
-
-    // res = true;
-    goto _BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_FREE_BUFS;
+    return true;
 
 BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_ERR:
     if (dst != NULL)
         bra_io_file_close(dst);
 
     bra_io_file_close(src);
-    res = false;
+    return false;
+}
 
-_BRA_IO_FILE_DECOMPRESS_FILE_CHUNKS_FREE_BUFS:
-    if (buf_huffman != NULL)
-        free(buf_huffman);
-    if (buf_rle != NULL)
-        free(buf_rle);
+bool bra_io_file_chunks_decode_chunk(bra_codec_ctx_t* codec, bra_io_file_t* src, const bool fast, const uint8_t** out, uint32_t* out_size)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(out != NULL);
+    assert(out_size != NULL);
 
-    return res;
+    if (!bra_codec_ctx_reserve(codec))
+        return false;
+
+    bra_io_chunk_header_t chunk_header = {.primary_index = 0};
+    if (fast)
+    {
+        // the CRC32 of the chunk is not needed.
+        bra_meta_entry_t me = {.crc32 = BRA_CRC32C_INIT};
+        if (!bra_io_file_chunks_decompress_chunk_fast(codec, NULL, src, &me, true, &chunk_header))
+            goto BRA_IO_FILE_CHUNKS_DECODE_CHUNK_ERR;
+
+        *out      = codec->buf2;
+        *out_size = chunk_header.huffman.orig_size;
+        return true;
+    }
+
+    size_t s = 0;
+    if (!bra_io_file_chunks_read_chunk(codec, src, true, &chunk_header, &s))
+        goto BRA_IO_FILE_CHUNKS_DECODE_CHUNK_ERR;
+
+    *out      = codec->buf;
+    *out_size = (uint32_t) s;
+    return true;
+
+BRA_IO_FILE_CHUNKS_DECODE_CHUNK_ERR:
+    bra_io_file_close(src);
+    return false;
+}
+
+bool bra_io_file_chunks_write_solid_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_meta_entry_t* me)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(dst);
+    assert(me != NULL);
+    assert(BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID);
+
+    bra_meta_entry_file_t* mef = (bra_meta_entry_file_t*) me->entry_data;
+    assert(mef != NULL);
+    assert(codec->solid != NULL);
+    assert((uint64_t) mef->solid_offset + mef->solid_size <= codec->solid_size);
+
+    // the first file of the block carries the block.
+    bra_io_chunk_header_t chunk_header = {.primary_index = 0};
+    const uint8_t*        out          = NULL;
+    mef->data_size                     = 0;
+    if (mef->solid_offset == 0)
+    {
+        if (!bra_codec_ctx_reserve(codec))
+            goto BRA_IO_FILE_CHUNKS_WRITE_SOLID_FILE_ERR;
+
+        memcpy(codec->buf, codec->solid, codec->solid_size);
+        const bra_io_comp_level_t* level = &g_bra_io_comp_levels[_bra_min(codec->level, BRA_COMP_LEVEL_MAX)];
+        if (!bra_io_file_chunks_encode_chunk(codec, codec->solid_size, level, false, &chunk_header, &out))
+        {
+            bra_log_error("unable to compress solid block: %s", me->name);
+            goto BRA_IO_FILE_CHUNKS_WRITE_SOLID_FILE_ERR;
+        }
+
+        mef->data_size = bra_io_file_chunks_header_size(&chunk_header) + chunk_header.huffman.encoded_size;
+    }
+
+    _bra_compute_file_entry_crc32(me);
+    me->crc32 = bra_crc32c(&codec->solid[mef->solid_offset], mef->solid_size, me->crc32);
+    if (!bra_io_file_meta_entry_write_file_entry(dst, me))
+        goto BRA_IO_FILE_CHUNKS_WRITE_SOLID_FILE_ERR;
+
+    if (mef->data_size > 0)
+    {
+        if (!bra_io_file_chunks_write_header(dst, &chunk_header))
+            goto BRA_IO_FILE_CHUNKS_WRITE_SOLID_FILE_ERR;
+
+        if (!bra_io_file_write(dst, out, chunk_header.huffman.encoded_size))
+            goto BRA_IO_FILE_CHUNKS_WRITE_SOLID_FILE_ERR;
+    }
+
+    return true;
+
+BRA_IO_FILE_CHUNKS_WRITE_SOLID_FILE_ERR:
+    bra_io_file_close(dst);
+    return false;
+}
+
+bool bra_io_file_chunks_read_solid_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
+
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    assert(mef != NULL);
+
+    const int64_t data_offset = bra_io_file_tell(src);
+    if (data_offset < 0 || mef->_solid_block <= 0)
+        goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+
+    me->_compression_ratio = mef->solid_size == 0 ? 1.0f : (float) ((double) mef->data_size / (double) mef->solid_size);
+    if (!decode)
+    {
+        if (mef->data_size > 0 && !bra_io_file_skip_data(src, mef->data_size))
+            goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+
+        return true;
+    }
+
+    // decode the block once for all its files.
+    if (codec->solid_block != mef->_solid_block)
+    {
+        if (!bra_codec_ctx_reserve(codec) || !bra_codec_ctx_reserve_solid(codec))
+            goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+
+        if (data_offset != mef->_solid_block && !bra_io_file_seek(src, mef->_solid_block, SEEK_SET))
+            goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+
+        bra_io_chunk_header_t chunk_header = {.primary_index = 0};
+        size_t                s            = 0;
+        codec->solid_block                 = 0;
+        if (!bra_io_file_chunks_read_chunk(codec, src, true, &chunk_header, &s))
+            goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+
+        memcpy(codec->solid, codec->buf, s);
+        codec->solid_size  = (uint32_t) s;
+        codec->solid_block = mef->_solid_block;
+    }
+
+    if ((uint64_t) mef->solid_offset + mef->solid_size > codec->solid_size)
+    {
+        bra_log_error("corrupted solid file entry: %s", me->name);
+        goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+    }
+
+    // update CRC32
+    me->crc32 = bra_crc32c(&codec->solid[mef->solid_offset], mef->solid_size, me->crc32);
+
+    // write file contents
+    if (dst != NULL && mef->solid_size > 0)
+    {
+        if (!bra_io_file_write(dst, &codec->solid[mef->solid_offset], mef->solid_size))
+            goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+    }
+
+    if (bra_io_file_tell(src) != data_offset + (int64_t) mef->data_size && !bra_io_file_seek(src, data_offset + (int64_t) mef->data_size, SEEK_SET))
+        goto BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR;
+
+    return true;
+
+BRA_IO_FILE_CHUNKS_READ_SOLID_FILE_ERR:
+    if (dst != NULL)
+        bra_io_file_close(dst);
+
+    bra_io_file_close(src);
+    return false;
+}
+
+bool bra_io_file_chunks_read_ref_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(me != NULL);
+    assert(BRA_ATTR_IS_REF(me->attributes));
+
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    assert(mef != NULL);
+
+    me->_compression_ratio = 0.0f;
+    if (!decode)
+        return true;
+
+    bra_meta_entry_t orig = {0};
+    const int64_t    pos  = bra_io_file_tell(src);
+    if (pos < 0 || mef->_ref_entry <= 0 || !bra_io_file_seek(src, mef->_ref_entry, SEEK_SET))
+        goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_ERR;
+
+    // the first copy entry, its data follows.
+    if (!bra_io_file_meta_entry_read_common_header(src, &orig))
+        goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_DST_ERR;
+
+    if (BRA_ATTR_TYPE(orig.attributes) != BRA_ATTR_TYPE_FILE || BRA_ATTR_IS_REF(orig.attributes) || BRA_ATTR_COMP(orig.attributes) == BRA_ATTR_COMP_SOLID)
+    {
+        bra_log_error("first copy of %s not valid: %s", me->name, mef->ref_name);
+        goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_ERR;
+    }
+
+    if (!bra_io_file_meta_entry_read_file_entry(src, &orig))
+        goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_DST_ERR;
+
+    // the checksum of the duplicate is on the contents only.
+    bra_meta_entry_file_t* orig_mef  = (bra_meta_entry_file_t*) orig.entry_data;
+    const uint64_t         data_size = orig_mef->data_size;
+    uint32_t               crc32     = BRA_CRC32C_INIT;
+    orig.crc32                       = BRA_CRC32C_INIT;
+    if (BRA_ATTR_IS_CDC(orig.attributes))
+    {
+        // its block runs refer to its entry.
+        orig_mef->_cdc_entry = mef->_ref_entry;
+        if (!bra_io_file_cdc_read_file(codec, dst, src, &orig, true))
+            goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_CLOSED;
+        crc32 = codec->data_crc32;
+    }
+    else switch (BRA_ATTR_COMP(orig.attributes))
+    {
+    case BRA_ATTR_COMP_STORED:
+        if (!bra_io_file_chunks_copy_file(dst, src, data_size, &orig, true))
+            goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_CLOSED;
+        crc32 = orig.crc32;
+        break;
+    case BRA_ATTR_COMP_COMPRESSED:
+    case BRA_ATTR_COMP_FAST:
+        codec->data_crc32 = BRA_CRC32C_INIT;
+        if (!bra_io_file_chunks_decompress_file(codec, dst, src, data_size, &orig, true))
+            goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_CLOSED;
+        crc32 = codec->data_crc32;
+        break;
+    default:
+        goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_ERR;
+    }
+
+    me->crc32 = bra_crc32c_combine(me->crc32, crc32, mef->ref_size);
+    bra_meta_entry_free(&orig);
+    if (!bra_io_file_seek(src, pos, SEEK_SET))
+        goto BRA_IO_FILE_CHUNKS_READ_REF_FILE_ERR;
+
+    return true;
+
+BRA_IO_FILE_CHUNKS_READ_REF_FILE_ERR:
+    bra_io_file_close(src);
+BRA_IO_FILE_CHUNKS_READ_REF_FILE_DST_ERR:
+    if (dst != NULL)
+        bra_io_file_close(dst);
+BRA_IO_FILE_CHUNKS_READ_REF_FILE_CLOSED:
+    bra_meta_entry_free(&orig);
+    return false;
 }
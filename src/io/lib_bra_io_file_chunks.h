@@ -41,6 +41,7 @@ bool bra_io_file_chunks_write_header(bra_io_file_t* dst, const bra_io_chunk_head
  * entry. Used for processing large files efficiently while maintaining
  * data integrity verification.
  *
+ * @param codec codec work buffers, used for compressed data (must not be @c NULL)
  * @param src Source file wrapper positioned at start of data (must not be @c NULL)
  * @param data_size Total number of bytes to read
  * @param me Metadata entry to update with CRC32 (must not be @c NULL)
@@ -57,12 +58,12 @@ bool bra_io_file_chunks_write_header(bra_io_file_t* dst, const bra_io_chunk_head
  * @see bra_io_file_chunks_read_file_stored
  * @see bra_io_file_chunks_read_file_compressed
  */
-bool bra_io_file_chunks_read_file(bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode);
+bool bra_io_file_chunks_read_file(bra_codec_ctx_t* codec, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode);
 
 /**
  * @brief Copy data between files in chunks, optionally computing CRC32.
  *
- * Efficiently copies data from source to destination in #BRA_MAX_CHUNK_SIZE
+ * Efficiently copies data from source to destination in #BRA_CHUNK_SIZE
  * chunks. Both files must be positioned
  * at the correct read/write offsets before calling.
  *
@@ -77,7 +78,7 @@ bool bra_io_file_chunks_read_file(bra_io_file_t* src, const uint64_t data_size,
  *
  * @note Both files advance by @p data_size bytes on success.
  * @note On error, both files are automatically closed via @ref bra_io_file_close().
- * @note Memory usage is limited to #BRA_MAX_CHUNK_SIZE regardless of @p data_size.
+ * @note Memory usage is limited to #BRA_CHUNK_SIZE regardless of @p data_size.
  *
  * @see bra_io_file_chunks_read_file
  * @see bra_io_file_chunks_compress_file
@@ -91,6 +92,7 @@ bool bra_io_file_chunks_copy_file(bra_io_file_t* dst, bra_io_file_t* src, const
  * algorithm, and writes the compressed data to the destination file. Updates
  * metadata entry with compression information and CRC32 of original data.
  *
+ * @param codec codec work buffers, allocated on first use (must not be @c NULL)
  * @param dst Destination file for compressed data (must not be @c NULL)
  * @param src Source file for original data (must not be @c NULL)
  * @param data_size Size of original data to compress
@@ -101,11 +103,42 @@ bool bra_io_file_chunks_copy_file(bra_io_file_t* dst, bra_io_file_t* src, const
  * @note Both files must be positioned correctly before calling.
  * @note Compression ratio and method are stored in metadata entry.
  * @note CRC32 is calculated on original (uncompressed) data.
+ * @note Reentrant: concurrent calls must use different @p codec contexts.
  *
  * @see bra_io_file_chunks_decompress_file
  * @see bra_io_file_chunks_copy_file
  */
-bool bra_io_file_chunks_compress_file(bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me);
+bool bra_io_file_chunks_compress_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me);
+
+/**
+ * @brief Compress the file data without writing it, to know its size before writing the entry to a stream.
+ *
+ * @param codec codec work buffers, allocated on first use (must not be @c NULL)
+ * @param src Source file for original data, at its start (must not be @c NULL)
+ * @param data_size Size of original data to compress
+ * @param me Metadata entry, its compression type selects the engine (must not be @c NULL)
+ * @param out_size the size the data would have, chunk headers included.
+ * @retval true On success, @p src is back at its start.
+ * @retval false On error, @p src is closed.
+ *
+ * @see bra_io_file_chunks_compress_stream
+ */
+bool bra_io_file_chunks_compress_size(bra_codec_ctx_t* codec, bra_io_file_t* src, const uint64_t data_size, const bra_meta_entry_t* me, uint64_t* out_size);
+
+/**
+ * @brief Compress the file data straight to @p dst, without a temporary file.
+ *        Its size is already known from @ref bra_io_file_chunks_compress_size and smaller than @p data_size.
+ *
+ * @param codec codec work buffers, allocated on first use (must not be @c NULL)
+ * @param dst Destination file for compressed data, e.g. a stream (must not be @c NULL)
+ * @param src Source file for original data (must not be @c NULL)
+ * @param data_size Size of original data to compress
+ * @param comp_size Size of the compressed data
+ * @param me Metadata entry to update with compression info (must not be @c NULL)
+ * @retval true On successful compression and write
+ * @retval false On error, both files are closed.
+ */
+bool bra_io_file_chunks_compress_stream(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, const uint64_t comp_size, bra_meta_entry_t* me);
 
 /**
  * @brief Decompress file data in chunks.
@@ -114,6 +147,7 @@ bool bra_io_file_chunks_compress_file(bra_io_file_t* dst, bra_io_file_t* src, co
  * specified in the metadata entry, and writes the original data to the
  * destination file. Verifies data integrity using stored CRC32.
  *
+ * @param codec codec work buffers, allocated on first use (must not be @c NULL)
  * @param dst Destination file for decompressed data (if @c NULL will be in test mode with @p decode true)
  * @param src Source file containing compressed data (must not be @c NULL)
  * @param data_size Size of compressed data to read
@@ -125,8 +159,79 @@ bool bra_io_file_chunks_compress_file(bra_io_file_t* dst, bra_io_file_t* src, co
  * @note Both files must be positioned correctly before calling.
  * @note Decompression method is determined from metadata entry.
  * @note CRC32 verification ensures data integrity after decompression.
+ * @note Reentrant: concurrent calls must use different @p codec contexts.
  *
  * @see bra_io_file_chunks_compress_file
  * @see bra_io_file_chunks_copy_file
  */
-bool bra_io_file_chunks_decompress_file(bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode);
+bool bra_io_file_chunks_decompress_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, const uint64_t data_size, bra_meta_entry_t* me, const bool decode);
+
+/**
+ * @brief Read the chunk at the current position of @p src and decode it in the @p codec buffers.
+ *
+ * @param codec    codec work buffers, allocated on first use (must not be @c NULL)
+ * @param src      positioned at the chunk header (must not be @c NULL)
+ * @param fast     @c true for a #BRA_ATTR_COMP_FAST chunk, @c false for a #BRA_ATTR_COMP_COMPRESSED one.
+ * @param out      the decoded chunk, valid until the next use of @p codec.
+ * @param out_size bytes of @p out.
+ * @retval true On success, @p src is positioned after the chunk.
+ * @retval false On error, @p src is closed.
+ *
+ * @note Reentrant: concurrent calls must use different @p codec contexts.
+ */
+bool bra_io_file_chunks_decode_chunk(bra_codec_ctx_t* codec, bra_io_file_t* src, const bool fast, const uint8_t** out, uint32_t* out_size);
+
+/**
+ * @brief Write the file entry data of a #BRA_ATTR_COMP_SOLID file, its contents are in @c codec->solid.
+ *
+ * The first file of a solid block (@c solid_offset 0) compresses the whole block
+ * as a single chunk and writes it after its entry data, the next ones have no data.
+ * The CRC32 is calculated on the file contents only.
+ *
+ * @param codec codec with the solid block to encode (must not be @c NULL)
+ * @param dst Destination archive positioned after the common meta entry header (must not be @c NULL)
+ * @param me Metadata entry, @c solid_offset and @c solid_size set (must not be @c NULL)
+ * @retval true On success
+ * @retval false On compression error or write failure, @p dst is closed.
+ *
+ * @see bra_io_file_chunks_read_solid_file
+ */
+bool bra_io_file_chunks_write_solid_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_meta_entry_t* me);
+
+/**
+ * @brief Read the data of a #BRA_ATTR_COMP_SOLID file.
+ *
+ * The solid block at @c _solid_block is decoded once in @c codec->solid,
+ * then the following files of the same block are sliced from it.
+ *
+ * @param codec codec work buffers and solid block cache (must not be @c NULL)
+ * @param dst Destination file for the file contents (can be @c NULL)
+ * @param src Archive positioned at the file data (must not be @c NULL)
+ * @param me Metadata entry with its solid block located (must not be @c NULL)
+ * @param decode if @c true decode the file contents and compute the CRC32; if @c false only skip its data.
+ * @retval true On success, @p src is positioned after the file data.
+ * @retval false On decompression error or I/O failure, both files are closed.
+ *
+ * @note Reentrant: concurrent calls must use different @p codec contexts.
+ *
+ * @see bra_io_file_chunks_write_solid_file
+ */
+bool bra_io_file_chunks_read_solid_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode);
+
+/**
+ * @brief Read the contents of a #BRA_ATTR_REF file from the data of its first copy.
+ *
+ * The entry of the first copy at @c _ref_entry is read again and its data decoded,
+ * then @p src goes back after the duplicate entry, which has no data.
+ *
+ * @param codec codec work buffers (must not be @c NULL)
+ * @param dst Destination file for the file contents (can be @c NULL)
+ * @param src Archive positioned after the duplicate entry data (must not be @c NULL)
+ * @param me Metadata entry with its first copy located (must not be @c NULL)
+ * @param decode if @c true decode the file contents and compute the CRC32; if @c false nothing is read.
+ * @retval true On success
+ * @retval false On a first copy not valid, decompression error or I/O failure, both files are closed.
+ *
+ * @note Reentrant: concurrent calls must use different @p codec contexts.
+ */
+bool bra_io_file_chunks_read_ref_file(bra_codec_ctx_t* codec, bra_io_file_t* dst, bra_io_file_t* src, bra_meta_entry_t* me, const bool decode);
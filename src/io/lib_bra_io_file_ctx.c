@@ -1,5 +1,6 @@
 #include <io/lib_bra_io_file_ctx.h>
 #include <io/lib_bra_io_file.h>
+#include <io/lib_bra_io_file_cdc.h>
 #include <io/lib_bra_io_file_chunks.h>
 #include <io/lib_bra_io_file_meta_entries.h>
 
@@ -9,6 +10,7 @@
 #include <log/bra_log.h>
 #include <fs/bra_fs_c.h>
 #include <utils/bra_tree_dir.h>
+#include <encoders/bra_codec.h>
 
 #include <lib_bra.h>
 
@@ -21,54 +23,138 @@ static const char* g_attr_type_names[] = {"file", "dir", "symlink", "subdir"};
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief Ensure @p buf can hold at least @p size bytes.
+ *        It grows geometrically starting from #BRA_MAX_PATH_LENGTH, so steady state is allocation free.
+ *
+ * @param buf
+ * @param capacity
+ * @param size
+ * @retval true  On success.
+ * @retval false On allocation failure; @p buf is left untouched.
+ */
+static bool _bra_io_file_ctx_buf_reserve(char** buf, size_t* capacity, const size_t size)
+{
+    assert(buf != NULL);
+    assert(capacity != NULL);
+
+    if (size <= *capacity)
+        return true;
+
+    size_t new_capacity = *capacity < BRA_MAX_PATH_LENGTH ? BRA_MAX_PATH_LENGTH : *capacity;
+    while (new_capacity < size)
+        new_capacity *= 2;
+
+    char* b = (char*) realloc(*buf, new_capacity * sizeof(char));
+    if (b == NULL)
+    {
+        bra_log_error("unable to allocate path buffer of %zu bytes", new_capacity);
+        return false;
+    }
+
+    *buf      = b;
+    *capacity = new_capacity;
+    return true;
+}
+
+/**
+ * @brief Set @p node as last dir and update the cached @c ctx->last_dir path incrementally.
+ *
+ * The cached path is popped back to the parent of @p node when it is an ancestor of the
+ * previous last dir (always the case for archives written in tree order), then the new dirname is appended.
+ * Otherwise the path is fully reconstructed from the tree.
+ *
+ * @param ctx
+ * @param node
+ * @retval true  On success.
+ * @retval false On error.
+ */
+static bool _bra_io_file_ctx_set_last_dir_node(bra_io_file_ctx_t* ctx, bra_tree_node_t* node)
+{
+    assert(ctx != NULL);
+    assert(node != NULL && node->parent != NULL);
+    assert(ctx->last_dir_node != NULL);
+
+    const bra_tree_node_t* n   = ctx->last_dir_node;
+    size_t                 len = ctx->last_dir_size;
+    while (n != node->parent && n->index != BRA_TREE_NODE_ROOT_INDEX)
+    {
+        const size_t dl = strlen(n->dirname) + (n->parent->index != BRA_TREE_NODE_ROOT_INDEX ? 1 : 0);    // +1 for '/'
+        assert(len >= dl);
+        len -= dl;
+        n    = n->parent;
+    }
+
+    if (n != node->parent)
+    {
+        char* path = bra_tree_dir_reconstruct_path(node);
+        if (path == NULL)
+            return false;
+
+        free(ctx->last_dir);
+        ctx->last_dir_size     = strlen(path);
+        ctx->last_dir_capacity = ctx->last_dir_size + 1;
+        ctx->last_dir          = path;
+        ctx->last_dir_node     = node;
+        return true;
+    }
+
+    const size_t dirname_len = strlen(node->dirname);
+    if (!_bra_io_file_ctx_buf_reserve(&ctx->last_dir, &ctx->last_dir_capacity, len + 1 + dirname_len + 1))    // '/' and '\0'
+        return false;
+
+    if (len > 0)
+        ctx->last_dir[len++] = BRA_DIR_DELIM[0];
+
+    memcpy(&ctx->last_dir[len], node->dirname, dirname_len);
+    len                += dirname_len;
+    ctx->last_dir[len]  = '\0';
+    ctx->last_dir_size  = len;
+    ctx->last_dir_node  = node;
+    return true;
+}
+
 /**
  * @brief Reconstructs the full path of a meta entry.
  *
+ * @note The returned string is owned by @p ctx and valid until the next meta entry is read.
+ *
  * @param ctx The file context.
  * @param me  The meta entry.
  * @param len The length of the reconstructed path.
- * @return char* The reconstructed path or NULL on failure.
+ * @return const char* The reconstructed path or NULL on failure.
  */
-static char* _bra_io_file_ctx_reconstruct_meta_entry_name(bra_io_file_ctx_t* ctx, bra_meta_entry_t* me, size_t* len)
+static const char* _bra_io_file_ctx_reconstruct_meta_entry_name(bra_io_file_ctx_t* ctx, bra_meta_entry_t* me, size_t* len)
 {
     assert_bra_io_file_cxt_t(ctx);
     assert(me != NULL);
+    assert(ctx->last_dir != NULL);
 
-    char* dirname = bra_tree_dir_reconstruct_path(ctx->last_dir_node);
-    if (dirname == NULL)
-        return NULL;
-
-    const size_t dirname_len = strlen(dirname);
-    char*        fn          = NULL;
+    const size_t dirname_len = ctx->last_dir_size;
 
     switch (BRA_ATTR_TYPE(me->attributes))
     {
     case BRA_ATTR_TYPE_FILE:
     {
+        // +1 for '/' and +1 for '\0'
+        if (!_bra_io_file_ctx_buf_reserve(&ctx->entry_name, &ctx->entry_name_capacity, dirname_len + 1 + me->name_size + 1))
+            return NULL;
+
+        char*  fn  = ctx->entry_name;
+        size_t pos = 0;
         if (dirname_len > 0)
         {
-            fn = malloc((dirname_len + 1 + me->name_size + 1) * sizeof(char));    // +1 for '/' and +1 for '\0'
-            if (fn == NULL)
-                goto _BRA_IO_FILE_CTX_RECONSTRUCT_META_ENTRY_NAME_EXIT;
-
-            memcpy(fn, dirname, dirname_len);
+            memcpy(fn, ctx->last_dir, dirname_len);
             fn[dirname_len] = BRA_DIR_DELIM[0];
-            memcpy(&fn[dirname_len + 1], me->name, me->name_size);
-            fn[dirname_len + 1 + me->name_size] = '\0';
-            if (len != NULL)
-                *len = dirname_len + me->name_size + 1;
-        }
-        else
-        {
-            fn = _bra_strdup(me->name);
-            if (fn == NULL)
-                goto _BRA_IO_FILE_CTX_RECONSTRUCT_META_ENTRY_NAME_EXIT;
-            if (len != NULL)
-                *len = me->name_size;
+            pos             = dirname_len + 1;
         }
 
-    _BRA_IO_FILE_CTX_RECONSTRUCT_META_ENTRY_NAME_EXIT:
-        free(dirname);
+        memcpy(&fn[pos], me->name, me->name_size);
+        pos     += me->name_size;
+        fn[pos]  = '\0';
+        if (len != NULL)
+            *len = pos;
+
         return fn;
     }
     break;
@@ -79,7 +165,7 @@ static char* _bra_io_file_ctx_reconstruct_meta_entry_name(bra_io_file_ctx_t* ctx
         if (len != NULL)
             *len = dirname_len;
 
-        return dirname;
+        return ctx->last_dir;
     }
     break;
     }
@@ -95,11 +181,12 @@ static char* _bra_io_file_ctx_reconstruct_meta_entry_name(bra_io_file_ctx_t* ctx
  * @param ctx        Archive file context
  * @param attributes File attributes
  * @param filename   File name (full path)
+ * @param data_size  File size in bytes
  * @param me         Provided by caller; this function initializes/populates it.
  * @retval true      On success.
  * @retval false     On error.
  */
-static bool _bra_io_file_ctx_write_meta_entry_file(bra_io_file_ctx_t* ctx, const bra_attr_t attributes, const char* filename, bra_meta_entry_t* me)
+static bool _bra_io_file_ctx_write_meta_entry_file(bra_io_file_ctx_t* ctx, const bra_attr_t attributes, const char* filename, const uint64_t data_size, bra_meta_entry_t* me)
 {
     assert_bra_io_file_cxt_t(ctx);
     assert(filename != NULL);
@@ -144,16 +231,60 @@ static bool _bra_io_file_ctx_write_meta_entry_file(bra_io_file_ctx_t* ctx, const
     if (!bra_meta_entry_init(me, attributes, &filename[l], (uint8_t) (filename_len - l)))
         return false;
 
-    uint64_t ds;
-    if (!bra_fs_file_size(filename, &ds))
+    if (!bra_meta_entry_file_set(me, data_size))
         return false;
 
-    if (!bra_meta_entry_file_set(me, ds))
-        return false;
+    bra_meta_entry_file_t* mef   = (bra_meta_entry_file_t*) me->entry_data;
+    const bool             solid = BRA_ATTR_COMP(attributes) == BRA_ATTR_COMP_SOLID;
+    const bool             ref   = BRA_ATTR_IS_REF(attributes);
+    if (solid)
+    {
+        mef->solid_offset = ctx->solid_pos;
+        mef->solid_size   = (uint32_t) data_size;
+    }
+    else if (ref)
+    {
+        const size_t  ref_len = strlen(ctx->ref_fn);
+        const int64_t me_pos  = bra_io_file_tell(&ctx->f);
+        if (ref_len == 0 || ref_len > UINT8_MAX || me_pos <= ctx->ref_entry)
+        {
+            bra_log_critical("first copy %s of %s not valid", ctx->ref_fn, filename);
+            return false;
+        }
 
-    if (!bra_io_file_meta_entry_flush_entry_file(&ctx->f, me, filename, filename_len))
+        mef->data_size     = 0;
+        mef->ref_offset    = (uint64_t) (me_pos - ctx->ref_entry);
+        mef->ref_size      = data_size;
+        mef->ref_name_size = (uint8_t) ref_len;
+        mef->ref_name      = _bra_strdup(ctx->ref_fn);
+        if (mef->ref_name == NULL)
+            return false;
+    }
+
+    // the blocks already archived are referred, only the new ones are in the data.
+    uint32_t cdc_crc32 = BRA_CRC32C_INIT;
+    if (ctx->cdc != NULL && !solid && !ref && data_size > 0)
+    {
+        const int64_t me_pos = bra_io_file_tell(&ctx->f);
+        if (me_pos <= 0 || !bra_io_file_cdc_plan(ctx->cdc, filename, me_pos, me, &cdc_crc32))
+            return false;
+    }
+
+    if (!bra_io_file_meta_entry_flush_entry_file(&ctx->f, me, filename, filename_len, &ctx->codec))
         return false;
 
+    // the contents are not read again.
+    if (ref)
+        me->crc32 = bra_crc32c_combine(me->crc32, ctx->ref_crc32, data_size);
+    else if (BRA_ATTR_IS_CDC(me->attributes))
+        me->crc32 = bra_crc32c_combine(me->crc32, cdc_crc32, data_size);
+
+    if (solid)
+    {
+        ctx->solid_pos += (uint32_t) data_size;
+        --ctx->solid_files;
+    }
+
     return true;
 }
 
@@ -180,8 +311,11 @@ static bool _bra_io_file_ctx_write_meta_entry_dir_subdir(bra_io_file_ctx_t* ctx,
         return false;
 
     // Dir & subdirs are always only stored
-    attributes            = BRA_ATTR_SET_COMP(attributes, BRA_ATTR_COMP_STORED);
-    bra_tree_node_t* node = bra_tree_dir_add(ctx->tree, dirname);
+    attributes = BRA_ATTR_SET_COMP(attributes, BRA_ATTR_COMP_STORED);
+    // a directory already in the tree is written again to switch back to it, when appending.
+    bra_tree_node_t* node = bra_tree_dir_find(ctx->tree, dirname);
+    if (node == NULL || node->index == BRA_TREE_NODE_ROOT_INDEX)
+        node = bra_tree_dir_add(ctx->tree, dirname);
     if (node == NULL)
     {
         bra_log_error("unable to add dir %s to bra_tree", dirname);
@@ -217,18 +351,13 @@ static bool _bra_io_file_ctx_write_meta_entry_dir_subdir(bra_io_file_ctx_t* ctx,
         me->crc32                          = bra_crc32c(&mes->parent_index, sizeof(uint32_t), me->crc32);
     }
 
-    ctx->last_dir_node = node;
-    if (ctx->last_dir != NULL)
-    {
-        free(ctx->last_dir);
-        ctx->last_dir = NULL;
-    }
-
-    ctx->last_dir = _bra_strdup(dirname);
-    if (ctx->last_dir == NULL)
+    const size_t dirname_len = strlen(dirname);
+    if (!_bra_io_file_ctx_buf_reserve(&ctx->last_dir, &ctx->last_dir_capacity, dirname_len + 1))
         return false;
 
-    ctx->last_dir_size = strlen(ctx->last_dir);
+    memcpy(ctx->last_dir, dirname, dirname_len + 1);
+    ctx->last_dir_size = dirname_len;
+    ctx->last_dir_node = node;
     switch (BRA_ATTR_TYPE(me->attributes))
     {
     case BRA_ATTR_TYPE_DIR:
@@ -247,6 +376,254 @@ static bool _bra_io_file_ctx_write_meta_entry_dir_subdir(bra_io_file_ctx_t* ctx,
     return true;
 }
 
+/**
+ * @brief Print the first columns of a listing row: attributes, size and filename.
+ *
+ * @param me
+ * @param fn  full path of the entry.
+ * @param len length of @p fn.
+ */
+static void _bra_io_file_ctx_print_entry_head(const bra_meta_entry_t* me, const char* fn, const size_t len)
+{
+    assert(me != NULL);
+    assert(fn != NULL);
+
+    char           bytes[BRA_PRINTF_FMT_BYTES_BUF_SIZE];
+    const uint64_t ds        = BRA_ATTR_TYPE(me->attributes) == BRA_ATTR_TYPE_FILE ? ((const bra_meta_entry_file_t*) me->entry_data)->data_size : 0;
+    const char     attr_type = bra_format_meta_attribute_types(me->attributes);
+    const char     attr_comp = bra_format_meta_attribute_compression(me->attributes);
+
+    bra_format_bytes(ds, bytes);
+    bra_log_printf("| %c|%c  | %s | ", attr_type, attr_comp, bytes);
+    _bra_print_string_max_length(fn, (int) len, BRA_PRINTF_FMT_FILENAME_MAX_LENGTH);
+}
+
+/**
+ * @brief Print the last columns of a listing row: compression ratio and CRC32.
+ *
+ * @param me
+ * @param crc32 the CRC32 stored in the archive.
+ */
+static void _bra_io_file_ctx_print_entry_tail(const bra_meta_entry_t* me, const uint32_t crc32)
+{
+    assert(me != NULL);
+
+    if (me->_compression_ratio >= 1.0f)
+        bra_log_printf("| 100 %% ");
+    else
+        bra_log_printf("| %4.1f%% ", me->_compression_ratio * 100.0);
+    bra_log_printf("|%08X|\n", crc32);
+}
+
+/**
+ * @brief Original size of the file entry @p me, once its data has been read.
+ *
+ * @param me
+ * @return uint64_t
+ */
+static uint64_t _bra_io_file_ctx_entry_orig_size(const bra_meta_entry_t* me)
+{
+    assert(me != NULL);
+
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    assert(mef != NULL);
+
+    // most of the solid files have no data, the duplicates neither.
+    if (BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID)
+        return mef->solid_size;
+
+    if (BRA_ATTR_IS_REF(me->attributes))
+        return mef->ref_size;
+
+    if (BRA_ATTR_IS_CDC(me->attributes))
+        return mef->cdc_size;
+
+    return (uint64_t) (mef->data_size / me->_compression_ratio);
+}
+
+/**
+ * @brief Extract the duplicate file of @p job into @p f2 from its first copy, when already extracted with the same contents:
+ *        reflinked if possible, copied otherwise. If not, it is decoded from the archive.
+ *
+ * @param codec
+ * @param src   archive positioned after the duplicate entry, where its CRC32 is.
+ * @param job
+ * @param f2    the file to extract, just opened.
+ * @retval true  On success, @p src is positioned at the CRC32.
+ * @retval false On error.
+ */
+static bool _bra_io_file_ctx_job_run_ref(bra_codec_ctx_t* codec, bra_io_file_t* src, bra_io_file_entry_job_t* job, bra_io_file_t* f2)
+{
+    bra_meta_entry_t*            me    = &job->me;
+    const bra_meta_entry_file_t* mef   = (const bra_meta_entry_file_t*) me->entry_data;
+    const uint32_t               crc32 = me->crc32;
+    uint32_t                     read_crc32;
+    uint64_t                     size;
+
+    // no data, the CRC32 follows.
+    if (!bra_io_file_read(src, &read_crc32, sizeof(uint32_t)) || !bra_io_file_seek(src, job->data_offset, SEEK_SET))
+        return false;
+
+    if (_bra_validate_filename(mef->ref_name, mef->ref_name_size) && bra_fs_file_exists(mef->ref_name) && bra_fs_file_size(mef->ref_name, &size) && size == mef->ref_size)
+    {
+        bra_io_file_t f3 = {.f = NULL, .fn = NULL};
+        if (bra_io_file_open(&f3, mef->ref_name, "rb"))
+        {
+            // with a reflink only the CRC32 is computed.
+            const bool cloned = bra_io_file_clone(f2, &f3);
+            const bool res    = bra_io_file_chunks_copy_file(cloned ? NULL : f2, &f3, mef->ref_size, me, true);
+            bra_io_file_close(&f3);
+            if (res && me->crc32 == read_crc32)
+                return true;
+        }
+    }
+
+    // the first copy has been skipped or changed.
+    me->crc32 = crc32;
+    bra_io_file_close(f2);
+    if (!bra_io_file_open(f2, job->fn, "wb"))
+        return false;
+
+    return bra_io_file_chunks_read_ref_file(codec, f2, src, me, true);
+}
+
+/**
+ * @brief Read the current pointed entry. Directories are created and verified,
+ *        a file to extract is located into @p job.
+ *
+ * @param ctx
+ * @param overwrite_policy
+ * @param job             initialized by this function, @c job->fn is @c NULL when there is nothing to extract.
+ * @param skip_file_data  if true the stream is moved to the next entry,
+ *                        otherwise it is left at the beginning of the file data.
+ * @retval true  On success.
+ * @retval false On error, @p ctx->f is closed and @p job freed.
+ */
+static bool _bra_io_file_ctx_read_entry(bra_io_file_ctx_t* ctx, bra_fs_overwrite_policy_e* overwrite_policy, bra_io_file_entry_job_t* job, const bool skip_file_data)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(overwrite_policy != NULL);
+    assert(job != NULL);
+
+    const char*       end_msg;    // 'OK  ' | 'SKIP'
+    const char*       fn = NULL;
+    bra_meta_entry_t* me = &job->me;
+
+    memset(job, 0, sizeof(bra_io_file_entry_job_t));
+    if (!bra_io_file_ctx_read_meta_entry(ctx, me))
+        goto BRA_IO_READ_ENTRY_ERR;
+
+    // the full path name
+    size_t fn_len = 0;
+    fn            = _bra_io_file_ctx_reconstruct_meta_entry_name(ctx, me, &fn_len);
+    if (fn == NULL)
+        goto BRA_IO_READ_ENTRY_ERR;
+
+    if (!_bra_validate_filename(fn, fn_len))
+        goto BRA_IO_READ_ENTRY_ERR;
+
+    if (!_bra_compute_header_crc32(fn_len, fn, me))
+        goto BRA_IO_READ_ENTRY_ERR;
+
+    // NOTE: nothing to extract for a directory, but only to create it
+    switch (BRA_ATTR_TYPE(me->attributes))
+    {
+    case BRA_ATTR_TYPE_FILE:
+    {
+        const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+        assert(mef != NULL);
+        uint64_t ds = mef->data_size;
+        if (!bra_fs_file_exists_ask_overwrite(fn, overwrite_policy, false))
+        {
+            bra_log_printf("Skipping file:   " BRA_PRINTF_FMT_FILENAME " [  %-4.4s  ]\n", fn, g_end_messages[1]);
+
+            // NOTE: a stream can't go back to a solid block for its next files:
+            //       the block is decoded anyway and kept in the codec.
+            if (ctx->f.stream && BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID && ds > 0)
+            {
+                if (!bra_io_file_chunks_read_solid_file(&ctx->codec, NULL, &ctx->f, me, true))
+                    goto BRA_IO_READ_ENTRY_ERR;
+
+                ds = 0;
+            }
+
+            // skip file contents & crc32 too
+            // NOTE: the sizeof(uint32_t) is for the CRC32
+            if (!bra_io_file_skip_data(&ctx->f, ds + sizeof(uint32_t)))
+                goto BRA_IO_READ_ENTRY_ERR;
+
+            bra_meta_entry_free(me);
+            return true;
+        }
+
+        _bra_compute_file_entry_crc32(me);
+        job->data_offset = bra_io_file_tell(&ctx->f);
+        job->fn          = _bra_strdup(fn);
+        if (job->data_offset < 0 || job->fn == NULL)
+            goto BRA_IO_READ_ENTRY_ERR;
+
+        // the data and the CRC32 are read by the job
+        if (skip_file_data && !bra_io_file_skip_data(&ctx->f, ds + sizeof(uint32_t)))
+            goto BRA_IO_READ_ENTRY_ERR;
+
+        return true;
+    }
+    break;
+    case BRA_ATTR_TYPE_SUBDIR:
+    {
+        const bra_meta_entry_subdir_t* mes = me->entry_data;
+        me->crc32                          = bra_crc32c(&mes->parent_index, sizeof(uint32_t), me->crc32);
+    }
+        BRA_FALLTHROUGH;
+    // [[fallthrough]];
+    case BRA_ATTR_TYPE_DIR:
+    {
+        if (bra_fs_dir_exists(fn))
+        {
+            end_msg = g_end_messages[1];
+            bra_log_printf("Dir exists:    : " BRA_PRINTF_FMT_FILENAME, fn);
+        }
+        else
+        {
+            end_msg = g_end_messages[0];
+            bra_log_printf("Creating dir   : " BRA_PRINTF_FMT_FILENAME, fn);
+
+            if (!bra_fs_dir_make(fn))
+                goto BRA_IO_READ_ENTRY_ERR;
+        }
+    }
+    break;
+    case BRA_ATTR_TYPE_SYM:
+        bra_log_critical("SYMLINK NOT IMPLEMENTED YET");
+        // fallthrough
+        BRA_FALLTHROUGH;
+    default:
+        goto BRA_IO_READ_ENTRY_ERR;
+        break;
+    }
+
+    // read CRC32
+    uint32_t read_crc32;
+    if (!bra_io_file_read(&ctx->f, &read_crc32, sizeof(uint32_t)))
+        goto BRA_IO_READ_ENTRY_ERR;
+
+    // compare CRC32
+    if (read_crc32 != me->crc32)
+    {
+        bra_log_critical("%s checksum failed!!!", fn);
+        goto BRA_IO_READ_ENTRY_ERR;
+    }
+
+    bra_meta_entry_free(me);
+    bra_log_printf(" [  %-4.4s  ]\n", end_msg);
+    return true;
+
+BRA_IO_READ_ENTRY_ERR:
+    bra_io_file_entry_job_free(job);
+    bra_io_file_error(&ctx->f, "decode");
+    return false;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool bra_io_file_ctx_open(bra_io_file_ctx_t* ctx, const char* fn, const char* mode)
@@ -259,11 +636,13 @@ bool bra_io_file_ctx_open(bra_io_file_ctx_t* ctx, const char* fn, const char* mo
     ctx->tree = bra_tree_dir_create();
     if (ctx->tree == NULL)
         return false;
-    ctx->last_dir = _bra_strdup("");
-    if (ctx->last_dir == NULL)
+    if (!_bra_io_file_ctx_buf_reserve(&ctx->last_dir, &ctx->last_dir_capacity, BRA_MAX_PATH_LENGTH))
+        goto BRA_IO_FILE_CTX_OPEN_ERR;
+    ctx->last_dir[0] = '\0';
+    if (!_bra_io_file_ctx_buf_reserve(&ctx->entry_name, &ctx->entry_name_capacity, BRA_MAX_PATH_LENGTH))
         goto BRA_IO_FILE_CTX_OPEN_ERR;
 
-    const bool res = bra_io_file_open(&ctx->f, fn, mode);
+    const bool res = strcmp(fn, BRA_STDIO_FILENAME) == 0 ? bra_io_file_stdio_open(&ctx->f, mode[0] != 'r') : bra_io_file_open(&ctx->f, fn, mode);
     if (!res)
         goto BRA_IO_FILE_CTX_OPEN_ERR;
     else
@@ -282,6 +661,13 @@ BRA_IO_FILE_CTX_OPEN_ERR:
         free(ctx->last_dir);
         ctx->last_dir = NULL;
     }
+    if (ctx->entry_name != NULL)
+    {
+        free(ctx->entry_name);
+        ctx->entry_name = NULL;
+    }
+    ctx->last_dir_capacity   = 0;
+    ctx->entry_name_capacity = 0;
 
     return false;
 }
@@ -336,7 +722,23 @@ bool bra_io_file_ctx_close(bra_io_file_ctx_t* ctx)
         free(ctx->last_dir);
         ctx->last_dir = NULL;
     }
+    if (ctx->entry_name != NULL)
+    {
+        free(ctx->entry_name);
+        ctx->entry_name = NULL;
+    }
+    ctx->last_dir_capacity   = 0;
+    ctx->entry_name_capacity = 0;
+
+    // a stream isn't closed: its last data is only flushed, failing when the reader has gone.
+    if (ctx->f.f != NULL && ctx->f.stream && fflush(ctx->f.f) != 0)
+    {
+        bra_io_file_write_error(&ctx->f);
+        res = false;
+    }
 
+    bra_io_file_cdc_table_destroy(&ctx->cdc);
+    bra_codec_ctx_free(&ctx->codec);
     bra_io_file_close(&ctx->f);
     return res;
 }
@@ -378,13 +780,24 @@ bool bra_io_file_ctx_write_header(bra_io_file_ctx_t* ctx, const uint32_t num_fil
     return true;
 }
 
-bool bra_io_file_ctx_sfx_open_and_read_footer_header(const char* fn, bra_io_header_t* out_bh, bra_io_file_ctx_t* ctx)
+/**
+ * @brief Open @p fn in @p mode, read the SFX footer to obtain the header offset, seek to it, and read the header.
+ *
+ * @param fn
+ * @param mode @c fopen modes
+ * @param out_bh
+ * @param ctx[out]
+ * @retval true on success (file positioned immediately after the header, at first entry)
+ * @retval false on error (errors during read/seek close @p ctx->f via @ref bra_io_file_close)
+ */
+static bool _bra_io_file_ctx_sfx_open_and_read_footer_header(const char* fn, const char* mode, bra_io_header_t* out_bh, bra_io_file_ctx_t* ctx)
 {
     assert(fn != NULL);
+    assert(mode != NULL);
     assert(out_bh != NULL);
     assert(ctx != NULL);
 
-    if (!bra_io_file_ctx_sfx_open(ctx, fn, "rb"))
+    if (!bra_io_file_ctx_sfx_open(ctx, fn, mode))
         return false;
 
     bra_io_footer_t bf;
@@ -420,11 +833,99 @@ bool bra_io_file_ctx_sfx_open_and_read_footer_header(const char* fn, bra_io_head
     return true;
 }
 
+bool bra_io_file_ctx_sfx_open_and_read_footer_header(const char* fn, bra_io_header_t* out_bh, bra_io_file_ctx_t* ctx)
+{
+    return _bra_io_file_ctx_sfx_open_and_read_footer_header(fn, "rb", out_bh, ctx);
+}
+
+bool bra_io_file_ctx_append_open(bra_io_file_ctx_t* ctx, const char* fn, const bool sfx, bra_io_header_t* out_bh, int64_t* out_header_offset)
+{
+    assert(ctx != NULL);
+    assert(fn != NULL);
+    assert(out_bh != NULL);
+    assert(out_header_offset != NULL);
+
+    if (sfx)
+    {
+        if (!_bra_io_file_ctx_sfx_open_and_read_footer_header(fn, "rb+", out_bh, ctx))
+            return false;
+    }
+    else
+    {
+        if (!bra_io_file_ctx_open(ctx, fn, "rb+"))
+            return false;
+
+        if (!bra_io_file_ctx_read_header(ctx, out_bh))
+            return false;
+    }
+
+    *out_header_offset = bra_io_file_tell(&ctx->f) - (int64_t) sizeof(bra_io_header_t);
+    if (*out_header_offset < 0)
+    {
+        bra_io_file_seek_error(&ctx->f);
+        return false;
+    }
+
+    return true;
+}
+
+bool bra_io_file_ctx_skip_entry(bra_io_file_ctx_t* ctx, const char** out_fn)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(out_fn != NULL);
+
+    bra_meta_entry_t me = {0};
+    uint64_t         ds = 0;
+
+    if (!bra_io_file_ctx_read_meta_entry(ctx, &me))
+        goto BRA_IO_FILE_CTX_SKIP_ENTRY_ERR;
+
+    *out_fn = _bra_io_file_ctx_reconstruct_meta_entry_name(ctx, &me, NULL);
+    if (*out_fn == NULL)
+        goto BRA_IO_FILE_CTX_SKIP_ENTRY_ERR;
+
+    if (BRA_ATTR_TYPE(me.attributes) == BRA_ATTR_TYPE_FILE)
+        ds = ((const bra_meta_entry_file_t*) me.entry_data)->data_size;
+
+    // the data and the CRC32 are not read: only the entry headers are.
+    if (!bra_io_file_skip_data(&ctx->f, ds + sizeof(uint32_t)))
+        goto BRA_IO_FILE_CTX_SKIP_ENTRY_ERR;
+
+    bra_meta_entry_free(&me);
+    return true;
+
+BRA_IO_FILE_CTX_SKIP_ENTRY_ERR:
+    bra_meta_entry_free(&me);
+    bra_io_file_error(&ctx->f, "skip");
+    return false;
+}
+
+bool bra_io_file_ctx_update_header(bra_io_file_ctx_t* ctx, const int64_t header_offset, const uint32_t num_files)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(header_offset >= 0);
+
+    if (!bra_io_file_seek(&ctx->f, header_offset, SEEK_SET))
+    {
+        bra_io_file_seek_error(&ctx->f);
+        return false;
+    }
+
+    return bra_io_file_ctx_write_header(ctx, num_files);
+}
+
 bool bra_io_file_ctx_read_meta_entry(bra_io_file_ctx_t* ctx, bra_meta_entry_t* me)
 {
     assert_bra_io_file_cxt_t(ctx);
     assert(me != NULL);
 
+    const int64_t me_pos = bra_io_file_tell(&ctx->f);
+    if (me_pos < 0)
+    {
+        bra_io_file_seek_error(&ctx->f);
+        return false;
+    }
+
     if (!bra_io_file_meta_entry_read_common_header(&ctx->f, me))
         return false;
 
@@ -438,8 +939,8 @@ bool bra_io_file_ctx_read_meta_entry(bra_io_file_ctx_t* ctx, bra_meta_entry_t* m
         if (!bra_io_file_meta_entry_read_subdir_entry(&ctx->f, me))
             return false;
 
-        ctx->last_dir_node = bra_tree_dir_insert_at_parent(ctx->tree, ((bra_meta_entry_subdir_t*) me->entry_data)->parent_index, me->name);
-        if (ctx->last_dir_node == NULL)
+        bra_tree_node_t* node = bra_tree_dir_insert_at_parent(ctx->tree, ((bra_meta_entry_subdir_t*) me->entry_data)->parent_index, me->name);
+        if (node == NULL || !_bra_io_file_ctx_set_last_dir_node(ctx, node))
         {
         BRA_IO_READ_ERR:
             bra_io_file_close(&ctx->f);
@@ -450,8 +951,8 @@ bool bra_io_file_ctx_read_meta_entry(bra_io_file_ctx_t* ctx, bra_meta_entry_t* m
     case BRA_ATTR_TYPE_DIR:
     {
         // nothing extra to save except the common entry data.
-        ctx->last_dir_node = bra_tree_dir_insert_at_parent(ctx->tree, BRA_TREE_NODE_ROOT_INDEX, me->name);
-        if (ctx->last_dir_node == NULL)
+        bra_tree_node_t* node = bra_tree_dir_insert_at_parent(ctx->tree, BRA_TREE_NODE_ROOT_INDEX, me->name);
+        if (node == NULL || !_bra_io_file_ctx_set_last_dir_node(ctx, node))
             goto BRA_IO_READ_ERR;
     }
     break;
@@ -461,6 +962,54 @@ bool bra_io_file_ctx_read_meta_entry(bra_io_file_ctx_t* ctx, bra_meta_entry_t* m
 
         if (!bra_io_file_meta_entry_read_file_entry(&ctx->f, me))
             return false;
+
+        // the first file of a solid block has the block data, the next ones refer to it.
+        if (BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID)
+        {
+            bra_meta_entry_file_t* mef = (bra_meta_entry_file_t*) me->entry_data;
+            if (mef->solid_offset == 0)
+            {
+                ctx->solid_block = bra_io_file_tell(&ctx->f);
+                if (ctx->solid_block < 0)
+                    goto BRA_IO_READ_ERR;
+            }
+            else if (ctx->solid_block == 0)
+            {
+                bra_log_error("solid file entry without its block: %s", me->name);
+                goto BRA_IO_READ_ERR;
+            }
+
+            mef->_solid_block = ctx->solid_block;
+        }
+
+        // a duplicate refers to a previous entry.
+        if (BRA_ATTR_IS_REF(me->attributes))
+        {
+            bra_meta_entry_file_t* mef = (bra_meta_entry_file_t*) me->entry_data;
+            if (mef->ref_offset == 0 || mef->ref_offset > (uint64_t) me_pos)
+            {
+                bra_log_error("duplicate file entry with its first copy not valid: %s", me->name);
+                goto BRA_IO_READ_ERR;
+            }
+
+            mef->_ref_entry = me_pos - (int64_t) mef->ref_offset;
+        }
+
+        // its blocks refer to the previous entries, to itself or to the base archive.
+        if (BRA_ATTR_IS_CDC(me->attributes))
+        {
+            bra_meta_entry_file_t* mef = (bra_meta_entry_file_t*) me->entry_data;
+            for (uint32_t i = 0; i < mef->cdc_num_runs; ++i)
+            {
+                if (mef->cdc_runs[i].ref == BRA_CDC_RUN_REF && mef->cdc_runs[i].offset >= (uint64_t) me_pos)
+                {
+                    bra_log_error("file entry with its blocks not valid: %s", me->name);
+                    goto BRA_IO_READ_ERR;
+                }
+            }
+
+            mef->_cdc_entry = me_pos;
+        }
     }
     break;
     case BRA_ATTR_TYPE_SYM:
@@ -474,7 +1023,7 @@ bool bra_io_file_ctx_read_meta_entry(bra_io_file_ctx_t* ctx, bra_meta_entry_t* m
     return true;
 }
 
-bool bra_io_file_ctx_write_meta_entry(bra_io_file_ctx_t* ctx, const bra_attr_t attributes, const char* fn)
+bool bra_io_file_ctx_write_meta_entry(bra_io_file_ctx_t* ctx, const bra_attr_t attributes, const char* fn, const uint64_t data_size)
 {
     assert_bra_io_file_cxt_t(ctx);
 
@@ -485,7 +1034,7 @@ bool bra_io_file_ctx_write_meta_entry(bra_io_file_ctx_t* ctx, const bra_attr_t a
     {
     case BRA_ATTR_TYPE_FILE:
     {
-        if (!_bra_io_file_ctx_write_meta_entry_file(ctx, attributes, fn, &me))
+        if (!_bra_io_file_ctx_write_meta_entry_file(ctx, attributes, fn, data_size, &me))
             goto BRA_IO_WRITE_ERR;
     }
     break;
@@ -520,182 +1069,410 @@ BRA_IO_WRITE_ERR:
     return false;
 }
 
-bool bra_io_file_ctx_encode_and_write_to_disk(bra_io_file_ctx_t* ctx, const char* fn, const bool compress)
+bool bra_io_file_ctx_encode_and_write_to_disk(bra_io_file_ctx_t* ctx, const char* fn, const bra_attr_t type, const uint64_t file_size, const uint8_t level)
 {
     assert_bra_io_file_cxt_t(ctx);
     assert(fn != NULL);
     assert(ctx->last_dir != NULL);
 
     // get entry attributes
-    bra_attr_t attributes;
-    if (!bra_fs_file_attributes("./", fn, &attributes))
+    if (type != BRA_ATTR_TYPE_FILE && type != BRA_ATTR_TYPE_DIR)
     {
         bra_log_error("%s has unknown attribute", fn);
         bra_io_file_close(&ctx->f);
         return false;
     }
 
+    // fn is relative to the current dir: a directory with a parent is a sub-directory.
+    bra_attr_t attributes = BRA_ATTR_SET_TYPE(0, type);
+    if (type == BRA_ATTR_TYPE_DIR && strchr(fn, BRA_DIR_DELIM[0]) != NULL)
+        attributes = BRA_ATTR_SET_TYPE(attributes, BRA_ATTR_TYPE_SUBDIR);
+
     // NOTE: compression is used only in files.
-    if (compress && BRA_ATTR_TYPE(attributes) == BRA_ATTR_TYPE_FILE)
+    if (level == BRA_COMP_LEVEL_STORED || BRA_ATTR_TYPE(attributes) != BRA_ATTR_TYPE_FILE)
     {
-        attributes = BRA_ATTR_SET_COMP(attributes, BRA_ATTR_COMP_COMPRESSED);
+        attributes = BRA_ATTR_SET_COMP(attributes, BRA_ATTR_COMP_STORED);
+    }
+    else if (ctx->solid_files > 0 && level > BRA_COMP_LEVEL_FAST)
+    {
+        // the next file of the solid block: the same file already read.
+        if ((uint64_t) ctx->solid_pos + file_size > ctx->codec.solid_size)
+        {
+            bra_log_error("%s doesn't fit in the solid block", fn);
+            bra_io_file_close(&ctx->f);
+            return false;
+        }
+
+        attributes       = BRA_ATTR_SET_COMP(attributes, BRA_ATTR_COMP_SOLID);
+        ctx->codec.level = level;
     }
     else
     {
-        attributes = BRA_ATTR_SET_COMP(attributes, BRA_ATTR_COMP_STORED);
+        attributes       = BRA_ATTR_SET_COMP(attributes, level == BRA_COMP_LEVEL_FAST ? BRA_ATTR_COMP_FAST : BRA_ATTR_COMP_COMPRESSED);
+        ctx->codec.level = level;
     }
 
     bra_log_printf("Archiving %-7s:  ", g_attr_type_names[BRA_ATTR_TYPE(attributes)]);
     _bra_print_string_max_length(fn, (int) strlen(fn), BRA_PRINTF_FMT_FILENAME_MAX_LENGTH);
 
-    if (!bra_io_file_ctx_write_meta_entry(ctx, attributes, fn))
+    if (!bra_io_file_ctx_write_meta_entry(ctx, attributes, fn, file_size))
+        return false;    // f closed already
+
+    bra_log_printf(" [  %-4.4s  ]\n", g_end_messages[0]);
+    return true;
+}
+
+bool bra_io_file_ctx_encode_ref_and_write_to_disk(bra_io_file_ctx_t* ctx, const char* fn, const uint64_t file_size, const uint32_t crc32, const char* ref_fn, const int64_t ref_entry)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(fn != NULL);
+    assert(ref_fn != NULL);
+
+    const bra_attr_t attributes = BRA_ATTR_SET_COMP(BRA_ATTR_TYPE_FILE, BRA_ATTR_COMP_STORED) | BRA_ATTR_REF;
+
+    bra_log_printf("Archiving %-7s:  ", g_attr_type_names[BRA_ATTR_TYPE_FILE]);
+    _bra_print_string_max_length(fn, (int) strlen(fn), BRA_PRINTF_FMT_FILENAME_MAX_LENGTH);
+
+    ctx->ref_fn    = ref_fn;
+    ctx->ref_entry = ref_entry;
+    ctx->ref_crc32 = crc32;
+    const bool res = bra_io_file_ctx_write_meta_entry(ctx, attributes, fn, file_size);
+    ctx->ref_fn    = NULL;
+    if (!res)
         return false;    // f closed already
 
     bra_log_printf(" [  %-4.4s  ]\n", g_end_messages[0]);
     return true;
 }
 
+bool bra_io_file_ctx_solid_begin(bra_io_file_ctx_t* ctx, const char* const fns[], const uint64_t sizes[], const uint32_t n)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(fns != NULL);
+    assert(sizes != NULL);
+    assert(n > 0);
+
+    ctx->solid_files       = 0;
+    ctx->solid_pos         = 0;
+    ctx->codec.solid_size  = 0;
+    ctx->codec.solid_block = 0;
+    if (!bra_codec_ctx_reserve_solid(&ctx->codec))
+        return false;
+
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        if (sizes[i] == 0 || sizes[i] > BRA_SOLID_BLOCK_SIZE - pos)
+        {
+            bra_log_error("%s doesn't fit in the solid block", fns[i]);
+            return false;
+        }
+
+        bra_io_file_t f;
+        memset(&f, 0, sizeof(bra_io_file_t));
+        if (!bra_io_file_open(&f, fns[i], "rb"))
+            return false;
+
+        const bool res = bra_io_file_read(&f, &ctx->codec.solid[pos], sizes[i]);
+        bra_io_file_close(&f);
+        if (!res)
+            return false;
+
+        pos += (uint32_t) sizes[i];
+    }
+
+    ctx->codec.solid_size = pos;
+    ctx->solid_files      = n;
+    return true;
+}
+
+bool bra_io_file_ctx_cdc_enable(bra_io_file_ctx_t* ctx)
+{
+    assert_bra_io_file_cxt_t(ctx);
+
+    if (ctx->cdc == NULL)
+        ctx->cdc = bra_io_file_cdc_table_create();
+
+    return ctx->cdc != NULL;
+}
+
+bool bra_io_file_ctx_cdc_base(bra_io_file_ctx_t* ctx, const char* fn, const char* base_name)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(fn != NULL);
+    assert(base_name != NULL);
+
+    bra_io_file_ctx_t base;
+    bra_io_header_t   bh;
+    bra_meta_entry_t  me = {0};
+
+    if (!bra_io_file_ctx_cdc_enable(ctx) || !bra_io_file_cdc_table_set_base(ctx->cdc, base_name))
+        return false;
+
+    if (!bra_io_file_ctx_open(&base, fn, "rb"))
+        return false;
+
+    if (!bra_io_file_ctx_read_header(&base, &bh))
+        goto BRA_IO_FILE_CTX_CDC_BASE_ERR;
+
+    bra_log_printf("Reading base: %s (%u entries)\n", fn, bh.num_files);
+    for (uint32_t i = 0; i < bh.num_files; ++i)
+    {
+        const int64_t me_pos = bra_io_file_tell(&base.f);
+        if (me_pos <= 0 || !bra_io_file_ctx_read_meta_entry(&base, &me))
+            goto BRA_IO_FILE_CTX_CDC_BASE_ERR;
+
+        if (BRA_ATTR_TYPE(me.attributes) == BRA_ATTR_TYPE_FILE && !bra_io_file_cdc_table_add_base_entry(ctx->cdc, &base.codec, &base.f, &me, me_pos))
+            goto BRA_IO_FILE_CTX_CDC_BASE_ERR;
+
+        // the CRC32 of the entry: the contents are checked when extracting.
+        uint32_t crc32;
+        if (!bra_io_file_read(&base.f, &crc32, sizeof(uint32_t)))
+            goto BRA_IO_FILE_CTX_CDC_BASE_ERR;
+
+        bra_meta_entry_free(&me);
+    }
+
+    bra_io_file_ctx_close(&base);
+    return true;
+
+BRA_IO_FILE_CTX_CDC_BASE_ERR:
+    bra_log_error("unable to read the base archive: %s", fn);
+    bra_meta_entry_free(&me);
+    bra_io_file_ctx_close(&base);
+    return false;
+}
+
 bool bra_io_file_ctx_decode_and_write_to_disk(bra_io_file_ctx_t* ctx, bra_fs_overwrite_policy_e* overwrite_policy)
 {
     assert_bra_io_file_cxt_t(ctx);
     assert(overwrite_policy != NULL);
 
-    const char*      end_msg;    // 'OK  ' | 'SKIP'
-    char*            fn = NULL;
-    bra_meta_entry_t me = {0};
+    bra_io_file_entry_job_t job;
 
-    if (!bra_io_file_ctx_read_meta_entry(ctx, &me))
-        goto BRA_IO_DECODE_ERR;
+    // the file data is decoded in place, just after its meta entry.
+    if (!_bra_io_file_ctx_read_entry(ctx, overwrite_policy, &job, false))
+        return false;
 
-    // the full path name
-    fn = _bra_io_file_ctx_reconstruct_meta_entry_name(ctx, &me, NULL);
+    bool res = true;
+    if (job.fn != NULL)
+        res = bra_io_file_entry_job_run(&ctx->codec, &ctx->f, &job);
+
+    bra_io_file_entry_job_free(&job);
+    return res;
+}
+
+bool bra_io_file_ctx_locate_entry(bra_io_file_ctx_t* ctx, bra_fs_overwrite_policy_e* overwrite_policy, bra_io_file_entry_job_t* job)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(overwrite_policy != NULL);
+    assert(job != NULL);
+
+    return _bra_io_file_ctx_read_entry(ctx, overwrite_policy, job, true);
+}
+
+bool bra_io_file_entry_job_run(bra_codec_ctx_t* codec, bra_io_file_t* src, bra_io_file_entry_job_t* job)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(job != NULL);
+    assert(job->fn != NULL);
+    assert(BRA_ATTR_TYPE(job->me.attributes) == BRA_ATTR_TYPE_FILE);
+
+    bra_meta_entry_t*            me  = &job->me;
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    bra_io_file_t                f2  = {.f = NULL, .fn = NULL};
+
+    assert(mef != NULL);
+    if (bra_io_file_tell(src) != job->data_offset && !bra_io_file_seek(src, job->data_offset, SEEK_SET))
+    {
+        bra_io_file_seek_error(src);
+        return false;
+    }
+
+    // NOTE: the directory must have been created in the previous entry,
+    //       otherwise this will fail to create the file.
+    //       The archive ensures the last used directory is created first,
+    //       and then its files follow.
+    //       So, no need to create the parent directory for each file each time.
+    if (!bra_io_file_open(&f2, job->fn, "wb"))
+        goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+
+    switch (BRA_ATTR_COMP(me->attributes))
+    {
+    case BRA_ATTR_COMP_STORED:
+        if (BRA_ATTR_IS_REF(me->attributes) ? !_bra_io_file_ctx_job_run_ref(codec, src, job, &f2) : BRA_ATTR_IS_CDC(me->attributes) ? !bra_io_file_cdc_read_file(codec, &f2, src, me, true) : !bra_io_file_chunks_copy_file(&f2, src, mef->data_size, me, true))
+            goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+        break;
+    case BRA_ATTR_COMP_COMPRESSED:
+    case BRA_ATTR_COMP_FAST:
+        if (BRA_ATTR_IS_CDC(me->attributes) ? !bra_io_file_cdc_read_file(codec, &f2, src, me, true) : !bra_io_file_chunks_decompress_file(codec, &f2, src, mef->data_size, me, true))
+            goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+        break;
+    case BRA_ATTR_COMP_SOLID:
+        if (!bra_io_file_chunks_read_solid_file(codec, &f2, src, me, true))
+            goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+        break;
+    default:
+        bra_log_critical("invalid compression type for file: %u", BRA_ATTR_COMP(me->attributes));
+        goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+        break;
+    }
+
+    bra_io_file_close(&f2);
+
+    // read CRC32
+    uint32_t read_crc32;
+    if (!bra_io_file_read(src, &read_crc32, sizeof(uint32_t)))
+        goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+
+    // compare CRC32
+    if (read_crc32 != me->crc32)
+    {
+        bra_log_critical("%s checksum failed!!!", job->fn);
+        goto BRA_IO_FILE_ENTRY_JOB_RUN_ERR;
+    }
+
+    // a single call, the jobs might run concurrently.
+    bra_log_printf("Extracting file: " BRA_PRINTF_FMT_FILENAME " [  %-4.4s  ]\n", job->fn, g_end_messages[0]);
+    return true;
+
+BRA_IO_FILE_ENTRY_JOB_RUN_ERR:
+    bra_io_file_close(&f2);
+    bra_io_file_error(src, "decode");
+    return false;
+}
+
+bool bra_io_file_ctx_locate_entry_for_test(bra_io_file_ctx_t* ctx, bra_io_file_entry_job_t* job)
+{
+    assert_bra_io_file_cxt_t(ctx);
+    assert(job != NULL);
+
+    const char*       fn = NULL;
+    bra_meta_entry_t* me = &job->me;
+    uint64_t          ds = 0;
+
+    memset(job, 0, sizeof(bra_io_file_entry_job_t));
+    if (!bra_io_file_ctx_read_meta_entry(ctx, me))
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
+
+    size_t fn_len = 0;
+    fn            = _bra_io_file_ctx_reconstruct_meta_entry_name(ctx, me, &fn_len);
     if (fn == NULL)
-        goto BRA_IO_DECODE_ERR;
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
 
-    const size_t fn_len     = strlen(fn);
-    bool         skip_entry = false;
     if (!_bra_validate_filename(fn, fn_len))
-        goto BRA_IO_DECODE_ERR;
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
 
-    if (!_bra_compute_header_crc32(fn_len, fn, &me))
-        goto BRA_IO_DECODE_ERR;
+    if (!_bra_compute_header_crc32(fn_len, fn, me))
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
 
-    // 4. read and write in chunk data
-    // NOTE: nothing to extract for a directory, but only to create it
-    switch (BRA_ATTR_TYPE(me.attributes))
+    switch (BRA_ATTR_TYPE(me->attributes))
     {
     case BRA_ATTR_TYPE_FILE:
     {
-        const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me.entry_data;
+        const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
         assert(mef != NULL);
-        const uint64_t ds = mef->data_size;
-        if (!bra_fs_file_exists_ask_overwrite(fn, overwrite_policy, false))
-        {
-            end_msg = g_end_messages[1];
-            bra_log_printf("Skipping file:   " BRA_PRINTF_FMT_FILENAME, fn);
-
-            // skip file contents & crc32 too
-            // NOTE: the sizeof(uint32_t) is for the CRC32
-            if (!bra_io_file_skip_data(&ctx->f, ds + sizeof(uint32_t)))
-                goto BRA_IO_DECODE_ERR;
-
-            skip_entry = true;
-        }
-        else
-        {
-            bra_io_file_t f2;
-            end_msg  = g_end_messages[0];
-            me.crc32 = bra_crc32c(&mef->data_size, sizeof(uint64_t), me.crc32);
-            bra_log_printf("Extracting file: " BRA_PRINTF_FMT_FILENAME, fn);
-            // NOTE: the directory must have been created in the previous entry,
-            //       otherwise this will fail to create the file.
-            //       The archive ensures the last used directory is created first,
-            //       and then its files follow.
-            //       So, no need to create the parent directory for each file each time.
-            if (!bra_io_file_open(&f2, fn, "wb"))
-                goto BRA_IO_DECODE_ERR;
-
-            switch (BRA_ATTR_COMP(me.attributes))
-            {
-            case BRA_ATTR_COMP_STORED:
-                if (!bra_io_file_chunks_copy_file(&f2, &ctx->f, ds, &me, true))
-                    goto BRA_IO_DECODE_ERR;
-                break;
-            case BRA_ATTR_COMP_COMPRESSED:
-                if (!bra_io_file_chunks_decompress_file(&f2, &ctx->f, ds, &me, true))
-                    goto BRA_IO_DECODE_ERR;
-                break;
-            default:
-                bra_log_critical("invalid compression type for file: %u", BRA_ATTR_COMP(me.attributes));
-                bra_io_file_close(&f2);
-                goto BRA_IO_DECODE_ERR;
-                break;
-            }
 
-            bra_io_file_close(&f2);
-        }
+        ds = mef->data_size;
+        _bra_compute_file_entry_crc32(me);
     }
     break;
     case BRA_ATTR_TYPE_SUBDIR:
     {
-        const bra_meta_entry_subdir_t* mes = me.entry_data;
-        me.crc32                           = bra_crc32c(&mes->parent_index, sizeof(uint32_t), me.crc32);
-    }
-        BRA_FALLTHROUGH;
-    // [[fallthrough]];
-    case BRA_ATTR_TYPE_DIR:
-    {
-        if (bra_fs_dir_exists(fn))
-        {
-            end_msg = g_end_messages[1];
-            bra_log_printf("Dir exists:    : " BRA_PRINTF_FMT_FILENAME, fn);
-        }
-        else
-        {
-            end_msg = g_end_messages[0];
-            bra_log_printf("Creating dir   : " BRA_PRINTF_FMT_FILENAME, fn);
-
-            if (!bra_fs_dir_make(fn))
-                goto BRA_IO_DECODE_ERR;
-        }
+        const bra_meta_entry_subdir_t* mes = me->entry_data;
+        me->crc32                          = bra_crc32c(&mes->parent_index, sizeof(uint32_t), me->crc32);
     }
     break;
+    case BRA_ATTR_TYPE_DIR:
+        break;
     case BRA_ATTR_TYPE_SYM:
         bra_log_critical("SYMLINK NOT IMPLEMENTED YET");
-        // fallthrough
         BRA_FALLTHROUGH;
+        // fallthrough
     default:
-        goto BRA_IO_DECODE_ERR;
-        break;
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
+    }
+
+    job->data_offset = bra_io_file_tell(&ctx->f);
+    job->fn          = _bra_strdup(fn);
+    if (job->data_offset < 0 || job->fn == NULL)
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
+
+    // skip the data and the CRC32, read by the job
+    if (!bra_io_file_skip_data(&ctx->f, ds + sizeof(uint32_t)))
+        goto BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR;
+
+    return true;
+
+BRA_IO_LOCATE_ENTRY_FOR_TEST_ERR:
+    bra_io_file_entry_job_free(job);
+    bra_io_file_error(&ctx->f, "test");
+    return false;
+}
+
+bool bra_io_file_entry_job_test(bra_codec_ctx_t* codec, bra_io_file_t* src, bra_io_file_entry_job_t* job)
+{
+    assert(codec != NULL);
+    assert_bra_io_file_t(src);
+    assert(job != NULL);
+    assert(job->fn != NULL);
+
+    bra_meta_entry_t* me = &job->me;
+
+    if (bra_io_file_tell(src) != job->data_offset && !bra_io_file_seek(src, job->data_offset, SEEK_SET))
+    {
+        bra_io_file_seek_error(src);
+        return false;
     }
 
-    if (!skip_entry)
+    if (BRA_ATTR_TYPE(me->attributes) == BRA_ATTR_TYPE_FILE)
     {
-        // read CRC32
-        uint32_t read_crc32;
-        if (!bra_io_file_read(&ctx->f, &read_crc32, sizeof(uint32_t)))
-            goto BRA_IO_DECODE_ERR;
+        const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+        assert(mef != NULL);
 
-        // compare CRC32
-        if (read_crc32 != me.crc32)
-        {
-            bra_log_critical("%s checksum failed!!!", fn);
-            goto BRA_IO_DECODE_ERR;
-        }
+        if (!bra_io_file_chunks_read_file(codec, src, mef->data_size, me, true))
+            return false;
+    }
+
+    if (!bra_io_file_read(src, &job->read_crc32, sizeof(uint32_t)))
+        return false;
+
+    if (job->read_crc32 != me->crc32)
+    {
+        bra_log_critical("%s checksum failed!!!", job->fn);
+        return false;
     }
 
-    bra_meta_entry_free(&me);
-    free(fn);
-    bra_log_printf(" [  %-4.4s  ]\n", end_msg);
     return true;
+}
+
+void bra_io_file_ctx_print_entry_job(bra_io_file_ctx_t* ctx, const bra_io_file_entry_job_t* job)
+{
+    assert(ctx != NULL);
+    assert(job != NULL);
+    assert(job->fn != NULL);
 
-BRA_IO_DECODE_ERR:
-    if (fn != NULL)
-        free(fn);
+    const bra_meta_entry_t* me = &job->me;
 
-    bra_meta_entry_free(&me);
-    bra_io_file_error(&ctx->f, "decode");
-    return false;
+    _bra_io_file_ctx_print_entry_head(me, job->fn, strlen(job->fn));
+    _bra_io_file_ctx_print_entry_tail(me, job->read_crc32);
+    if (BRA_ATTR_TYPE(me->attributes) == BRA_ATTR_TYPE_FILE)
+        ctx->total_size_uncompressed += _bra_io_file_ctx_entry_orig_size(me);
+}
+
+void bra_io_file_entry_job_free(bra_io_file_entry_job_t* job)
+{
+    assert(job != NULL);
+
+    bra_meta_entry_free(&job->me);
+    if (job->fn != NULL)
+    {
+        free(job->fn);
+        job->fn = NULL;
+    }
+
+    job->data_offset = 0;
 }
 
 bool bra_io_file_ctx_print_meta_entry(bra_io_file_ctx_t* ctx, const bool test_mode)
@@ -703,25 +1480,19 @@ bool bra_io_file_ctx_print_meta_entry(bra_io_file_ctx_t* ctx, const bool test_mo
     assert(ctx != NULL);
     assert_bra_io_file_t(&ctx->f);
 
-    char             bytes[BRA_PRINTF_FMT_BYTES_BUF_SIZE];
     bra_meta_entry_t me = {0};
-    char*            fn = NULL;
+    const char*      fn = NULL;
 
     if (!bra_io_file_ctx_read_meta_entry(ctx, &me))
         goto BRA_IO_FILE_CTX_PRINT_META_ENTRY_ERR;
 
-    const uint64_t ds        = BRA_ATTR_TYPE(me.attributes) == BRA_ATTR_TYPE_FILE ? ((bra_meta_entry_file_t*) me.entry_data)->data_size : 0;
-    const char     attr_type = bra_format_meta_attribute_types(me.attributes);
-    const char     attr_comp = bra_format_meta_attribute_compression(me.attributes);
-    size_t         len       = 0;
+    size_t len = 0;
 
     fn = _bra_io_file_ctx_reconstruct_meta_entry_name(ctx, &me, &len);
     if (fn == NULL)
         goto BRA_IO_FILE_CTX_PRINT_META_ENTRY_ERR;
 
-    bra_format_bytes(ds, bytes);
-    bra_log_printf("| %c|%c  | %s | ", attr_type, attr_comp, bytes);
-    _bra_print_string_max_length(fn, (int) len, BRA_PRINTF_FMT_FILENAME_MAX_LENGTH);
+    _bra_io_file_ctx_print_entry_head(&me, fn, len);
 
     if (test_mode)
     {
@@ -740,12 +1511,12 @@ bool bra_io_file_ctx_print_meta_entry(bra_io_file_ctx_t* ctx, const bool test_mo
         assert(mef != NULL);
 
         if (test_mode)
-            me.crc32 = bra_crc32c(&mef->data_size, sizeof(uint64_t), me.crc32);
+            _bra_compute_file_entry_crc32(&me);
 
-        if (!bra_io_file_chunks_read_file(&ctx->f, mef->data_size, &me, test_mode))
+        if (!bra_io_file_chunks_read_file(&ctx->codec, &ctx->f, mef->data_size, &me, test_mode))
             goto BRA_IO_FILE_CTX_PRINT_META_ENTRY_ERR;
 
-        ctx->total_size_uncompressed += (uint64_t) ds / me._compression_ratio;
+        ctx->total_size_uncompressed += _bra_io_file_ctx_entry_orig_size(&me);
     }
     break;
     case BRA_ATTR_TYPE_SUBDIR:
@@ -782,23 +1553,11 @@ bool bra_io_file_ctx_print_meta_entry(bra_io_file_ctx_t* ctx, const bool test_mo
         }
     }
 
-    free(fn);
-    fn = NULL;
-    if (me._compression_ratio >= 1.0f)
-        bra_log_printf("| 100 %% ");
-    else
-        bra_log_printf("| %4.1f%% ", me._compression_ratio * 100.0);
-    bra_log_printf("|%08X|\n", read_crc32);
+    _bra_io_file_ctx_print_entry_tail(&me, read_crc32);
     bra_meta_entry_free(&me);
     return true;
 
 BRA_IO_FILE_CTX_PRINT_META_ENTRY_ERR:
-    if (fn != NULL)
-    {
-        free(fn);
-        fn = NULL;
-    }
-
     bra_meta_entry_free(&me);
     return false;
 }
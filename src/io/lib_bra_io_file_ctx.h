@@ -12,7 +12,7 @@ extern "C" {
  *        On failure there is no need to call @ref bra_io_file_ctx_close.
  *
  * @param ctx[out]
- * @param fn
+ * @param fn   #BRA_STDIO_FILENAME for the standard input, or output when @p mode writes, as a stream.
  * @param mode
  * @retval true
  * @retval false
@@ -75,6 +75,45 @@ bool bra_io_file_ctx_write_header(bra_io_file_ctx_t* ctx, const uint32_t num_fil
  */
 bool bra_io_file_ctx_sfx_open_and_read_footer_header(const char* fn, bra_io_header_t* out_bh, bra_io_file_ctx_t* ctx);
 
+/**
+ * @brief Open the existing archive @p fn in read-write binary mode to append entries to it, and read its header.
+ *        Its entries are then skipped with @ref bra_io_file_ctx_skip_entry, to write the new ones after them.
+ *        On failure there is no need to call @ref bra_io_file_ctx_close.
+ *
+ * @param ctx[out]
+ * @param fn
+ * @param sfx @p fn is a self-extracting archive: its header is located by the footer.
+ * @param out_bh
+ * @param out_header_offset where the header is, to update it with @ref bra_io_file_ctx_update_header.
+ * @retval true on success (file positioned immediately after the header, at first entry)
+ * @retval false on error
+ */
+bool bra_io_file_ctx_append_open(bra_io_file_ctx_t* ctx, const char* fn, const bool sfx, bra_io_header_t* out_bh, int64_t* out_header_offset);
+
+/**
+ * @brief Read the entry currently pointed to by @p ctx->f, adding its directory to the tree as when decoding,
+ *        and skip its data and CRC32 without reading them: the stream is positioned at the next entry.
+ *        On error closes @p ctx->f via @ref bra_io_file_close.
+ *
+ * @param ctx[in,out]
+ * @param out_fn[out] full path of the entry, owned by @p ctx and valid until the next entry is read.
+ * @retval true on success
+ * @retval false on error
+ */
+bool bra_io_file_ctx_skip_entry(bra_io_file_ctx_t* ctx, const char** out_fn);
+
+/**
+ * @brief Rewrite in place the header at @p header_offset with @p num_files.
+ *        On error closes @p ctx->f via @ref bra_io_file_close.
+ *
+ * @param ctx[in,out]
+ * @param header_offset
+ * @param num_files
+ * @retval true on success (file positioned immediately after the header)
+ * @retval false on error
+ */
+bool bra_io_file_ctx_update_header(bra_io_file_ctx_t* ctx, const int64_t header_offset, const uint32_t num_files);
+
 /**
  * @brief Read the entry metadata (file or directory) currently pointed to by @p ctx->f and store it in @p me.
  *        @p me must be freed via @ref bra_meta_entry_free.
@@ -95,21 +134,86 @@ bool bra_io_file_ctx_read_meta_entry(bra_io_file_ctx_t* ctx, bra_meta_entry_t* m
  * @param ctx[in,out]
  * @param attributes[in]
  * @param fn[in]
+ * @param data_size[in] size in bytes of the file @p fn; ignored for directories.
  * @retval true on success
  * @retval false on error closes @p ctx->f via @ref bra_io_file_close.
  */
-bool bra_io_file_ctx_write_meta_entry(bra_io_file_ctx_t* ctx, const bra_attr_t attributes, const char* fn);
+bool bra_io_file_ctx_write_meta_entry(bra_io_file_ctx_t* ctx, const bra_attr_t attributes, const char* fn, const uint64_t data_size);
 
 /**
  * @brief Encode a file or directory @p fn and append it to the open archive @p ctx->f.
  *        On error closes @p ctx->f via @ref bra_io_file_close.
  *
+ * @note  @p fn is not stat'ed: its type and size are the ones cached by the caller when scanning.
+ *        Directory or sub-directory is resolved from the archive tree.
+ *
  * @param ctx[in,out]
  * @param fn NULL-terminated path to file or directory.
+ * @param type #BRA_ATTR_TYPE_FILE or #BRA_ATTR_TYPE_DIR.
+ * @param file_size size in bytes of the file; ignored for directories.
+ * @param level compression level of a file, #BRA_COMP_LEVEL_STORED to #BRA_COMP_LEVEL_MAX; directories are always stored.
  * @retval true on success
  * @retval false on error (archive handle is closed)
  */
-bool bra_io_file_ctx_encode_and_write_to_disk(bra_io_file_ctx_t* ctx, const char* fn, const bool compress);
+bool bra_io_file_ctx_encode_and_write_to_disk(bra_io_file_ctx_t* ctx, const char* fn, const bra_attr_t type, const uint64_t file_size, const uint8_t level);
+
+/**
+ * @brief Append the file @p fn as a duplicate of @p ref_fn, already in the archive: only a reference to it is stored.
+ *        On error closes @p ctx->f via @ref bra_io_file_close.
+ *
+ * @note  The contents of @p fn are not read: they must be the same of @p ref_fn, with the CRC32C @p crc32.
+ *
+ * @param ctx[in,out]
+ * @param fn NULL-terminated path to the file.
+ * @param file_size size in bytes of the file.
+ * @param crc32 CRC32C of the file contents.
+ * @param ref_fn NULL-terminated path to the first copy.
+ * @param ref_entry archive offset of the entry of @p ref_fn, as returned by @ref bra_io_file_tell before encoding it.
+ * @retval true on success
+ * @retval false on error (archive handle is closed)
+ */
+bool bra_io_file_ctx_encode_ref_and_write_to_disk(bra_io_file_ctx_t* ctx, const char* fn, const uint64_t file_size, const uint32_t crc32, const char* ref_fn, const int64_t ref_entry);
+
+/**
+ * @brief Start a solid block with the files @p fns: their contents are read now and compressed together as a single chunk.
+ *        The next @p n files encoded with @ref bra_io_file_ctx_encode_and_write_to_disk must be @p fns, in the same order.
+ *        The first one has the block data, the others only their offset and size in the block.
+ *
+ * @note  Compression levels up to #BRA_COMP_LEVEL_FAST ignore the solid block.
+ *
+ * @param ctx[in,out]
+ * @param fns   the files of the block.
+ * @param sizes sizes in bytes of @p fns, none is 0 and the total is up to #BRA_SOLID_BLOCK_SIZE.
+ * @param n     number of files, at least 1.
+ * @retval true on success
+ * @retval false on error, the files can still be encoded one by one.
+ */
+bool bra_io_file_ctx_solid_begin(bra_io_file_ctx_t* ctx, const char* const fns[], const uint64_t sizes[], const uint32_t n);
+
+/**
+ * @brief Split the next files encoded with @ref bra_io_file_ctx_encode_and_write_to_disk in content-defined blocks:
+ *        the blocks already in the archive are referred to, so only the new ones are stored.
+ *
+ * @note  The solid files and the duplicates are not split.
+ *
+ * @param ctx[in,out]
+ * @retval true on success
+ * @retval false on allocation failure.
+ */
+bool bra_io_file_ctx_cdc_enable(bra_io_file_ctx_t* ctx);
+
+/**
+ * @brief Enable the content-defined blocks as @ref bra_io_file_ctx_cdc_enable, with the blocks of the archive @p fn too:
+ *        the next files refer to them, so only their changes are stored.
+ *        The archive written depends on @p fn to be extracted.
+ *
+ * @param ctx[in,out]
+ * @param fn        the base archive, not self-extracting.
+ * @param base_name path of @p fn relative to the directory of the archive of @p ctx, stored in the entries.
+ * @retval true on success
+ * @retval false on error.
+ */
+bool bra_io_file_ctx_cdc_base(bra_io_file_ctx_t* ctx, const char* fn, const char* base_name);
 
 /**
  * @brief Decode the current pointed internal file contained in @p ctx->f and write it to its relative path on disk.
@@ -129,6 +233,78 @@ bool bra_io_file_ctx_encode_and_write_to_disk(bra_io_file_ctx_t* ctx, const char
  */
 bool bra_io_file_ctx_decode_and_write_to_disk(bra_io_file_ctx_t* ctx, bra_fs_overwrite_policy_e* overwrite_policy);
 
+/**
+ * @brief Read the current pointed entry in @p ctx->f, like @ref bra_io_file_ctx_decode_and_write_to_disk,
+ *        but a file to extract is only located into @p job and its data skipped,
+ *        so it can be decoded later on with @ref bra_io_file_entry_job_run, even from another thread.
+ *        Directories are created and verified straight away, so they exist before their files are decoded.
+ *        On error closes @p ctx->f via @ref bra_io_file_close.
+ *
+ * @pre  @p overwrite_policy != NULL.
+ *
+ * @param ctx[in,out]
+ * @param overwrite_policy[in/out]
+ * @param job[out] @c job->fn is @c NULL when there is nothing to extract (directory or skipped file).
+ *                 It must be freed via @ref bra_io_file_entry_job_free.
+ * @retval true on success
+ * @retval false on error
+ */
+bool bra_io_file_ctx_locate_entry(bra_io_file_ctx_t* ctx, bra_fs_overwrite_policy_e* overwrite_policy, bra_io_file_entry_job_t* job);
+
+/**
+ * @brief Decode the file located in @p job from the archive @p src and write it to disk, then verify its CRC32.
+ *        @p src is an archive handle owned by the caller: it is seeked to @c job->data_offset.
+ *        On error closes @p src via @ref bra_io_file_close.
+ *
+ * @param codec[in,out] codec work buffers, not shared with other threads.
+ * @param src[in,out] archive handle.
+ * @param job[in,out]
+ * @retval true on success
+ * @retval false on error
+ */
+bool bra_io_file_entry_job_run(bra_codec_ctx_t* codec, bra_io_file_t* src, bra_io_file_entry_job_t* job);
+
+/**
+ * @brief Read the current pointed entry in @p ctx->f and locate it into @p job to be verified later on
+ *        with @ref bra_io_file_entry_job_test, even from another thread. The entry data is skipped.
+ *        On error closes @p ctx->f via @ref bra_io_file_close.
+ *
+ * @param ctx[in,out]
+ * @param job[out] it must be freed via @ref bra_io_file_entry_job_free.
+ * @retval true on success
+ * @retval false on error
+ */
+bool bra_io_file_ctx_locate_entry_for_test(bra_io_file_ctx_t* ctx, bra_io_file_entry_job_t* job);
+
+/**
+ * @brief Recompute the CRC32 of the entry located in @p job reading (and decoding) it from the archive @p src,
+ *        and compare it with the stored one, saved in @c job->read_crc32.
+ *        @p src is an archive handle owned by the caller: it is seeked to @c job->data_offset.
+ *        On read errors closes @p src via @ref bra_io_file_close.
+ *
+ * @param codec[in,out] codec work buffers, not shared with other threads.
+ * @param src[in,out] archive handle.
+ * @param job[in,out]
+ * @retval true if the entry is valid
+ * @retval false on checksum mismatch or error
+ */
+bool bra_io_file_entry_job_test(bra_codec_ctx_t* codec, bra_io_file_t* src, bra_io_file_entry_job_t* job);
+
+/**
+ * @brief Print the listing row of the entry located in @p job, like @ref bra_io_file_ctx_print_meta_entry.
+ *
+ * @param ctx[in,out] accumulates @c ctx->total_size_uncompressed.
+ * @param job[in]
+ */
+void bra_io_file_ctx_print_entry_job(bra_io_file_ctx_t* ctx, const bra_io_file_entry_job_t* job);
+
+/**
+ * @brief Free the resources owned by @p job.
+ *
+ * @param job
+ */
+void bra_io_file_entry_job_free(bra_io_file_entry_job_t* job);
+
 /**
  * @brief Read and print one meta entry from @p ctx (attributes, size, filename),
  *        then skip its data, advancing the file position to the next entry.
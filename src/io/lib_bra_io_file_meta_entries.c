@@ -4,12 +4,15 @@
 #include <lib_bra_defs.h>
 #include <lib_bra.h>
 
+#include <io/lib_bra_io_file_cdc.h>
 #include <io/lib_bra_io_file_chunks.h>
 #include <utils/lib_bra_crc32c.h>
 
 #include <log/bra_log.h>
 
+#include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 
@@ -73,6 +76,87 @@ bool bra_io_file_meta_entry_write_common_header(bra_io_file_t* f, const bra_meta
     return true;
 }
 
+/**
+ * @brief Read the runs of blocks of a #BRA_ATTR_CDC file entry.
+ *
+ * @param f
+ * @param me
+ * @retval true on success.
+ * @retval false on error, @p f is closed.
+ */
+static bool _bra_io_file_meta_entry_read_cdc_runs(bra_io_file_t* f, bra_meta_entry_t* me)
+{
+    bra_meta_entry_file_t* mef = me->entry_data;
+    if (!bra_io_file_read(f, &mef->cdc_num_runs, sizeof(uint32_t)))
+        return false;
+
+    if (mef->cdc_num_runs == 0 || BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID)
+    {
+        bra_log_error("file entry with content-defined blocks not valid: %s", me->name);
+        goto BRA_IO_FILE_META_ENTRY_READ_CDC_RUNS_ERR;
+    }
+
+    mef->cdc_runs = malloc(sizeof(bra_cdc_run_t) * mef->cdc_num_runs);
+    if (mef->cdc_runs == NULL)
+    {
+        bra_log_critical("unable to allocate memory for the blocks of the file entry: %s", me->name);
+        goto BRA_IO_FILE_META_ENTRY_READ_CDC_RUNS_ERR;
+    }
+
+    bool base     = false;
+    mef->cdc_size = 0;
+    for (uint32_t i = 0; i < mef->cdc_num_runs; ++i)
+    {
+        bra_cdc_run_t* run = &mef->cdc_runs[i];
+        run->offset        = 0;
+        run->pos           = 0;
+        if (!bra_io_file_read(f, &run->ref, sizeof(uint8_t)) || !bra_io_file_read(f, &run->size, sizeof(uint64_t)))
+            return false;
+
+        if (run->ref != BRA_CDC_RUN_NEW && (!bra_io_file_read(f, &run->offset, sizeof(uint64_t)) || !bra_io_file_read(f, &run->pos, sizeof(uint64_t))))
+            return false;
+
+        if (run->ref > BRA_CDC_RUN_BASE || run->size == 0 || run->size > UINT64_MAX - mef->cdc_size)
+        {
+            bra_log_error("block run %" PRIu32 " not valid: %s", i, me->name);
+            goto BRA_IO_FILE_META_ENTRY_READ_CDC_RUNS_ERR;
+        }
+
+        base          |= run->ref == BRA_CDC_RUN_BASE;
+        mef->cdc_size += run->size;
+    }
+
+    if (!base)
+        return true;
+
+    // the base archive of the runs in it.
+    if (!bra_io_file_read(f, &mef->cdc_base_name_size, sizeof(uint8_t)))
+        return false;
+
+    if (mef->cdc_base_name_size == 0)
+    {
+        bra_log_error("file entry without its base archive: %s", me->name);
+        goto BRA_IO_FILE_META_ENTRY_READ_CDC_RUNS_ERR;
+    }
+
+    mef->cdc_base_name = malloc(sizeof(char) * (mef->cdc_base_name_size + 1));
+    if (mef->cdc_base_name == NULL)
+    {
+        bra_log_critical("unable to allocate memory for the base archive of the file entry: %s", me->name);
+        goto BRA_IO_FILE_META_ENTRY_READ_CDC_RUNS_ERR;
+    }
+
+    if (!bra_io_file_read(f, mef->cdc_base_name, mef->cdc_base_name_size))
+        return false;
+
+    mef->cdc_base_name[mef->cdc_base_name_size] = '\0';
+    return true;
+
+BRA_IO_FILE_META_ENTRY_READ_CDC_RUNS_ERR:
+    bra_io_file_close(f);
+    return false;
+}
+
 bool bra_io_file_meta_entry_read_file_entry(bra_io_file_t* f, bra_meta_entry_t* me)
 {
     assert_bra_io_file_t(f);
@@ -86,7 +170,47 @@ bool bra_io_file_meta_entry_read_file_entry(bra_io_file_t* f, bra_meta_entry_t*
     }
 
     bra_meta_entry_file_t* mef = me->entry_data;
-    return bra_io_file_read(f, &mef->data_size, sizeof(uint64_t));
+    if (!bra_io_file_read(f, &mef->data_size, sizeof(uint64_t)))
+        return false;
+
+    if (BRA_ATTR_IS_REF(me->attributes))
+    {
+        if (!bra_io_file_read(f, &mef->ref_offset, sizeof(uint64_t)) || !bra_io_file_read(f, &mef->ref_size, sizeof(uint64_t)))
+            return false;
+
+        if (!bra_io_file_read(f, &mef->ref_name_size, sizeof(uint8_t)))
+            return false;
+
+        if (mef->ref_name_size == 0)
+        {
+            bra_log_error("duplicate file entry without its first copy: %s", me->name);
+            bra_io_file_close(f);
+            return false;
+        }
+
+        free(mef->ref_name);
+        mef->ref_name = malloc(sizeof(char) * (mef->ref_name_size + 1));
+        if (mef->ref_name == NULL)
+        {
+            bra_log_critical("unable to allocate memory for the duplicate file entry: %s", me->name);
+            bra_io_file_close(f);
+            return false;
+        }
+
+        if (!bra_io_file_read(f, mef->ref_name, mef->ref_name_size))
+            return false;
+
+        mef->ref_name[mef->ref_name_size] = '\0';
+        return true;
+    }
+
+    if (BRA_ATTR_IS_CDC(me->attributes))
+        return _bra_io_file_meta_entry_read_cdc_runs(f, me);
+
+    if (BRA_ATTR_COMP(me->attributes) != BRA_ATTR_COMP_SOLID)
+        return true;
+
+    return bra_io_file_read(f, &mef->solid_offset, sizeof(uint32_t)) && bra_io_file_read(f, &mef->solid_size, sizeof(uint32_t));
 }
 
 bool bra_io_file_meta_entry_write_file_entry(bra_io_file_t* f, const bra_meta_entry_t* me)
@@ -102,7 +226,42 @@ bool bra_io_file_meta_entry_write_file_entry(bra_io_file_t* f, const bra_meta_en
     }
 
     bra_meta_entry_file_t* mef = me->entry_data;
-    return bra_io_file_write(f, &mef->data_size, sizeof(uint64_t));
+    if (!bra_io_file_write(f, &mef->data_size, sizeof(uint64_t)))
+        return false;
+
+    if (BRA_ATTR_IS_REF(me->attributes))
+    {
+        return bra_io_file_write(f, &mef->ref_offset, sizeof(uint64_t)) &&
+               bra_io_file_write(f, &mef->ref_size, sizeof(uint64_t)) &&
+               bra_io_file_write(f, &mef->ref_name_size, sizeof(uint8_t)) &&
+               bra_io_file_write(f, mef->ref_name, mef->ref_name_size);
+    }
+
+    if (BRA_ATTR_IS_CDC(me->attributes))
+    {
+        if (!bra_io_file_write(f, &mef->cdc_num_runs, sizeof(uint32_t)))
+            return false;
+
+        for (uint32_t i = 0; i < mef->cdc_num_runs; ++i)
+        {
+            const bra_cdc_run_t* run = &mef->cdc_runs[i];
+            if (!bra_io_file_write(f, &run->ref, sizeof(uint8_t)) || !bra_io_file_write(f, &run->size, sizeof(uint64_t)))
+                return false;
+
+            if (run->ref != BRA_CDC_RUN_NEW && (!bra_io_file_write(f, &run->offset, sizeof(uint64_t)) || !bra_io_file_write(f, &run->pos, sizeof(uint64_t))))
+                return false;
+        }
+
+        if (mef->cdc_base_name_size == 0)
+            return true;
+
+        return bra_io_file_write(f, &mef->cdc_base_name_size, sizeof(uint8_t)) && bra_io_file_write(f, mef->cdc_base_name, mef->cdc_base_name_size);
+    }
+
+    if (BRA_ATTR_COMP(me->attributes) != BRA_ATTR_COMP_SOLID)
+        return true;
+
+    return bra_io_file_write(f, &mef->solid_offset, sizeof(uint32_t)) && bra_io_file_write(f, &mef->solid_size, sizeof(uint32_t));
 }
 
 bool bra_io_file_meta_entry_read_subdir_entry(bra_io_file_t* f, bra_meta_entry_t* me)
@@ -141,7 +300,28 @@ bool bra_io_file_meta_entry_write_subdir_entry(bra_io_file_t* f, const bra_meta_
     return bra_io_file_write(f, &mes->parent_index, sizeof(uint32_t));
 }
 
-bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t* me, const char* filename, const size_t filename_len)
+/**
+ * @brief Compress the file @p filename once only to measure it, before writing its entry to a stream:
+ *        a stream can't be sought back to rewrite the entry stored when it doesn't compress.
+ */
+static bool _bra_io_file_meta_entry_stream_measure(bra_codec_ctx_t* codec, bra_meta_entry_t* me, const char* filename, uint64_t* comp_size)
+{
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    bra_io_file_t                f   = {.f = NULL, .fn = NULL};
+    if (BRA_ATTR_IS_CDC(me->attributes) ? !bra_io_file_cdc_open_data(&f, filename, me) : !bra_io_file_open(&f, filename, "rb"))
+        return false;
+
+    if (!bra_io_file_chunks_compress_size(codec, &f, mef->data_size, me, comp_size))
+        return false;
+
+    bra_io_file_close(&f);
+    if (*comp_size >= mef->data_size)
+        me->attributes = BRA_ATTR_SET_COMP(me->attributes, BRA_ATTR_COMP_STORED);
+
+    return true;
+}
+
+bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t* me, const char* filename, const size_t filename_len, bra_codec_ctx_t* codec)
 {
     assert_bra_io_file_t(f);
     assert(me != NULL);
@@ -155,7 +335,12 @@ bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t*
     }
 
     // compute crc32 up to here
-    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+    const bra_meta_entry_file_t* mef       = (const bra_meta_entry_file_t*) me->entry_data;
+    const bool                   comp      = BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_COMPRESSED || BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_FAST;
+    uint64_t                     comp_size = 0;
+    if (f->stream && comp && !BRA_ATTR_IS_REF(me->attributes) && !_bra_io_file_meta_entry_stream_measure(codec, me, filename, &comp_size))
+        goto BRA_IO_FILE_META_ENTRY_FLUSH_ENTRY_FILE_ERR;
+
     if (!_bra_compute_header_crc32(filename_len, filename, me))
         goto BRA_IO_FILE_META_ENTRY_FLUSH_ENTRY_FILE_ERR;
 
@@ -171,16 +356,27 @@ bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t*
     // 3. file size
     assert(mef != NULL);
 
-    // file content
+    // a duplicate has no data: the CRC32 of its contents is added by the caller.
+    if (BRA_ATTR_IS_REF(me->attributes))
+    {
+        _bra_compute_file_entry_crc32(me);
+        return bra_io_file_meta_entry_write_file_entry(f, me);
+    }
+
+    // the content of a solid file has been read with its block already.
+    if (BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID)
+        return bra_io_file_chunks_write_solid_file(codec, f, me);
+
+    // file content, only its new blocks when they are content-defined.
     bra_io_file_t f2;
     memset(&f2, 0, sizeof(bra_io_file_t));
-    if (!bra_io_file_open(&f2, filename, "rb"))
+    if (BRA_ATTR_IS_CDC(me->attributes) ? !bra_io_file_cdc_open_data(&f2, filename, me) : !bra_io_file_open(&f2, filename, "rb"))
         goto BRA_IO_FILE_META_ENTRY_FLUSH_ENTRY_FILE_ERR;
 
     switch (BRA_ATTR_COMP(me->attributes))
     {
     case BRA_ATTR_COMP_STORED:
-        me->crc32 = bra_crc32c(&mef->data_size, sizeof(uint64_t), me->crc32);
+        _bra_compute_file_entry_crc32(me);
         if (!bra_io_file_meta_entry_write_file_entry(f, me))
             goto BRA_IO_FILE_META_ENTRY_FLUSH_ENTRY_FILE_ERROR;
 
@@ -188,7 +384,13 @@ bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t*
             return false;
         break;
     case BRA_ATTR_COMP_COMPRESSED:
-        if (!bra_io_file_chunks_compress_file(f, &f2, mef->data_size, me))
+    case BRA_ATTR_COMP_FAST:
+        if (f->stream)
+        {
+            if (!bra_io_file_chunks_compress_stream(codec, f, &f2, mef->data_size, comp_size, me))
+                return false;
+        }
+        else if (!bra_io_file_chunks_compress_file(codec, f, &f2, mef->data_size, me))
         {
             // check if it has failed do it to invalidate file compression rather than error
             if (attr_orig != me->attributes)
@@ -201,7 +403,7 @@ bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t*
                 // TODO: this is a quick fix after changed the metadata attribute
                 //       later on refactor to avoid a recursive call.
                 bra_io_file_close(&f2);
-                return bra_io_file_meta_entry_flush_entry_file(f, me, filename, filename_len);
+                return bra_io_file_meta_entry_flush_entry_file(f, me, filename, filename_len, codec);
             }
             else
                 goto BRA_IO_FILE_META_ENTRY_FLUSH_ENTRY_FILE_ERROR;
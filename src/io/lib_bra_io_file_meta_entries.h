@@ -75,10 +75,11 @@ bool bra_io_file_meta_entry_write_subdir_entry(bra_io_file_t* f, const bra_meta_
  * @param me the meta entry file.
  * @param filename the original filename with its path to be archived.
  * @param filename_len the length of @p filename (to avoid to recompute it internally)
+ * @param codec codec work buffers used to compress the file.
  * @retval true on success
  * @retval false on failure and close the file @p f via @ref bra_io_file_close
  */
-bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t* me, const char* filename, const size_t filename_len);
+bool bra_io_file_meta_entry_flush_entry_file(bra_io_file_t* f, bra_meta_entry_t* me, const char* filename, const size_t filename_len, bra_codec_ctx_t* codec);
 
 /**
  * @brief Flush the whole meta entry directory.
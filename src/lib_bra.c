@@ -22,48 +22,17 @@ _Static_assert(BRA_MAX_CHUNK_SIZE <= UINT32_MAX, "BRA_MAX_CHUNK_SIZE must fit in
 
 /////////////////////////////////////////////////////////////////////////////
 
-uint8_t*         g_buf       = NULL;
-uint8_t*         g_buf2      = NULL;
-bra_bwt_index_t* g_buf_trans = NULL;
-
 bool bra_init(void)
 {
     bra_log_init();
     bra_crc32c_use_sse42(true);
 
-    g_buf       = malloc(sizeof(uint8_t) * BRA_MAX_CHUNK_SIZE);
-    g_buf2      = malloc(sizeof(uint8_t) * BRA_MAX_CHUNK_SIZE);
-    g_buf_trans = malloc(sizeof(bra_bwt_index_t) * BRA_MAX_CHUNK_SIZE);
-    if (g_buf == NULL || g_buf2 == NULL || g_buf_trans == NULL)
-    {
-        bra_log_critical("unable to allocate global buffers");
-        bra_quit();
-        return false;
-    }
-
+    // NOTE: the codec work buffers are owned by each bra_codec_ctx_t.
     return true;
 }
 
 bool bra_quit(void)
 {
-    if (g_buf != NULL)
-    {
-        free(g_buf);
-        g_buf = NULL;
-    }
-
-    if (g_buf2 != NULL)
-    {
-        free(g_buf2);
-        g_buf2 = NULL;
-    }
-
-    if (g_buf_trans != NULL)
-    {
-        free(g_buf_trans);
-        g_buf_trans = NULL;
-    }
-
     return true;
 }
 
@@ -107,12 +76,21 @@ char bra_format_meta_attribute_types(const bra_attr_t attributes)
 
 char bra_format_meta_attribute_compression(const bra_attr_t attributes)
 {
+    if (BRA_ATTR_IS_REF(attributes))
+        return 'r';
+    if (BRA_ATTR_IS_CDC(attributes))
+        return 'd';
+
     switch (BRA_ATTR_COMP(attributes))
     {
     case BRA_ATTR_COMP_STORED:
         return 's';
     case BRA_ATTR_COMP_COMPRESSED:
         return 'c';
+    case BRA_ATTR_COMP_FAST:
+        return 'f';
+    case BRA_ATTR_COMP_SOLID:
+        return 'b';
     default:
         return '?';
     }
@@ -158,7 +136,7 @@ bool bra_meta_entry_init(bra_meta_entry_t* me, const bra_attr_t attr, const char
     switch (BRA_ATTR_TYPE(attr))
     {
     case BRA_ATTR_TYPE_FILE:
-        me->entry_data = malloc(sizeof(bra_meta_entry_file_t));
+        me->entry_data = calloc(1, sizeof(bra_meta_entry_file_t));
         if (me->entry_data == NULL)
             return false;
         break;
@@ -201,6 +179,13 @@ void bra_meta_entry_free(bra_meta_entry_t* me)
 
     if (me->entry_data != NULL)
     {
+        if (BRA_ATTR_TYPE(me->attributes) == BRA_ATTR_TYPE_FILE)
+        {
+            free(((bra_meta_entry_file_t*) me->entry_data)->ref_name);
+            free(((bra_meta_entry_file_t*) me->entry_data)->cdc_runs);
+            free(((bra_meta_entry_file_t*) me->entry_data)->cdc_base_name);
+        }
+
         free(me->entry_data);
         me->entry_data = NULL;
     }
@@ -224,6 +209,23 @@ bool bra_meta_entry_file_set(bra_meta_entry_t* me, const uint64_t data_size)
 
     bra_meta_entry_file_t* mef = me->entry_data;
     mef->data_size             = data_size;
+    mef->solid_offset          = 0;
+    mef->solid_size            = 0;
+    mef->_solid_block          = 0;
+    mef->ref_offset            = 0;
+    mef->ref_size              = 0;
+    mef->ref_name_size         = 0;
+    mef->_ref_entry            = 0;
+    mef->cdc_num_runs          = 0;
+    mef->cdc_size              = 0;
+    mef->cdc_base_name_size    = 0;
+    mef->_cdc_entry            = 0;
+    free(mef->ref_name);
+    free(mef->cdc_runs);
+    free(mef->cdc_base_name);
+    mef->ref_name      = NULL;
+    mef->cdc_runs      = NULL;
+    mef->cdc_base_name = NULL;
     return true;
 }
 
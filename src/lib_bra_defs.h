@@ -49,6 +49,7 @@
 #define BRA_NAME             "BRa"        //!< Program Default Name
 #define BRA_SFX_FILENAME     "bra.sfx"    //!< @todo: generate it through cmake conf
 #define BRA_SFX_TMP_FILE_EXT ".tmp"       //!< SFX Temporary file extension
+#define BRA_STDIO_FILENAME   "-"          //!< the archive is the standard input or output
 
 #define BRA_DIR_DELIM "/"                 //!< default paths delimiter
 
@@ -66,7 +67,17 @@
 #define BRA_ATTR_SET_COMP(x, comp) ((bra_attr_t) ((x) & ~BRA_ATTR_COMP_MASK) | BRA_ATTR_COMP(comp))    //!< set bits 2-3
 #define BRA_ATTR_COMP_STORED       (0 << 2)                                                            //!< No compression. No Chunk Header required.
 #define BRA_ATTR_COMP_COMPRESSED   (1 << 2)                                                            //!< Compressed. This must read a chunk header.
-#define BRA_ATTR_COMP_RESERVED     (2 << 2)                                                            //!< 3 bit reserved for future use (possibly compression types)
+#define BRA_ATTR_COMP_FAST         (2 << 2)                                                            //!< LZ77 compressed, for speed. This must read a fast chunk header.
+#define BRA_ATTR_COMP_SOLID        (3 << 2)                                                            //!< Part of a solid block shared with the next files. The first file of the block has the block data.
+#define BRA_ATTR_REF_MASK          ((bra_attr_t) 0x10)                                                 //!< bit 4 flags a duplicate file
+#define BRA_ATTR_IS_REF(x)         (((bra_attr_t) (x) & BRA_ATTR_REF_MASK) != 0)                       //!< bit 4
+#define BRA_ATTR_REF               (1 << 4)                                                            //!< Duplicate file, stored: no data, it refers to the first file entry with the same contents.
+#define BRA_ATTR_CDC_MASK          ((bra_attr_t) 0x20)                                                 //!< bit 5 flags a file with content-defined blocks already archived
+#define BRA_ATTR_IS_CDC(x)         (((bra_attr_t) (x) & BRA_ATTR_CDC_MASK) != 0)                       //!< bit 5
+#define BRA_ATTR_CDC               (1 << 5)                                                            //!< File made of runs of blocks: the new ones are its data, the others refer to a previous file entry data.
+#define BRA_CDC_RUN_NEW            0                                                                   //!< run of new blocks, next in the entry data.
+#define BRA_CDC_RUN_REF            1                                                                   //!< run of blocks in the data of a previous entry, or of the entry itself.
+#define BRA_CDC_RUN_BASE           2                                                                   //!< run of blocks in the data of an entry of the base archive.
 // #define BRA_ATTR_BWT_MTF_RLE      (1 << 2)
 // #define BRA_ATTR_BWT_MTD_RLE_LZ78 (2 << 2)
 
@@ -90,11 +101,49 @@
 #endif
 
 #define BRA_MAX_PATH_LENGTH      (UINT8_MAX + 1)                                  //!< capacity including trailing @c '\\0'; max on-disk name_size = UINT8_MAX (255).
-#define BRA_MAX_CHUNK_SIZE       (256 * 1024)                                     //!< Use #BRA_MAX_CHUNK_SIZE for optimal I/O performance during file transfers (256KB).
+#define BRA_CHUNK_SIZE           (256 * 1024)                                     //!< Use #BRA_CHUNK_SIZE for optimal I/O performance during file transfers (256KB).
+#define BRA_MAX_CHUNK_SIZE       (1024 * 1024)                                    //!< largest chunk of a compressed file, used by the highest compression levels (1MB).
+#define BRA_COMP_LEVEL_STORED    0                                                //!< compression level: no compression.
+#define BRA_COMP_LEVEL_FAST      1                                                //!< compression level: LZ77 only, see #BRA_ATTR_COMP_FAST.
+#define BRA_COMP_LEVEL_DEFAULT   6                                                //!< compression level: BWT pipeline with all its stages on #BRA_CHUNK_SIZE chunks.
+#define BRA_COMP_LEVEL_MAX       9                                                //!< compression level: highest ratio, the slowest.
+#define BRA_SOLID_BLOCK_SIZE     BRA_CHUNK_SIZE                                   //!< max bytes of the files sharing a solid block, compressed as a single chunk.
+#define BRA_SOLID_MAX_FILE_SIZE  (64 * 1024)                                      //!< larger files are not worth a solid block, they are compressed alone.
 #define BRA_BWT_INDEX_BYTES      3                                                //!< number of bytes used to store bra_bwt_index_t on disk, must be sufficient to represent values up to #BRA_MAX_CHUNK_SIZE
+#define BRA_BWT_ENCODE_WORK_SIZE(n) (2 * (n))                                 //!< elements of the bra_bwt_index_t work buffer to encode @p n bytes with the BWT: the sorted rotations and their groups.
+#define BRA_IO_CHUNK_PIPELINE_SHIFT     21                                                                             //!< the upper 3 bits of the on disk primary index select the chunk pipeline.
+#define BRA_IO_CHUNK_FILTERED           (1U << 20)                                                                     //!< flag of the on disk primary index: the chunk was filtered before the BWT, its filter byte follows.
+#define BRA_IO_CHUNK_PRIMARY_INDEX(x)   ((bra_bwt_index_t) (x) & (BRA_IO_CHUNK_FILTERED - 1))                          //!< BWT primary index of a chunk header primary index field.
+#define BRA_IO_CHUNK_FILTER(x)          ((uint8_t) ((bra_bwt_index_t) (x) >> 24))                                      //!< filter of a chunk header primary index field, kept above its on disk bytes.
+#define BRA_IO_CHUNK_SET_FILTER(x, f)   (((bra_bwt_index_t) (x) & ((1U << 24) - 1) & ~BRA_IO_CHUNK_FILTERED) | ((f) != BRA_FILTER_NONE ? BRA_IO_CHUNK_FILTERED | ((bra_bwt_index_t) (f) << 24) : 0))    //!< set the filter of a chunk header primary index field.
+#define BRA_IO_CHUNK_PIPELINE(x)        ((unsigned) ((bra_bwt_index_t) (x) >> BRA_IO_CHUNK_PIPELINE_SHIFT) & 7U)      //!< pipeline of a chunk header primary index field.
+#define BRA_IO_CHUNK_SET_PIPELINE(x, p) (BRA_IO_CHUNK_PRIMARY_INDEX(x) | ((bra_bwt_index_t) (p) << BRA_IO_CHUNK_PIPELINE_SHIFT))    //!< set the pipeline of a chunk header primary index field.
+#define BRA_IO_CHUNK_PIPELINE_RLE       0                                                                              //!< BWT+MTF+RLE+Huffman
+#define BRA_IO_CHUNK_PIPELINE_COMPACT   1                                                                              //!< flag: Huffman sizes as varints in the chunk header.
+#define BRA_IO_CHUNK_PIPELINE_ZRLE      2                                                                              //!< flag: zero-run stage instead of RLE.
+#define BRA_IO_CHUNK_PIPELINE_MULTI     4                                                                              //!< flag: multi-table Huffman stream, one table or more, no code lengths in the chunk header.
+#define BRA_IO_CHUNK_PIPELINE_CM        BRA_IO_CHUNK_PIPELINE_COMPACT                                                  //!< #BRA_IO_CHUNK_PIPELINE_COMPACT alone: BWT+context mixing, its sizes as varints.
 #define BRA_MAX_RLE_COUNTS       UINT8_MAX                                        //!< Maximum encoded count value (255) representing runs up to 256 bytes (count = run_length - 1).
 #define BRA_RLE_MAX_RUNS         128                                              //!< Max repeated consecutive chars
 #define BRA_RLE_MIN_RUNS         3                                                //!< Min repeated consecutive chars
 #define BRA_RLE_CTL_RUNS         -127                                             //!< Control Value to check for Run block while decoding
+#define BRA_RLE_ENCODE_BOUND(n)  ((n) + ((n) + BRA_RLE_MAX_RUNS - 1) / BRA_RLE_MAX_RUNS)    //!< worst case RLE encoded size of @p n bytes: a control byte every #BRA_RLE_MAX_RUNS literals.
+#define BRA_ZRLE_RUNA            0                                                //!< zero-run digit 1
+#define BRA_ZRLE_RUNB            1                                                //!< zero-run digit 2
+#define BRA_ZRLE_ESC             UINT8_MAX                                        //!< escape for the MTF ranks 254 and 255, followed by rank - 254
+#define BRA_LZ_MIN_MATCH         4                                                //!< shortest LZ77 match
+#define BRA_LZ_LAST_LITERALS     5                                                //!< the last bytes of an LZ77 block are always literals.
+#define BRA_LZ_ENCODE_BOUND(n)   ((n) + (n) / UINT8_MAX + 16)                     //!< worst case LZ77 encoded size of @p n bytes: all literals.
+#define BRA_FILTER_NONE          0                                                //!< no filter before the BWT.
+#define BRA_FILTER_DELTA         1                                                //!< each byte minus the one a stride before: sampled data.
+#define BRA_FILTER_X86           2                                                //!< x86 E8/E9 call and jump displacements made absolute: executables.
+#define BRA_FILTER_TRANSPOSE     3                                                //!< the bytes of fixed stride records grouped by field: binary tables.
+#define BRA_FILTER_MAX_STRIDE    16                                               //!< largest stride of the delta and transposition filters.
+#define BRA_FILTER_TYPE(f)       ((unsigned) (f) & 0x0F)                          //!< type of a filter byte, lower 4 bits.
+#define BRA_FILTER_STRIDE(f)     (((unsigned) (f) >> 4) + 1)                      //!< stride of a filter byte, upper 4 bits + 1.
+#define BRA_FILTER_SET(type, stride) ((uint8_t) ((type) | (((stride) - 1) << 4)))    //!< filter byte of @p type with @p stride.
+#define BRA_CODEC_BUF_SIZE       BRA_RLE_ENCODE_BOUND(BRA_MAX_CHUNK_SIZE)         //!< size of the codec work buffers: any stage output of a chunk fits in it, but the zero-run one.
 #define BRA_IO_CHUNK_HEADER_SIZE (BRA_BWT_INDEX_BYTES + sizeof(bra_huffman_t))    //!< Real size on disk for a chunk header
+#define BRA_IO_CHUNK_HEADER_MULTI_SIZE (BRA_BWT_INDEX_BYTES + 2 * sizeof(uint32_t))    //!< Real size on disk for a #BRA_IO_CHUNK_PIPELINE_MULTI chunk header: only the Huffman sizes.
+#define BRA_IO_VARINT_MAX_BYTES        5                                                //!< LEB128 bytes of the largest uint32_t.
 #define BRA_ALPHABET_SIZE        256                                              //!< Extended ASCII
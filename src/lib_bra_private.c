@@ -85,3 +85,48 @@ bool _bra_compute_header_crc32(const size_t filename_len, const char* filename,
 
     return true;
 }
+
+void _bra_compute_file_entry_crc32(bra_meta_entry_t* me)
+{
+    assert(me != NULL);
+    assert(me->entry_data != NULL);
+
+    const bra_meta_entry_file_t* mef = (const bra_meta_entry_file_t*) me->entry_data;
+
+    me->crc32 = bra_crc32c(&mef->data_size, sizeof(uint64_t), me->crc32);
+    if (BRA_ATTR_COMP(me->attributes) == BRA_ATTR_COMP_SOLID)
+    {
+        me->crc32 = bra_crc32c(&mef->solid_offset, sizeof(uint32_t), me->crc32);
+        me->crc32 = bra_crc32c(&mef->solid_size, sizeof(uint32_t), me->crc32);
+    }
+
+    if (BRA_ATTR_IS_REF(me->attributes))
+    {
+        me->crc32 = bra_crc32c(&mef->ref_offset, sizeof(uint64_t), me->crc32);
+        me->crc32 = bra_crc32c(&mef->ref_size, sizeof(uint64_t), me->crc32);
+        me->crc32 = bra_crc32c(&mef->ref_name_size, sizeof(uint8_t), me->crc32);
+        me->crc32 = bra_crc32c(mef->ref_name, mef->ref_name_size, me->crc32);
+    }
+
+    if (BRA_ATTR_IS_CDC(me->attributes))
+    {
+        me->crc32 = bra_crc32c(&mef->cdc_num_runs, sizeof(uint32_t), me->crc32);
+        for (uint32_t i = 0; i < mef->cdc_num_runs; ++i)
+        {
+            const bra_cdc_run_t* run = &mef->cdc_runs[i];
+            me->crc32                = bra_crc32c(&run->ref, sizeof(uint8_t), me->crc32);
+            me->crc32                = bra_crc32c(&run->size, sizeof(uint64_t), me->crc32);
+            if (run->ref != BRA_CDC_RUN_NEW)
+            {
+                me->crc32 = bra_crc32c(&run->offset, sizeof(uint64_t), me->crc32);
+                me->crc32 = bra_crc32c(&run->pos, sizeof(uint64_t), me->crc32);
+            }
+        }
+
+        if (mef->cdc_base_name_size > 0)
+        {
+            me->crc32 = bra_crc32c(&mef->cdc_base_name_size, sizeof(uint8_t), me->crc32);
+            me->crc32 = bra_crc32c(mef->cdc_base_name, mef->cdc_base_name_size, me->crc32);
+        }
+    }
+}
@@ -63,3 +63,10 @@ void _bra_print_string_max_length(const char* buf, const int buf_length, const i
  * @retval false
  */
 bool _bra_compute_header_crc32(const size_t filename_len, const char* filename, bra_meta_entry_t* me);
+
+/**
+ * @brief Update the CRC32C checksum of a file metadata entry with its entry data.
+ *
+ * @param me Pointer to the file metadata entry.
+ */
+void _bra_compute_file_entry_crc32(bra_meta_entry_t* me);
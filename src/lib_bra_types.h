@@ -62,7 +62,7 @@ typedef struct bra_huffman_t
  */
 typedef struct bra_io_chunk_header_t
 {
-    bra_bwt_index_t primary_index;    //!< BWT primary index for reconstruction of the original data
+    bra_bwt_index_t primary_index;    //!< BWT primary index for reconstruction of the original data, the upper bits select the pipeline. @see BRA_IO_CHUNK_PIPELINE
     bra_huffman_t   huffman;          //!< huffman meta data for huffman tree reconstruction.
 
 } bra_io_chunk_header_t;
@@ -74,8 +74,10 @@ typedef struct bra_io_chunk_header_t
  */
 typedef struct bra_io_file_t
 {
-    FILE* f;     //!< File Pointer representing a file on the disk.
-    char* fn;    //!< the filename of the file on disk.
+    FILE*    f;             //!< File Pointer representing a file on the disk.
+    char*    fn;            //!< the filename of the file on disk.
+    bool     stream;        //!< the standard input or output: it can only go forward.
+    uint64_t stream_pos;    //!< bytes read or written so far, when @p stream.
 } bra_io_file_t;
 
 /**
@@ -93,12 +95,50 @@ typedef struct bra_meta_entry_t
     float      _compression_ratio;    //!< private, this is only applied to file. normalized value.
 } bra_meta_entry_t;
 
+/**
+ * @brief An entry located in the archive, that can be decoded or tested independently from the other entries.
+ */
+typedef struct bra_io_file_entry_job_t
+{
+    bra_meta_entry_t me;             //!< entry metadata, @c me.crc32 is computed up to the file data. (owned)
+    char*            fn;             //!< full path of the entry; @c NULL when there is nothing to extract. (owned)
+    int64_t          data_offset;    //!< absolute offset of the file data in the archive.
+    uint32_t         read_crc32;     //!< CRC32 stored in the archive, read when the job is tested.
+} bra_io_file_entry_job_t;
+
+/**
+ * @brief A run of consecutive content-defined blocks of a #BRA_ATTR_CDC file.
+ */
+typedef struct bra_cdc_run_t
+{
+    uint8_t  ref;       //!< #BRA_CDC_RUN_NEW, #BRA_CDC_RUN_REF or #BRA_CDC_RUN_BASE.
+    uint64_t size;      //!< bytes of the run.
+    uint64_t offset;    //!< #BRA_CDC_RUN_REF: bytes from the entry with the blocks to this entry, @c 0 for this entry;
+                        //!< #BRA_CDC_RUN_BASE: absolute offset of the entry with the blocks in the base archive.
+    uint64_t pos;       //!< not #BRA_CDC_RUN_NEW: offset of the blocks in the decoded data of that entry.
+} bra_cdc_run_t;
+
 /**
  * @brief Metadata for a file entry in a BR-archive.
  */
 typedef struct bra_meta_entry_file_t
 {
-    uint64_t data_size;    //!< Archived file contents size in bytes.
+    uint64_t data_size;       //!< Archived file contents size in bytes.
+    uint32_t solid_offset;    //!< #BRA_ATTR_COMP_SOLID only: offset of the file contents in the decoded solid block.
+    uint32_t solid_size;      //!< #BRA_ATTR_COMP_SOLID only: file contents size in bytes.
+    int64_t  _solid_block;    //!< private, #BRA_ATTR_COMP_SOLID only: absolute offset of the solid block data in the archive, not stored.
+    uint64_t ref_offset;      //!< #BRA_ATTR_REF only: bytes from the entry of the first copy to this entry.
+    uint64_t ref_size;        //!< #BRA_ATTR_REF only: file contents size in bytes.
+    char*    ref_name;        //!< #BRA_ATTR_REF only: full path of the first copy.
+    uint8_t  ref_name_size;   //!< #BRA_ATTR_REF only: length of @p ref_name.
+    int64_t  _ref_entry;      //!< private, #BRA_ATTR_REF only: absolute offset of the entry of the first copy in the archive, not stored.
+
+    bra_cdc_run_t* cdc_runs;              //!< #BRA_ATTR_CDC only: the file contents as runs of blocks. (owned)
+    uint32_t       cdc_num_runs;          //!< #BRA_ATTR_CDC only: number of @p cdc_runs.
+    uint64_t       cdc_size;              //!< #BRA_ATTR_CDC only: file contents size in bytes, the sum of the runs, not stored.
+    char*          cdc_base_name;         //!< #BRA_ATTR_CDC only: base archive of the #BRA_CDC_RUN_BASE runs, relative to the directory of this archive; stored only with such runs. (owned)
+    uint8_t        cdc_base_name_size;    //!< #BRA_ATTR_CDC only: length of @p cdc_base_name.
+    int64_t        _cdc_entry;            //!< private, #BRA_ATTR_CDC only: absolute offset of this entry in the archive, the runs refer to it, not stored.
 } bra_meta_entry_file_t;
 
 /**
@@ -109,15 +149,41 @@ typedef struct bra_meta_entry_subdir_t
     uint32_t parent_index;    //!< index of the parent directory in the archive; 0 for root.
 } bra_meta_entry_subdir_t;
 
+/**
+ * @brief SHA-256 streaming state, see utils/bra_sha256.h.
+ */
+typedef struct bra_sha256_t
+{
+    uint32_t state[8];     //!< intermediate hash value
+    uint64_t length;       //!< bytes hashed so far
+    uint8_t  block[64];    //!< pending input not yet hashed
+    uint32_t used;         //!< bytes in @p block
+} bra_sha256_t;
+
+/**
+ * @brief Arena memory block (opaque, see utils/bra_arena.c).
+ */
+typedef struct bra_arena_block_t bra_arena_block_t;
+
+/**
+ * @brief Bump allocator: memory is carved from contiguous blocks and released all at once.
+ */
+typedef struct bra_arena_t
+{
+    bra_arena_block_t* head;          //!< block currently carved, older blocks are chained after it; @c NULL when empty
+    size_t             block_size;    //!< capacity in bytes of each new block
+} bra_arena_t;
+
 /**
  * @brief Directory tree node.
  */
 typedef struct bra_tree_node_t
 {
     uint32_t                index;         //!< Archive index of this directory entry
-    char*                   dirname;       //!< Directory name (owned; freed with node)
+    char*                   dirname;       //!< Directory name (stored in the tree arena)
     struct bra_tree_node_t* parent;        //!< Parent directory node; @c NULL for root
     struct bra_tree_node_t* firstChild;    //!< First child in sibling list; @c NULL if no children
+    struct bra_tree_node_t* lastChild;     //!< Last child in sibling list; @c NULL if no children
     struct bra_tree_node_t* next;          //!< Next sibling; @c NULL if last child
 } bra_tree_node_t;
 
@@ -126,10 +192,45 @@ typedef struct bra_tree_node_t
  */
 typedef struct bra_tree_dir_t
 {
-    bra_tree_node_t* root;         //!< Root directory node; @c NULL for empty tree
-    uint32_t         num_nodes;    //!< Total number of directory nodes in tree
+    bra_tree_node_t*  root;              //!< Root directory node; @c NULL for empty tree
+    uint32_t          num_nodes;         //!< Total number of directory nodes in tree
+    uint32_t          nodes_capacity;    //!< capacity of @p nodes
+    bra_tree_node_t** nodes;             //!< nodes by archive index (owned), @c nodes[0] is the root
+    bra_arena_t       arena;             //!< owns all the nodes and their dirnames
 } bra_tree_dir_t;
 
+/**
+ * @brief Context mixing model of the entropy stage (opaque, see encoders/bra_cm.c).
+ */
+typedef struct bra_cm_t bra_cm_t;
+
+/**
+ * @brief Codec work buffers, the chunk stages ping-pong between @p buf and @p buf2.
+ *        A context is used by one thread at a time; the buffers are allocated on first use.
+ */
+typedef struct bra_codec_ctx_t
+{
+    uint8_t*         buf;            //!< #BRA_CODEC_BUF_SIZE bytes: source chunk when encoding, decoded chunk when decoding.
+    uint8_t*         buf2;           //!< #BRA_CODEC_BUF_SIZE bytes: intermediate stage output.
+    bra_bwt_index_t* buf_trans;      //!< #BRA_BWT_ENCODE_WORK_SIZE(#BRA_MAX_CHUNK_SIZE) elements: BWT suffix index when encoding, inverse transformation vector when decoding.
+    uint8_t          level;          //!< compression level of the chunks encoded, #BRA_COMP_LEVEL_STORED to #BRA_COMP_LEVEL_MAX. Decoding doesn't use it.
+    uint8_t*         solid;          //!< #BRA_MAX_CHUNK_SIZE bytes: files of the solid block being encoded, or the last decoded solid block.
+    uint32_t         solid_size;     //!< bytes in @p solid.
+    int64_t          solid_block;    //!< archive offset of the solid block decoded in @p solid; @c 0 for none.
+    uint32_t         data_crc32;     //!< CRC32C of the decoded chunks data only, without their headers, or of the contents of a #BRA_ATTR_CDC file: the checksum of the duplicates.
+    bra_cm_t*        cm;             //!< context mixing model of the #BRA_IO_CHUNK_PIPELINE_CM chunks, allocated on first use.
+} bra_codec_ctx_t;
+
+/**
+ * @brief Pool of codec contexts shared by worker threads (opaque, see encoders/bra_codec_pool.cpp).
+ */
+typedef struct bra_codec_pool_t bra_codec_pool_t;
+
+/**
+ * @brief Content-defined blocks already archived, to store them once (opaque, see io/lib_bra_io_file_cdc.c).
+ */
+typedef struct bra_cdc_table_t bra_cdc_table_t;
+
 /**
  * @brief Archive File Context.
  */
@@ -140,7 +241,18 @@ typedef struct bra_io_file_ctx_t
     // uint32_t         cur_files;        //!< entries written in this session; used to reconcile header on close
     char*            last_dir;                   //!< the last encoded or decoded directory. used for files as they don't know where they belong.
     size_t           last_dir_size;              //!< length of last_dir in bytes;
+    size_t           last_dir_capacity;          //!< allocated bytes of last_dir, reused across directories.
+    char*            entry_name;                 //!< reusable buffer where the full path of a decoded file entry is composed.
+    size_t           entry_name_capacity;        //!< allocated bytes of entry_name.
     bra_tree_dir_t*  tree;                       //!< directory tree used when encoding.
-    bra_tree_node_t* last_dir_node;              //!< pointer to the node of last_dir in the tree; NULL for root.
+    bra_tree_node_t* last_dir_node;              //!< pointer to the node of last_dir in the tree; root node for the current dir.
     uint64_t         total_size_uncompressed;    //!< total uncompressed size of all files processed.
+    bra_codec_ctx_t  codec;                      //!< codec work buffers of the entries processed through this context.
+    uint32_t         solid_files;                //!< files of the solid block still to be encoded.
+    uint32_t         solid_pos;                  //!< offset in the solid block of the next file to be encoded.
+    int64_t          solid_block;                //!< archive offset of the last solid block data read; @c 0 for none.
+    const char*      ref_fn;                     //!< full path of the first copy of the duplicate file being encoded.
+    int64_t          ref_entry;                  //!< archive offset of the entry of @p ref_fn.
+    uint32_t         ref_crc32;                  //!< CRC32C of the contents of the duplicate file being encoded.
+    bra_cdc_table_t* cdc;                        //!< blocks of the files encoded; @c NULL when content-defined chunking is disabled.
 } bra_io_file_ctx_t;
@@ -85,6 +85,9 @@ std::optional<bool> BraProgram::parseArgs(const int argc, const char* const argv
         return false;
     }
 
+    // the current directory is captured once for all the input paths.
+    const bra::fs::path_sanitizer sanitizer;
+
     m_overwrite_policy = BRA_OVERWRITE_ASK;
     for (int i = 1; i < argc; ++i)
     {
@@ -129,19 +132,21 @@ std::optional<bool> BraProgram::parseArgs(const int argc, const char* const argv
             parseArgs_adjustFilename(p);
 
             // check file path
-            if (!bra::fs::try_sanitize(p))
+            if (!sanitizer.sanitize(p))
             {
                 bra_log_error("path not valid: %s", p.string().c_str());
                 return false;
             }
 
             // check if it is file or a dir
-            if (bra::fs::file_exists(p))
+            const auto info = bra::fs::file_stat(p);
+            const auto type = info ? info->type : fs::file_type::not_found;
+            if (type == fs::file_type::regular)
             {
-                if (!parseArgs_file(p))
+                if (!parseArgs_file(p, *info))
                     return false;
             }
-            else if (bra::fs::dir_exists(p))
+            else if (type == fs::file_type::directory)
             {
                 if (auto d = parseArgs_dir(p); d)
                 {
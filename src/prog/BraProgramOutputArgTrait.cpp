@@ -1,15 +1,110 @@
 #include "BraProgramOutputArgTrait.hpp"
 
+#include <io/lib_bra_io_file.h>
+#include <io/lib_bra_io_file_ctx.h>
+#include <encoders/bra_codec.h>
 #include <log/bra_log.h>
 #include <fs/bra_fs.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace fs = std::filesystem;
 
 /// \cond DO_NOT_DOCUMENT
 
+namespace
+{
+
+constexpr unsigned MAX_DEFAULT_THREADS           = 8;     //!< upper bound of the worker threads when not given.
+constexpr size_t   EXTRACT_QUEUE_JOBS_PER_THREAD = 64;    //!< located entries waiting per worker, bounds the memory.
+
+/**
+ * @brief Bounded queue of the located file entries, consumed by the extraction workers.
+ */
+class ExtractQueue
+{
+private:
+    std::mutex                          m_mutex;
+    std::condition_variable             m_cv_push;
+    std::condition_variable             m_cv_pop;
+    std::deque<bra_io_file_entry_job_t> m_jobs;
+    const size_t                        m_capacity;
+    bool                                m_closed = false;
+    bool                                m_failed = false;
+
+public:
+    explicit ExtractQueue(const size_t capacity) : m_capacity(capacity) {}
+
+    ~ExtractQueue()
+    {
+        for (auto& job : m_jobs)
+            bra_io_file_entry_job_free(&job);
+    }
+
+    /**
+     * @brief Take the ownership of @p job. It is freed when the extraction has already failed.
+     */
+    bool push(bra_io_file_entry_job_t& job)
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv_push.wait(lock, [this] { return m_failed || m_jobs.size() < m_capacity; });
+        if (m_failed)
+        {
+            bra_io_file_entry_job_free(&job);
+            return false;
+        }
+
+        m_jobs.push_back(job);
+        m_cv_pop.notify_one();
+        return true;
+    }
+
+    bool pop(bra_io_file_entry_job_t& job)
+    {
+        std::unique_lock lock(m_mutex);
+        m_cv_pop.wait(lock, [this] { return m_failed || m_closed || !m_jobs.empty(); });
+        if (m_failed || m_jobs.empty())
+            return false;
+
+        job = m_jobs.front();
+        m_jobs.pop_front();
+        m_cv_push.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        const std::lock_guard lock(m_mutex);
+        m_closed = true;
+        m_cv_pop.notify_all();
+    }
+
+    void fail()
+    {
+        const std::lock_guard lock(m_mutex);
+        m_failed = true;
+        m_cv_pop.notify_all();
+        m_cv_push.notify_all();
+    }
+
+    bool failed()
+    {
+        const std::lock_guard lock(m_mutex);
+        return m_failed;
+    }
+};
+
+}    // namespace
+
 void BraProgramOutputArgTrait::help_options() const
 {
     bra_log_printf("--output | -o : output path must be a directory relative to the current one (default: current directory).\n");
+    bra_log_printf("--threads| -j : <num> worker threads extracting or testing the files (default: 0, one per core).\n");
 }
 
 std::optional<bool> BraProgramOutputArgTrait::parseArgs_option(const int argc, const char* const argv[], int& i, const std::string& s)
@@ -24,6 +119,23 @@ std::optional<bool> BraProgramOutputArgTrait::parseArgs_option(const int argc, c
 
         m_output_path = fs::path(argv[++i]);
     }
+    else if (s == "--threads" || s == "-j")
+    {
+        if (i + 1 >= argc)
+        {
+            bra_log_error("missing argument for --threads");
+            return false;
+        }
+
+        const std::string n = argv[++i];
+        if (n.empty() || !std::all_of(n.begin(), n.end(), [](const char c) { return c >= '0' && c <= '9'; }) || n.size() > 4)
+        {
+            bra_log_error("invalid number of threads: %s", n.c_str());
+            return false;
+        }
+
+        m_num_threads = static_cast<unsigned>(std::stoul(n));
+    }
     else
     {
         return std::nullopt;
@@ -87,6 +199,24 @@ int BraProgramOutputArgTrait::run_prog()
         return 1;
     }
 
+    // the standard input can't be opened again: its entries are extracted in order, by this thread.
+    if (!m_ctx.f.stream)
+    {
+        // the workers open the archive again after changing directory.
+        m_archive_path = fs::absolute(m_ctx.f.fn, ec);
+        if (ec)
+        {
+            bra_log_error("unable to resolve %s", m_ctx.f.fn);
+            return 1;
+        }
+
+        // so does the archive: the base archive of the delta entries is relative to it.
+        const int64_t pos = bra_io_file_tell(&m_ctx.f);
+        bra_io_file_close(&m_ctx.f);
+        if (pos < 0 || !bra_io_file_open(&m_ctx.f, m_archive_path.string().c_str(), "rb") || !bra_io_file_seek(&m_ctx.f, pos, SEEK_SET))
+            return 1;
+    }
+
     fs::current_path(m_output_path, ec);
     if (ec)
     {
@@ -97,6 +227,111 @@ int BraProgramOutputArgTrait::run_prog()
     return 0;
 }
 
+unsigned BraProgramOutputArgTrait::num_threads() const
+{
+    if (m_num_threads != 0)
+        return m_num_threads;
+
+    return std::clamp(std::thread::hardware_concurrency(), 1U, MAX_DEFAULT_THREADS);
+}
+
+bool BraProgramOutputArgTrait::run_prog_extract(const uint32_t num_files)
+{
+    const unsigned num_threads = this->num_threads();
+    if (num_threads == 1 || num_files <= 1 || m_ctx.f.stream)
+    {
+        for (uint32_t i = 0; i < num_files; i++)
+        {
+            if (!bra_io_file_ctx_decode_and_write_to_disk(&m_ctx, &m_overwrite_policy))
+                return false;
+        }
+
+        return true;
+    }
+
+    ExtractQueue      queue(num_threads * EXTRACT_QUEUE_JOBS_PER_THREAD);
+    bra_codec_pool_t* pool    = bra_codec_pool_create();
+    const auto        archive = m_archive_path.string();
+    if (pool == nullptr)
+        return false;
+
+    const auto worker = [&queue, pool, &archive]() {
+        bra_io_file_t    f{};
+        bra_codec_ctx_t* codec = bra_codec_pool_acquire(pool);
+        if (codec == nullptr || !bra_io_file_open(&f, archive.c_str(), "rb"))
+        {
+            bra_codec_pool_release(pool, codec);
+            queue.fail();
+            return;
+        }
+
+        bra_io_file_entry_job_t job;
+        while (queue.pop(job))
+        {
+            const bool res = bra_io_file_entry_job_run(codec, &f, &job);
+            bra_io_file_entry_job_free(&job);
+            if (!res)
+            {
+                queue.fail();
+                break;    // f is closed on error
+            }
+        }
+
+        bra_io_file_close(&f);
+        bra_codec_pool_release(pool, codec);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (unsigned i = 0; i < num_threads; ++i)
+        threads.emplace_back(worker);
+
+    // directories are created here in archive order, before their files are queued.
+    // the deduplicated files are extracted at the end, copying their first copy once written.
+    std::vector<bra_io_file_entry_job_t> refs;
+    bool                                 res = true;
+    for (uint32_t i = 0; i < num_files && res; i++)
+    {
+        bra_io_file_entry_job_t job;
+        if (!bra_io_file_ctx_locate_entry(&m_ctx, &m_overwrite_policy, &job))
+            res = false;
+        else if (job.fn == nullptr)
+            bra_io_file_entry_job_free(&job);
+        else if (BRA_ATTR_IS_REF(job.me.attributes))
+        {
+            try
+            {
+                refs.push_back(job);
+            }
+            catch (const std::exception& e)
+            {
+                bra_log_critical("unable to defer %s: %s", job.fn, e.what());
+                bra_io_file_entry_job_free(&job);
+                res = false;
+            }
+        }
+        else
+            res = queue.push(job);
+    }
+
+    if (!res)
+        queue.fail();
+    queue.close();
+    for (auto& t : threads)
+        t.join();
+
+    bra_codec_pool_destroy(&pool);
+    res = res && !queue.failed();
+    for (auto& job : refs)
+    {
+        if (res && !bra_io_file_entry_job_run(&m_ctx.codec, &m_ctx.f, &job))
+            res = false;
+        bra_io_file_entry_job_free(&job);
+    }
+
+    return res;
+}
+
 void BraProgramOutputArgTrait::run_prog_end()
 {
     std::error_code ec;
@@ -6,21 +6,36 @@
 #include <optional>
 #include <string>
 
+#include <cstdint>
+
 /// \cond DO_NOT_DOCUMENT
 
 class BraProgramOutputArgTrait : public BraProgram
 {
 private:
     std::filesystem::path m_cur_path;
+    std::filesystem::path m_archive_path;    //!< absolute path of the open archive, for the extraction workers.
 
 protected:
     std::filesystem::path m_output_path;
+    unsigned              m_num_threads = 0;    //!< worker threads; @c 0 selects the hardware concurrency.
 
     void                help_options() const override;
     std::optional<bool> parseArgs_option(const int argc, const char* const argv[], int& i, const std::string& s) override;
     bool                validateArgs() override;
     int                 run_prog() override;
 
+    /**
+     * @brief Number of worker threads: @c m_num_threads or, when not given, the hardware concurrency.
+     */
+    unsigned num_threads() const;
+
+    /**
+     * @brief Extract the @p num_files entries of the archive open in @c m_ctx.
+     *        Directories are created in archive order, files are decoded by worker threads.
+     */
+    bool run_prog_extract(const uint32_t num_files);
+
     void run_prog_end();
 
 public:
@@ -10,11 +10,11 @@
 
 #include <filesystem>
 #include <string>
-#include <set>
 #include <algorithm>
-#include <limits>
-#include <map>
+#include <unordered_set>
+#include <vector>
 
+#include <cstdarg>
 #include <cstdint>
 #include <cstdio>
 
@@ -34,22 +34,29 @@ private:
     Bra(Bra&&)                 = delete;
     Bra& operator=(Bra&&)      = delete;
 
-    std::set<fs::path>                     m_files;
-    std::map<fs::path, std::set<fs::path>> m_tree;
-    fs::path                               m_out_filename;
-    uint32_t                               m_tot_files         = 0;
-    uint32_t                               m_written_num_files = 0;
-    int64_t                                m_header_offset     = -1;
-    bool                                   m_sfx               = false;
-    bool                                   m_recursive         = false;
-    bool                                   m_compress          = false;
-    int                                    m_progress_width    = 0;
+    bra::fs::file_table   m_files;
+    bra::fs::walk_options m_walk_options;
+    fs::path              m_out_filename;
+    fs::path              m_base;
+    string                m_base_name;
+    uint32_t              m_tot_files         = 0;
+    uint32_t              m_written_num_files = 0;
+    uint32_t              m_prev_num_files    = 0;
+    int64_t               m_header_offset     = -1;
+    bool                  m_sfx               = false;
+    bool                  m_update            = false;
+    bool                  m_recursive         = false;
+    bool                  m_solid             = false;
+    bool                  m_dedup             = false;
+    bool                  m_cdc               = false;
+    uint8_t               m_level             = BRA_COMP_LEVEL_STORED;
+    int                   m_progress_width    = 0;
 
 
 protected:
     void help_usage() const override
     {
-        bra_log_printf("  %s [-s] [-r] -o <output_file> <input_file1> [<input_file2> ...]\n", fs::path(m_argv0).filename().string().c_str());
+        bra_log_printf("  %s [-s] [-r] [-u] -o <output_file> <input_file1> [<input_file2> ...]\n", fs::path(m_argv0).filename().string().c_str());
         bra_log_printf("The <output_file> will have %s (or %s with --sfx)\n", BRA_FILE_EXT, BRA_SFX_FILE_EXT);
     };
 
@@ -57,6 +64,7 @@ protected:
     {
         bra_log_printf("  bra -o test test.txt\n");
         bra_log_printf("  bra -o test *.txt\n");
+        bra_log_printf("  bra -r -o - dir | ssh host unbra -\n");
         bra_log_printf("\n");
         bra_log_printf("<input_file>      : path to an existing file or a wildcard pattern\n");
         bra_log_printf("                    Use shell wildcards like 'dir/*' to include files from directories;\n");
@@ -67,11 +75,22 @@ protected:
     {
         bra_log_printf("--sfx        | -s : generate a self-extracting archive\n");
         bra_log_printf("--recursive  | -r : recursively scan files and directories. \n");
-        // bra_log_printf("--update     | -u : update an existing archive with missing files from input.\n");
+        bra_log_printf("--skip-symlinks   : with -r, skip symbolic links instead of archiving their targets.\n");
+        bra_log_printf("--skip-denied     : with -r, skip directories that can't be read instead of failing.\n");
+        bra_log_printf("--update     | -u : append to the existing <output_file> the input files missing from it.\n");
         // bra_log_printf("--test       | -t : test an existing archive.\n");
         bra_log_printf("--out        | -o : <output_filename> it takes the path of the output file.\n");
         bra_log_printf("                    If the extension %s is missing it will be automatically added.\n", BRA_FILE_EXT);
-        bra_log_printf("-c                : compress files (alpha version)\n");
+        bra_log_printf("                    %s writes it to the standard output, the messages go to the standard error.\n", BRA_STDIO_FILENAME);
+        bra_log_printf("-c                : compress files (alpha version), same as -%d.\n", BRA_COMP_LEVEL_DEFAULT);
+        bra_log_printf("--fast            : compress files with LZ77, faster but with a lower ratio than -c, same as -%d.\n", BRA_COMP_LEVEL_FAST);
+        bra_log_printf("-0 ... -9         : compression level: -0 store, -1 LZ77, -2 to -9 BWT with more stages and larger blocks,\n");
+        bra_log_printf("                    -9 with a context mixing coder: the highest ratio, the slowest.\n");
+        bra_log_printf("--solid           : with -2 to -9, compress the small files together in shared blocks.\n");
+        bra_log_printf("--dedup           : store the files with the same contents only once, the others refer to the first copy.\n");
+        bra_log_printf("--cdc             : split the files in content-defined blocks, storing the same blocks only once.\n");
+        bra_log_printf("--base <archive>  : as --cdc, referring also to the blocks of <archive>: only the changes from it are stored.\n");
+        bra_log_printf("                    <archive> is needed to extract, in the same relative path.\n");
     };
 
     int parseArgs_minArgc() const override { return 2; }
@@ -92,36 +111,60 @@ protected:
         }
         else if (s == "--sfx" || s == "-s")
             m_sfx = true;
+        else if (s == "--update" || s == "-u")
+            m_update = true;
         else if (s == "--recursive" || s == "-r")
         {
             m_recursive = true;
         }
+        else if (s == "--skip-symlinks")
+            m_walk_options.follow_symlinks = false;
+        else if (s == "--skip-denied")
+            m_walk_options.skip_permission_denied = true;
         else if (s == "-c")
-            m_compress = true;
+            m_level = BRA_COMP_LEVEL_DEFAULT;
+        else if (s == "--fast")
+            m_level = BRA_COMP_LEVEL_FAST;
+        else if (s.size() == 2 && s[0] == '-' && s[1] >= '0' && s[1] <= '0' + BRA_COMP_LEVEL_MAX)
+            m_level = static_cast<uint8_t>(s[1] - '0');
+        else if (s == "--solid")
+            m_solid = true;
+        else if (s == "--dedup")
+            m_dedup = true;
+        else if (s == "--cdc")
+            m_cdc = true;
+        else if (s == "--base")
+        {
+            // next arg is the base archive
+            ++i;
+            if (i >= argc)
+            {
+                bra_log_error("%s missing argument <archive>", s.c_str());
+                return false;
+            }
+
+            m_base = argv[i];
+        }
         else
             return nullopt;
 
         return true;
     }
 
-    bool parseArgs_file(const std::filesystem::path& p) override
+    bool parseArgs_file(const std::filesystem::path& p, const bra::fs::file_info& info) override
     {
-        if (!m_files.insert(p).second)
-        {
-            bra_log_warn("duplicate file given in input: %s\n", p.string().c_str());
-            return true;
-        }
-
-        return true;
+        // NOTE: duplicates are resolved once all the inputs are collected.
+        return m_files.add(p, info);
     };
 
     std::optional<bool> parseArgs_dir(const std::filesystem::path& p) override
     {
         if (m_recursive)
         {
-            if (!m_files.insert(p).second)
-                bra_log_warn("duplicate dir given in input: %s\n", p.string().c_str());
-            else if (!bra::fs::search_wildcard(p / "*", m_files, m_recursive))
+            if (!m_files.add(p, bra::fs::file_info{fs::file_type::directory, 0}))
+                return false;
+
+            if (!bra::fs::search_wildcard(p / "*", m_files, m_recursive, m_walk_options))
             {
                 bra_log_error("path not valid: %s", p.string().c_str());
 
@@ -134,7 +177,7 @@ protected:
 
     std::optional<bool> parseArgs_wildcards(const std::filesystem::path& p) override
     {
-        return bra::fs::search_wildcard(p, m_files, m_recursive);
+        return bra::fs::search_wildcard(p, m_files, m_recursive, m_walk_options);
     }
 
     bool validateArgs() override
@@ -145,13 +188,17 @@ protected:
             return false;
         }
 
-        if (!bra::fs::file_set_add_dirs(m_files))
+        // sorted in archive order once: each directory followed by its files.
+        if (!m_files.finalize())
             return false;
 
+        if (m_solid)
+            m_files.sort_by_extension();
+
 #ifndef NDEBUG
         bra_log_verbose("Detected files:");
-        for (const auto& file : m_files)
-            bra_log_verbose("- %s", file.string().c_str());
+        for (const auto& entry : m_files)
+            bra_log_verbose("- %s", entry.path.data());
 #endif
 
         // TODO: Here could also start encoding the filenames
@@ -165,6 +212,68 @@ protected:
             return false;
         }
 
+        fs::path p;
+        if (m_out_filename == BRA_STDIO_FILENAME)
+        {
+            if (!validate_stream())
+                return false;
+        }
+        else if (m_update)
+        {
+            if (!update_open())
+                return false;
+
+            p = m_out_filename;
+            if (m_files.empty())
+                return true;    // nothing to append
+        }
+        else if (!validate_output(p))
+            return false;
+
+        if (!m_base.empty() && !validate_base(p))
+            return false;
+
+        if (m_dedup && !m_files.dedup(m_walk_options.num_threads))
+            return false;
+
+        m_tot_files = static_cast<uint32_t>(m_files.size());
+        if (m_tot_files > UINT32_MAX - m_prev_num_files)
+        {
+            bra_log_error("too many entries to append: %u", m_tot_files);
+            return false;
+        }
+
+        m_progress_width = snprintf(nullptr, 0, "%u", m_tot_files);
+        if (m_progress_width < 0)
+        {
+            bra_log_critical("internal error");
+            return false;
+        }
+
+        return true;
+    };
+
+    /**
+     * @brief The archive written to the standard output is read forward only, without seeking back:
+     *        the entries referring to the previous ones and the trailing SFX footer are not possible.
+     */
+    bool validate_stream() const
+    {
+        const char* opt = m_sfx ? "--sfx" : m_update ? "--update" : m_dedup ? "--dedup" : m_cdc ? "--cdc" : !m_base.empty() ? "--base" : nullptr;
+        if (opt != nullptr)
+        {
+            bra_log_error("%s can't be used writing to the standard output", opt);
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Adjust the output filename and ask to overwrite it, @p p is the archive written.
+     */
+    bool validate_output(fs::path& p)
+    {
         // adjust input file extension
         if (m_sfx)
         {
@@ -191,7 +300,7 @@ protected:
             m_out_filename = bra::fs::filename_archive_adjust(m_out_filename);
         }
 
-        fs::path p = m_out_filename;
+        p = m_out_filename;
         if (m_sfx)
             p = p.replace_extension(BRA_SFX_FILE_EXT);
 
@@ -219,84 +328,171 @@ protected:
             }
         }
 
-// build tree from the set file list.
-#ifndef NDEBUG
-        bra_log_verbose("Building Tree from %zu files...", m_files.size());
-#endif
-
-        m_tree.clear();
-        size_t tot_files = 0;
-        if (!bra::fs::make_tree(m_files, m_tree, tot_files))
+        if (m_files.empty())
+        {
+            bra_log_error("no input entries to archive");
             return false;
+        }
 
-#ifndef NDEBUG
-        if (m_files.size() != tot_files)
-            bra_log_debug("set<->tree size mismatch: %zu <-> %zu", m_files.size(), tot_files);
-#endif
+        return true;
+    }
 
-        if (tot_files == 0)
+    /**
+     * @brief Open the existing archive to append the input files missing from it.
+     *        Its entries are skipped without reading their data, rebuilding its directory tree,
+     *        so the new entries are written after them referring to its directories.
+     */
+    bool update_open()
+    {
+        m_out_filename = m_sfx ? bra::fs::filename_sfx_adjust(m_out_filename, false) : bra::fs::filename_archive_adjust(m_out_filename);
+        if (!bra::fs::file_exists(m_out_filename))
         {
-            bra_log_error("no input entries to archive");
+            bra_log_error("archive to update not found: %s", m_out_filename.string().c_str());
             return false;
         }
-        else if (tot_files > std::numeric_limits<uint32_t>::max())
-        {
-            bra_log_critical("Too many entries to archive: %zu", tot_files);
+
+        m_files.erase(m_out_filename);
+
+        const string    out_fn = m_out_filename.generic_string();
+        bra_io_header_t bh;
+        if (!bra_io_file_ctx_append_open(&m_ctx, out_fn.c_str(), m_sfx, &bh, &m_header_offset))
             return false;
+
+        std::unordered_set<string> names;
+        names.reserve(bh.num_files);
+        for (uint32_t i = 0; i < bh.num_files; ++i)
+        {
+            const char* fn = nullptr;
+            if (!bra_io_file_ctx_skip_entry(&m_ctx, &fn))
+                return false;
+
+            names.emplace(fn);
         }
 
-        m_tot_files = static_cast<uint32_t>(tot_files);
+        // the files belong to the last directory entry before them:
+        // the directories already archived with new files are written again to switch back to them.
+        std::unordered_set<string> dirs;
+        for (const auto& e : m_files)
+        {
+            if (e.is_dir() || names.count(string(e.path)) > 0)
+                continue;
 
-#ifndef NDEBUG
-        bra_log_verbose("Built Tree : [TOT_FILES: %u]", m_tot_files);
-        for (const auto& [dir, files] : m_tree)
+            if (e.dir_len == 0 && m_ctx.last_dir_size > 0)
+            {
+                bra_log_error("%s: the top level files can't be appended after the directories of the archive", e.path.data());
+                return false;
+            }
+
+            dirs.emplace(e.dir());
+        }
+
+        m_prev_num_files = bh.num_files;
+        const size_t n   = m_files.erase_if([&names, &dirs](const bra::fs::file_entry& e) {
+            const string p(e.path);
+            return names.count(p) > 0 && (!e.is_dir() || dirs.count(p) == 0);
+        });
+        bra_log_printf("Updating: %s (%u entries, %zu inputs already in it)\n", out_fn.c_str(), m_prev_num_files, n);
+        return true;
+    }
+
+    /**
+     * @brief The base archive must be a plain archive other than @p out, its path is stored relative to @p out.
+     */
+    bool validate_base(const fs::path& out)
+    {
+        std::error_code ec;
+        if (!bra::fs::file_exists(m_base) || m_base.extension() == BRA_SFX_FILE_EXT_LIN || m_base.extension() == BRA_SFX_FILE_EXT_WIN)
         {
-            if (m_recursive)
-                bra_log_verbose("- [%s]", dir.string().c_str());
-            for (const auto& file : files)
-                bra_log_verbose("- [%s]/%s", dir.string().c_str(), file.string().c_str());
+            bra_log_error("base archive not valid: %s", m_base.string().c_str());
+            return false;
         }
-#endif
 
-        m_files.clear();
-        m_progress_width = snprintf(nullptr, 0, "%u", m_tot_files);
-        if (m_progress_width < 0)
+        if (fs::exists(out) && fs::equivalent(m_base, out, ec))
         {
-            bra_log_critical("internal error");
+            bra_log_error("base archive can't be the output file: %s", m_base.string().c_str());
+            return false;
+        }
+
+        m_base_name = fs::absolute(m_base, ec).lexically_normal().lexically_relative(fs::absolute(out, ec).lexically_normal().parent_path()).generic_string();
+        if (ec || m_base_name.empty() || m_base_name.size() > UINT8_MAX)
+        {
+            bra_log_error("base archive path not valid: %s", m_base.string().c_str());
             return false;
         }
 
         return true;
-    };
+    }
 
-    bool run_encode(const std::filesystem::path& p)
+    bool run_encode(const bra::fs::file_entry& entry, const std::vector<int64_t>& offsets)
     {
-        auto path = p;
-
         // write Progress (+1 because it is the file that is going to be written now)
         // TODO: add progress bar?
         bra_log_printf("[%*u/%u] ", m_progress_width, m_written_num_files + 1, m_tot_files);
 
-        // no need to sanitize it again, but it won't hurt neither
-        if (!bra::fs::try_sanitize(path))
-        {
-            bra_log_error("invalid path: %s", p.string().c_str());
-            return false;
-        }
+        if (entry.ref != bra::fs::file_entry::no_ref)
+            return bra_io_file_ctx_encode_ref_and_write_to_disk(&m_ctx, entry.path.data(), entry.info.size, entry.crc32, m_files[entry.ref].path.data(), offsets[entry.ref]);
 
-        const string fn = path.generic_string();
-        if (!bra_io_file_ctx_encode_and_write_to_disk(&m_ctx, fn.c_str(), m_compress))
+        // NOTE: paths are already sanitized when collected,
+        //       and type and size are the cached ones: nothing is stat'ed again.
+        const bra_attr_t type = entry.is_dir() ? BRA_ATTR_TYPE_DIR : BRA_ATTR_TYPE_FILE;
+        if (!bra_io_file_ctx_encode_and_write_to_disk(&m_ctx, entry.path.data(), type, entry.info.size, m_level))
             return false;
 
         return true;
     }
 
+    static bool is_solid_file(const bra::fs::file_entry& entry) noexcept
+    {
+        // the deduplicated files are kept out of the blocks: the references point to whole entries.
+        return !entry.is_dir() && entry.info.size > 0 && entry.info.size <= BRA_SOLID_MAX_FILE_SIZE &&
+               entry.ref == bra::fs::file_entry::no_ref && !entry.referenced;
+    }
+
+    /**
+     * @brief Start a solid block with the small files from @p first, if at least 2.
+     *        The directories in between have no data, the block ends at the first file too large.
+     */
+    bool solid_begin(bra::fs::file_table::const_iterator first)
+    {
+        std::vector<const char*> fns;
+        std::vector<uint64_t>    sizes;
+        uint64_t                 tot = 0;
+        for (auto it = first; it != m_files.end(); ++it)
+        {
+            if (it->is_dir())
+                continue;
+
+            if (!is_solid_file(*it) || tot + it->info.size > BRA_SOLID_BLOCK_SIZE)
+                break;
+
+            fns.push_back(it->path.data());
+            sizes.push_back(it->info.size);
+            tot += it->info.size;
+        }
+
+        if (fns.size() < 2)
+            return true;
+
+        return bra_io_file_ctx_solid_begin(&m_ctx, fns.data(), sizes.data(), static_cast<uint32_t>(fns.size()));
+    }
+
     int run_prog() override
     {
         string   out_fn = m_out_filename.generic_string();
         fs::path sfx_path;
 
-        if (m_sfx)
+        if (m_update)
+        {
+            if (m_tot_files == 0)
+            {
+                bra_log_printf("Nothing to append to: %s\n", out_fn.c_str());
+                return 0;
+            }
+
+            // positioned after the last entry (on the footer of a SFX archive).
+            bra_log_printf("Appending Into: %s\n", out_fn.c_str());
+        }
+        else if (m_sfx)
         {
             sfx_path = out_fn;    // here is with BRA_SFX_TMP_FILE_EXT
             sfx_path.replace_extension(BRA_SFX_FILE_EXT);
@@ -330,31 +526,37 @@ protected:
                 return 1;
         }
 
-        if (!bra_io_file_ctx_write_header(&m_ctx, static_cast<uint32_t>(m_tot_files)))
+        if (!m_update && !bra_io_file_ctx_write_header(&m_ctx, static_cast<uint32_t>(m_tot_files)))
             return 1;
 
+        if (!m_base.empty())
+        {
+            if (!bra_io_file_ctx_cdc_base(&m_ctx, m_base.string().c_str(), m_base_name.c_str()))
+                return 1;
+        }
+        else if (m_cdc && !bra_io_file_ctx_cdc_enable(&m_ctx))
+            return 1;
+
+        // start of each entry, for the deduplicated files referring to it.
+        std::vector<int64_t> offsets(m_files.size(), -1);
+
         m_written_num_files = 0;
-        for (const auto& [dir, files] : m_tree)
+        for (auto it = m_files.begin(); it != m_files.end(); ++it)
         {
-            // write dir first...
-            if (!dir.empty())
-            {
-                fs::path p = dir;
-                if (!run_encode(p))
-                    return 3;
+            if (m_solid && m_level > BRA_COMP_LEVEL_FAST && m_ctx.solid_files == 0 && is_solid_file(*it) && !solid_begin(it))
+                return 3;
 
-                ++m_written_num_files;
+            offsets[m_written_num_files] = bra_io_file_tell(&m_ctx.f);
+            if (offsets[m_written_num_files] < 0)
+            {
+                bra_io_file_error(&m_ctx.f, "tell");
+                return 2;
             }
 
-            // ...then all its files
-            for (const auto& fn_ : files)
-            {
-                fs::path p = dir / fn_;
-                if (!run_encode(p))
-                    return 3;
+            if (!run_encode(*it, offsets))
+                return 3;
 
-                ++m_written_num_files;
-            }
+            ++m_written_num_files;
         }
 
 #ifndef NDEBUG
@@ -362,7 +564,19 @@ protected:
             bra_log_warn("written entries (%u) != header count (%u)", m_written_num_files, m_tot_files);
 #endif
 
-        if (m_sfx)
+        if (m_update)
+        {
+            if (m_sfx && !bra_io_file_write_footer(&m_ctx.f, m_header_offset))
+                return 2;
+
+            // the header is updated last: until then it counts only the previous entries.
+            if (!bra_io_file_ctx_update_header(&m_ctx, m_header_offset, m_prev_num_files + m_tot_files))
+                return 2;
+
+            if (!bra_io_file_ctx_close(&m_ctx))
+                return 1;
+        }
+        else if (m_sfx)
         {
             if (!bra_io_file_write_footer(&m_ctx.f, m_header_offset))
                 return 2;
@@ -393,10 +607,26 @@ public:
 
 /////////////////////////////////////////////////////////////////////////
 
+/**
+ * @brief The standard output carries the archive: the messages go to the standard error.
+ */
+static int vprintf_stderr(const char* fmt, va_list args)
+{
+    return vfprintf(stderr, fmt, args);
+}
+
 int main(int argc, char* argv[])
 {
     Bra bra_prog;
 
+    // before the banner, the arguments are parsed after it.
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        const string s = argv[i];
+        if ((s == "--out" || s == "-o") && string(argv[i + 1]) == BRA_STDIO_FILENAME)
+            bra_log_set_message_callback(vprintf_stderr);
+    }
+
     return bra_prog.run(argc, argv);
 }
 
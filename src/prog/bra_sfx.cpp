@@ -56,7 +56,7 @@ protected:
     //     return BraProgramOutputArgTrait::parseArgs_option(argc, argv, i, s);
     // }
 
-    bool parseArgs_file([[maybe_unused]] const std::filesystem::path& p) override
+    bool parseArgs_file([[maybe_unused]] const std::filesystem::path& p, [[maybe_unused]] const bra::fs::file_info& info) override
     {
         return false;
     }
@@ -89,11 +89,8 @@ protected:
         if (ret != 0)
             return ret;
 
-        for (uint32_t i = 0; i < bh.num_files; i++)
-        {
-            if (!bra_io_file_ctx_decode_and_write_to_disk(&m_ctx, &m_overwrite_policy))
-                return 1;
-        }
+        if (!run_prog_extract(bh.num_files))
+            return 1;
 
         BraProgramOutputArgTrait::run_prog_end();
         if (!bra_io_file_ctx_close(&m_ctx))
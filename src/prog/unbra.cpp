@@ -1,6 +1,7 @@
 #include <lib_bra.h>
 #include <io/lib_bra_io_file.h>
 #include <io/lib_bra_io_file_ctx.h>
+#include <encoders/bra_codec.h>
 
 #include <log/bra_log.h>
 #include <fs/bra_fs.hpp>
@@ -11,7 +12,10 @@
 #include <filesystem>
 #include <string>
 #include <list>
+#include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include <cstdint>
 #include <cinttypes>
@@ -50,9 +54,11 @@ protected:
     virtual void help_example() const override
     {
         bra_log_printf("  unbra test.BRa\n");
+        bra_log_printf("  bra -r -o - dir | ssh host unbra -\n");
         bra_log_printf("\n");
         bra_log_printf("<input_file>[%s]          : %s archive to extract.\n", BRA_FILE_EXT, BRA_NAME);
         bra_log_printf("<input_file>%s[%s|%s] : %s self-extracting archive to extract.\n", BRA_FILE_EXT, BRA_SFX_FILE_EXT_LIN, BRA_SFX_FILE_EXT_WIN, BRA_NAME);
+        bra_log_printf("%s                         : %s archive read from the standard input, in a single pass.\n", BRA_STDIO_FILENAME, BRA_NAME);
     };
 
     virtual void help_options() const override
@@ -77,6 +83,11 @@ protected:
             m_testContent = true;
             m_listContent = true;
         }
+        else if (s == BRA_STDIO_FILENAME)
+        {
+            // archive from the standard input
+            m_bra_file = s;
+        }
         else
         {
             return BraProgramOutputArgTrait::parseArgs_option(argc, argv, i, s);
@@ -108,7 +119,7 @@ protected:
         p = path;
     };
 
-    bool parseArgs_file(const std::filesystem::path& p) override
+    bool parseArgs_file(const std::filesystem::path& p, [[maybe_unused]] const bra::fs::file_info& info) override
     {
         if (p.extension() == BRA_SFX_FILE_EXT_LIN || p.extension() == BRA_SFX_FILE_EXT_WIN)
             m_sfx = true;
@@ -126,9 +137,98 @@ protected:
             return false;
         }
 
+        // the prompts would read the archive.
+        if (m_bra_file == BRA_STDIO_FILENAME && m_overwrite_policy == BRA_OVERWRITE_ASK)
+        {
+            bra_log_warn("reading the archive from the standard input: existing files are skipped, use --yes to overwrite them.");
+            m_overwrite_policy = BRA_OVERWRITE_ALWAYS_NO;
+        }
+
         return BraProgramOutputArgTrait::validateArgs();
     }
 
+    /**
+     * @brief Verify the @p num_files entries with worker threads, then print them in archive order.
+     *        All the failing entries are reported.
+     */
+    bool run_prog_test(const uint32_t num_files)
+    {
+        std::vector<bra_io_file_entry_job_t> jobs(num_files, bra_io_file_entry_job_t{});
+        std::vector<uint8_t>                 valid(num_files, 0);
+
+        const auto free_jobs = [&jobs]() {
+            for (auto& job : jobs)
+                bra_io_file_entry_job_free(&job);
+        };
+
+        // the entries are located sequentially, only the meta data is read.
+        for (uint32_t i = 0; i < num_files; i++)
+        {
+            if (!bra_io_file_ctx_locate_entry_for_test(&m_ctx, &jobs[i]))
+            {
+                free_jobs();
+                return false;
+            }
+        }
+
+        std::atomic<uint32_t> next{0};
+        bra_codec_pool_t*     pool    = bra_codec_pool_create();
+        const string          archive = m_ctx.f.fn;
+        if (pool == nullptr)
+        {
+            free_jobs();
+            return false;
+        }
+
+        const auto worker = [&]() {
+            bra_io_file_t    f{};
+            bra_codec_ctx_t* codec = bra_codec_pool_acquire(pool);
+            for (uint32_t i = next++; i < num_files; i = next++)
+            {
+                // reopen after an error, to go on with the next entries.
+                if (codec == nullptr || (f.f == nullptr && !bra_io_file_open(&f, archive.c_str(), "rb")))
+                    continue;
+
+                valid[i] = bra_io_file_entry_job_test(codec, &f, &jobs[i]);
+            }
+
+            bra_io_file_close(&f);
+            bra_codec_pool_release(pool, codec);
+        };
+
+        std::vector<std::thread> threads;
+        const unsigned           n = std::min(num_threads(), std::max(num_files, 1U));
+        threads.reserve(n);
+        for (unsigned i = 0; i < n; ++i)
+            threads.emplace_back(worker);
+        for (auto& t : threads)
+            t.join();
+
+        bra_codec_pool_destroy(&pool);
+        for (uint32_t i = 0; i < num_files; i++)
+            bra_io_file_ctx_print_entry_job(&m_ctx, &jobs[i]);
+
+        // reported after the listing, not to interleave with it.
+        uint32_t failed = 0;
+        for (uint32_t i = 0; i < num_files; i++)
+        {
+            if (!valid[i])
+            {
+                bra_log_error("%s verification failed", jobs[i].fn);
+                ++failed;
+            }
+        }
+
+        free_jobs();
+        if (failed > 0)
+        {
+            bra_log_printf("* %u of %u entr%s failed verification.\n", failed, num_files, num_files == 1 ? "y" : "ies");
+            return false;
+        }
+
+        return true;
+    }
+
     int run_prog() override
     {
         // header
@@ -156,13 +256,22 @@ protected:
             for (int i = 0; i < BRA_PRINTF_FMT_FILENAME_MAX_LENGTH; i++)
                 bra_log_printf("-");
             bra_log_printf("|-------|--------|\n");
-            for (uint32_t i = 0; i < bh.num_files; i++)
+            if (m_testContent && num_threads() > 1 && !m_ctx.f.stream)
             {
-                if (!bra_io_file_ctx_print_meta_entry(&m_ctx, m_testContent))
+                if (!run_prog_test(bh.num_files))
                     return 2;
             }
+            else
+            {
+                for (uint32_t i = 0; i < bh.num_files; i++)
+                {
+                    if (!bra_io_file_ctx_print_meta_entry(&m_ctx, m_testContent))
+                        return 2;
+                }
+            }
 
-            auto fs_size = bra::fs::file_size(m_bra_file).value_or(0);
+            // the whole standard input has been read.
+            const uint64_t fs_size = m_ctx.f.stream ? static_cast<uint64_t>(bra_io_file_tell(&m_ctx.f)) : bra::fs::file_size(m_bra_file).value_or(0);
             bra_log_printf("\nORIGINAL SIZE: %" PRIu64 "\n", m_ctx.total_size_uncompressed);
             bra_log_printf("COMPRESSED SIZE: %" PRIu64 "\n", fs_size);
             bra_log_printf("RATIO: %.2f%%\n", fs_size == 0 ? 0.0 : ((double) fs_size / (double) m_ctx.total_size_uncompressed) * 100.0);
@@ -176,11 +285,8 @@ protected:
             if (ret != 0)
                 return ret;
 
-            for (uint32_t i = 0; i < bh.num_files; i++)
-            {
-                if (!bra_io_file_ctx_decode_and_write_to_disk(&m_ctx, &m_overwrite_policy))
-                    return 1;
-            }
+            if (!run_prog_extract(bh.num_files))
+                return 1;
 
             BraProgramOutputArgTrait::run_prog_end();
         }
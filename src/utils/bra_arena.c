@@ -0,0 +1,129 @@
+#include <utils/bra_arena.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define BRA_ARENA_ALIGN _Alignof(max_align_t)    //!< alignment of every bra_arena_alloc() result.
+
+/**
+ * @brief Contiguous memory block carved by the arena.
+ */
+struct bra_arena_block_t
+{
+    struct bra_arena_block_t*     next;        //!< previously filled block; @c NULL for the first one.
+    size_t                        capacity;    //!< usable bytes in @p data
+    size_t                        used;        //!< bytes already handed out from @p data
+    _Alignas(max_align_t) uint8_t data[];      //!< block payload
+};
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+static inline size_t _bra_arena_align_up(const size_t n, const size_t align)
+{
+    return (n + align - 1) & ~(align - 1);
+}
+
+static bra_arena_block_t* _bra_arena_block_alloc(const size_t capacity)
+{
+    bra_arena_block_t* block = malloc(sizeof(bra_arena_block_t) + capacity);
+    if (block == NULL)
+        return NULL;
+
+    block->next     = NULL;
+    block->capacity = capacity;
+    block->used     = 0;
+    return block;
+}
+
+static void* _bra_arena_alloc_aligned(bra_arena_t* arena, const size_t size, const size_t align)
+{
+    assert(arena != NULL);
+
+    if (size == 0)
+        return NULL;
+
+    bra_arena_block_t* block = arena->head;
+    if (block != NULL)
+    {
+        const size_t offs = _bra_arena_align_up(block->used, align);
+        if (offs <= block->capacity && size <= block->capacity - offs)
+        {
+            block->used = offs + size;
+            return &block->data[offs];
+        }
+    }
+
+    if (size > arena->block_size)
+    {
+        // oversized request: dedicated block chained after the current one,
+        // so the current block can still be filled.
+        block = _bra_arena_block_alloc(size);
+        if (block == NULL)
+            return NULL;
+
+        block->used = size;
+        if (arena->head == NULL)
+            arena->head = block;
+        else
+        {
+            block->next       = arena->head->next;
+            arena->head->next = block;
+        }
+
+        return block->data;
+    }
+
+    block = _bra_arena_block_alloc(arena->block_size);
+    if (block == NULL)
+        return NULL;
+
+    block->next = arena->head;
+    block->used = size;
+    arena->head = block;
+    return block->data;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
+void bra_arena_init(bra_arena_t* arena, const size_t block_size)
+{
+    assert(arena != NULL);
+
+    arena->head       = NULL;
+    arena->block_size = block_size == 0 ? BRA_ARENA_DEFAULT_BLOCK_SIZE : block_size;
+}
+
+void bra_arena_destroy(bra_arena_t* arena)
+{
+    assert(arena != NULL);
+
+    bra_arena_block_t* block = arena->head;
+    while (block != NULL)
+    {
+        bra_arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head = NULL;
+}
+
+void* bra_arena_alloc(bra_arena_t* arena, const size_t size)
+{
+    return _bra_arena_alloc_aligned(arena, size, BRA_ARENA_ALIGN);
+}
+
+char* bra_arena_strndup(bra_arena_t* arena, const char* str, const size_t len)
+{
+    assert(str != NULL);
+
+    char* s = _bra_arena_alloc_aligned(arena, len + 1, 1);
+    if (s == NULL)
+        return NULL;
+
+    memcpy(s, str, len);
+    s[len] = '\0';
+    return s;
+}
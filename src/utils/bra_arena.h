@@ -0,0 +1,58 @@
+#pragma once
+#ifndef BRA_ARENA_H
+#define BRA_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <lib_bra_types.h>
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define BRA_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)    //!< default capacity of an arena block in bytes.
+
+/**
+ * @brief Initialize an empty arena. No memory is allocated until the first request.
+ *
+ * @param arena
+ * @param block_size capacity in bytes of each new block; @c 0 selects #BRA_ARENA_DEFAULT_BLOCK_SIZE.
+ */
+void bra_arena_init(bra_arena_t* arena, const size_t block_size);
+
+/**
+ * @brief Release all the blocks owned by @p arena at once.
+ *        Every pointer obtained from the arena becomes invalid.
+ *
+ * @note Idempotent: the arena is left empty and can be reused.
+ *
+ * @param arena
+ */
+void bra_arena_destroy(bra_arena_t* arena);
+
+/**
+ * @brief Bump-allocate @p size bytes aligned for any fundamental type.
+ *        Requests bigger than the block size get a dedicated block.
+ *
+ * @param arena
+ * @param size
+ * @return void* the uninitialized memory, @c NULL on allocation failure or when @p size is 0.
+ */
+void* bra_arena_alloc(bra_arena_t* arena, const size_t size);
+
+/**
+ * @brief Copy the first @p len bytes of @p str into the arena and NUL-terminate it.
+ *
+ * @param arena
+ * @param str
+ * @param len
+ * @return char* the copy, @c NULL on allocation failure.
+ */
+char* bra_arena_strndup(bra_arena_t* arena, const char* str, const size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // BRA_ARENA_H
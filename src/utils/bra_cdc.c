@@ -0,0 +1,109 @@
+#include <utils/bra_cdc.h>
+
+#include <assert.h>
+
+// FastCDC (Xia et al. 2016) masks for 8KB blocks, the bits spread over the upper part of the hash.
+#define BRA_CDC_MASK_S 0x0003590703530000ULL    //!< 15 bits, before #BRA_CDC_AVG_SIZE: a cut is less likely.
+#define BRA_CDC_MASK_L 0x0000D90003530000ULL    //!< 11 bits, after #BRA_CDC_AVG_SIZE: a cut is more likely.
+
+// Gear table: 256 random 64 bits values (splitmix64).
+// clang-format off
+static const uint64_t g_bra_cdc_gear[256] = {
+    0xAAB3C66FA6E9553DULL, 0x9D535CA4D92E8857ULL, 0x56FC614EB3A6B284ULL, 0x6AA99103C79E3887ULL,
+    0xFBB3DF02A7A5098FULL, 0xBBD10448CB985495ULL, 0x9304FF224A7ED23AULL, 0x725750A315701BB1ULL,
+    0x0575763AA74240E7ULL, 0xBDC9CA2D542273FEULL, 0xEB3B520FD1BEDBD2ULL, 0x8E651A955B3E98D8ULL,
+    0x93787AB22F2E2833ULL, 0xF9F06CC699B52DFBULL, 0x4939AB19DE0113A8ULL, 0x0DBB7C43E9A3F549ULL,
+    0xCFEC208C458F5594ULL, 0x909C1BD0BDC520A1ULL, 0x8713D88EBEE6AE69ULL, 0xEB9912447AE73594ULL,
+    0x29E63A64318F6A6FULL, 0x86CD091624859909ULL, 0x5C54307FDF272B2DULL, 0xA9B0EAABFD6B79EEULL,
+    0x40F7E24433481C28ULL, 0xDB0826599D26BF9BULL, 0x68674969A21E4F43ULL, 0xCA94E84A58A43A1EULL,
+    0x3E3DA8CBE6E85D43ULL, 0x8FD198F5BA7B8BCCULL, 0x3FB477DC7EEC95A5ULL, 0xD2D1E7EB8CA1CADBULL,
+    0xDBA33A566F5A93A3ULL, 0xCDB8ECCB4893E61BULL, 0x12024D8E29272A8AULL, 0x09FCD2C3BC25A564ULL,
+    0x7EA8F633B3177AFEULL, 0xCCACACDAC5E48310ULL, 0x934F7DC9434217D2ULL, 0x6590BCD3A98CDBF4ULL,
+    0xFA9FAA30ABDA865FULL, 0xD4F9D0AA7452F5E3ULL, 0x28661CC0F0053F96ULL, 0x433C55942C5FB487ULL,
+    0x437CB0DD02B7E64FULL, 0x2A89CEBCE591F0A6ULL, 0xEF8C51A90F1D6EDEULL, 0x3DA7A7F0E1F44E1AULL,
+    0xEEC75877A6795AEAULL, 0xA2CF5E126FFF93B4ULL, 0x822706F711DA1C14ULL, 0x25610C65E95B7A16ULL,
+    0xCA2F652C93F7CC1BULL, 0x22A93852EB21A03FULL, 0xD055C41451A6BB1AULL, 0x2209E1A290C405D8ULL,
+    0x3E70F12516838B5DULL, 0x94B85BA9798E8512ULL, 0xC4B744193F58822CULL, 0x5A33AF3E0051C234ULL,
+    0x5581E736CB9512B3ULL, 0xD5A4494FC7B988ECULL, 0x76179DA9E40D2B74ULL, 0x4AAC4EC0BB65C0B1ULL,
+    0xA19B655280A8F068ULL, 0xAE1387C0BC789B36ULL, 0x1E32EF352B70B275ULL, 0x7EB4BD9355E236D9ULL,
+    0xE69131F5497621CAULL, 0x6E3CC9FA6EBB03FCULL, 0xCA3A7A2E7882D467ULL, 0x82B863C07DFC4C81ULL,
+    0xCBF9E2071497133AULL, 0x03AC1C8CA4DCEC23ULL, 0x6D9F4FEC3E7ECEBFULL, 0xC0017375E9E46F56ULL,
+    0xDD4E34935F12D6CAULL, 0x917715070601E633ULL, 0xA977A4F7227489D9ULL, 0x639F0BFAD78AC19CULL,
+    0x102D35FFCC466B7CULL, 0x656A598675F8BDE4ULL, 0xA800D1CB788D2A1BULL, 0xE0081211EB254EB3ULL,
+    0x797074456A9F2FB6ULL, 0x2BA1908AB9EFC02BULL, 0x6B7EF6025BCD0F4EULL, 0x1D14D6744650FB9BULL,
+    0xE522DE61C5516E54ULL, 0x58E84DBC2734809BULL, 0xCBB224E806825939ULL, 0x8D2CCFAF3EF96B51ULL,
+    0x59CB904D0E4D89B8ULL, 0xE27228023E23718BULL, 0xE2958FF6C335C6F2ULL, 0x1209F8D0DF9DE1D2ULL,
+    0x740703960156C92BULL, 0xDD8704FC6A9DB1B1ULL, 0x73787D96619D58D6ULL, 0x0B157542CB4CF3A7ULL,
+    0x5A764D58A2D7A061ULL, 0x4986D860857355D5ULL, 0x7A7CB1E361B12043ULL, 0x86F7F9A2D93F47A2ULL,
+    0x4E58812B56361CEFULL, 0x1B2B7407670D17DCULL, 0x9F1DF837099E29A1ULL, 0x622258CE1856697DULL,
+    0x47EC1BEBE402E487ULL, 0x1FA1DF3059C5E2C7ULL, 0x4ABB7BB69FF11334ULL, 0x81D0D1AB4BCE7313ULL,
+    0x1B9FCCED6D09E460ULL, 0x3236988FEB9C12EDULL, 0x05217DA358983A70ULL, 0x03B12188247DA070ULL,
+    0xC779FFF428489B4FULL, 0x9FEE3D50815965D5ULL, 0x60B64636E8F4EE04ULL, 0xD9EFB43727247935ULL,
+    0x17C4C3EDCE2A9C75ULL, 0xC69C07FB54D64E3DULL, 0x1BA39DDEA5617F87ULL, 0xCA4D1520A4003BBFULL,
+    0x388BC1E1EF8A98BDULL, 0x71055CF96024B115ULL, 0xB6994E3866147151ULL, 0x1B7F01F321972E1BULL,
+    0x8847D4A9B797E805ULL, 0x0693E20E25381D81ULL, 0x4B824158448C84DAULL, 0x56A9A4ABCBD03783ULL,
+    0x5EF78D6C53C313B4ULL, 0x88B19063F2542D6CULL, 0x8F50C59ACE9D419DULL, 0x09897D7A3AB5FF91ULL,
+    0x7FFD78837CF88A87ULL, 0x12B0ADD67FF9E93FULL, 0x93879437A10EB478ULL, 0x84946C090CE9057EULL,
+    0xE0320DD593FBF40BULL, 0xAB87CAD0F45F34B3ULL, 0x99A808C2FA660C15ULL, 0xE0FC583B939E9D90ULL,
+    0xCD938720282304A9ULL, 0xBE0FE01238D808AEULL, 0x946F4730CCF75FD2ULL, 0x52637A69953CD257ULL,
+    0x73D9903680E9F3F1ULL, 0x7B0F691ABA19DD4AULL, 0xA9077CC472286BFBULL, 0x064EBC92A355450DULL,
+    0xA6610CAAD99225FAULL, 0x56D15086282B5922ULL, 0x31BF5B78880E682EULL, 0x9B3BBB1CE685DF86ULL,
+    0x4BB5A6E862271BADULL, 0x43AD2412F51AF75EULL, 0x90F32D3144D26B02ULL, 0x66121365ABC9C6DFULL,
+    0x9A199AE314C243B5ULL, 0x9F790C11F3DE92BFULL, 0x6B77BDD6973D8C25ULL, 0x47F51E06F7D511FEULL,
+    0x7100C2300B1F4F4AULL, 0x61530E0BEB0D6EBAULL, 0x15F5A5221743D492ULL, 0xF17263BB2F51C416ULL,
+    0x41A4EEADA99B3980ULL, 0x8015AA6BA8A7E13FULL, 0x8FEAED7FAE24FE89ULL, 0x6A48F3717BCB42E0ULL,
+    0x525DB5F648B264D6ULL, 0x29998D766F173484ULL, 0xCE4F29C821FAD722ULL, 0x81AEBA76805F058FULL,
+    0x3E37569561FAA501ULL, 0x4FDF834D8670FA06ULL, 0x4895E78B88646732ULL, 0x6E0D81F6C7FED07CULL,
+    0x2E30825151047A1FULL, 0x2C0690D4906997EBULL, 0x3F07AB496054F3AFULL, 0x41BF374CF90443E4ULL,
+    0xC431927F88EA246DULL, 0xE9BE35A5B1811C37ULL, 0xF41EDBEDAEB74FFEULL, 0x7AA660DFADFB7F1AULL,
+    0x364E13B37464F0B0ULL, 0xFD900283D98A89C5ULL, 0xEF69F551C31121E5ULL, 0xD1ABAC0EC9AC4047ULL,
+    0x9D2039A4368E2433ULL, 0xCB6EA775A080109FULL, 0x23CA5A17C7479205ULL, 0x4ABF8DBD4B24380CULL,
+    0xBC73DBC6A4E1916BULL, 0x58DEC544DE23EDA5ULL, 0x790471669C27932CULL, 0xC3995A0C34C625D6ULL,
+    0xCF72964B5D5DA742ULL, 0x26B08FFB2D304708ULL, 0x214EDF496E2C0D4BULL, 0x863C47F06A2A5CCBULL,
+    0x0AF26CBED6F4341DULL, 0x114FCC49766ED5B8ULL, 0xC15C265A82EC40C8ULL, 0xAC63A2C46369B1E9ULL,
+    0x58263C19BD054DD3ULL, 0xE15D03DA16BB1EF0ULL, 0xA83CC2A0231787BEULL, 0xF8581F0265FEB786ULL,
+    0x44972B0EBFEA675EULL, 0xBDD307EE59AD004AULL, 0x5030F3AB677B4D65ULL, 0xD016DAC09A0ED08CULL,
+    0x5EC58A8DE7BB566FULL, 0xB61DCE2C7C825971ULL, 0xF8757F790B00D2ADULL, 0xDCFF580F15F2FE87ULL,
+    0x797E86BE96486029ULL, 0xAD32EC0990FFC12BULL, 0x00137D4310D4560DULL, 0x73FDF13D60C1F627ULL,
+    0xBD429174E80B1ABFULL, 0x00593C19941D2C1FULL, 0x304BC5288DEC5071ULL, 0x17DC9AB4FBCAD32FULL,
+    0x98CA2EEBDB0FCF4EULL, 0x939F40F29880FA18ULL, 0xD29A3650F89CB83DULL, 0xF62421C2D07C4E07ULL,
+    0xD5E26FFB8B1B9913ULL, 0x87A60F547BAA1B42ULL, 0x6B6D2144578F8D24ULL, 0x6AD7635DFAA787BCULL,
+    0x7B3814E1A1CEFBBDULL, 0x62D2B978630B2A7CULL, 0xEA4C406D30F70C38ULL, 0x17AF52B763FE3DCAULL,
+    0xEC92DCD97909DAA0ULL, 0x15484DA059696F33ULL, 0xA2D7782753869F29ULL, 0x555BF07EA170F122ULL,
+    0xC00AE173B046071AULL, 0xA3861C6916923137ULL, 0xC998D84DEF2FE06CULL, 0x20744AA3DC553C5DULL,
+    0xF09EF936B64A14FDULL, 0x74A007BF87013ED5ULL, 0x5A9A7FDCD6A45E14ULL, 0x568A44987CA887BCULL,
+    0xF966C6B123815123ULL, 0xA4DBC6825A2952D9ULL, 0x1DF9B5A2EC21F26DULL, 0x81A8D874C18DFB5EULL,
+};
+// clang-format on
+
+///////////////////////////////////////////////////////////////////////////////////////////
+
+size_t bra_cdc_cut(const uint8_t* buf, const size_t size)
+{
+    assert(buf != NULL || size == 0);
+
+    if (size <= BRA_CDC_MIN_SIZE)
+        return size;
+
+    const size_t n      = size < BRA_CDC_MAX_SIZE ? size : BRA_CDC_MAX_SIZE;
+    const size_t normal = n < BRA_CDC_AVG_SIZE ? n : BRA_CDC_AVG_SIZE;
+    uint64_t     h      = 0;
+    size_t       i      = BRA_CDC_MIN_SIZE;
+
+    // the bytes before the minimum size are skipped: they can't be a cut point.
+    for (; i < normal; ++i)
+    {
+        h = (h << 1) + g_bra_cdc_gear[buf[i]];
+        if ((h & BRA_CDC_MASK_S) == 0)
+            return i + 1;
+    }
+
+    for (; i < n; ++i)
+    {
+        h = (h << 1) + g_bra_cdc_gear[buf[i]];
+        if ((h & BRA_CDC_MASK_L) == 0)
+            return i + 1;
+    }
+
+    return n;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef BRA_CDC_H
+#define BRA_CDC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BRA_CDC_MIN_SIZE (2 * 1024)     //!< smallest content-defined block, but the last one of a file.
+#define BRA_CDC_AVG_SIZE (8 * 1024)     //!< expected size of a content-defined block.
+#define BRA_CDC_MAX_SIZE (64 * 1024)    //!< largest content-defined block.
+
+/**
+ * @brief Find the end of the next content-defined block of @p buf with the FastCDC Gear rolling hash.
+ *        The same contents give the same cut points, wherever they are in a file.
+ *
+ * @details Normalized chunking: a stricter mask before #BRA_CDC_AVG_SIZE and a looser one after,
+ *          so the block sizes gather around it.
+ *
+ * @param buf
+ * @param size bytes available in @p buf.
+ * @return size_t size of the block starting at @p buf: up to #BRA_CDC_MAX_SIZE,
+ *                at least #BRA_CDC_MIN_SIZE unless @p size is smaller.
+ */
+size_t bra_cdc_cut(const uint8_t* buf, const size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BRA_CDC_H */
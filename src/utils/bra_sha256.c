@@ -0,0 +1,158 @@
+#include <utils/bra_sha256.h>
+
+#include <string.h>
+#include <assert.h>
+
+#define BRA_SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))    //!< 32 bits right rotation.
+
+// FIPS 180-4, 4.2.2: the first 32 bits of the fractional parts of the cube roots of the first 64 primes.
+// clang-format off
+static const uint32_t g_bra_sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+// clang-format on
+
+///////////////////////////////////////////////////////////////////////////////////////////
+
+static void _bra_sha256_transform(uint32_t state[8], const uint8_t block[64])
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+        w[i] = (uint32_t) block[i * 4] << 24 | (uint32_t) block[i * 4 + 1] << 16 | (uint32_t) block[i * 4 + 2] << 8 | block[i * 4 + 3];
+
+    for (int i = 16; i < 64; ++i)
+    {
+        const uint32_t s0 = BRA_SHA256_ROTR(w[i - 15], 7) ^ BRA_SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = BRA_SHA256_ROTR(w[i - 2], 17) ^ BRA_SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i]              = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+    for (int i = 0; i < 64; ++i)
+    {
+        const uint32_t s1 = BRA_SHA256_ROTR(e, 6) ^ BRA_SHA256_ROTR(e, 11) ^ BRA_SHA256_ROTR(e, 25);
+        const uint32_t t1 = h + s1 + ((e & f) ^ (~e & g)) + g_bra_sha256_k[i] + w[i];
+        const uint32_t s0 = BRA_SHA256_ROTR(a, 2) ^ BRA_SHA256_ROTR(a, 13) ^ BRA_SHA256_ROTR(a, 22);
+        const uint32_t t2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+
+void bra_sha256_init(bra_sha256_t* ctx)
+{
+    assert(ctx != NULL);
+
+    // FIPS 180-4, 5.3.3
+    ctx->state[0] = 0x6A09E667;
+    ctx->state[1] = 0xBB67AE85;
+    ctx->state[2] = 0x3C6EF372;
+    ctx->state[3] = 0xA54FF53A;
+    ctx->state[4] = 0x510E527F;
+    ctx->state[5] = 0x9B05688C;
+    ctx->state[6] = 0x1F83D9AB;
+    ctx->state[7] = 0x5BE0CD19;
+    ctx->length   = 0;
+    ctx->used     = 0;
+}
+
+void bra_sha256_update(bra_sha256_t* ctx, const void* data, const size_t length)
+{
+    assert(ctx != NULL);
+    assert(data != NULL || length == 0);
+
+    const uint8_t* p = (const uint8_t*) data;
+    size_t         n = length;
+
+    ctx->length += length;
+    if (ctx->used > 0)
+    {
+        const size_t s = n < 64 - ctx->used ? n : 64 - ctx->used;
+        memcpy(&ctx->block[ctx->used], p, s);
+        ctx->used += (uint32_t) s;
+        p         += s;
+        n         -= s;
+        if (ctx->used < 64)
+            return;
+
+        _bra_sha256_transform(ctx->state, ctx->block);
+        ctx->used = 0;
+    }
+
+    // whole blocks straight from the input
+    for (; n >= 64; p += 64, n -= 64)
+        _bra_sha256_transform(ctx->state, p);
+
+    memcpy(ctx->block, p, n);
+    ctx->used = (uint32_t) n;
+}
+
+void bra_sha256_final(bra_sha256_t* ctx, uint8_t digest[BRA_SHA256_DIGEST_SIZE])
+{
+    assert(ctx != NULL);
+    assert(digest != NULL);
+
+    // 0x80, zeros and the message length in bits, big endian.
+    const uint64_t bits = ctx->length * 8;
+    ctx->block[ctx->used++] = 0x80;
+    if (ctx->used > 56)
+    {
+        memset(&ctx->block[ctx->used], 0, 64 - ctx->used);
+        _bra_sha256_transform(ctx->state, ctx->block);
+        ctx->used = 0;
+    }
+
+    memset(&ctx->block[ctx->used], 0, 56 - ctx->used);
+    for (int i = 0; i < 8; ++i)
+        ctx->block[56 + i] = (uint8_t) (bits >> (56 - i * 8));
+    _bra_sha256_transform(ctx->state, ctx->block);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        digest[i * 4]     = (uint8_t) (ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t) (ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t) (ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t) ctx->state[i];
+    }
+}
+
+void bra_sha256(const void* data, const size_t length, uint8_t digest[BRA_SHA256_DIGEST_SIZE])
+{
+    bra_sha256_t ctx;
+
+    bra_sha256_init(&ctx);
+    bra_sha256_update(&ctx, data, length);
+    bra_sha256_final(&ctx, digest);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef BRA_SHA256_H
+#define BRA_SHA256_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <lib_bra_types.h>
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BRA_SHA256_DIGEST_SIZE 32    //!< bytes of a SHA-256 digest.
+
+/**
+ * @brief Start a new SHA-256 computation.
+ *
+ * @param ctx
+ */
+void bra_sha256_init(bra_sha256_t* ctx);
+
+/**
+ * @brief Hash the next @p length bytes of the message.
+ *
+ * @param ctx
+ * @param data
+ * @param length
+ */
+void bra_sha256_update(bra_sha256_t* ctx, const void* data, const size_t length);
+
+/**
+ * @brief Pad the message and output its digest. @p ctx must be initialized again to be reused.
+ *
+ * @param ctx
+ * @param digest
+ */
+void bra_sha256_final(bra_sha256_t* ctx, uint8_t digest[BRA_SHA256_DIGEST_SIZE]);
+
+/**
+ * @brief SHA-256 digest of @p data in a single call.
+ *
+ * @param data
+ * @param length
+ * @param digest
+ */
+void bra_sha256(const void* data, const size_t length, uint8_t digest[BRA_SHA256_DIGEST_SIZE]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // BRA_SHA256_H
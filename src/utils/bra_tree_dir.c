@@ -1,5 +1,5 @@
 #include <utils/bra_tree_dir.h>
-#include <lib_bra_private.h>    // _bra_strdup
+#include <utils/bra_arena.h>
 #include <log/bra_log.h>
 #include <lib_bra_defs.h>
 
@@ -7,38 +7,17 @@
 #include <string.h>
 #include <assert.h>
 
-static uint32_t _bra_tree_node_destroy_subtree(bra_tree_node_t** node)
-{
-    if (node == NULL || *node == NULL)
-        return 0;
+#define BRA_TREE_DIR_NODES_INIT_CAPACITY 64U    //!< initial capacity of the index -> node table
 
-    uint32_t         count = 0;
-    bra_tree_node_t* child = (*node)->firstChild;
-    while (child != NULL)
-    {
-        bra_tree_node_t* next  = child->next;
-        count                 += _bra_tree_node_destroy_subtree(&child);
-        child                  = next;
-    }
-    if ((*node)->dirname != NULL)
-    {
-        free((*node)->dirname);
-        (*node)->dirname = NULL;
-    }
-    free(*node);
-    ++count;
-    *node = NULL;
-    return count;
-}
-
-static bra_tree_node_t* _bra_tree_node_alloc()
+static bra_tree_node_t* _bra_tree_node_alloc(bra_tree_dir_t* tree)
 {
-    bra_tree_node_t* node = (bra_tree_node_t*) malloc(sizeof(bra_tree_node_t));
+    bra_tree_node_t* node = (bra_tree_node_t*) bra_arena_alloc(&tree->arena, sizeof(bra_tree_node_t));
     if (node != NULL)
     {
         node->parent     = NULL;
         node->dirname    = NULL;
         node->firstChild = NULL;
+        node->lastChild  = NULL;
         node->next       = NULL;
         node->index      = 0U;
     }
@@ -46,81 +25,124 @@ static bra_tree_node_t* _bra_tree_node_alloc()
     return node;
 }
 
-static bra_tree_node_t* _bra_tree_node_parent_index_search(bra_tree_node_t* node, const uint32_t parent_index)
+/**
+ * @brief Register @p node in the index table, assigning it the next archive index.
+ */
+static bool _bra_tree_dir_nodes_push(bra_tree_dir_t* tree, bra_tree_node_t* node)
 {
-    bra_tree_node_t* res = node;
-    while (res != NULL)
+    if (tree->num_nodes == tree->nodes_capacity)
     {
-        if (res->index == parent_index)
-            return res;
-
-        if (res->firstChild != NULL)
+        if (tree->nodes_capacity > UINT32_MAX / 2U)
         {
-            bra_tree_node_t* r = _bra_tree_node_parent_index_search(res->firstChild, parent_index);
-            if (r != NULL)
-                return r;
+            bra_log_error("too many directories in tree: %u", tree->num_nodes);
+            return false;
         }
 
-        res = res->next;
+        const uint32_t    capacity = tree->nodes_capacity == 0U ? BRA_TREE_DIR_NODES_INIT_CAPACITY : tree->nodes_capacity * 2U;
+        bra_tree_node_t** nodes    = (bra_tree_node_t**) realloc(tree->nodes, capacity * sizeof(bra_tree_node_t*));
+        if (nodes == NULL)
+            return false;
+
+        tree->nodes          = nodes;
+        tree->nodes_capacity = capacity;
     }
 
-    return NULL;
+    node->index                    = tree->num_nodes;
+    tree->nodes[tree->num_nodes++] = node;
+    return true;
 }
 
-static bra_tree_node_t* _bra_tree_dir_add_child_node(bra_tree_dir_t* tree, bra_tree_node_t* parent, const char* dirname)
+/**
+ * @brief Non-destructive @c strtok on #BRA_DIR_DELIM: skip leading delimiters and return the next part of @p str.
+ *
+ * @param str
+ * @param len[out] length of the returned part.
+ * @return const char* the part (not NUL-terminated), @c NULL when there are no parts left.
+ */
+static const char* _bra_tree_dir_next_part(const char* str, size_t* len)
 {
-    if (tree == NULL || parent == NULL || dirname == NULL || dirname[0] == '\0')
-        return NULL;
+    while (*str == BRA_DIR_DELIM[0])
+        ++str;
 
-    // check if it is not already present first
-    bra_tree_node_t* sibling = parent->firstChild;
-    while (sibling != NULL)
+    const char* end = str;
+    while (*end != '\0' && *end != BRA_DIR_DELIM[0])
+        ++end;
+
+    *len = (size_t) (end - str);
+    return *len > 0 ? str : NULL;
+}
+
+static bra_tree_node_t* _bra_tree_node_find_child(const bra_tree_node_t* parent, const char* name, const size_t len)
+{
+    for (bra_tree_node_t* child = parent->firstChild; child != NULL; child = child->next)
     {
-        if (strcmp(sibling->dirname, dirname) == 0)
-            return sibling;    // already present
-        sibling = sibling->next;
+        if (strncmp(child->dirname, name, len) == 0 && child->dirname[len] == '\0')
+            return child;
     }
 
-    bra_tree_node_t* new_node = _bra_tree_node_alloc();
+    return NULL;
+}
+
+/**
+ * @brief Append a new child @p name to @p parent without checking if it is already present.
+ */
+static bra_tree_node_t* _bra_tree_dir_append_child_node(bra_tree_dir_t* tree, bra_tree_node_t* parent, const char* name, const size_t len)
+{
+    bra_tree_node_t* new_node = _bra_tree_node_alloc(tree);
     if (new_node == NULL)
         return NULL;
 
-    new_node->dirname = _bra_strdup(dirname);
+    new_node->dirname = bra_arena_strndup(&tree->arena, name, len);
     if (new_node->dirname == NULL)
-    {
-        free(new_node);
         return NULL;
-    }
+
+    if (!_bra_tree_dir_nodes_push(tree, new_node))
+        return NULL;
+
     new_node->parent = parent;
-    new_node->index  = tree->num_nodes;
-    if (parent->firstChild == NULL)
+    if (parent->lastChild == NULL)
         parent->firstChild = new_node;
     else
-    {
-        // TODO: track the tail too (lastChild for faster insertion)
-        // new_node->next     = parent->firstChild;
-        // parent->firstChild = new_node;
-        sibling = parent->firstChild;
-        while (sibling->next != NULL)
-            sibling = sibling->next;
-        sibling->next = new_node;
-    }
-    ++tree->num_nodes;
+        parent->lastChild->next = new_node;
+    parent->lastChild = new_node;
+
     return new_node;
 }
 
+static bra_tree_node_t* _bra_tree_dir_add_child_node(bra_tree_dir_t* tree, bra_tree_node_t* parent, const char* name, const size_t len)
+{
+    if (tree == NULL || parent == NULL || name == NULL || len == 0)
+        return NULL;
+
+    // check if it is not already present first
+    bra_tree_node_t* node = _bra_tree_node_find_child(parent, name, len);
+    if (node != NULL)
+        return node;
+
+    return _bra_tree_dir_append_child_node(tree, parent, name, len);
+}
+
 ////////////////////////////////////////////////////////////////////
 
 #ifndef NDEBUG
 void bra_tree_node_log_verbose(const bra_tree_node_t* node)
 {
+    const bra_tree_node_t* const stop = node != NULL ? node->parent : NULL;
+
     while (node != NULL)
     {
         bra_log_verbose("tree: [%u] %s", node->index, node->dirname);
 
-        bra_tree_node_log_verbose(node->firstChild);
+        if (node->firstChild != NULL)
+        {
+            node = node->firstChild;
+            continue;
+        }
+
+        while (node != stop && node->next == NULL)
+            node = node->parent;
 
-        node = node->next;
+        node = node != stop ? node->next : NULL;
     }
 }
 #endif
@@ -131,13 +153,19 @@ bra_tree_dir_t* bra_tree_dir_create()
     if (tree == NULL)
         return NULL;
 
-    tree->root        = _bra_tree_node_alloc();    // alloc root with './' current dir
-    tree->root->index = BRA_TREE_NODE_ROOT_INDEX;
-    tree->num_nodes   = 1U;
+    bra_arena_init(&tree->arena, 0);
+    tree->nodes          = NULL;
+    tree->nodes_capacity = 0U;
+    tree->num_nodes      = 0U;
 
-    if (tree->root == NULL)
+    tree->root = _bra_tree_node_alloc(tree);    // alloc root with './' current dir
+    if (tree->root == NULL || !_bra_tree_dir_nodes_push(tree, tree->root))
+    {
         bra_tree_dir_destroy(&tree);
+        return NULL;
+    }
 
+    assert(tree->root->index == BRA_TREE_NODE_ROOT_INDEX);
     return tree;
 }
 
@@ -146,95 +174,90 @@ void bra_tree_dir_destroy(bra_tree_dir_t** tree)
     if (tree == NULL || *tree == NULL)
         return;
 
-    const uint32_t count = _bra_tree_node_destroy_subtree(&(*tree)->root);
-    if (count != (*tree)->num_nodes)
-        bra_log_warn("tree destroy count mismatch: %u != %u", count, (*tree)->num_nodes);
-    assert(count == (*tree)->num_nodes);
+    // nodes and dirnames are all in the arena: no need to walk the tree.
+    bra_arena_destroy(&(*tree)->arena);
+    free((*tree)->nodes);
     free(*tree);
     *tree = NULL;
 }
 
+bra_tree_node_t* bra_tree_node_next(const bra_tree_node_t* node)
+{
+    if (node == NULL)
+        return NULL;
+
+    if (node->firstChild != NULL)
+        return node->firstChild;
+
+    while (node != NULL && node->next == NULL)
+        node = node->parent;
+
+    return node != NULL ? node->next : NULL;
+}
+
 bra_tree_node_t* bra_tree_dir_add(bra_tree_dir_t* tree, const char* dirname)
 {
     if (tree == NULL || dirname == NULL || dirname[0] == '\0')
         return NULL;
 
     // dirname is the dirname, not the final dir
-    // so need to be divided and inserted in the tree in chunks
-    char* parts = _bra_strdup(dirname);
-    if (parts == NULL)
-        return NULL;
-
-    char* part = strtok(parts, BRA_DIR_DELIM);
+    // so need to be divided and inserted in the tree in parts
+    size_t      len;
+    const char* part = _bra_tree_dir_next_part(dirname, &len);
     if (part == NULL)
     {
         bra_log_error("invalid dirname, can't tokenize: %s", dirname);
-        free(parts);
         return NULL;
     }
 
     // skip the root as it is current directory always
+    // and walk down the parts already in the tree
     bra_tree_node_t* parent = tree->root;
-    bra_tree_node_t* cur    = parent->firstChild;
-    while (cur != NULL)
+    bra_tree_node_t* cur;
+    while ((cur = _bra_tree_node_find_child(parent, part, len)) != NULL)
     {
-        if (strcmp(cur->dirname, part) == 0)
+        parent = cur;
+        part   = _bra_tree_dir_next_part(part + len, &len);
+        if (part == NULL)
         {
-            // already exists
-            // next token
-            part = strtok(NULL, BRA_DIR_DELIM);
-            if (part == NULL)
-            {
-                // it was already in there (actually error)
-                bra_log_error("directory %s already in tree", dirname);
-                goto BRA_TREE_DIR_ADD_NULL;
-            }
-
-            if (cur->firstChild != NULL)
-            {
-                parent = cur;
-                cur    = cur->firstChild;    // going down one level
-            }
-            else
-            {
-                parent = cur;
-                cur    = NULL;    // will exit loop and add new node as first child
-            }
-        }
-        else
-        {
-            cur = cur->next;
+            // it was already in there (actually error)
+            bra_log_error("directory %s already in tree", dirname);
+            return NULL;
         }
     }
 
-    // if it is here it wasn't found, so add it
-    assert(part != NULL && part[0] != '\0');
+    // if it is here it wasn't found, so add it with all its remaining parts
     do
     {
-        parent = _bra_tree_dir_add_child_node(tree, parent, part);
+        parent = _bra_tree_dir_append_child_node(tree, parent, part, len);
         if (parent == NULL)
-            goto BRA_TREE_DIR_ADD_NULL;
-        part = strtok(NULL, BRA_DIR_DELIM);
+            return NULL;
+        part = _bra_tree_dir_next_part(part + len, &len);
     }
     while (part != NULL);
 
-    free(parts);
     return parent;
+}
 
-BRA_TREE_DIR_ADD_NULL:
-    free(parts);
-    return NULL;
+bra_tree_node_t* bra_tree_dir_find(const bra_tree_dir_t* tree, const char* dirname)
+{
+    if (tree == NULL || dirname == NULL)
+        return NULL;
+
+    bra_tree_node_t* node = tree->root;
+    size_t           len;
+    for (const char* part = _bra_tree_dir_next_part(dirname, &len); part != NULL && node != NULL; part = _bra_tree_dir_next_part(part + len, &len))
+        node = _bra_tree_node_find_child(node, part, len);
+
+    return node;
 }
 
 bra_tree_node_t* bra_tree_dir_parent_index_search(const bra_tree_dir_t* tree, const uint32_t parent_index)
 {
-    if (tree == NULL)
+    if (tree == NULL || parent_index >= tree->num_nodes)
         return NULL;
 
-    if (parent_index == 0U)
-        return tree->root;
-
-    return _bra_tree_node_parent_index_search(tree->root, parent_index);
+    return tree->nodes[parent_index];
 }
 
 bra_tree_node_t* bra_tree_dir_insert_at_parent(bra_tree_dir_t* tree, const uint32_t parent_index, const char* dirname)
@@ -250,29 +273,25 @@ bra_tree_node_t* bra_tree_dir_insert_at_parent(bra_tree_dir_t* tree, const uint3
     }
 
     // dirname is the dirname, not the final dir
-    // so need to be divided and inserted in the tree in chunks
-    char* parts = _bra_strdup(dirname);
-    if (parts == NULL)
-        return NULL;
-    char* part = strtok(parts, BRA_DIR_DELIM);
+    // so need to be divided and inserted in the tree in parts
+    size_t      len;
+    const char* part = _bra_tree_dir_next_part(dirname, &len);
     if (part == NULL)
-        part = parts;
+    {
+        bra_log_error("invalid dirname, can't tokenize: %s", dirname);
+        return NULL;
+    }
 
     do
     {
-        parent = _bra_tree_dir_add_child_node(tree, parent, part);
+        parent = _bra_tree_dir_add_child_node(tree, parent, part, len);
         if (parent == NULL)
-            goto BRA_TREE_DIR_INSERT_AT_PARENT_NULL;
-        part = strtok(NULL, BRA_DIR_DELIM);
+            return NULL;
+        part = _bra_tree_dir_next_part(part + len, &len);
     }
     while (part != NULL);
 
-    free(parts);
     return parent;
-
-BRA_TREE_DIR_INSERT_AT_PARENT_NULL:
-    free(parts);
-    return NULL;
 }
 
 char* bra_tree_dir_reconstruct_path(const bra_tree_node_t* node)
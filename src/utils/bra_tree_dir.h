@@ -15,7 +15,7 @@ extern "C" {
 
 #ifndef NDEBUG
 /**
- * @brief Print the tree starting from @p node.
+ * @brief Print in pre-order @p node, its next siblings and all their descendants.
  *
  * @param node
  */
@@ -31,11 +31,21 @@ bra_tree_dir_t* bra_tree_dir_create(void);
 
 /**
  * @brief Destroy a directory tree.
+ *        All nodes and names are released at once with the tree arena.
  *
  * @param tree
  */
 void bra_tree_dir_destroy(bra_tree_dir_t** tree);
 
+/**
+ * @brief Next node of a non-recursive pre-order traversal of the whole tree.
+ *        Starting from the root, the nodes are visited in archive write order.
+ *
+ * @param node
+ * @return bra_tree_node_t* the next node, @c NULL when the traversal is over.
+ */
+bra_tree_node_t* bra_tree_node_next(const bra_tree_node_t* node);
+
 /**
  * @brief Add a directory to the tree.
  *
@@ -45,8 +55,18 @@ void bra_tree_dir_destroy(bra_tree_dir_t** tree);
  */
 bra_tree_node_t* bra_tree_dir_add(bra_tree_dir_t* tree, const char* dirname);
 
+/**
+ * @brief Find the node of the directory @p dirname (e.g. "dir/subdir") already in the tree.
+ *
+ * @param tree
+ * @param dirname an empty string is the root.
+ * @return bra_tree_node_t* the found node, @c NULL if not found.
+ */
+bra_tree_node_t* bra_tree_dir_find(const bra_tree_dir_t* tree, const char* dirname);
+
 /**
  * @brief Search a node by its index (0 is root) and return the node pointer.
+ *        Constant time lookup in the tree index table.
  *
  * @param tree
  * @param parent_index
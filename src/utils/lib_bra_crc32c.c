@@ -178,7 +178,7 @@ uint32_t bra_crc32c(const void* data, const uint64_t length, const uint32_t prev
     return g_bra_crc32c_f(data, length, previous_crc);
 }
 
-uint32_t bra_crc32c_combine(uint32_t crc32a, uint32_t crc32b, uint32_t len_b)
+uint32_t bra_crc32c_combine(uint32_t crc32a, uint32_t crc32b, uint64_t len_b)
 {
     if (len_b == 0)
         return crc32a;
@@ -57,7 +57,7 @@ uint32_t bra_crc32c(const void* data, const uint64_t length, const uint32_t prev
  * @param len_b  length of the input used for @p crc32b
  * @return uint32_t the combined crc32
  */
-uint32_t bra_crc32c_combine(uint32_t crc32a, uint32_t crc32b, uint32_t len_b);
+uint32_t bra_crc32c_combine(uint32_t crc32a, uint32_t crc32b, uint64_t len_b);
 
 /**
  * @brief Set the CRC32C implementation to use SSE4.2 intrinsics or not.
@@ -1,11 +1,15 @@
 #include "bra_test.hpp"
 
+#include <lib_bra.h>
+#include <io/lib_bra_io_file.h>
+#include <io/lib_bra_io_file_ctx.h>
 #include <fs/bra_fs.hpp>
 
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <cstdio>
+#include <map>
 
 
 namespace fs = std::filesystem;
@@ -52,6 +56,128 @@ bool AreFilesContentEquals(const std::filesystem::path& file1, const std::filesy
     return true;    // Files are identical
 }
 
+/**
+ * @brief Compare the tree @p in_dir with the one restored in @p out_dir.
+ *
+ * @param in_dir  the original directory, relative to the current one.
+ * @param out_dir the extraction directory, @p in_dir is restored under it.
+ * @return int 0 when all the entries are restored with the same contents.
+ */
+int compare_tree(const fs::path& in_dir, const fs::path& out_dir)
+{
+    for (const auto& entry : fs::recursive_directory_iterator(in_dir))
+    {
+        const fs::path p = out_dir / entry.path();
+        ASSERT_TRUE(fs::exists(p));
+        if (entry.is_regular_file())
+            ASSERT_TRUE(AreFilesContentEquals(entry.path(), p));
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Extract @p archive with @p jobs threads in a directory named after it, compare it with @p in_dir.
+ *
+ * @param archive the archive to extract.
+ * @param in_dir  the directory archived.
+ * @param jobs    the number of extraction threads.
+ * @return int 0 when the tree is restored.
+ */
+int extract_and_compare(const std::string& archive, const fs::path& in_dir, const std::string& jobs)
+{
+    const fs::path out_dir = fs::path(archive).stem().string() + "_j" + jobs;
+    if (fs::exists(out_dir))
+        fs::remove_all(out_dir);
+
+    ASSERT_EQ(call_system(CMD_PREFIX + "unbra -y -j " + jobs + " -o " + out_dir.string() + " " + archive), 0);
+    ASSERT_EQ(compare_tree(in_dir, out_dir), 0);
+    fs::remove_all(out_dir);
+    return 0;
+}
+
+/**
+ * @brief A log of @p num_lines numbered lines, not repeating: many content-defined blocks to share.
+ *
+ * @param num_lines
+ * @return std::string the lines, each ended by a new line.
+ */
+std::string log_lines(const int num_lines)
+{
+    std::string log;
+    for (int i = 0; i < num_lines; ++i)
+        log += "line " + std::to_string(i) + ": " + std::to_string(i * 7919 % 10007) + " event " + std::to_string(i % 13) + "\n";
+
+    return log;
+}
+
+/**
+ * @brief How a file entry is stored with --dedup, --cdc or --base.
+ */
+struct cdc_entry_t
+{
+    bool        ref = false;     //!< a #BRA_ATTR_REF entry: the same contents as a previous one.
+    bool        cdc = false;     //!< a #BRA_ATTR_CDC entry: runs of content-defined blocks.
+    uint64_t    size[3]{};       //!< bytes of its #BRA_CDC_RUN_NEW, #BRA_CDC_RUN_REF and #BRA_CDC_RUN_BASE runs.
+    std::string base_name;       //!< base archive of its #BRA_CDC_RUN_BASE runs.
+};
+
+/**
+ * @brief Read the block tables of the file entries of @p archive, without decoding their data.
+ *
+ * @param archive
+ * @param out_entries[out] the file entries by file name, the names are expected unique in @p archive.
+ * @retval true on success
+ * @retval false on error
+ */
+bool read_cdc_entries(const std::string& archive, std::map<std::string, cdc_entry_t>& out_entries)
+{
+    bra_io_file_ctx_t ctx{};
+    bra_io_header_t   bh;
+    bra_meta_entry_t  me{};
+
+    if (!bra_io_file_ctx_open(&ctx, archive.c_str(), "rb"))
+        return false;
+
+    if (!bra_io_file_ctx_read_header(&ctx, &bh))
+        goto READ_CDC_ENTRIES_ERR;
+
+    for (uint32_t i = 0; i < bh.num_files; ++i)
+    {
+        if (!bra_io_file_ctx_read_meta_entry(&ctx, &me))
+            goto READ_CDC_ENTRIES_ERR;
+
+        uint64_t ds = 0;
+        if (BRA_ATTR_TYPE(me.attributes) == BRA_ATTR_TYPE_FILE)
+        {
+            const bra_meta_entry_file_t* mef = static_cast<const bra_meta_entry_file_t*>(me.entry_data);
+            cdc_entry_t&                 e   = out_entries[me.name];
+
+            ds    = mef->data_size;
+            e.ref = BRA_ATTR_IS_REF(me.attributes);
+            e.cdc = BRA_ATTR_IS_CDC(me.attributes);
+            for (uint32_t j = 0; e.cdc && j < mef->cdc_num_runs; ++j)
+                e.size[mef->cdc_runs[j].ref] += mef->cdc_runs[j].size;
+            if (mef->cdc_base_name != nullptr)
+                e.base_name = mef->cdc_base_name;
+        }
+
+        // the data and its CRC32.
+        if (!bra_io_file_skip_data(&ctx.f, ds + sizeof(uint32_t)))
+            goto READ_CDC_ENTRIES_ERR;
+
+        bra_meta_entry_free(&me);
+    }
+
+    bra_io_file_ctx_close(&ctx);
+    return true;
+
+READ_CDC_ENTRIES_ERR:
+    bra_meta_entry_free(&me);
+    bra_io_file_ctx_close(&ctx);
+    return false;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 TEST(test_bra_help_ret_code)
@@ -308,6 +434,52 @@ TEST(test_bra_not_more_than_1_same_file)
     return 5;
 }
 
+TEST(test_bra_unbra_symlink_escape)
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string unbra    = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir   = "escape";
+    const fs::path    out_dir  = fs::temp_directory_path() / "bra_escape";
+    const std::string out_file = "escape.BRa";
+
+    // a directory outside the current one, reached through a symlink.
+    for (const auto& d : {in_dir, out_dir})
+    {
+        if (fs::exists(d))
+            fs::remove_all(d);
+    }
+    if (fs::exists(out_file))
+        fs::remove(out_file);
+
+    ASSERT_TRUE(fs::create_directories(in_dir));
+    ASSERT_TRUE(fs::create_directories(out_dir));
+    std::ofstream(out_dir / "outside.txt") << "outside";
+    std::ofstream(in_dir / "inside.txt") << "inside";
+    std::error_code ec;
+    fs::create_directory_symlink(out_dir, in_dir / "out", ec);
+    if (ec)
+    {
+        std::cout << std::format("[TEST] symlinks not supported, skipped: {}", ec.message()) << std::endl;
+        fs::remove_all(in_dir);
+        fs::remove_all(out_dir);
+        return 0;
+    }
+
+    // input
+    ASSERT_TRUE(call_system(bra + " -o " + out_file + " " + (in_dir / "out" / "outside.txt").string()) != 0);
+    ASSERT_FALSE(fs::exists(out_file));
+
+    // output
+    ASSERT_EQ(call_system(bra + " -o " + out_file + " " + (in_dir / "inside.txt").string()), 0);
+    ASSERT_TRUE(call_system(unbra + " -o " + (in_dir / "out" / "escaped").string() + " " + out_file) != 0);
+    ASSERT_FALSE(fs::exists(out_dir / "escaped"));
+
+    fs::remove_all(in_dir);
+    fs::remove_all(out_dir);
+    fs::remove(out_file);
+    return 0;
+}
+
 TEST(test_bra_unbra_all)
 {
     const std::string bra      = CMD_PREFIX + "bra -r";
@@ -397,6 +569,651 @@ int test_bra_unbra_comp_2b()
     return 0;
 }
 
+int test_bra_unbra_comp_fast()
+{
+    const std::string bra      = CMD_PREFIX + "bra --fast";
+    const std::string unbra    = CMD_PREFIX + "unbra";
+    const std::string in_file  = "fixtures/lorem.txt";
+    const std::string out_file = "lorem_fast.BRa";
+
+    if (fs::exists("fast"))
+        fs::remove_all("fast");
+
+    if (fs::exists(out_file))
+        fs::remove(out_file);
+
+    ASSERT_FALSE(fs::exists(out_file));
+
+    ASSERT_EQ(call_system(bra + " -o " + out_file + " " + in_file), 0);
+    ASSERT_TRUE(fs::exists(out_file));
+    ASSERT_TRUE(fs::file_size(out_file) < fs::file_size(in_file));
+    ASSERT_EQ(call_system(unbra + " -l " + out_file), 0);
+    ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+    ASSERT_EQ(call_system(unbra + " -y -o fast " + out_file), 0);
+    ASSERT_TRUE(fs::exists(fs::path("fast") / in_file));
+    ASSERT_EQ(fs::file_size(fs::path("fast") / in_file), fs::file_size(in_file));
+    fs::remove_all("fast");
+    fs::remove(out_file);
+
+    return 0;
+}
+
+int test_bra_unbra_comp_levels()
+{
+    const std::string unbra    = CMD_PREFIX + "unbra";
+    const std::string in_file  = "fixtures/lorem.txt";
+    const std::string out_file = "lorem_levels.BRa";
+
+    for (int level = 0; level <= BRA_COMP_LEVEL_MAX; ++level)
+    {
+        const std::string bra = CMD_PREFIX + "bra -" + std::to_string(level);
+        if (fs::exists(out_file))
+            fs::remove(out_file);
+
+        ASSERT_EQ(call_system(bra + " -o " + out_file + " " + in_file), 0);
+        ASSERT_TRUE(fs::exists(out_file));
+        if (level != BRA_COMP_LEVEL_STORED)
+            ASSERT_TRUE(fs::file_size(out_file) < fs::file_size(in_file));
+        ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+        fs::remove(out_file);
+    }
+
+    return 0;
+}
+
+int test_bra_unbra_comp_levels_size()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const fs::path    in_dir   = "levels";
+    const std::string out_file = "levels.BRa";
+
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+    ASSERT_TRUE(fs::create_directories(in_dir));
+
+    // text of random words and a CSV table, spanning several chunks of each level.
+    {
+        std::ifstream     lorem("fixtures/lorem.txt", std::ios::binary);
+        const std::string l((std::istreambuf_iterator<char>(lorem)), std::istreambuf_iterator<char>());
+        std::ofstream     text(in_dir / "text.txt", std::ios::binary);
+        std::ofstream     csv(in_dir / "table.csv", std::ios::binary);
+        uint32_t          seed = 12345;
+        text << l;
+        for (uint32_t i = 0; i < 100000; ++i)
+        {
+            seed             = seed * 1103515245U + 12345U;
+            const size_t pos = (seed >> 8) % l.size();
+            const size_t end = l.find(' ', pos);
+            text << l.substr(pos, end == std::string::npos ? std::string::npos : end - pos + 1);
+            csv << i << "," << (i * 7919U % 1000U) << ",name" << (i % 97U) << "," << (seed >> 28) << "\n";
+        }
+    }
+
+    // a higher level never gives a larger archive.
+    uintmax_t prev = UINTMAX_MAX;
+    for (int level = BRA_COMP_LEVEL_FAST; level <= BRA_COMP_LEVEL_MAX; ++level)
+    {
+        if (fs::exists(out_file))
+            fs::remove(out_file);
+
+        ASSERT_EQ(call_system(bra + " -" + std::to_string(level) + " -o " + out_file + " " + (in_dir / "*").string()), 0);
+        const uintmax_t size = fs::file_size(out_file);
+        ASSERT_TRUE(size <= prev);
+        prev = size;
+    }
+
+    fs::remove(out_file);
+    fs::remove_all(in_dir);
+    return 0;
+}
+
+int test_bra_unbra_comp_filters()
+{
+    const std::string unbra   = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir  = "filters";
+    const fs::path    out_dir = "filters_out";
+
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+    ASSERT_TRUE(fs::create_directories(in_dir));
+
+    // a table of 12 bytes records is transposed, the text is left as it is.
+    {
+        std::ofstream table(in_dir / "table.bin", std::ios::binary);
+        uint32_t      seed = 12345;
+        for (uint32_t id = 0; id < 4000; ++id)
+        {
+            seed              = seed * 1103515245U + 12345U;
+            const char flag[] = {id % 3 == 0 ? 'Y' : 'N', 0, 0, 0};
+            table.write(reinterpret_cast<const char*>(&id), sizeof(id));
+            table.write(flag, sizeof(flag));
+            table.write(reinterpret_cast<const char*>(&seed), sizeof(seed));
+        }
+
+        std::ofstream text(in_dir / "text.txt", std::ios::binary);
+        std::ifstream lorem("fixtures/lorem.txt", std::ios::binary);
+        const std::string l((std::istreambuf_iterator<char>(lorem)), std::istreambuf_iterator<char>());
+        text << l << l;
+    }
+
+    // level 4 has no filters, level 5 has them: both in a single chunk.
+    for (const char* fn : {"table.bin", "text.txt"})
+    {
+        const fs::path    in_file = in_dir / fn;
+        const std::string out_4   = std::string(fn) + ".4.BRa";
+        const std::string out_5   = std::string(fn) + ".5.BRa";
+        for (const auto& f : {out_4, out_5})
+        {
+            if (fs::exists(f))
+                fs::remove(f);
+        }
+
+        ASSERT_EQ(call_system(CMD_PREFIX + "bra -4 -o " + out_4 + " " + in_file.string()), 0);
+        ASSERT_EQ(call_system(CMD_PREFIX + "bra -5 -o " + out_5 + " " + in_file.string()), 0);
+        if (std::string(fn) == "table.bin")
+            ASSERT_TRUE(fs::file_size(out_5) < fs::file_size(out_4));
+        else
+            ASSERT_EQ(fs::file_size(out_5), fs::file_size(out_4));
+
+        if (fs::exists(out_dir))
+            fs::remove_all(out_dir);
+        ASSERT_EQ(call_system(unbra + " -o " + out_dir.string() + " " + out_5), 0);
+        ASSERT_TRUE(AreFilesContentEquals(in_file, out_dir / in_file));
+
+        fs::remove_all(out_dir);
+        fs::remove(out_4);
+        fs::remove(out_5);
+    }
+
+    // a real executable, its calls and jumps converted by the x86 filter.
+    {
+        const fs::path    exe      = fs::exists("bra.exe") ? "bra.exe" : "bra";
+        const fs::path    in_file  = in_dir / exe;
+        const std::string out_file = "exe.BRa";
+        ASSERT_TRUE(fs::copy_file(exe, in_file));
+        for (const char* level : {"-6", "-9"})
+        {
+            if (fs::exists(out_file))
+                fs::remove(out_file);
+            if (fs::exists(out_dir))
+                fs::remove_all(out_dir);
+
+            ASSERT_EQ(call_system(CMD_PREFIX + "bra " + level + " -o " + out_file + " " + in_file.string()), 0);
+            ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+            ASSERT_EQ(call_system(unbra + " -o " + out_dir.string() + " " + out_file), 0);
+            ASSERT_TRUE(AreFilesContentEquals(in_file, out_dir / in_file));
+        }
+
+        fs::remove_all(out_dir);
+        fs::remove(out_file);
+    }
+
+    fs::remove_all(in_dir);
+    return 0;
+}
+
+int test_bra_unbra_comp_solid()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string unbra    = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir   = "solid";
+    const std::string out_file = "solid.BRa";
+    const std::string out_base = "solid_c.BRa";
+
+    // small similar files, an empty one and a sub-directory in between.
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+
+    ASSERT_TRUE(fs::create_directories(in_dir / "sub"));
+    for (const char* fn : {"a.txt", "b.md", "c.txt", "sub/d.txt", "sub/e.md"})
+        fs::copy_file("fixtures/lorem.txt", in_dir / fn);
+    std::ofstream(in_dir / "empty").close();
+    std::ofstream(in_dir / "sub" / "f.txt") << "the last line of lorem.txt\n";
+
+    for (const auto& f : {out_file, out_base})
+    {
+        if (fs::exists(f))
+            fs::remove(f);
+    }
+
+    ASSERT_EQ(call_system(bra + " -c -o " + out_base + " " + in_dir.string()), 0);
+    ASSERT_EQ(call_system(bra + " -c --solid -o " + out_file + " " + in_dir.string()), 0);
+    ASSERT_TRUE(fs::exists(out_file));
+    ASSERT_TRUE(fs::file_size(out_file) < fs::file_size(out_base));
+    ASSERT_EQ(call_system(unbra + " -l " + out_file), 0);
+    ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+    ASSERT_EQ(call_system(unbra + " -t -j 4 " + out_file), 0);
+
+    // the files of a block are decoded from the first one, serial or not
+    for (const std::string j : {"1", "4"})
+        ASSERT_EQ(extract_and_compare(out_file, in_dir, j), 0);
+
+    fs::remove_all(in_dir);
+    fs::remove(out_file);
+    fs::remove(out_base);
+    return 0;
+}
+
+int test_bra_unbra_dedup()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string unbra    = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir   = "dedup";
+    const std::string out_file = "dedup.BRa";
+    const std::string out_base = "dedup_c.BRa";
+
+    // the same contents 3 times, once in a sub-directory, and a file of the same size but different.
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+
+    ASSERT_TRUE(fs::create_directories(in_dir / "sub"));
+    for (const char* fn : {"a.txt", "b.txt", "sub/c.txt"})
+        fs::copy_file("fixtures/lorem.txt", in_dir / fn);
+    std::string lorem;
+    {
+        std::ifstream f("fixtures/lorem.txt", std::ios::binary);
+        lorem.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    ASSERT_TRUE(!lorem.empty());
+    lorem.back() ^= 1;
+    std::ofstream(in_dir / "d.txt", std::ios::binary) << lorem;
+
+    for (const std::string comp : {"", " --fast", " -c", " -c --solid"})
+    {
+        for (const auto& f : {out_file, out_base})
+        {
+            if (fs::exists(f))
+                fs::remove(f);
+        }
+
+        ASSERT_EQ(call_system(bra + comp + " -o " + out_base + " " + in_dir.string()), 0);
+        ASSERT_EQ(call_system(bra + comp + " --dedup -o " + out_file + " " + in_dir.string()), 0);
+        ASSERT_TRUE(fs::exists(out_file));
+        // a solid block already shares the similar contents.
+        if (comp.find("--solid") == std::string::npos)
+            ASSERT_TRUE(fs::file_size(out_file) < fs::file_size(out_base));
+        ASSERT_EQ(call_system(unbra + " -l " + out_file), 0);
+        ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+        ASSERT_EQ(call_system(unbra + " -t -j 4 " + out_file), 0);
+
+        // the duplicates are copied from the first one extracted, serial or not
+        for (const std::string j : {"1", "4"})
+            ASSERT_EQ(extract_and_compare(out_file, in_dir, j), 0);
+    }
+
+    fs::remove_all(in_dir);
+    fs::remove(out_file);
+    fs::remove(out_base);
+    return 0;
+}
+
+int test_bra_unbra_cdc()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string unbra    = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir   = "cdc";
+    const std::string out_file = "cdc.BRa";
+    const std::string out_base = "cdc_c.BRa";
+
+    // a growing log: the same lines shifted by new ones before, in the middle and after.
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+
+    ASSERT_TRUE(fs::create_directories(in_dir / "sub"));
+    const std::string log = log_lines(4000);
+
+    std::ofstream(in_dir / "a.log", std::ios::binary) << log;
+    std::ofstream(in_dir / "b.log", std::ios::binary) << "started\n" << log.substr(0, log.size() / 2) << "restarted\n" << log.substr(log.size() / 2) << "stopped\n";
+    std::ofstream(in_dir / "sub" / "c.log", std::ios::binary) << log << log.substr(0, 50000);
+    // a duplicate of a file sharing blocks: with --dedup its first copy is a CDC entry.
+    std::ofstream(in_dir / "sub" / "d.log", std::ios::binary) << log << "extra\n";
+    ASSERT_TRUE(fs::create_directories(in_dir / "z"));
+    fs::copy_file(in_dir / "sub" / "d.log", in_dir / "z" / "e.log");
+
+    for (const std::string comp : {"", " --fast", " -c"})
+    {
+        for (const std::string mode : {" --cdc", " --cdc --dedup"})
+        {
+            for (const auto& f : {out_file, out_base})
+            {
+                if (fs::exists(f))
+                    fs::remove(f);
+            }
+
+            ASSERT_EQ(call_system(bra + comp + " -o " + out_base + " " + in_dir.string()), 0);
+            ASSERT_EQ(call_system(bra + comp + mode + " -o " + out_file + " " + in_dir.string()), 0);
+            ASSERT_TRUE(fs::exists(out_file));
+            ASSERT_TRUE(fs::file_size(out_file) < fs::file_size(out_base));
+
+            // the first log has only new blocks, the next ones mostly refer to them.
+            std::map<std::string, cdc_entry_t> entries;
+            ASSERT_TRUE(read_cdc_entries(out_file, entries));
+            ASSERT_EQ(entries.size(), 5U);
+            ASSERT_FALSE(entries["a.log"].cdc);
+            for (const char* fn : {"b.log", "c.log", "d.log"})
+            {
+                const cdc_entry_t& e = entries[fn];
+                ASSERT_TRUE(e.cdc);
+                ASSERT_TRUE(e.size[BRA_CDC_RUN_REF] > 2 * e.size[BRA_CDC_RUN_NEW]);
+                ASSERT_EQ(e.size[BRA_CDC_RUN_BASE], 0U);
+            }
+            if (mode.find("--dedup") != std::string::npos)
+                ASSERT_TRUE(entries["e.log"].ref);
+            else
+                ASSERT_TRUE(entries["e.log"].cdc && entries["e.log"].size[BRA_CDC_RUN_NEW] == 0);
+            ASSERT_EQ(call_system(unbra + " -l " + out_file), 0);
+            ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+            ASSERT_EQ(call_system(unbra + " -t -j 4 " + out_file), 0);
+
+            // the shared blocks are decoded from the previous entries, serial or not
+            for (const std::string j : {"1", "4"})
+                ASSERT_EQ(extract_and_compare(out_file, in_dir, j), 0);
+        }
+    }
+
+    fs::remove_all(in_dir);
+    fs::remove(out_file);
+    fs::remove(out_base);
+    return 0;
+}
+
+int test_bra_unbra_base()
+{
+    const std::string bra       = CMD_PREFIX + "bra -r";
+    const std::string unbra     = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir    = "base";
+    const std::string base_file = "base_full.BRa";
+    const std::string out_file  = "base_delta.BRa";
+
+    // a tree archived, then changed: a file edited, one added, the others unchanged.
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+
+    ASSERT_TRUE(fs::create_directories(in_dir / "sub"));
+    const std::string log = log_lines(4000);
+
+    std::ofstream(in_dir / "a.log", std::ios::binary) << log;
+    std::ofstream(in_dir / "sub" / "b.log", std::ios::binary) << log.substr(log.size() / 3);
+    fs::copy_file("fixtures/lorem.txt", in_dir / "lorem.txt");
+
+    for (const std::string comp : {"", " --fast", " -c"})
+    {
+        for (const auto& f : {base_file, out_file})
+        {
+            if (fs::exists(f))
+                fs::remove(f);
+        }
+
+        std::ofstream(in_dir / "a.log", std::ios::binary) << log;
+        fs::remove(in_dir / "new.txt");
+        ASSERT_EQ(call_system(bra + comp + " -o " + base_file + " " + in_dir.string()), 0);
+
+        std::ofstream(in_dir / "a.log", std::ios::binary) << log.substr(0, 60000) << "edited\n" << log.substr(60000) << "appended\n";
+        std::ofstream(in_dir / "new.txt", std::ios::binary) << "new file\n";
+        ASSERT_EQ(call_system(bra + comp + " --base " + base_file + " -o " + out_file + " " + in_dir.string()), 0);
+        ASSERT_TRUE(fs::exists(out_file));
+        ASSERT_TRUE(fs::file_size(out_file) * 4 < fs::file_size(base_file));
+
+        // the unchanged files and most of the edited one refer to the base archive, the new file can't.
+        std::map<std::string, cdc_entry_t> entries;
+        ASSERT_TRUE(read_cdc_entries(out_file, entries));
+        ASSERT_EQ(entries.size(), 4U);
+        for (const char* fn : {"a.log", "b.log", "lorem.txt"})
+        {
+            const cdc_entry_t& e = entries[fn];
+            ASSERT_TRUE(e.cdc);
+            ASSERT_EQ(e.base_name, base_file);
+            ASSERT_EQ(e.size[BRA_CDC_RUN_REF], 0U);
+            ASSERT_TRUE(e.size[BRA_CDC_RUN_BASE] > 2 * e.size[BRA_CDC_RUN_NEW]);
+        }
+        ASSERT_EQ(entries["b.log"].size[BRA_CDC_RUN_NEW], 0U);
+        ASSERT_EQ(entries["lorem.txt"].size[BRA_CDC_RUN_NEW], 0U);
+        ASSERT_EQ(entries["new.txt"].size[BRA_CDC_RUN_BASE], 0U);
+        ASSERT_EQ(call_system(unbra + " -l " + out_file), 0);
+        ASSERT_EQ(call_system(unbra + " -t " + out_file), 0);
+        ASSERT_EQ(call_system(unbra + " -t -j 4 " + out_file), 0);
+
+        // the unchanged blocks are decoded from the base archive, serial or not
+        for (const std::string j : {"1", "4"})
+            ASSERT_EQ(extract_and_compare(out_file, in_dir, j), 0);
+    }
+
+    // the delta can't be extracted without its base, nor be its own base.
+    fs::remove(base_file);
+    ASSERT_TRUE(call_system(unbra + " -t " + out_file) != 0);
+    ASSERT_TRUE(call_system(bra + " -y --base " + out_file + " -o " + out_file + " " + in_dir.string()) != 0);
+    ASSERT_TRUE(fs::exists(out_file));
+
+    fs::remove_all(in_dir);
+    fs::remove(out_file);
+    return 0;
+}
+
+int test_bra_unbra_update()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string unbra    = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir   = "upd";
+    const std::string root_fn  = "upd_root.txt";
+    const std::string root_fn2 = "upd_root2.txt";
+    const std::string out_file = "upd.BRa";
+    const std::string sfx_file = bra::fs::filename_sfx_adjust("upd_sfx", false).string();
+
+    for (const std::string comp : {"", " -c"})
+    {
+        for (const auto& f : {out_file, sfx_file, root_fn, root_fn2})
+        {
+            if (fs::exists(f))
+                fs::remove(f);
+        }
+
+        if (fs::exists(in_dir))
+            fs::remove_all(in_dir);
+
+        ASSERT_TRUE(fs::create_directories(in_dir / "sub"));
+        std::ofstream(in_dir / "a.txt", std::ios::binary) << "file a\n";
+        fs::copy_file("fixtures/lorem.txt", in_dir / "sub" / "b.txt");
+        std::ofstream(root_fn, std::ios::binary) << "root file\n";
+        ASSERT_EQ(call_system(bra + comp + " -o " + out_file + " " + root_fn + " " + in_dir.string()), 0);
+        ASSERT_EQ(call_system(bra + comp + " -s -y -o upd_sfx " + root_fn + " " + in_dir.string()), 0);
+
+        std::string prev;
+        {
+            std::ifstream f(out_file, std::ios::binary);
+            prev.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+
+        // files in the existing directories and in a new sub-directory.
+        ASSERT_TRUE(fs::create_directories(in_dir / "sub" / "new"));
+        std::ofstream(in_dir / "c.txt", std::ios::binary) << "file c\n";
+        std::ofstream(in_dir / "sub" / "d.txt", std::ios::binary) << "file d\n";
+        fs::copy_file("fixtures/lorem.txt", in_dir / "sub" / "new" / "e.txt");
+        std::ofstream(root_fn2, std::ios::binary) << "root file 2\n";
+
+        for (const auto& f : {out_file, sfx_file})
+        {
+            const std::string sfx = f == sfx_file ? " -s" : "";
+            const std::string out = f == sfx_file ? "upd_sfx" : f;
+
+            ASSERT_EQ(call_system(bra + comp + sfx + " -u -o " + out + " " + root_fn + " " + in_dir.string()), 0);
+            ASSERT_EQ(call_system(unbra + " -l " + f), 0);
+            ASSERT_EQ(call_system(unbra + " -t " + f), 0);
+            ASSERT_EQ(call_system(unbra + " -t -j 4 " + f), 0);
+
+            // nothing left to append, and no top level files after the directories.
+            const auto size = fs::file_size(f);
+            ASSERT_EQ(call_system(bra + comp + sfx + " -u -o " + out + " " + root_fn + " " + in_dir.string()), 0);
+            ASSERT_EQ(fs::file_size(f), size);
+            ASSERT_TRUE(call_system(bra + comp + sfx + " -u -o " + out + " " + root_fn2) != 0);
+            ASSERT_EQ(fs::file_size(f), size);
+
+            const fs::path out_dir = "upd_out";
+            if (fs::exists(out_dir))
+                fs::remove_all(out_dir);
+
+            ASSERT_EQ(call_system(unbra + " -o " + out_dir.string() + " " + f), 0);
+            ASSERT_TRUE(AreFilesContentEquals(root_fn, out_dir / root_fn));
+            ASSERT_EQ(compare_tree(in_dir, out_dir), 0);
+
+            fs::remove_all(out_dir);
+        }
+
+        // the previous entries are not rewritten: only the number of files in the header.
+        std::string cur;
+        {
+            std::ifstream f(out_file, std::ios::binary);
+            cur.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+
+        ASSERT_TRUE(cur.size() > prev.size());
+        ASSERT_TRUE(cur.compare(0, 4, prev, 0, 4) == 0);
+        ASSERT_TRUE(cur.compare(8, prev.size() - 8, prev, 8) == 0);
+    }
+
+    // the archive to update must exist.
+    fs::remove(out_file);
+    ASSERT_TRUE(call_system(bra + " -u -o " + out_file + " " + in_dir.string()) != 0);
+    ASSERT_FALSE(fs::exists(out_file));
+
+    fs::remove_all(in_dir);
+    fs::remove(root_fn);
+    fs::remove(root_fn2);
+    fs::remove(sfx_file);
+    return 0;
+}
+
+int test_bra_unbra_stream()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string unbra    = CMD_PREFIX + "unbra -y";
+    const fs::path    in_dir   = "strm";
+    const fs::path    out_dir  = "strm_out";
+    const std::string out_file = "strm.BRa";
+    const std::string stream   = "strm_stream.BRa";
+
+    if (fs::exists(in_dir))
+        fs::remove_all(in_dir);
+
+    ASSERT_TRUE(fs::create_directories(in_dir / "sub"));
+    std::ofstream(in_dir / "a.txt", std::ios::binary) << "file a\n";
+    std::ofstream(in_dir / "empty.txt", std::ios::binary);
+    fs::copy_file("fixtures/lorem.txt", in_dir / "sub" / "b.txt");
+    fs::copy_file("fixtures/lorem.txt", in_dir / "sub" / "c.txt");
+    {
+        // not compressible: stored, without seeking back.
+        std::ofstream f(in_dir / "sub" / "rand.bin", std::ios::binary);
+        uint32_t      x = 12345;
+        for (int i = 0; i < 100000; ++i)
+        {
+            x = x * 1664525U + 1013904223U;
+            f.put(static_cast<char>(x >> 24));
+        }
+    }
+
+    for (const std::string comp : {"", " --fast", " -c", " -c --solid"})
+    {
+        for (const auto& f : {out_file, stream})
+        {
+            if (fs::exists(f))
+                fs::remove(f);
+        }
+
+        // the same archive as written to a file.
+        ASSERT_EQ(call_system(bra + comp + " -o " + out_file + " " + in_dir.string()), 0);
+        ASSERT_EQ(call_system(bra + comp + " -o - " + in_dir.string() + " > " + stream), 0);
+        ASSERT_TRUE(AreFilesContentEquals(out_file, stream));
+
+        ASSERT_EQ(call_system(unbra + " -l - < " + stream), 0);
+        ASSERT_EQ(call_system(unbra + " -t - < " + stream), 0);
+        ASSERT_EQ(call_system(unbra + " -t -j 4 - < " + stream), 0);
+
+        if (fs::exists(out_dir))
+            fs::remove_all(out_dir);
+
+        ASSERT_EQ(call_system(bra + comp + " -o - " + in_dir.string() + " | " + unbra + " -o " + out_dir.string() + " -"), 0);
+        ASSERT_EQ(compare_tree(in_dir, out_dir), 0);
+
+        // the existing files are skipped, the first one of a solid block too: its next ones are still extracted.
+        for (const auto& entry : fs::recursive_directory_iterator(in_dir))
+        {
+            if (!entry.is_regular_file())
+                continue;
+
+            const fs::path p = out_dir / entry.path();
+            fs::remove(p);
+            ASSERT_EQ(call_system(CMD_PREFIX + "unbra -o " + out_dir.string() + " - < " + stream), 0);
+            ASSERT_TRUE(AreFilesContentEquals(entry.path(), p));
+        }
+
+        fs::remove_all(out_dir);
+    }
+
+    // the options needing to seek back.
+    for (const std::string& opt : {std::string(" -s"), std::string(" -u"), std::string(" --dedup"), std::string(" --cdc"), " --base " + out_file})
+        ASSERT_TRUE(call_system(bra + opt + " -o - " + in_dir.string() + " > " + stream) != 0);
+
+    fs::remove_all(in_dir);
+    fs::remove(out_file);
+    fs::remove(stream);
+    return 0;
+}
+
+int test_bra_unbra_threads()
+{
+    const std::string bra      = CMD_PREFIX + "bra -r";
+    const std::string in_file  = "dir1/*";
+    const std::string out_file = "dir1_j.BRa";
+
+    for (const std::string comp : {"", " -c"})
+    {
+        if (fs::exists(out_file))
+            fs::remove(out_file);
+
+        ASSERT_EQ(call_system(bra + comp + " -o " + out_file + " " + in_file), 0);
+        ASSERT_TRUE(fs::exists(out_file));
+
+        // serial and parallel extraction must restore the same tree
+        for (const std::string j : {"1", "4"})
+            ASSERT_EQ(extract_and_compare(out_file, "dir1", j), 0);
+    }
+
+    fs::remove(out_file);
+    return 0;
+}
+
+int test_bra_unbra_test_threads()
+{
+    const std::string bra      = CMD_PREFIX + "bra";
+    const std::string unbra    = CMD_PREFIX + "unbra -t -j 4";
+    const std::string out_file = "test_j.BRa";
+
+    for (const std::string comp : {"", " -c"})
+    {
+        if (fs::exists(out_file))
+            fs::remove(out_file);
+
+        ASSERT_EQ(call_system(bra + comp + " -r -o " + out_file + " dir1/*"), 0);
+        ASSERT_EQ(call_system(unbra + " " + out_file), 0);
+    }
+
+    // a corrupted file data must fail the verification
+    fs::remove(out_file);
+    ASSERT_EQ(call_system(bra + " -o " + out_file + " fixtures/lorem.txt"), 0);
+    {
+        std::fstream f(out_file, std::ios::in | std::ios::out | std::ios::binary);
+        ASSERT_TRUE(f.is_open());
+        // the file data is followed by its CRC32.
+        f.seekg(-16, std::ios::end);
+        const char c = static_cast<char>(f.get() ^ 0xFF);
+        f.seekp(-16, std::ios::end);
+        f.put(c);
+    }
+    ASSERT_EQ(call_system(unbra + " " + out_file), 2);
+
+    fs::remove(out_file);
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     const std::map<std::string, std::function<int()>> m = {
@@ -410,10 +1227,23 @@ int main(int argc, char* argv[])
         {TEST_FUNC(test_bra_sfx_1)},
         {TEST_FUNC(test_bra_sfx_2)},
         {TEST_FUNC(test_bra_not_more_than_1_same_file)},
+        {TEST_FUNC(test_bra_unbra_symlink_escape)},
         {TEST_FUNC(test_bra_unbra_all)},
         {TEST_FUNC(test_bra_unbra_comp)},
         {TEST_FUNC(test_bra_unbra_comp_2)},
         {TEST_FUNC(test_bra_unbra_comp_2b)},
+        {TEST_FUNC(test_bra_unbra_comp_fast)},
+        {TEST_FUNC(test_bra_unbra_comp_levels)},
+        {TEST_FUNC(test_bra_unbra_comp_levels_size)},
+        {TEST_FUNC(test_bra_unbra_comp_filters)},
+        {TEST_FUNC(test_bra_unbra_comp_solid)},
+        {TEST_FUNC(test_bra_unbra_dedup)},
+        {TEST_FUNC(test_bra_unbra_cdc)},
+        {TEST_FUNC(test_bra_unbra_base)},
+        {TEST_FUNC(test_bra_unbra_update)},
+        {TEST_FUNC(test_bra_unbra_stream)},
+        {TEST_FUNC(test_bra_unbra_threads)},
+        {TEST_FUNC(test_bra_unbra_test_threads)},
     };
 
     return test_main(argc, argv, m);
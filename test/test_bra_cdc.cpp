@@ -0,0 +1,108 @@
+#include "bra_test.hpp"
+
+#include <utils/bra_cdc.h>
+
+#include <random>
+#include <vector>
+#include <set>
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+static std::vector<uint8_t> random_bytes(const size_t size, const unsigned seed)
+{
+    std::mt19937         rng(seed);
+    std::vector<uint8_t> v(size);
+    for (auto& b : v)
+        b = static_cast<uint8_t>(rng());
+
+    return v;
+}
+
+/**
+ * @brief Absolute cut points of the whole @p buf.
+ */
+static std::vector<size_t> cuts(const std::vector<uint8_t>& buf)
+{
+    std::vector<size_t> v;
+    for (size_t i = 0; i < buf.size();)
+    {
+        i += bra_cdc_cut(&buf[i], buf.size() - i);
+        v.push_back(i);
+    }
+
+    return v;
+}
+
+TEST(test_bra_cdc_bounds)
+{
+    const auto buf = random_bytes(1024 * 1024, 1);
+    const auto c   = cuts(buf);
+
+    ASSERT_TRUE(c.size() > 1);
+    ASSERT_EQ(c.back(), buf.size());
+    size_t prev = 0;
+    for (size_t i = 0; i < c.size(); ++i)
+    {
+        const size_t s = c[i] - prev;
+        ASSERT_TRUE(s <= BRA_CDC_MAX_SIZE);
+        if (i + 1 < c.size())
+            ASSERT_TRUE(s >= BRA_CDC_MIN_SIZE);
+        prev = c[i];
+    }
+
+    // on average around the expected size.
+    const size_t avg = buf.size() / c.size();
+    ASSERT_TRUE(avg >= BRA_CDC_AVG_SIZE / 2 && avg <= BRA_CDC_AVG_SIZE * 2);
+
+    // small inputs are a single block.
+    ASSERT_EQ(bra_cdc_cut(buf.data(), 0), 0U);
+    ASSERT_EQ(bra_cdc_cut(buf.data(), 1), 1U);
+    ASSERT_EQ(bra_cdc_cut(buf.data(), BRA_CDC_MIN_SIZE), static_cast<size_t>(BRA_CDC_MIN_SIZE));
+
+    // no content-defined cut in a constant input: the largest blocks.
+    const std::vector<uint8_t> zeros(BRA_CDC_MAX_SIZE * 2);
+    ASSERT_EQ(bra_cdc_cut(zeros.data(), zeros.size()), static_cast<size_t>(BRA_CDC_MAX_SIZE));
+
+    return 0;
+}
+
+TEST(test_bra_cdc_shift)
+{
+    // the same contents after an insertion are cut at the same points, once resynchronized.
+    const auto           buf = random_bytes(512 * 1024, 2);
+    std::vector<uint8_t> buf2(buf.begin(), buf.begin() + 100000);
+    const size_t         ins = 777;
+    buf2.insert(buf2.end(), ins, 'x');
+    buf2.insert(buf2.end(), buf.begin() + 100000, buf.end());
+
+    const auto c  = cuts(buf);
+    const auto c2 = cuts(buf2);
+
+    std::set<size_t> s;
+    for (const size_t p : c)
+    {
+        if (p > 100000)
+            s.insert(p + ins);
+    }
+
+    size_t same = 0;
+    for (const size_t p : c2)
+        same += s.count(p);
+
+    // all but the first couple of blocks after the insertion.
+    ASSERT_TRUE(same + 3 >= s.size());
+    ASSERT_TRUE(cuts(buf) == c);
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::map<std::string, std::function<int()>> m = {
+        {TEST_FUNC(test_bra_cdc_bounds)},
+        {TEST_FUNC(test_bra_cdc_shift)},
+    };
+
+    return test_main(argc, argv, m);
+}
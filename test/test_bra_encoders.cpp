@@ -5,9 +5,14 @@ extern "C" {
 #endif
 
 #include <encoders/bra_rle.h>
+#include <encoders/bra_zrle.h>
+#include <encoders/bra_lz.h>
 #include <encoders/bra_bwt.h>
 #include <encoders/bra_mtf.h>
 #include <encoders/bra_huffman.h>
+#include <encoders/bra_cm.h>
+#include <encoders/bra_codec.h>
+#include <encoders/bra_filter.h>
 
 #ifdef __cplusplus
 }
@@ -15,8 +20,11 @@ extern "C" {
 
 #include <fs/bra_fs.hpp>
 
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -113,6 +121,216 @@ TEST(test_bra_encoders_rle_encode_3)
     return 0;
 }
 
+/**
+ * @brief Byte by byte PackBits reference: the output of bra_rle_encode must not depend on the run detection.
+ */
+static std::vector<uint8_t> _test_bra_encoders_rle_encode_ref(const std::vector<uint8_t>& buf)
+{
+    const auto run_at = [&buf](const size_t i) {
+        size_t run = 1;
+        while (i + run < buf.size() && buf[i + run] == buf[i] && run < BRA_RLE_MAX_RUNS)
+            ++run;
+        return run;
+    };
+
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < buf.size();)
+    {
+        const size_t run = run_at(i);
+        if (run >= BRA_RLE_MIN_RUNS)
+        {
+            out.push_back(static_cast<uint8_t>(-static_cast<int>(run - 1)));
+            out.push_back(buf[i]);
+            i += run;
+            continue;
+        }
+
+        const size_t start = i;
+        i += run;
+        while (i < buf.size() && i - start < BRA_RLE_MAX_RUNS && run_at(i) < BRA_RLE_MIN_RUNS)
+            ++i;
+
+        out.push_back(static_cast<uint8_t>(i - start - 1));
+        out.insert(out.end(), buf.begin() + start, buf.begin() + i);
+    }
+
+    return out;
+}
+
+TEST(test_bra_encoders_rle_encode_4)
+{
+    // runs and literals of every length around the 16 bytes compare and the 128 bytes block limit
+    std::vector<uint8_t> buf;
+    uint32_t             seed = 12345;
+    const auto           rnd  = [&seed]() {
+        seed = seed * 1103515245U + 12345U;
+        return seed >> 16;
+    };
+
+    for (size_t len = 1; len <= 300; ++len)
+    {
+        if (len % 2 == 0)
+            buf.insert(buf.end(), len, static_cast<uint8_t>(len));
+        else
+        {
+            for (size_t i = 0; i < len; ++i)
+                buf.push_back(static_cast<uint8_t>(rnd() % 4));    // short runs inside the literals
+        }
+    }
+
+    const std::vector<uint8_t> exp = _test_bra_encoders_rle_encode_ref(buf);
+
+    uint8_t* out_buf   = nullptr;
+    size_t   out_buf_s = 0;
+    ASSERT_TRUE(bra_rle_encode(buf.data(), buf.size(), &out_buf, &out_buf_s));
+    ASSERT_EQ(out_buf_s, exp.size());
+    ASSERT_EQ(memcmp(out_buf, exp.data(), exp.size()), 0);
+
+    uint8_t* buf2   = nullptr;
+    size_t   buf2_s = 0;
+    ASSERT_TRUE(bra_rle_decode(out_buf, out_buf_s, &buf2, &buf2_s));
+    ASSERT_EQ(buf2_s, buf.size());
+    ASSERT_EQ(memcmp(buf2, buf.data(), buf.size()), 0);
+    free(buf2);
+    free(out_buf);
+
+    // no runs at all: the worst case bound is reached exactly
+    std::vector<uint8_t> lit(1000);
+    for (size_t i = 0; i < lit.size(); ++i)
+        lit[i] = static_cast<uint8_t>(i % 2);
+
+    ASSERT_TRUE(bra_rle_encode(lit.data(), lit.size(), &out_buf, &out_buf_s));
+    ASSERT_EQ(out_buf_s, static_cast<size_t>(BRA_RLE_ENCODE_BOUND(lit.size())));
+    free(out_buf);
+
+    std::vector<uint8_t> small(BRA_RLE_ENCODE_BOUND(lit.size()) - 1);
+    ASSERT_FALSE(bra_rle_encode2(lit.data(), lit.size(), small.data(), small.size(), &out_buf_s));
+    ASSERT_EQ(out_buf_s, 0U);
+
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_zrle_1)
+{
+    // zero runs of 1 to 300, separated by all the ranks, escaped ones included.
+    std::vector<uint8_t> buf;
+    for (size_t len = 1; len <= 300; ++len)
+    {
+        buf.insert(buf.end(), len, 0);
+        buf.push_back(static_cast<uint8_t>(1 + len % 255));
+    }
+    buf.insert(buf.end(), 1000, 0);
+
+    std::vector<uint8_t> out(2 * buf.size());
+    size_t               out_s = 0;
+    ASSERT_TRUE(bra_zrle_encode2(buf.data(), buf.size(), out.data(), out.size(), &out_s));
+    ASSERT_TRUE(out_s < buf.size());
+
+    ASSERT_EQ(bra_zrle_decode_compute_size(out.data(), out_s), buf.size());
+
+    std::vector<uint8_t> buf2(buf.size());
+    size_t               buf2_s = 0;
+    ASSERT_TRUE(bra_zrle_decode2(out.data(), out_s, buf2.data(), buf2.size(), &buf2_s));
+    ASSERT_EQ(buf2_s, buf.size());
+    ASSERT_EQ(memcmp(buf2.data(), buf.data(), buf.size()), 0);
+
+    // too small buffers
+    ASSERT_FALSE(bra_zrle_decode2(out.data(), out_s, buf2.data(), buf2.size() - 1, &buf2_s));
+    ASSERT_FALSE(bra_zrle_encode2(buf.data(), buf.size(), out.data(), out_s - 1, &out_s));
+
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_zrle_2)
+{
+    // RUNA/RUNB digits and escapes
+    const uint8_t buf[]   = {0, 0, 0, 1, 254, 255, 0, 0};
+    const uint8_t exp[]   = {BRA_ZRLE_RUNA, BRA_ZRLE_RUNA, 2, BRA_ZRLE_ESC, 0, BRA_ZRLE_ESC, 1, BRA_ZRLE_RUNB};
+    uint8_t       out[16] = {0};
+    size_t        out_s   = 0;
+    ASSERT_TRUE(bra_zrle_encode2(buf, sizeof(buf), out, sizeof(out), &out_s));
+    ASSERT_EQ(out_s, sizeof(exp));
+    ASSERT_EQ(memcmp(out, exp, sizeof(exp)), 0);
+
+    // escape without its rank
+    const uint8_t bad[] = {2, BRA_ZRLE_ESC};
+    ASSERT_EQ(bra_zrle_decode_compute_size(bad, sizeof(bad)), 0U);
+    const uint8_t bad2[] = {BRA_ZRLE_ESC, 2};
+    ASSERT_EQ(bra_zrle_decode_compute_size(bad2, sizeof(bad2)), 0U);
+
+    return 0;
+}
+
+static int _test_bra_encoders_encode_decode_lz(const uint8_t* buf, const size_t buf_size)
+{
+    std::vector<uint8_t> enc(BRA_LZ_ENCODE_BOUND(buf_size));
+    std::vector<uint8_t> dec(buf_size + 1);
+    size_t               enc_s = 0;
+    size_t               dec_s = 0;
+    ASSERT_TRUE(bra_lz_encode2(buf, buf_size, enc.data(), enc.size(), &enc_s));
+    ASSERT_TRUE(enc_s <= enc.size());
+    ASSERT_TRUE(bra_lz_decode2(enc.data(), enc_s, dec.data(), dec.size(), &dec_s));
+    ASSERT_EQ(dec_s, buf_size);
+    ASSERT_EQ(memcmp(dec.data(), buf, buf_size), 0);
+
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_lz_1)
+{
+    // short inputs are all literals
+    const uint8_t* text = (const uint8_t*) "abcabcabcabcabcabcabcabcabcabcabcab";
+    for (size_t i = 0; i < 14; ++i)
+        ASSERT_EQ(_test_bra_encoders_encode_decode_lz(text, i), 0);
+
+    // overlapped matches
+    ASSERT_EQ(_test_bra_encoders_encode_decode_lz(text, strlen((const char*) text)), 0);
+
+    // repetitive, text and random data
+    std::vector<uint8_t> buf(200000);
+    std::fill(buf.begin(), buf.end(), 'x');
+    ASSERT_EQ(_test_bra_encoders_encode_decode_lz(buf.data(), buf.size()), 0);
+    for (size_t i = 0; i < buf.size(); ++i)
+        buf[i] = (uint8_t) ("lorem ipsum dolor sit amet "[i % 27] + (i / 1000) % 3);
+    ASSERT_EQ(_test_bra_encoders_encode_decode_lz(buf.data(), buf.size()), 0);
+    srand(41);
+    for (auto& b : buf)
+        b = (uint8_t) rand();
+    ASSERT_EQ(_test_bra_encoders_encode_decode_lz(buf.data(), buf.size()), 0);
+
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_lz_2)
+{
+    std::vector<uint8_t> buf(1000, 'a');
+    std::vector<uint8_t> enc(BRA_LZ_ENCODE_BOUND(buf.size()));
+    std::vector<uint8_t> dec(buf.size());
+    size_t               enc_s = 0;
+    size_t               dec_s = 0;
+
+    // a run is a single long match
+    ASSERT_TRUE(bra_lz_encode2(buf.data(), buf.size(), enc.data(), enc.size(), &enc_s));
+    ASSERT_TRUE(enc_s < 16U);
+    ASSERT_FALSE(bra_lz_encode2(buf.data(), buf.size(), enc.data(), enc_s - 1, &dec_s));
+
+    // output too small
+    ASSERT_FALSE(bra_lz_decode2(enc.data(), enc_s, dec.data(), buf.size() - 1, &dec_s));
+    // truncated input
+    ASSERT_FALSE(bra_lz_decode2(enc.data(), enc_s - 1, dec.data(), dec.size(), &dec_s));
+
+    // offset 0 and offset before the start of the output
+    const uint8_t bad_0[] = {0x10, 'a', 0x00, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+    ASSERT_FALSE(bra_lz_decode2(bad_0, sizeof(bad_0), dec.data(), dec.size(), &dec_s));
+    const uint8_t bad_1[] = {0x10, 'a', 0x02, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+    ASSERT_FALSE(bra_lz_decode2(bad_1, sizeof(bad_1), dec.data(), dec.size(), &dec_s));
+    const uint8_t good[] = {0x10, 'a', 0x01, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+    ASSERT_TRUE(bra_lz_decode2(good, sizeof(good), dec.data(), dec.size(), &dec_s));
+    ASSERT_EQ(dec_s, 10U);
+
+    return 0;
+}
+
 static int _test_bra_encoders_encode_decode_bwt(const uint8_t* buf, const size_t buf_size, const uint8_t* exp_buf, const bra_bwt_index_t exp_primary_index)
 {
     bra_bwt_index_t primary_index;
@@ -149,6 +367,45 @@ TEST(test_bra_encoders_encode_decode_bwt_2)
     return _test_bra_encoders_encode_decode_bwt(buf, buf_size, exp_buf, 9U);
 }
 
+TEST(test_bra_encoders_encode_decode_bwt_3)
+{
+    // the largest chunks of repetitive data: the worst case of a comparison sort of the rotations.
+    bra_codec_ctx_t codec;
+    bra_codec_ctx_init(&codec);
+    ASSERT_TRUE(bra_codec_ctx_reserve(&codec));
+
+    const bra_bwt_index_t s = BRA_MAX_CHUNK_SIZE;
+    for (int t = 0; t < 3; ++t)
+    {
+        for (bra_bwt_index_t i = 0; i < s; ++i)
+        {
+            switch (t)
+            {
+            case 0:
+                codec.buf[i] = 0;
+                break;
+            case 1:
+                codec.buf[i] = static_cast<uint8_t>("ABAB"[i % 4]);
+                break;
+            default:
+                // records of 12 bytes with a slowly changing counter.
+                codec.buf[i] = i % 12 == 0 ? static_cast<uint8_t>(i / 12 / 256) : static_cast<uint8_t>(i % 12);
+                break;
+            }
+        }
+
+        const std::vector<uint8_t> orig(codec.buf, codec.buf + s);
+        bra_bwt_index_t            primary_index = 0;
+        ASSERT_TRUE(bra_bwt_encode2(codec.buf, s, &primary_index, codec.buf_trans, codec.buf2));
+        ASSERT_TRUE(primary_index < s);
+        bra_bwt_decode2(codec.buf2, s, primary_index, codec.buf_trans, codec.buf);
+        ASSERT_EQ(memcmp(codec.buf, orig.data(), s), 0);
+    }
+
+    bra_codec_ctx_free(&codec);
+    return 0;
+}
+
 TEST(test_bra_encoders_encode_decode_mtf_1)
 {
     const uint8_t* buf       = (const uint8_t*) "BANANA";
@@ -364,6 +621,111 @@ TEST(test_bra_encoders_encode_decode_huffman_4)
     return 0;
 }
 
+TEST(test_bra_encoders_encode_decode_huffman_multi_1)
+{
+    // segments with different statistics, so the groups pick different tables.
+    std::vector<uint8_t> buf(BRA_MAX_CHUNK_SIZE);
+    uint32_t             seed = 12345;
+    for (size_t i = 0; i < buf.size(); ++i)
+    {
+        seed   = seed * 1103515245U + 12345U;
+        buf[i] = (i / 1000) % 2 == 0 ? static_cast<uint8_t>((seed >> 16) % 4) : static_cast<uint8_t>(200 + (seed >> 16) % 50);
+    }
+
+    std::vector<uint8_t> out(BRA_CODEC_BUF_SIZE);
+    std::vector<uint8_t> buf2(buf.size());
+    for (const size_t size : {size_t{1}, size_t{49}, size_t{50}, size_t{51}, size_t{1000}, size_t{5000}, buf.size()})
+    {
+        bra_huffman_t meta;
+        ASSERT_TRUE(bra_huffman_encode_multi(buf.data(), static_cast<uint32_t>(size), &meta, out.data(), static_cast<uint32_t>(out.size())));
+        ASSERT_EQ(meta.orig_size, size);
+        ASSERT_TRUE(meta.encoded_size > 0);
+
+        std::fill(buf2.begin(), buf2.end(), 0);
+        ASSERT_TRUE(bra_huffman_decode_multi(&meta, out.data(), buf2.data(), static_cast<uint32_t>(buf2.size())));
+        ASSERT_EQ(memcmp(buf2.data(), buf.data(), size), 0);
+
+        // truncated
+        bra_huffman_t meta2 = meta;
+        meta2.encoded_size  = meta.encoded_size / 2;
+        ASSERT_FALSE(bra_huffman_decode_multi(&meta2, out.data(), buf2.data(), static_cast<uint32_t>(buf2.size())));
+    }
+
+    // smaller than the single table coding
+    bra_huffman_t meta;
+    ASSERT_TRUE(bra_huffman_encode_multi(buf.data(), static_cast<uint32_t>(buf.size()), &meta, out.data(), static_cast<uint32_t>(out.size())));
+    const uint32_t multi_size = meta.encoded_size;
+    ASSERT_TRUE(bra_huffman_encode2(buf.data(), static_cast<uint32_t>(buf.size()), &meta, out.data(), static_cast<uint32_t>(out.size())));
+    ASSERT_TRUE(multi_size < meta.encoded_size);
+
+    // too small output
+    ASSERT_FALSE(bra_huffman_encode_multi(buf.data(), static_cast<uint32_t>(buf.size()), &meta, out.data(), 100));
+
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_huffman_multi_2)
+{
+    // short streams: the coding description must be cheaper than the 256 bytes code lengths table.
+    const uint8_t* text = (const uint8_t*) "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.";
+    const size_t   len  = strlen((const char*) text);
+
+    uint8_t out[BRA_MAX_CHUNK_SIZE];
+    uint8_t buf2[BRA_MAX_CHUNK_SIZE];
+    for (size_t size = 1; size <= len; ++size)
+    {
+        bra_huffman_t meta;
+        ASSERT_TRUE(bra_huffman_encode_multi(text, static_cast<uint32_t>(size), &meta, out, sizeof(out)));
+        ASSERT_TRUE(meta.encoded_size < sizeof(meta.lengths));
+        ASSERT_TRUE(bra_huffman_decode_multi(&meta, out, buf2, sizeof(buf2)));
+        ASSERT_EQ(memcmp(buf2, text, size), 0);
+    }
+
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_huffman_compact)
+{
+    bra_codec_ctx_t codec;
+    bra_codec_ctx_init(&codec);
+    ASSERT_TRUE(bra_codec_ctx_reserve(&codec));
+
+    // a small chunk of text as level 2 encodes it: its single table costs much less than the 256 bytes code lengths.
+    const char*           words[] = {"lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ", "adipiscing ", "elit.\n"};
+    const bra_bwt_index_t s       = 2000;
+    uint32_t              seed    = 12345;
+    for (bra_bwt_index_t i = 0; i < s;)
+    {
+        seed = seed * 1103515245U + 12345U;
+        for (const char* w = words[(seed >> 16) % std::size(words)]; *w != '\0' && i < s; ++w)
+            codec.buf[i++] = static_cast<uint8_t>(*w);
+    }
+
+    bra_bwt_index_t primary_index = 0;
+    size_t          rle_s         = 0;
+    ASSERT_TRUE(bra_bwt_encode2(codec.buf, s, &primary_index, codec.buf_trans, codec.buf2));
+    ASSERT_TRUE(bra_mtf_encode2(codec.buf2, s, codec.buf));
+    ASSERT_TRUE(bra_rle_encode2(codec.buf, s, codec.buf2, BRA_CODEC_BUF_SIZE, &rle_s));
+
+    bra_huffman_t single;
+    bra_huffman_t compact;
+    ASSERT_TRUE(bra_huffman_encode2(codec.buf2, static_cast<uint32_t>(rle_s), &single, codec.buf, BRA_CODEC_BUF_SIZE));
+    ASSERT_TRUE(bra_huffman_encode_compact(codec.buf2, static_cast<uint32_t>(rle_s), &compact, codec.buf, BRA_CODEC_BUF_SIZE));
+    ASSERT_EQ(compact.orig_size, rle_s);
+    ASSERT_TRUE(compact.encoded_size < single.encoded_size + sizeof(single.lengths) / 2);
+
+    std::vector<uint8_t> dec(rle_s);
+    ASSERT_TRUE(bra_huffman_decode_multi(&compact, codec.buf, dec.data(), static_cast<uint32_t>(dec.size())));
+    ASSERT_EQ(memcmp(dec.data(), codec.buf2, rle_s), 0);
+
+    // empty or too small output
+    ASSERT_FALSE(bra_huffman_encode_compact(codec.buf2, 0, &compact, codec.buf, BRA_CODEC_BUF_SIZE));
+    ASSERT_FALSE(bra_huffman_encode_compact(codec.buf2, static_cast<uint32_t>(rle_s), &compact, codec.buf, 16));
+
+    bra_codec_ctx_free(&codec);
+    return 0;
+}
+
 TEST(test_bra_encoders_encode_decode_bwt_mtf_huffman_1)
 {
     const uint8_t* buf      = (const uint8_t*) "BANANA";
@@ -401,6 +763,364 @@ TEST(test_bra_encoders_encode_decode_bwt_mtf_huffman_1)
     return 0;
 }
 
+TEST(test_bra_encoders_codec_pool)
+{
+    bra_codec_pool_t* pool = bra_codec_pool_create();
+    ASSERT_TRUE(pool != nullptr);
+
+    bra_codec_ctx_t* c1 = bra_codec_pool_acquire(pool);
+    bra_codec_ctx_t* c2 = bra_codec_pool_acquire(pool);
+    ASSERT_TRUE(c1 != nullptr);
+    ASSERT_TRUE(c2 != nullptr);
+    ASSERT_TRUE(c1 != c2);
+    ASSERT_TRUE(c1->buf == nullptr);
+
+    ASSERT_TRUE(bra_codec_ctx_reserve(c1));
+    ASSERT_TRUE(c1->buf != nullptr);
+    ASSERT_TRUE(c1->buf2 != nullptr);
+    ASSERT_TRUE(c1->buf_trans != nullptr);
+
+    // the buffers are kept for the next owner
+    const uint8_t* buf = c1->buf;
+    bra_codec_pool_release(pool, c1);
+    bra_codec_ctx_t* c3 = bra_codec_pool_acquire(pool);
+    ASSERT_TRUE(c3 == c1);
+    ASSERT_TRUE(c3->buf == buf);
+
+    bra_codec_pool_release(pool, c3);
+    bra_codec_pool_release(pool, c2);
+
+    // concurrent owners never share a context
+    std::vector<std::thread> threads;
+    std::vector<int>         res(8, 0);
+    for (size_t t = 0; t < res.size(); ++t)
+    {
+        threads.emplace_back([pool, &res, t]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                bra_codec_ctx_t* c = bra_codec_pool_acquire(pool);
+                if (c == nullptr || !bra_codec_ctx_reserve(c))
+                    return;
+
+                memset(c->buf, static_cast<int>(t), BRA_MAX_CHUNK_SIZE);
+                std::this_thread::yield();
+                for (size_t j = 0; j < BRA_MAX_CHUNK_SIZE; j += 4096)
+                {
+                    if (c->buf[j] != static_cast<uint8_t>(t))
+                        return;
+                }
+
+                bra_codec_pool_release(pool, c);
+            }
+
+            res[t] = 1;
+        });
+    }
+
+    for (auto& th : threads)
+        th.join();
+    for (const int r : res)
+        ASSERT_EQ(r, 1);
+
+    bra_codec_pool_destroy(&pool);
+    ASSERT_TRUE(pool == nullptr);
+    return 0;
+}
+
+TEST(test_bra_encoders_codec_chunk_roundtrip)
+{
+    bra_codec_ctx_t codec;
+    bra_codec_ctx_init(&codec);
+    ASSERT_TRUE(bra_codec_ctx_reserve(&codec));
+
+    // random data: the RLE stage expands it, up to its worst case bound.
+    std::vector<uint8_t> src(BRA_MAX_CHUNK_SIZE);
+    uint32_t             seed = 12345;
+    for (auto& b : src)
+    {
+        seed = seed * 1103515245U + 12345U;
+        b    = static_cast<uint8_t>(seed >> 16);
+    }
+
+    const bra_bwt_index_t s = static_cast<bra_bwt_index_t>(src.size());
+    memcpy(codec.buf, src.data(), s);
+
+    bra_bwt_index_t primary_index = 0;
+    ASSERT_TRUE(bra_bwt_encode2(codec.buf, s, &primary_index, codec.buf_trans, codec.buf2));
+    ASSERT_TRUE(bra_mtf_encode2(codec.buf2, s, codec.buf));
+    size_t rle_s = 0;
+    ASSERT_TRUE(bra_rle_encode2(codec.buf, s, codec.buf2, BRA_CODEC_BUF_SIZE, &rle_s));
+    ASSERT_TRUE(rle_s > s);
+    ASSERT_TRUE(rle_s <= BRA_CODEC_BUF_SIZE);
+    // too small output buffer
+    size_t tmp_s = 0;
+    ASSERT_FALSE(bra_rle_encode2(codec.buf, s, codec.buf2, s, &tmp_s));
+    ASSERT_TRUE(bra_rle_encode2(codec.buf, s, codec.buf2, BRA_CODEC_BUF_SIZE, &tmp_s));
+    ASSERT_EQ(tmp_s, rle_s);
+
+    bra_huffman_t meta;
+    ASSERT_TRUE(bra_huffman_encode2(codec.buf2, static_cast<uint32_t>(rle_s), &meta, codec.buf, BRA_CODEC_BUF_SIZE));
+    ASSERT_EQ(meta.orig_size, rle_s);
+    ASSERT_TRUE(meta.encoded_size <= rle_s);
+
+    ////// decode //////
+    ASSERT_FALSE(bra_huffman_decode2(&meta, codec.buf, codec.buf2, meta.orig_size - 1));
+    ASSERT_TRUE(bra_huffman_decode2(&meta, codec.buf, codec.buf2, BRA_CODEC_BUF_SIZE));
+    size_t dec_s = 0;
+    ASSERT_FALSE(bra_rle_decode2(codec.buf2, rle_s, codec.buf, s - 1, &dec_s));
+    ASSERT_TRUE(bra_rle_decode2(codec.buf2, rle_s, codec.buf, BRA_MAX_CHUNK_SIZE, &dec_s));
+    ASSERT_EQ(dec_s, s);
+    bra_mtf_decode2(codec.buf, s, codec.buf2);
+    bra_bwt_decode2(codec.buf2, s, primary_index, codec.buf_trans, codec.buf);
+    ASSERT_TRUE(memcmp(codec.buf, src.data(), s) == 0);
+
+    bra_codec_ctx_free(&codec);
+    return 0;
+}
+
+TEST(test_bra_encoders_filter_roundtrip)
+{
+    // a chunk with a partial last record, calls and jumps for the x86 filter.
+    std::vector<uint8_t> src(10001);
+    uint32_t             seed = 12345;
+    for (auto& b : src)
+    {
+        seed = seed * 1103515245U + 12345U;
+        b    = static_cast<uint8_t>(seed >> 16);
+    }
+    for (size_t i = 0; i + 5 <= src.size(); i += 37)
+    {
+        src[i]     = (i & 1) ? 0xE8 : 0xE9;
+        src[i + 4] = (i & 2) ? 0xFF : 0x00;
+    }
+
+    const uint8_t filters[] = {
+        BRA_FILTER_SET(BRA_FILTER_DELTA, 1),
+        BRA_FILTER_SET(BRA_FILTER_DELTA, 4),
+        BRA_FILTER_SET(BRA_FILTER_X86, 1),
+        BRA_FILTER_SET(BRA_FILTER_TRANSPOSE, 2),
+        BRA_FILTER_SET(BRA_FILTER_TRANSPOSE, 7),
+        BRA_FILTER_SET(BRA_FILTER_TRANSPOSE, BRA_FILTER_MAX_STRIDE),
+    };
+
+    std::vector<uint8_t> buf(src.size());
+    std::vector<uint8_t> tmp(src.size());
+    for (const uint8_t f : filters)
+    {
+        ASSERT_TRUE(bra_filter_validate(f));
+        buf = src;
+        bra_filter_encode(f, buf.data(), buf.size(), tmp.data());
+        ASSERT_FALSE(buf == src);
+        ASSERT_TRUE(bra_filter_decode(f, buf.data(), buf.size(), tmp.data()));
+        ASSERT_TRUE(buf == src);
+    }
+
+    // not valid
+    ASSERT_FALSE(bra_filter_validate(BRA_FILTER_NONE));
+    ASSERT_FALSE(bra_filter_validate(BRA_FILTER_SET(BRA_FILTER_X86, 2)));
+    ASSERT_FALSE(bra_filter_validate(BRA_FILTER_SET(BRA_FILTER_TRANSPOSE, 1)));
+    ASSERT_FALSE(bra_filter_validate(BRA_FILTER_SET(BRA_FILTER_TRANSPOSE + 1, 1)));
+    ASSERT_FALSE(bra_filter_decode(BRA_FILTER_SET(BRA_FILTER_TRANSPOSE + 1, 1), buf.data(), buf.size(), tmp.data()));
+    ASSERT_TRUE(bra_filter_decode(BRA_FILTER_NONE, buf.data(), buf.size(), tmp.data()));
+    ASSERT_TRUE(buf == src);
+    return 0;
+}
+
+TEST(test_bra_encoders_filter_x86)
+{
+    const uint8_t        f = BRA_FILTER_SET(BRA_FILTER_X86, 1);
+    std::vector<uint8_t> tmp(4096);
+
+    // an opcode inside the displacement of a previous one, the upper byte of that changed by the later one.
+    const std::vector<uint8_t> overlap = {0xE8, 0x11, 0xE8, 0xF9, 0xFE, 0x00, 0x00, 0xE9, 0xE8, 0x00, 0xFF, 0xE8, 0x00, 0x00, 0xFF, 0xFF};
+    std::vector<uint8_t>       buf     = overlap;
+    bra_filter_encode(f, buf.data(), buf.size(), tmp.data());
+    ASSERT_TRUE(bra_filter_decode(f, buf.data(), buf.size(), tmp.data()));
+    ASSERT_TRUE(buf == overlap);
+
+    // opcodes and upper bytes everywhere.
+    const uint8_t dense[] = {0xE8, 0xE9, 0x00, 0xFF};
+    uint32_t      seed    = 12345;
+    for (int k = 0; k < 1000; ++k)
+    {
+        std::vector<uint8_t> src(1 + k % 300);
+        for (auto& b : src)
+        {
+            seed = seed * 1103515245U + 12345U;
+            b    = (seed >> 28) < 12 ? dense[(seed >> 16) % 4] : static_cast<uint8_t>(seed >> 16);
+        }
+
+        buf = src;
+        bra_filter_encode(f, buf.data(), buf.size(), tmp.data());
+        ASSERT_TRUE(bra_filter_decode(f, buf.data(), buf.size(), tmp.data()));
+        ASSERT_TRUE(buf == src);
+    }
+
+    return 0;
+}
+
+TEST(test_bra_encoders_filter_select)
+{
+    std::vector<uint32_t> counts(BRA_FILTER_COUNTS_SIZE);
+    std::vector<uint8_t>  buf(64 * 1024);
+
+    // noise
+    uint32_t seed = 12345;
+    for (auto& b : buf)
+    {
+        seed = seed * 1103515245U + 12345U;
+        b    = static_cast<uint8_t>(seed >> 16);
+    }
+    ASSERT_EQ(bra_filter_select(buf.data(), buf.size(), counts.data()), BRA_FILTER_NONE);
+
+    // too small
+    ASSERT_EQ(bra_filter_select(buf.data(), 100, counts.data()), BRA_FILTER_NONE);
+
+    // samples of a smooth signal, its slope changing slowly.
+    int v     = 0;
+    int slope = 0;
+    for (auto& b : buf)
+    {
+        seed   = seed * 1103515245U + 12345U;
+        slope  = std::clamp(slope + static_cast<int>((seed >> 16) % 3) - 1, -8, 8);
+        v     += slope;
+        b      = static_cast<uint8_t>(v);
+    }
+    ASSERT_EQ(bra_filter_select(buf.data(), buf.size(), counts.data()), BRA_FILTER_SET(BRA_FILTER_DELTA, 1));
+
+    // a piecewise linear signal: its delta degenerates in long runs.
+    for (size_t i = 0; i < buf.size(); ++i)
+    {
+        if (i % 1000 == 0)
+        {
+            seed  = seed * 1103515245U + 12345U;
+            slope = 1 + static_cast<int>((seed >> 16) % 40);
+        }
+        v      += slope;
+        buf[i]  = static_cast<uint8_t>(v);
+    }
+    ASSERT_TRUE(BRA_FILTER_TYPE(bra_filter_select(buf.data(), buf.size(), counts.data())) != BRA_FILTER_DELTA);
+
+    // indented markup, short records of names: its delta lowers only the order-1 entropy.
+    {
+        const char* words[] = {"Alpha", "Beta", "Gamma", "Delta", "Epsilon", "Zeta", "Eta", "Theta"};
+        std::string xml     = "<?xml version=\"1.0\"?>\n<entries>\n";
+        for (uint32_t id = 0; xml.size() < buf.size(); ++id)
+        {
+            seed  = seed * 1103515245U + 12345U;
+            xml  += "\t<entry\n\t\tcode=\"" + std::string(1, static_cast<char>('A' + id / 100 % 26)) + "-" + std::to_string(id % 100) + "\"";
+            xml  += "\tname=\"" + std::string(words[(seed >> 16) % 8]) + "\" />\n";
+        }
+        memcpy(buf.data(), xml.data(), buf.size());
+    }
+    ASSERT_EQ(bra_filter_select(buf.data(), buf.size(), counts.data()), BRA_FILTER_NONE);
+
+    // table of 12 bytes records: an id, a flag and a random value.
+    for (size_t i = 0; i + 12 <= buf.size(); i += 12)
+    {
+        const uint32_t id = static_cast<uint32_t>(i / 12);
+        seed              = seed * 1103515245U + 12345U;
+        memcpy(&buf[i], &id, sizeof(id));
+        memset(&buf[i + 4], id % 3 == 0 ? 'Y' : 'N', 4);
+        memcpy(&buf[i + 8], &seed, sizeof(seed));
+    }
+    const uint8_t f = bra_filter_select(buf.data(), buf.size(), counts.data());
+    ASSERT_EQ(BRA_FILTER_TYPE(f), static_cast<unsigned>(BRA_FILTER_TRANSPOSE));
+    ASSERT_EQ(BRA_FILTER_STRIDE(f), 12U);
+
+    // executables
+    std::vector<uint8_t> elf(64);
+    memcpy(elf.data(), "\x7F" "ELF", 4);
+    elf[18] = 62;
+    ASSERT_TRUE(bra_filter_is_x86(elf.data(), elf.size()));
+    elf[18] = 183;    // aarch64
+    ASSERT_FALSE(bra_filter_is_x86(elf.data(), elf.size()));
+    ASSERT_FALSE(bra_filter_is_x86(buf.data(), buf.size()));
+    return 0;
+}
+
+TEST(test_bra_encoders_encode_decode_cm_1)
+{
+    bra_cm_t* cm = bra_cm_create();
+    ASSERT_TRUE(cm != nullptr);
+
+    // noise, skewed bytes and an empty buffer.
+    std::vector<uint8_t> src(100000);
+    uint32_t             seed = 12345;
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        seed   = seed * 1103515245U + 12345U;
+        src[i] = static_cast<uint8_t>(i < src.size() / 2 ? seed >> 16 : (seed >> 16) % 4);
+    }
+
+    std::vector<uint8_t> out(src.size() * 2);
+    std::vector<uint8_t> dec(src.size());
+    for (const size_t size : {src.size(), src.size() / 2, static_cast<size_t>(1), static_cast<size_t>(0)})
+    {
+        const uint8_t* buf   = &src[src.size() - size];
+        size_t         out_s = 0;
+        ASSERT_TRUE(bra_cm_encode2(cm, buf, size, out.data(), out.size(), &out_s));
+        ASSERT_TRUE(bra_cm_decode2(cm, out.data(), out_s, dec.data(), size));
+        ASSERT_TRUE(memcmp(dec.data(), buf, size) == 0);
+        // 2 bits per byte, less the flat start.
+        if (size == src.size() / 2)
+            ASSERT_TRUE(out_s < size / 4 + size / 64);
+
+        // truncated
+        if (size > 0)
+            ASSERT_FALSE(bra_cm_decode2(cm, out.data(), out_s - 1, dec.data(), size));
+    }
+
+    // too small output buffer
+    size_t out_s = 0;
+    ASSERT_FALSE(bra_cm_encode2(cm, src.data(), src.size(), out.data(), src.size() / 2, &out_s));
+
+    bra_cm_destroy(&cm);
+    ASSERT_TRUE(cm == nullptr);
+    return 0;
+}
+
+TEST(test_bra_encoders_cm_vs_huffman)
+{
+    bra_codec_ctx_t codec;
+    bra_codec_ctx_init(&codec);
+    ASSERT_TRUE(bra_codec_ctx_reserve(&codec));
+    ASSERT_TRUE(bra_codec_ctx_reserve_cm(&codec));
+
+    // text of random words as a chunk, then its BWT for both the paths.
+    const char*           words[] = {"lorem ", "ipsum ", "dolor ", "sit ", "amet, ", "consectetur ", "adipiscing ", "elit, ", "sed ", "do ", "eiusmod ", "tempor ", "incididunt ", "ut ", "labore ", "et ", "dolore ", "magna ", "aliqua.\n"};
+    const bra_bwt_index_t s       = 256 * 1024;
+    uint32_t              seed    = 12345;
+    for (bra_bwt_index_t i = 0; i < s;)
+    {
+        seed = seed * 1103515245U + 12345U;
+        for (const char* w = words[(seed >> 16) % std::size(words)]; *w != '\0' && i < s; ++w)
+            codec.buf[i++] = static_cast<uint8_t>(*w);
+    }
+
+    bra_bwt_index_t primary_index = 0;
+    ASSERT_TRUE(bra_bwt_encode2(codec.buf, s, &primary_index, codec.buf_trans, codec.buf2));
+    const std::vector<uint8_t> bwt(codec.buf2, codec.buf2 + s);
+
+    // huffman path: MTF+zero-run+multiple tables.
+    size_t zrle_s = 0;
+    ASSERT_TRUE(bra_mtf_encode2(codec.buf2, s, codec.buf));
+    ASSERT_TRUE(bra_zrle_encode2(codec.buf, s, codec.buf2, BRA_CODEC_BUF_SIZE, &zrle_s));
+    bra_huffman_t meta;
+    ASSERT_TRUE(bra_huffman_encode_multi(codec.buf2, static_cast<uint32_t>(zrle_s), &meta, codec.buf, BRA_CODEC_BUF_SIZE));
+
+    // context mixing path: the BWT output directly.
+    size_t cm_s = 0;
+    ASSERT_TRUE(bra_cm_encode2(codec.cm, bwt.data(), s, codec.buf, BRA_CODEC_BUF_SIZE, &cm_s));
+    ASSERT_TRUE(bra_cm_decode2(codec.cm, codec.buf, cm_s, codec.buf2, s));
+    ASSERT_TRUE(memcmp(codec.buf2, bwt.data(), s) == 0);
+    ASSERT_TRUE(cm_s < meta.encoded_size);
+
+    bra_codec_ctx_free(&codec);
+    ASSERT_TRUE(codec.cm == nullptr);
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     const std::map<std::string, std::function<int()>> m = {
@@ -408,9 +1128,17 @@ int main(int argc, char* argv[])
         {TEST_FUNC(test_bra_encoders_encode_decode_rle_2)},
 
         {TEST_FUNC(test_bra_encoders_rle_encode_3)},
+        {TEST_FUNC(test_bra_encoders_rle_encode_4)},
+
+        {TEST_FUNC(test_bra_encoders_encode_decode_zrle_1)},
+        {TEST_FUNC(test_bra_encoders_encode_decode_zrle_2)},
+
+        {TEST_FUNC(test_bra_encoders_encode_decode_lz_1)},
+        {TEST_FUNC(test_bra_encoders_encode_decode_lz_2)},
 
         {TEST_FUNC(test_bra_encoders_encode_decode_bwt_1)},
         {TEST_FUNC(test_bra_encoders_encode_decode_bwt_2)},
+        {TEST_FUNC(test_bra_encoders_encode_decode_bwt_3)},
 
         {TEST_FUNC(test_bra_encoders_encode_decode_mtf_1)},
 
@@ -424,8 +1152,21 @@ int main(int argc, char* argv[])
         {TEST_FUNC(test_bra_encoders_encode_decode_huffman_2)},
         {TEST_FUNC(test_bra_encoders_encode_decode_huffman_3)},
         {TEST_FUNC(test_bra_encoders_encode_decode_huffman_4)},
+        {TEST_FUNC(test_bra_encoders_encode_decode_huffman_multi_1)},
+        {TEST_FUNC(test_bra_encoders_encode_decode_huffman_multi_2)},
+        {TEST_FUNC(test_bra_encoders_encode_decode_huffman_compact)},
 
         {TEST_FUNC(test_bra_encoders_encode_decode_bwt_mtf_huffman_1)},
+
+        {TEST_FUNC(test_bra_encoders_encode_decode_cm_1)},
+        {TEST_FUNC(test_bra_encoders_cm_vs_huffman)},
+
+        {TEST_FUNC(test_bra_encoders_codec_pool)},
+        {TEST_FUNC(test_bra_encoders_codec_chunk_roundtrip)},
+
+        {TEST_FUNC(test_bra_encoders_filter_roundtrip)},
+        {TEST_FUNC(test_bra_encoders_filter_x86)},
+        {TEST_FUNC(test_bra_encoders_filter_select)},
     };
 
     return test_main(argc, argv, m);
@@ -3,6 +3,8 @@
 #include <lib_bra_defs.h>
 #include <fs/bra_fs.hpp>
 
+#include <algorithm>
+
 
 using namespace std;
 
@@ -10,7 +12,7 @@ namespace fs = std::filesystem;
 
 TEST(test_bra_fs_search_wildcard)
 {
-    std::set<fs::path> files;
+    bra::fs::file_table files;
 
 #if defined(_WIN32)
     constexpr size_t exp_files = 2;    // bra.exe, bra.sfx
@@ -24,10 +26,10 @@ TEST(test_bra_fs_search_wildcard)
     files.clear();
 
     // No wildcard: function should return false and not modify the set
-    files.insert(fs::path("SENTINEL"));
-    const auto before = files;
+    ASSERT_TRUE(files.add(fs::path("SENTINEL"), {}));
     ASSERT_FALSE(bra::fs::search_wildcard("bra", files, false));
-    ASSERT_TRUE(files == before);
+    ASSERT_EQ(files.size(), 1U);
+    ASSERT_EQ(files.count("SENTINEL"), 1U);
     files.clear();
 
     ASSERT_TRUE(bra::fs::search_wildcard("*", files, false));
@@ -52,7 +54,7 @@ TEST(test_bra_fs_search_wildcard)
 
     ASSERT_TRUE(bra::fs::search_wildcard("?ra.?fx", files, false));
     ASSERT_EQ(files.size(), 1U);
-    ASSERT_EQ(files.begin()->string(), "bra.sfx");
+    ASSERT_EQ(files.begin()->path, "bra.sfx");
     files.clear();
 
     ASSERT_TRUE(bra::fs::search_wildcard("dir?", files, false));
@@ -65,7 +67,7 @@ TEST(test_bra_fs_search_wildcard)
 
 TEST(test_bra_fs_search_wildcard_recursive_on_dir1)
 {
-    std::set<fs::path>    files;
+    bra::fs::file_table   files;
     constexpr const char* gitkeep = "dir1/dir1b/.gitkeep";
 
     if (fs::exists(gitkeep))
@@ -85,7 +87,7 @@ TEST(test_bra_fs_search_wildcard_recursive_on_dir1)
     ASSERT_EQ(files.count("dir1/dir1c/dir1cc/file1cc.txt"), 1U);
     ASSERT_EQ(files.size(), 10U);
 
-    ASSERT_TRUE(bra::fs::file_set_add_dirs(files));
+    ASSERT_TRUE(files.finalize());
     ASSERT_EQ(files.count("dir1"), 1U);
     ASSERT_EQ(files.count("dir1/dir1a"), 1U);
     ASSERT_EQ(files.count("dir1/dir1a/dir1aa"), 1U);
@@ -113,7 +115,7 @@ TEST(test_bra_fs_search_wildcard_recursive_on_dir1)
     ASSERT_EQ(files.count("dir1/dir1c/dir1cc/file1cc.txt"), 1U);
     ASSERT_EQ(files.size(), 3U);
 
-    ASSERT_TRUE(bra::fs::file_set_add_dirs(files));
+    ASSERT_TRUE(files.finalize());
     ASSERT_EQ(files.count("dir1"), 1U);
     ASSERT_EQ(files.count("dir1/dir1a"), 1U);
     ASSERT_EQ(files.count("dir1/dir1a/file1a.txt"), 1U);
@@ -132,7 +134,7 @@ TEST(test_bra_fs_search_wildcard_recursive_on_dir1)
 
 TEST(test_bra_fs_search_wildcard_recursive_in_dir1)
 {
-    std::set<fs::path>    files;
+    bra::fs::file_table   files;
     constexpr const char* gitkeep = "dir1b/.gitkeep";
 
     const fs::path old_path = fs::current_path();
@@ -155,7 +157,7 @@ TEST(test_bra_fs_search_wildcard_recursive_in_dir1)
     ASSERT_EQ(files.count("dir1c/dir1cc/file1cc.txt"), 1U);
     ASSERT_EQ(files.size(), 10U);
 
-    ASSERT_TRUE(bra::fs::file_set_add_dirs(files));
+    ASSERT_TRUE(files.finalize());
     // ASSERT_EQ(files.count("dir1"), 1U);
     ASSERT_EQ(files.count("dir1a"), 1U);
     ASSERT_EQ(files.count("dir1a/dir1aa"), 1U);
@@ -184,7 +186,7 @@ TEST(test_bra_fs_search_wildcard_recursive_in_dir1)
     ASSERT_EQ(files.count("dir1c/dir1cc/file1cc.txt"), 1U);
     ASSERT_EQ(files.size(), 3U);
 
-    ASSERT_TRUE(bra::fs::file_set_add_dirs(files));
+    ASSERT_TRUE(files.finalize());
     // ASSERT_EQ(files.count("dir1"), 1U);
     ASSERT_EQ(files.count("dir1a"), 1U);
     ASSERT_EQ(files.count("dir1a/file1a.txt"), 1U);
@@ -202,6 +204,134 @@ TEST(test_bra_fs_search_wildcard_recursive_in_dir1)
     return 0;
 }
 
+TEST(test_bra_fs_walk)
+{
+    constexpr const char* gitkeep = "dir1/dir1b/.gitkeep";
+
+    if (fs::exists(gitkeep))
+        fs::remove(gitkeep);
+
+    bra::fs::file_list    files1;
+    bra::fs::file_list    files4;
+    bra::fs::walk_options opts;
+
+    opts.num_threads = 1;
+    ASSERT_TRUE(bra::fs::walk("dir1", "*", files1, opts));
+    opts.num_threads = 4;
+    ASSERT_TRUE(bra::fs::walk("./dir1/", "*", files4, opts));
+    ASSERT_EQ(files1.size(), 10U);
+    ASSERT_TRUE(files1 == files4);
+    ASSERT_TRUE(std::is_sorted(files1.begin(), files1.end(), [](const auto& a, const auto& b) { return a.first < b.first; }));
+    ASSERT_EQ(files1.front().first.generic_string(), "dir1/dir1a");
+    ASSERT_TRUE(files1.front().second.type == fs::file_type::directory);
+
+    files1.clear();
+    ASSERT_TRUE(bra::fs::walk("dir1", "*.txt", files1, opts));
+    ASSERT_EQ(files1.size(), 3U);
+
+    // symlinks: loops are not followed, or all skipped.
+    const fs::path walk_dir = "walk_symlink";
+    fs::remove_all(walk_dir);
+    fs::create_directories(walk_dir / "sub");
+    fs::copy_file("test.txt", walk_dir / "sub" / "test.txt");
+    std::error_code ec;
+    fs::create_directory_symlink("..", walk_dir / "sub" / "loop", ec);
+    if (!ec)
+    {
+        files1.clear();
+        opts.follow_symlinks = true;
+        ASSERT_TRUE(bra::fs::walk(walk_dir, "*", files1, opts));
+        ASSERT_EQ(files1.size(), 2U);    // sub, sub/test.txt
+
+        fs::create_symlink("test.txt", walk_dir / "sub" / "link.txt", ec);
+        ASSERT_FALSE(ec);
+        files1.clear();
+        ASSERT_TRUE(bra::fs::walk(walk_dir, "*", files1, opts));
+        ASSERT_EQ(files1.size(), 3U);    // + sub/link.txt as a regular file
+
+        files1.clear();
+        opts.follow_symlinks = false;
+        ASSERT_TRUE(bra::fs::walk(walk_dir, "*", files1, opts));
+        ASSERT_EQ(files1.size(), 2U);
+    }
+    else
+        cout << format("[TEST] symlinks not supported, skipped: {}", ec.message()) << endl;
+
+    fs::remove_all(walk_dir);
+    return 0;
+}
+
+TEST(test_bra_fs_file_stat)
+{
+    auto info = bra::fs::file_stat("test.txt");
+    ASSERT_TRUE(info.has_value());
+    ASSERT_TRUE(info->type == fs::file_type::regular);
+    ASSERT_EQ(info->size, fs::file_size("test.txt"));
+
+    info = bra::fs::file_stat("dir1");
+    ASSERT_TRUE(info.has_value());
+    ASSERT_TRUE(info->type == fs::file_type::directory);
+    ASSERT_EQ(info->size, 0U);
+
+    info = bra::fs::file_stat("test99.txt");
+    ASSERT_TRUE(info.has_value());
+    ASSERT_TRUE(info->type == fs::file_type::not_found);
+
+    // the scan caches the status used later on by the encoder
+    bra::fs::file_table files;
+    ASSERT_TRUE(bra::fs::search_wildcard("dir1/*.txt", files, true));
+    ASSERT_TRUE(files.finalize());
+    for (const auto& e : files)
+    {
+        ASSERT_TRUE(e.info.type == (fs::is_directory(e.path) ? fs::file_type::directory : fs::file_type::regular));
+        if (e.info.type == fs::file_type::regular)
+            ASSERT_EQ(e.info.size, fs::file_size(e.path));
+    }
+
+    return 0;
+}
+
+TEST(test_bra_fs_file_table)
+{
+    bra::fs::file_table files;
+
+    ASSERT_TRUE(files.add(fs::path("b/z.txt"), {fs::file_type::regular, 1}));
+    ASSERT_TRUE(files.add(fs::path("a.txt"), {fs::file_type::regular, 2}));
+    ASSERT_TRUE(files.add(fs::path("b/c"), {fs::file_type::directory, 0}));
+    ASSERT_TRUE(files.add(fs::path("b/a.txt"), {fs::file_type::regular, 3}));
+    ASSERT_TRUE(files.add(fs::path("b-c/d/e.txt"), {fs::file_type::regular, 4}));
+    ASSERT_TRUE(files.add(fs::path("b/z.txt"), {fs::file_type::regular, 1}));
+    ASSERT_TRUE(files.add(fs::path("."), {fs::file_type::directory, 0}));
+    ASSERT_EQ(files.size(), 6U);
+
+    // sorted in archive order: root files first, then each directory followed by its files.
+    ASSERT_TRUE(files.finalize());
+    const std::vector<std::string_view> expected = {"a.txt", "b", "b/a.txt", "b/z.txt", "b/c", "b-c", "b-c/d", "b-c/d/e.txt"};
+    ASSERT_EQ(files.size(), expected.size());
+    auto it = files.begin();
+    for (const auto& e : expected)
+    {
+        ASSERT_EQ(it->path, e);
+        ++it;
+    }
+
+    ASSERT_EQ(files.begin()->dir(), "");
+    ASSERT_EQ(files.begin()->name(), "a.txt");
+    ASSERT_EQ(std::next(files.begin(), 7)->dir(), "b-c/d");
+    ASSERT_EQ(std::next(files.begin(), 7)->name(), "e.txt");
+    ASSERT_EQ(std::next(files.begin(), 7)->info.size, 4U);
+    ASSERT_TRUE(std::next(files.begin(), 6)->is_dir());
+
+    ASSERT_EQ(files.erase("b/z.txt"), 1U);
+    ASSERT_EQ(files.count("b/z.txt"), 0U);
+    ASSERT_EQ(files.size(), 7U);
+
+    files.clear();
+    ASSERT_TRUE(files.empty());
+
+    return 0;
+}
+
 TEST(test_bra_fs_file_exists)
 {
     ASSERT_TRUE(bra::fs::file_exists("test.txt"));
@@ -281,6 +411,58 @@ TEST(test_bra_fs_try_sanitize_path)
     return 0;
 }
 
+TEST(test_bra_fs_path_sanitizer)
+{
+    const bra::fs::path_sanitizer sanitizer;
+    fs::path                      p;
+
+    ASSERT_TRUE(sanitizer.cwd() == fs::current_path());
+
+    // lexical only
+    p = "./dir1/./dir1a/";
+    ASSERT_TRUE(sanitizer.sanitize(p));
+    ASSERT_EQ(p.string(), "dir1/dir1a");
+    p = fs::current_path() / "dir1" / "file1";
+    ASSERT_TRUE(sanitizer.sanitize(p));
+    ASSERT_EQ(p.string(), "dir1/file1");
+    p = "../not_sane";
+    ASSERT_FALSE(sanitizer.sanitize(p));
+    p = "dir1/../../not_sane";
+    ASSERT_FALSE(sanitizer.sanitize(p));
+    p = "dir1/../test.txt";
+    ASSERT_TRUE(sanitizer.sanitize(p));
+    ASSERT_EQ(p.string(), "test.txt");
+
+    // ".." after a symlink is resolved on the filesystem
+    const fs::path san_dir = "sanitizer_dir";
+    fs::remove_all(san_dir);
+    fs::create_directories(san_dir / "sub");
+    std::error_code ec;
+    fs::create_directory_symlink("sub", san_dir / "link", ec);
+    if (!ec)
+    {
+        p = san_dir / "link" / ".." / "test.txt";
+        ASSERT_TRUE(sanitizer.sanitize(p));
+        ASSERT_EQ(p.string(), "sanitizer_dir/test.txt");
+
+        // nor can a symlink lead out of the current directory without a ".."
+        fs::create_directory_symlink(fs::current_path().parent_path(), san_dir / "out", ec);
+        ASSERT_FALSE(ec);
+        p = san_dir / "out" / "test.txt";
+        ASSERT_FALSE(sanitizer.sanitize(p));
+        p = fs::current_path() / san_dir / "out" / "test.txt";
+        ASSERT_FALSE(sanitizer.sanitize(p));
+        p = san_dir / "link" / "test.txt";
+        ASSERT_TRUE(sanitizer.sanitize(p));
+        ASSERT_EQ(p.string(), "sanitizer_dir/sub/test.txt");
+    }
+    else
+        cout << format("[TEST] symlinks not supported, skipped: {}", ec.message()) << endl;
+
+    fs::remove_all(san_dir);
+    return 0;
+}
+
 TEST(test_bra_fs_sfx_filename_adjust)
 {
     auto exp = [](const string& s, const bool tmp) {
@@ -411,10 +593,14 @@ int main(int argc, char* argv[])
                                      {TEST_FUNC(test_bra_fs_search_wildcard)},
                                      {TEST_FUNC(test_bra_fs_search_wildcard_recursive_on_dir1)},
                                      {TEST_FUNC(test_bra_fs_search_wildcard_recursive_in_dir1)},
+                                     {TEST_FUNC(test_bra_fs_walk)},
+                                     {TEST_FUNC(test_bra_fs_file_stat)},
+                                     {TEST_FUNC(test_bra_fs_file_table)},
                                      {TEST_FUNC(test_bra_fs_file_exists)},
                                      {TEST_FUNC(test_bra_fs_dir_exists)},
                                      {TEST_FUNC(test_bra_fs_dir_make)},
                                      {TEST_FUNC(test_bra_fs_try_sanitize_path)},
+                                     {TEST_FUNC(test_bra_fs_path_sanitizer)},
                                      {TEST_FUNC(test_bra_fs_sfx_filename_adjust)},
                                      {TEST_FUNC(test_bra_fs_dir_isSubDir)},
                                      {TEST_FUNC(test_bra_fs_file_attributes)},
@@ -0,0 +1,75 @@
+#include "bra_test.hpp"
+
+#ifdef __cplusplus
+extern "C" {
+
+#include <utils/bra_sha256.h>
+}
+#endif
+
+#include <string>
+#include <cstdio>
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+static std::string to_hex(const uint8_t digest[BRA_SHA256_DIGEST_SIZE])
+{
+    std::string s;
+    char        b[3];
+    for (int i = 0; i < BRA_SHA256_DIGEST_SIZE; ++i)
+    {
+        snprintf(b, sizeof(b), "%02x", digest[i]);
+        s += b;
+    }
+
+    return s;
+}
+
+// FIPS 180-2 test vectors
+TEST(test_bra_sha256_vectors)
+{
+    uint8_t digest[BRA_SHA256_DIGEST_SIZE];
+
+    bra_sha256("", 0, digest);
+    ASSERT_EQ(to_hex(digest), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    bra_sha256("abc", 3, digest);
+    ASSERT_EQ(to_hex(digest), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+    const std::string s = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    bra_sha256(s.data(), s.size(), digest);
+    ASSERT_EQ(to_hex(digest), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    return 0;
+}
+
+TEST(test_bra_sha256_update)
+{
+    // one million 'a' hashed in uneven pieces
+    const std::string a(1000, 'a');
+    bra_sha256_t      ctx;
+    uint8_t           digest[BRA_SHA256_DIGEST_SIZE];
+
+    bra_sha256_init(&ctx);
+    for (int i = 0; i < 1000; ++i)
+    {
+        const size_t n = static_cast<size_t>(i % 7) * 13;
+        bra_sha256_update(&ctx, a.data(), n);
+        bra_sha256_update(&ctx, a.data(), a.size() - n);
+    }
+    bra_sha256_final(&ctx, digest);
+    ASSERT_EQ(to_hex(digest), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::map<std::string, std::function<int()>> m = {
+        {TEST_FUNC(test_bra_sha256_vectors)},
+        {TEST_FUNC(test_bra_sha256_update)},
+    };
+
+    return test_main(argc, argv, m);
+}
@@ -2,6 +2,7 @@
 #include <utils/bra_tree_dir.h>
 
 #include <string.h>
+#include <stdio.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -149,6 +150,94 @@ TEST(test_bra_tree_dir_add3)
     return 0;
 }
 
+TEST(test_bra_tree_dir_next)
+{
+    bra_tree_dir_t* tree = bra_tree_dir_create();
+    ASSERT_TRUE(tree != nullptr);
+
+    ASSERT_TRUE(bra_tree_dir_add(tree, "a/b/c") != nullptr);
+    ASSERT_TRUE(bra_tree_dir_add(tree, "a/d") != nullptr);
+    ASSERT_TRUE(bra_tree_dir_add(tree, "e//f/") != nullptr);
+    ASSERT_EQ(tree->num_nodes, 7U);
+
+    const char*      expected[] = {nullptr, "a", "b", "c", "d", "e", "f"};
+    bra_tree_node_t* n          = tree->root;
+    for (uint32_t i = 0; i < tree->num_nodes; ++i)
+    {
+        ASSERT_TRUE(n != nullptr);
+        ASSERT_EQ(n->index, i);
+        ASSERT_TRUE(bra_tree_dir_parent_index_search(tree, i) == n);
+        if (expected[i] == nullptr)
+            ASSERT_TRUE(n->dirname == nullptr);
+        else
+            ASSERT_EQ(strcmp(n->dirname, expected[i]), 0);
+        n = bra_tree_node_next(n);
+    }
+
+    ASSERT_TRUE(n == nullptr);
+    ASSERT_TRUE(bra_tree_dir_parent_index_search(tree, tree->num_nodes) == nullptr);
+
+    bra_tree_dir_destroy(&tree);
+    ASSERT_TRUE(tree == nullptr);
+    return 0;
+}
+
+TEST(test_bra_tree_dir_find)
+{
+    bra_tree_dir_t* tree = bra_tree_dir_create();
+    ASSERT_TRUE(tree != nullptr);
+
+    bra_tree_node_t* n1 = bra_tree_dir_add(tree, "a/b");
+    bra_tree_node_t* n2 = bra_tree_dir_add(tree, "a/c");
+    ASSERT_TRUE(n1 != nullptr);
+    ASSERT_TRUE(n2 != nullptr);
+
+    ASSERT_TRUE(bra_tree_dir_find(tree, "") == tree->root);
+    ASSERT_TRUE(bra_tree_dir_find(tree, "a") == n1->parent);
+    ASSERT_TRUE(bra_tree_dir_find(tree, "a/b") == n1);
+    ASSERT_TRUE(bra_tree_dir_find(tree, "a/c/") == n2);
+    ASSERT_TRUE(bra_tree_dir_find(tree, "a/d") == nullptr);
+    ASSERT_TRUE(bra_tree_dir_find(tree, "b") == nullptr);
+    ASSERT_TRUE(bra_tree_dir_find(tree, "a/b/c") == nullptr);
+
+    bra_tree_dir_destroy(&tree);
+    ASSERT_TRUE(tree == nullptr);
+    return 0;
+}
+
+TEST(test_bra_tree_dir_many)
+{
+    constexpr uint32_t num_dirs = 10000U;
+    bra_tree_dir_t*    tree     = bra_tree_dir_create();
+    ASSERT_TRUE(tree != nullptr);
+
+    // wide and deep enough to span several arena blocks and index table growths.
+    char dirname[64];
+    for (uint32_t i = 0; i < num_dirs; ++i)
+    {
+        snprintf(dirname, sizeof(dirname), "dir%u/sub%u", i % 100U, i);
+        ASSERT_TRUE(bra_tree_dir_add(tree, dirname) != nullptr);
+    }
+
+    ASSERT_EQ(tree->num_nodes, 1U + 100U + num_dirs);
+    for (uint32_t i = 0; i < tree->num_nodes; ++i)
+    {
+        const bra_tree_node_t* n = bra_tree_dir_parent_index_search(tree, i);
+        ASSERT_TRUE(n != nullptr);
+        ASSERT_EQ(n->index, i);
+    }
+
+    bra_tree_node_t* last = bra_tree_dir_parent_index_search(tree, tree->num_nodes - 1U);
+    char*            path = bra_tree_dir_reconstruct_path(last);
+    ASSERT_TRUE(path != nullptr);
+    ASSERT_EQ(strcmp(path, "dir99/sub9999"), 0);
+    free(path);
+
+    bra_tree_dir_destroy(&tree);
+    ASSERT_TRUE(tree == nullptr);
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     g_argv0 = argv[0];
@@ -159,6 +248,9 @@ int main(int argc, char* argv[])
         {TEST_FUNC(test_bra_tree_dir_add1)},
         {TEST_FUNC(test_bra_tree_dir_add2)},
         {TEST_FUNC(test_bra_tree_dir_add3)},
+        {TEST_FUNC(test_bra_tree_dir_next)},
+        {TEST_FUNC(test_bra_tree_dir_find)},
+        {TEST_FUNC(test_bra_tree_dir_many)},
     };
 
     return test_main(argc, argv, m);
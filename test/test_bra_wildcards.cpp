@@ -87,6 +87,43 @@ TEST(test_bra_wildcards_to_regexp)
     return 0;
 }
 
+TEST(test_bra_wildcards_glob_matcher)
+{
+    ASSERT_TRUE(glob_matcher("*").match(""));
+    ASSERT_TRUE(glob_matcher("*").match("anything.txt"));
+    ASSERT_TRUE(glob_matcher("").match(""));
+    ASSERT_FALSE(glob_matcher("").match("a"));
+
+    ASSERT_TRUE(glob_matcher("file.txt").match("file.txt"));
+    ASSERT_FALSE(glob_matcher("file.txt").match("file.txt2"));
+    ASSERT_TRUE(glob_matcher("file?.txt").match("file1.txt"));
+    ASSERT_FALSE(glob_matcher("file?.txt").match("file.txt"));
+
+    ASSERT_TRUE(glob_matcher("bra*").match("bra.sfx"));
+    ASSERT_FALSE(glob_matcher("bra*").match("unbra"));
+    ASSERT_TRUE(glob_matcher("*.txt").match(".txt"));
+    ASSERT_FALSE(glob_matcher("*.txt").match("file.txt.bak"));
+    ASSERT_TRUE(glob_matcher("a*b*c").match("abc"));
+    ASSERT_TRUE(glob_matcher("a*b*c").match("aXbYbZc"));
+    ASSERT_FALSE(glob_matcher("a*b*c").match("aXcYb"));
+    ASSERT_FALSE(glob_matcher("ab*ba").match("aba"));    // prefix and suffix can't overlap
+    ASSERT_TRUE(glob_matcher("**a?*").match("xxaY"));
+    ASSERT_TRUE(glob_matcher("*+*").match("file+name"));    // no regex special chars
+
+    // same results as the regular expression conversion
+    const char* patterns[] = {"*", "?", "*.txt", "file?.*", "a*a", "*a*a*", "?*?", "*ab?c*d", "x??y*"};
+    const char* names[]    = {"", "a", "aa", "aaa", "file1.txt", "file.txt", "abxcd", "aabacd", "abab", "xaay", "xyy", "x12yzz"};
+    for (const char* pattern : patterns)
+    {
+        const glob_matcher g(pattern);
+        const std::regex   r(wildcard_to_regexp(pattern));
+        for (const char* name : names)
+            ASSERT_EQ(g.match(name), std::regex_match(name, r));
+    }
+
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     return test_main(argc, argv, {
@@ -94,5 +131,6 @@ int main(int argc, char* argv[])
 
                                      {TEST_FUNC(test_bra_wildcards_extract_dir)},
                                      {TEST_FUNC(test_bra_wildcards_to_regexp)},
+                                     {TEST_FUNC(test_bra_wildcards_glob_matcher)},
                                  });
 }